@@ -1,9 +1,16 @@
 #include "pch.h"
 #include "BitmapDefinition.h"
 
-BitmapDefinition::BitmapDefinition(PCWSTR uri) : uri(uri) {}
+BitmapDefinition::BitmapDefinition(PCWSTR uri, bitmap_decoder_t decoder) : uri(uri), decoder(decoder), png_header() {}
 
 void BitmapDefinition::CreateDeviceIndependentResources(IWICImagingFactory* imaging_factory) {
+	if (decoder == bitmap_decoder_t::PORTABLE) {
+		file.emplace(winrt::to_string(uri));
+		file_data = { reinterpret_cast<const BYTE*>(file->GetData().data()), file->GetData().size() };
+		png_header = ReadPngHeader(file_data);
+		return;
+	}
+
 	winrt::com_ptr<IWICBitmapDecoder> decoder;
 	winrt::com_ptr<IWICBitmapFrameDecode> source;
 	winrt::com_ptr<IWICStream> stream;
@@ -30,11 +37,24 @@ void BitmapDefinition::CreateDeviceIndependentResources(IWICImagingFactory* imag
 	));
 }
 
-BYTE* BitmapDefinition::GetBitmapAsBytes(UINT* width, UINT* height) {
+void BitmapDefinition::GetSize(UINT* width, UINT* height) {
+	if (decoder == bitmap_decoder_t::PORTABLE) {
+		*width = png_header.width;
+		*height = png_header.height;
+		return;
+	}
+
 	winrt::check_hresult(converter->GetSize(width, height));
+}
 
-	BYTE* bits = new BYTE[4 * *width * *height];
-	winrt::check_hresult(converter->CopyPixels(nullptr, 4 * *width, 4 * *width * *height, bits));
+void BitmapDefinition::CopyPixels(BYTE* destination, UINT row_pitch) {
+	UINT width, height;
+	GetSize(&width, &height);
+	if (decoder == bitmap_decoder_t::PORTABLE) {
+		DecodePng(file_data, destination, row_pitch);
+		return;
+	}
 
-	return bits;
+	// The last row is not padded to the row pitch.
+	winrt::check_hresult(converter->CopyPixels(nullptr, row_pitch, row_pitch * (height - 1) + 4 * width, destination));
 }
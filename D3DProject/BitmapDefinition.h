@@ -1,11 +1,28 @@
 #pragma once
 
+#include "MappedFile.h"
+#include "PngDecoder.h"
+
+enum class bitmap_decoder_t : UINT {
+	// Any format WIC has a codec for.
+	WIC,
+	// PNG only, decoded without WIC.
+	PORTABLE
+};
+
 class BitmapDefinition {
 public:
-	BitmapDefinition(PCWSTR uri);
+	BitmapDefinition(PCWSTR uri, bitmap_decoder_t decoder = bitmap_decoder_t::WIC);
+	// The imaging factory is not used, and may be null, with the portable decoder.
 	void CreateDeviceIndependentResources(IWICImagingFactory* imaging_factory);
-	BYTE* GetBitmapAsBytes(UINT* width, UINT* height);
+	void GetSize(UINT* width, UINT* height);
+	// Writes the image as 32bpp RGBA rows that start row_pitch bytes apart, which may be mapped upload memory.
+	void CopyPixels(BYTE* destination, UINT row_pitch);
 private:
 	PCWSTR uri;
+	bitmap_decoder_t decoder;
 	winrt::com_ptr<IWICFormatConverter> converter;
+	std::optional<MappedFile> file;
+	std::span<const BYTE> file_data;
+	png_header_t png_header;
 };
@@ -0,0 +1,759 @@
+#include "pch.h"
+#include "BlockCompressor.h"
+#include "parallel_utils.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace {
+	constexpr UINT BLOCK_PIXELS = 16;
+	// Power iterations used to find the principal axis of a block.
+	constexpr UINT POWER_ITERATIONS = 8;
+
+	// Interpolation weights of the BC7 indices, in 64ths.
+	constexpr UINT BC7_WEIGHTS_2[] = { 0, 21, 43, 64 };
+	constexpr UINT BC7_WEIGHTS_3[] = { 0, 9, 18, 27, 37, 46, 55, 64 };
+	constexpr UINT BC7_WEIGHTS_4[] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+
+	// Share of the second endpoint in each palette entry, in palette order.
+	constexpr FLOAT BC1_FRACTIONS[] = { 0.0f, 1.0f, 1.0f / 3.0f, 2.0f / 3.0f };
+	constexpr FLOAT BC3_ALPHA_FRACTIONS[] = { 0.0f, 1.0f, 1.0f / 7.0f, 2.0f / 7.0f, 3.0f / 7.0f, 4.0f / 7.0f, 5.0f / 7.0f, 6.0f / 7.0f };
+
+	// Channels compared by each fit.
+	const XMVECTORF32 COLOR_CHANNELS = { { { 1.0f, 1.0f, 1.0f, 0.0f } } };
+	const XMVECTORF32 ALPHA_CHANNEL = { { { 0.0f, 0.0f, 0.0f, 1.0f } } };
+
+	// RGBA values from 0 to 255, one pixel per vector.
+	using block_pixels_t = std::array<XMVECTOR, BLOCK_PIXELS>;
+	using block_indices_t = std::array<BYTE, BLOCK_PIXELS>;
+
+	struct quality_settings_t {
+		UINT refine_iterations;
+		bool bounding_box_start;
+		bool bc7_mode5;
+		UINT bc7_rotations;
+	};
+
+	quality_settings_t GetQualitySettings(compression_quality_t quality) {
+		switch (quality) {
+		case compression_quality_t::FAST: return { .refine_iterations = 0, .bounding_box_start = false, .bc7_mode5 = false, .bc7_rotations = 1 };
+		case compression_quality_t::HIGH: return { .refine_iterations = 6, .bounding_box_start = true, .bc7_mode5 = true, .bc7_rotations = 4 };
+		default: return { .refine_iterations = 2, .bounding_box_start = false, .bc7_mode5 = true, .bc7_rotations = 1 };
+		}
+	}
+
+	UINT GetBlockSize(DXGI_FORMAT format) {
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM: return 8;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC7_UNORM: return 16;
+		default: throw std::runtime_error("BlockCompressor: unsupported block-compressed format");
+		}
+	}
+
+	// Same levels as the source, with rows of 4x4 blocks.
+	texture_data_t CreateBlockLayout(const texture_data_t& source, DXGI_FORMAT format) {
+		UINT block_size = GetBlockSize(format);
+		texture_data_t texture = { .format = format };
+		std::size_t size = 0;
+		for (const texture_level_t& level : source.levels) {
+			UINT blocks_x = (level.width + 3) / 4;
+			UINT blocks_y = (level.height + 3) / 4;
+			texture.levels.push_back({
+				.width = level.width,
+				.height = level.height,
+				.offset = size,
+				.row_pitch = blocks_x * block_size,
+				.row_count = blocks_y
+			});
+			size += std::size_t(blocks_x) * block_size * blocks_y;
+		}
+		texture.data.resize(size);
+		return texture;
+	}
+
+	// Runs function(level, block_row) for every row of blocks, handing rows out to the threads one at a time
+	// so that the small levels at the end of the chain do not leave threads idle.
+	template <typename Function>
+	void ForEachBlockRow(const texture_data_t& blocks, UINT thread_count, Function&& function) {
+		std::vector<std::pair<UINT, UINT>> rows;
+		for (UINT level = 0; level < blocks.levels.size(); level++) {
+			for (UINT row = 0; row < blocks.levels[level].row_count; row++) {
+				rows.emplace_back(level, row);
+			}
+		}
+		std::atomic<std::size_t> next_row = 0;
+		ParallelFor(std::max(thread_count, 1u), [&](std::size_t) {
+			for (std::size_t row = next_row++; row < rows.size(); row = next_row++) {
+				function(rows[row].first, rows[row].second);
+			}
+		});
+	}
+
+	// Pixels past the edge of levels smaller than a block repeat the last row and column.
+	void LoadBlock(const BYTE* pixels, const texture_level_t& level, UINT block_x, UINT block_y, block_pixels_t& block) {
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			UINT x = std::min(block_x * 4 + i % 4, level.width - 1);
+			UINT y = std::min(block_y * 4 + i / 4, level.height - 1);
+			block[i] = XMLoadUByte4(reinterpret_cast<const XMUBYTE4*>(pixels + std::size_t(y) * level.row_pitch + x * 4));
+		}
+	}
+
+	void StoreBlock(const block_pixels_t& block, const texture_level_t& level, UINT block_x, UINT block_y, BYTE* pixels) {
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			UINT x = block_x * 4 + i % 4;
+			UINT y = block_y * 4 + i / 4;
+			if (x < level.width && y < level.height) {
+				XMStoreUByte4(reinterpret_cast<XMUBYTE4*>(pixels + std::size_t(y) * level.row_pitch + x * 4), block[i]);
+			}
+		}
+	}
+
+	XMVECTOR Interpolate(XMVECTOR first, XMVECTOR second, UINT weight) {
+		// ((64 - w) * e0 + w * e1 + 32) >> 6, exact on the integer endpoint values.
+		XMVECTOR sum = XMVectorMultiplyAdd(second, XMVectorReplicate(static_cast<FLOAT>(weight)),
+			XMVectorScale(first, static_cast<FLOAT>(64 - weight)));
+		return XMVectorFloor(XMVectorScale(XMVectorAdd(sum, XMVectorReplicate(32.0f)), 1.0f / 64.0f));
+	}
+
+	XMVECTOR DivideRounded(XMVECTOR value, FLOAT divisor) {
+		return XMVectorFloor(XMVectorScale(XMVectorAdd(value, XMVectorReplicate(divisor / 2.0f)), 1.0f / divisor));
+	}
+
+	// Squared error of the masked channels to the closest palette entry, summed over the block.
+	FLOAT AssignIndices(const block_pixels_t& pixels, XMVECTOR mask, std::span<const XMVECTOR> palette,
+		block_indices_t& indices) {
+		FLOAT total = 0.0f;
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			FLOAT best = FLT_MAX;
+			for (UINT entry = 0; entry < palette.size(); entry++) {
+				XMVECTOR difference = XMVectorMultiply(XMVectorSubtract(pixels[i], palette[entry]), mask);
+				FLOAT error = XMVectorGetX(XMVector4Dot(difference, difference));
+				if (error < best) {
+					best = error;
+					indices[i] = static_cast<BYTE>(entry);
+				}
+			}
+			total += best;
+		}
+		return total;
+	}
+
+	void PrincipalAxisEndpoints(const block_pixels_t& pixels, XMVECTOR mask, XMVECTOR& first, XMVECTOR& second) {
+		XMVECTOR minimum = pixels[0], maximum = pixels[0], mean = XMVectorZero();
+		for (XMVECTOR pixel : pixels) {
+			minimum = XMVectorMin(minimum, pixel);
+			maximum = XMVectorMax(maximum, pixel);
+			mean = XMVectorAdd(mean, pixel);
+		}
+		mean = XMVectorScale(mean, 1.0f / BLOCK_PIXELS);
+
+		XMMATRIX covariance(XMVectorZero(), XMVectorZero(), XMVectorZero(), XMVectorZero());
+		for (XMVECTOR pixel : pixels) {
+			XMVECTOR offset = XMVectorMultiply(XMVectorSubtract(pixel, mean), mask);
+			covariance.r[0] = XMVectorMultiplyAdd(offset, XMVectorSplatX(offset), covariance.r[0]);
+			covariance.r[1] = XMVectorMultiplyAdd(offset, XMVectorSplatY(offset), covariance.r[1]);
+			covariance.r[2] = XMVectorMultiplyAdd(offset, XMVectorSplatZ(offset), covariance.r[2]);
+			covariance.r[3] = XMVectorMultiplyAdd(offset, XMVectorSplatW(offset), covariance.r[3]);
+		}
+
+		XMVECTOR axis = XMVectorMultiply(XMVectorSubtract(maximum, minimum), mask);
+		for (UINT i = 0; i < POWER_ITERATIONS && XMVectorGetX(XMVector4LengthSq(axis)) > 0.0f; i++) {
+			XMVECTOR next = XMVector4Transform(axis, covariance);
+			if (XMVectorGetX(XMVector4LengthSq(next)) == 0.0f) {
+				break;
+			}
+			axis = XMVector4Normalize(next);
+		}
+		if (XMVectorGetX(XMVector4LengthSq(axis)) == 0.0f) {
+			first = second = mean;
+			return;
+		}
+		axis = XMVector4Normalize(axis);
+
+		FLOAT low = FLT_MAX, high = -FLT_MAX;
+		for (XMVECTOR pixel : pixels) {
+			FLOAT t = XMVectorGetX(XMVector4Dot(XMVectorSubtract(pixel, mean), axis));
+			low = std::min(low, t);
+			high = std::max(high, t);
+		}
+		first = XMVectorMultiplyAdd(axis, XMVectorReplicate(low), mean);
+		second = XMVectorMultiplyAdd(axis, XMVectorReplicate(high), mean);
+	}
+
+	struct endpoint_fit_t {
+		// Unquantized endpoints of the best fit found; quantizing them again gives the encoded values.
+		XMVECTOR endpoints[2];
+		block_indices_t indices;
+		FLOAT error = FLT_MAX;
+	};
+
+	// Fits two endpoints to the masked channels of a block. build_palette(first, second, palette) quantizes
+	// the endpoints the way the mode stores them and fills the palette they decode to, in the order of
+	// fractions, which gives the share of the second endpoint in each entry.
+	template <typename PaletteBuilder>
+	endpoint_fit_t FitEndpoints(const block_pixels_t& pixels, XMVECTOR mask, std::span<const FLOAT> fractions,
+		const quality_settings_t& quality, PaletteBuilder&& build_palette) {
+		std::array<XMVECTOR, 16> palette;
+		std::span<XMVECTOR> entries(palette.data(), fractions.size());
+
+		std::vector<std::pair<XMVECTOR, XMVECTOR>> starts(1);
+		PrincipalAxisEndpoints(pixels, mask, starts[0].first, starts[0].second);
+		if (quality.bounding_box_start) {
+			XMVECTOR minimum = pixels[0], maximum = pixels[0];
+			for (XMVECTOR pixel : pixels) {
+				minimum = XMVectorMin(minimum, pixel);
+				maximum = XMVectorMax(maximum, pixel);
+			}
+			starts.emplace_back(minimum, maximum);
+		}
+
+		endpoint_fit_t best;
+		for (auto [first, second] : starts) {
+			block_indices_t indices;
+			for (UINT iteration = 0; ; iteration++) {
+				first = XMVectorClamp(first, XMVectorZero(), XMVectorReplicate(255.0f));
+				second = XMVectorClamp(second, XMVectorZero(), XMVectorReplicate(255.0f));
+				build_palette(first, second, entries);
+				FLOAT error = AssignIndices(pixels, mask, entries, indices);
+				if (error < best.error) {
+					best = { .endpoints = { first, second }, .indices = indices, .error = error };
+				}
+				if (iteration == quality.refine_iterations || error == 0.0f) {
+					break;
+				}
+
+				// Least-squares endpoints for the current indices.
+				FLOAT first_sq = 0.0f, second_sq = 0.0f, cross = 0.0f;
+				XMVECTOR first_sum = XMVectorZero(), second_sum = XMVectorZero();
+				for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+					FLOAT t = fractions[indices[i]];
+					first_sq += (1.0f - t) * (1.0f - t);
+					second_sq += t * t;
+					cross += (1.0f - t) * t;
+					first_sum = XMVectorMultiplyAdd(pixels[i], XMVectorReplicate(1.0f - t), first_sum);
+					second_sum = XMVectorMultiplyAdd(pixels[i], XMVectorReplicate(t), second_sum);
+				}
+				FLOAT determinant = first_sq * second_sq - cross * cross;
+				if (std::abs(determinant) < 1e-4f) {
+					break;
+				}
+				XMVECTOR solved_first = XMVectorScale(XMVectorSubtract(XMVectorScale(first_sum, second_sq),
+					XMVectorScale(second_sum, cross)), 1.0f / determinant);
+				XMVECTOR solved_second = XMVectorScale(XMVectorSubtract(XMVectorScale(second_sum, first_sq),
+					XMVectorScale(first_sum, cross)), 1.0f / determinant);
+				first = XMVectorSelect(first, solved_first, XMVectorNotEqual(mask, XMVectorZero()));
+				second = XMVectorSelect(second, solved_second, XMVectorNotEqual(mask, XMVectorZero()));
+			}
+		}
+		return best;
+	}
+
+	// Sequential little-endian bit fields, as laid out in BC7 blocks.
+	class BitWriter {
+	public:
+		explicit BitWriter(BYTE* destination) : destination(destination) {}
+
+		void Write(UINT value, UINT bit_count) {
+			for (UINT bit = 0; bit < bit_count; bit++, position++) {
+				destination[position / 8] |= static_cast<BYTE>(((value >> bit) & 1) << (position % 8));
+			}
+		}
+
+	private:
+		BYTE* destination;
+		UINT position = 0;
+	};
+
+	class BitReader {
+	public:
+		explicit BitReader(const BYTE* source) : source(source) {}
+
+		UINT Read(UINT bit_count) {
+			UINT value = 0;
+			for (UINT bit = 0; bit < bit_count; bit++, position++) {
+				value |= ((source[position / 8] >> (position % 8)) & 1u) << bit;
+			}
+			return value;
+		}
+
+	private:
+		const BYTE* source;
+		UINT position = 0;
+	};
+
+	UINT16 EncodeRgb565(XMVECTOR color) {
+		XMUINT4 channels;
+		XMStoreUInt4(&channels, XMVectorRound(XMVectorMultiply(color, XMVectorSet(31.0f / 255.0f, 63.0f / 255.0f, 31.0f / 255.0f, 0.0f))));
+		return static_cast<UINT16>((channels.x << 11) | (channels.y << 5) | channels.z);
+	}
+
+	XMVECTOR DecodeRgb565(UINT16 color) {
+		UINT red = color >> 11, green = (color >> 5) & 0x3f, blue = color & 0x1f;
+		return XMVectorSet(static_cast<FLOAT>((red << 3) | (red >> 2)), static_cast<FLOAT>((green << 2) | (green >> 4)),
+			static_cast<FLOAT>((blue << 3) | (blue >> 2)), 255.0f);
+	}
+
+	void BuildBc1Palette(XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+		palette[0] = first;
+		palette[1] = second;
+		palette[2] = DivideRounded(XMVectorAdd(XMVectorScale(first, 2.0f), second), 3.0f);
+		palette[3] = DivideRounded(XMVectorAdd(first, XMVectorScale(second, 2.0f)), 3.0f);
+	}
+
+	// Always uses the four-color mode, which is the only one BC3 color blocks have.
+	void EncodeBc1Color(const block_pixels_t& pixels, const quality_settings_t& quality, BYTE* destination) {
+		endpoint_fit_t fit = FitEndpoints(pixels, COLOR_CHANNELS, BC1_FRACTIONS, quality,
+			[](XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+				BuildBc1Palette(DecodeRgb565(EncodeRgb565(first)), DecodeRgb565(EncodeRgb565(second)), palette);
+			});
+		UINT16 colors[2] = { EncodeRgb565(fit.endpoints[0]), EncodeRgb565(fit.endpoints[1]) };
+		if (colors[0] < colors[1]) {
+			// The four-color mode needs the first color to be the larger one; 0 <-> 1 and 2 <-> 3.
+			std::swap(colors[0], colors[1]);
+			for (BYTE& index : fit.indices) {
+				index ^= 1;
+			}
+		}
+		UINT32 bits = 0;
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			bits |= static_cast<UINT32>(colors[0] == colors[1] ? 0 : fit.indices[i]) << (i * 2);
+		}
+		std::memcpy(destination, colors, sizeof(colors));
+		std::memcpy(destination + sizeof(colors), &bits, sizeof(bits));
+	}
+
+	void BuildBc3AlphaPalette(XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+		palette[0] = first;
+		palette[1] = second;
+		for (UINT i = 2; i < 8; i++) {
+			palette[i] = DivideRounded(XMVectorAdd(XMVectorScale(first, static_cast<FLOAT>(8 - i)),
+				XMVectorScale(second, static_cast<FLOAT>(i - 1))), 7.0f);
+		}
+	}
+
+	// Always uses the eight-value mode.
+	void EncodeBc3Alpha(const block_pixels_t& pixels, const quality_settings_t& quality, BYTE* destination) {
+		endpoint_fit_t fit = FitEndpoints(pixels, ALPHA_CHANNEL, BC3_ALPHA_FRACTIONS, quality,
+			[](XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+				BuildBc3AlphaPalette(XMVectorRound(first), XMVectorRound(second), palette);
+			});
+		BYTE alphas[2] = {
+			static_cast<BYTE>(XMVectorGetW(XMVectorRound(fit.endpoints[0]))),
+			static_cast<BYTE>(XMVectorGetW(XMVectorRound(fit.endpoints[1])))
+		};
+		if (alphas[0] < alphas[1]) {
+			std::swap(alphas[0], alphas[1]);
+			for (BYTE& index : fit.indices) {
+				index = index < 2 ? index ^ 1 : 9 - index;
+			}
+		}
+		UINT64 bits = 0;
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			bits |= static_cast<UINT64>(alphas[0] == alphas[1] ? 0 : fit.indices[i]) << (i * 3);
+		}
+		destination[0] = alphas[0];
+		destination[1] = alphas[1];
+		std::memcpy(destination + 2, &bits, 6);
+	}
+
+	// Mode 6: one subset, RGBA endpoints with 7 bits per channel plus a shared low bit, and 4-bit indices.
+	struct bc7_mode6_endpoint_t {
+		XMUINT4 channels;
+		UINT p_bit;
+	};
+
+	bc7_mode6_endpoint_t QuantizeMode6(XMVECTOR value) {
+		bc7_mode6_endpoint_t best = {};
+		FLOAT best_error = FLT_MAX;
+		for (UINT p_bit = 0; p_bit < 2; p_bit++) {
+			XMVECTOR code = XMVectorClamp(XMVectorRound(XMVectorScale(XMVectorSubtract(value, XMVectorReplicate(static_cast<FLOAT>(p_bit))), 0.5f)),
+				XMVectorZero(), XMVectorReplicate(127.0f));
+			XMVECTOR difference = XMVectorSubtract(XMVectorMultiplyAdd(code, XMVectorReplicate(2.0f), XMVectorReplicate(static_cast<FLOAT>(p_bit))), value);
+			FLOAT error = XMVectorGetX(XMVector4Dot(difference, difference));
+			if (error < best_error) {
+				best_error = error;
+				best.p_bit = p_bit;
+				XMStoreUInt4(&best.channels, code);
+			}
+		}
+		return best;
+	}
+
+	XMVECTOR DecodeMode6(const bc7_mode6_endpoint_t& endpoint) {
+		return XMVectorSet(static_cast<FLOAT>(endpoint.channels.x * 2 + endpoint.p_bit), static_cast<FLOAT>(endpoint.channels.y * 2 + endpoint.p_bit),
+			static_cast<FLOAT>(endpoint.channels.z * 2 + endpoint.p_bit), static_cast<FLOAT>(endpoint.channels.w * 2 + endpoint.p_bit));
+	}
+
+	template <std::size_t Size>
+	std::array<FLOAT, Size> GetFractions(const UINT (&weights)[Size]) {
+		std::array<FLOAT, Size> fractions;
+		for (std::size_t i = 0; i < Size; i++) {
+			fractions[i] = weights[i] / 64.0f;
+		}
+		return fractions;
+	}
+
+	template <std::size_t Size>
+	void BuildBc7Palette(XMVECTOR first, XMVECTOR second, const UINT (&weights)[Size], std::span<XMVECTOR> palette) {
+		for (std::size_t i = 0; i < Size; i++) {
+			palette[i] = Interpolate(first, second, weights[i]);
+		}
+	}
+
+	FLOAT EncodeBc7Mode6(const block_pixels_t& pixels, const quality_settings_t& quality, BYTE* destination) {
+		static const auto fractions = GetFractions(BC7_WEIGHTS_4);
+		endpoint_fit_t fit = FitEndpoints(pixels, g_XMOne, fractions, quality,
+			[](XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+				BuildBc7Palette(DecodeMode6(QuantizeMode6(first)), DecodeMode6(QuantizeMode6(second)), BC7_WEIGHTS_4, palette);
+			});
+		bc7_mode6_endpoint_t endpoints[2] = { QuantizeMode6(fit.endpoints[0]), QuantizeMode6(fit.endpoints[1]) };
+		if (fit.indices[0] >= 8) {
+			// The most significant bit of the first index is implied to be zero.
+			std::swap(endpoints[0], endpoints[1]);
+			for (BYTE& index : fit.indices) {
+				index = 15 - index;
+			}
+		}
+
+		std::fill_n(destination, 16, BYTE(0));
+		BitWriter writer(destination);
+		writer.Write(1 << 6, 7);
+		for (UINT channel = 0; channel < 4; channel++) {
+			for (const bc7_mode6_endpoint_t& endpoint : endpoints) {
+				writer.Write((&endpoint.channels.x)[channel], 7);
+			}
+		}
+		writer.Write(endpoints[0].p_bit, 1);
+		writer.Write(endpoints[1].p_bit, 1);
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			writer.Write(fit.indices[i], i == 0 ? 3 : 4);
+		}
+		return fit.error;
+	}
+
+	// Mode 5: one subset with separate 2-bit indices for RGB (7 bits per channel) and alpha (8 bits). The
+	// rotation swaps alpha with one of the color channels, so that the channel varying independently of the
+	// others gets its own indices.
+	XMVECTOR RotateChannels(XMVECTOR value, UINT rotation) {
+		switch (rotation) {
+		case 1: return XMVectorSwizzle<3, 1, 2, 0>(value);
+		case 2: return XMVectorSwizzle<0, 3, 2, 1>(value);
+		case 3: return XMVectorSwizzle<0, 1, 3, 2>(value);
+		default: return value;
+		}
+	}
+
+	XMVECTOR QuantizeMode5Color(XMVECTOR value) {
+		return XMVectorClamp(XMVectorRound(XMVectorScale(value, 127.0f / 255.0f)), XMVectorZero(), XMVectorReplicate(127.0f));
+	}
+
+	XMVECTOR DecodeMode5Color(XMVECTOR code) {
+		// (c << 1) | (c >> 6)
+		return XMVectorAdd(XMVectorScale(code, 2.0f), XMVectorFloor(XMVectorScale(code, 1.0f / 64.0f)));
+	}
+
+	FLOAT EncodeBc7Mode5(const block_pixels_t& source, UINT rotation, const quality_settings_t& quality, BYTE* destination) {
+		static const auto fractions = GetFractions(BC7_WEIGHTS_2);
+		block_pixels_t pixels;
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			pixels[i] = RotateChannels(source[i], rotation);
+		}
+		endpoint_fit_t color = FitEndpoints(pixels, COLOR_CHANNELS, fractions, quality,
+			[](XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+				BuildBc7Palette(DecodeMode5Color(QuantizeMode5Color(first)), DecodeMode5Color(QuantizeMode5Color(second)),
+					BC7_WEIGHTS_2, palette);
+			});
+		endpoint_fit_t alpha = FitEndpoints(pixels, ALPHA_CHANNEL, fractions, quality,
+			[](XMVECTOR first, XMVECTOR second, std::span<XMVECTOR> palette) {
+				BuildBc7Palette(XMVectorRound(first), XMVectorRound(second), BC7_WEIGHTS_2, palette);
+			});
+
+		XMUINT4 colors[2], alphas[2];
+		XMStoreUInt4(&colors[0], QuantizeMode5Color(color.endpoints[0]));
+		XMStoreUInt4(&colors[1], QuantizeMode5Color(color.endpoints[1]));
+		XMStoreUInt4(&alphas[0], XMVectorRound(alpha.endpoints[0]));
+		XMStoreUInt4(&alphas[1], XMVectorRound(alpha.endpoints[1]));
+		if (color.indices[0] >= 2) {
+			std::swap(colors[0], colors[1]);
+			for (BYTE& index : color.indices) {
+				index = 3 - index;
+			}
+		}
+		if (alpha.indices[0] >= 2) {
+			std::swap(alphas[0], alphas[1]);
+			for (BYTE& index : alpha.indices) {
+				index = 3 - index;
+			}
+		}
+
+		std::fill_n(destination, 16, BYTE(0));
+		BitWriter writer(destination);
+		writer.Write(1 << 5, 6);
+		writer.Write(rotation, 2);
+		for (UINT channel = 0; channel < 3; channel++) {
+			writer.Write((&colors[0].x)[channel], 7);
+			writer.Write((&colors[1].x)[channel], 7);
+		}
+		writer.Write(alphas[0].w, 8);
+		writer.Write(alphas[1].w, 8);
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			writer.Write(color.indices[i], i == 0 ? 1 : 2);
+		}
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			writer.Write(alpha.indices[i], i == 0 ? 1 : 2);
+		}
+		return color.error + alpha.error;
+	}
+
+	void EncodeBc7(const block_pixels_t& pixels, const quality_settings_t& quality, BYTE* destination) {
+		FLOAT best_error = EncodeBc7Mode6(pixels, quality, destination);
+		if (!quality.bc7_mode5) {
+			return;
+		}
+		BYTE candidate[16];
+		for (UINT rotation = 0; rotation < quality.bc7_rotations && best_error > 0.0f; rotation++) {
+			FLOAT error = EncodeBc7Mode5(pixels, rotation, quality, candidate);
+			if (error < best_error) {
+				best_error = error;
+				std::memcpy(destination, candidate, sizeof(candidate));
+			}
+		}
+	}
+
+	void EncodeBlock(DXGI_FORMAT format, const block_pixels_t& pixels, const quality_settings_t& quality, BYTE* destination) {
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM:
+			EncodeBc1Color(pixels, quality, destination);
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+			EncodeBc3Alpha(pixels, quality, destination);
+			EncodeBc1Color(pixels, quality, destination + 8);
+			break;
+		default:
+			EncodeBc7(pixels, quality, destination);
+			break;
+		}
+	}
+
+	void DecodeBc1Color(const BYTE* source, bool four_colors_only, block_pixels_t& pixels) {
+		UINT16 colors[2];
+		UINT32 bits;
+		std::memcpy(colors, source, sizeof(colors));
+		std::memcpy(&bits, source + sizeof(colors), sizeof(bits));
+		XMVECTOR palette[4] = { DecodeRgb565(colors[0]), DecodeRgb565(colors[1]) };
+		if (four_colors_only || colors[0] > colors[1]) {
+			BuildBc1Palette(palette[0], palette[1], palette);
+		}
+		else {
+			palette[2] = DivideRounded(XMVectorAdd(palette[0], palette[1]), 2.0f);
+			palette[3] = XMVectorZero();
+		}
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			pixels[i] = palette[(bits >> (i * 2)) & 3];
+		}
+	}
+
+	void DecodeBc3Alpha(const BYTE* source, block_pixels_t& pixels) {
+		XMVECTOR palette[8] = { XMVectorReplicate(source[0]), XMVectorReplicate(source[1]) };
+		if (source[0] > source[1]) {
+			BuildBc3AlphaPalette(palette[0], palette[1], palette);
+		}
+		else {
+			for (UINT i = 2; i < 6; i++) {
+				palette[i] = DivideRounded(XMVectorAdd(XMVectorScale(palette[0], static_cast<FLOAT>(6 - i)),
+					XMVectorScale(palette[1], static_cast<FLOAT>(i - 1))), 5.0f);
+			}
+			palette[6] = XMVectorZero();
+			palette[7] = XMVectorReplicate(255.0f);
+		}
+		UINT64 bits = 0;
+		std::memcpy(&bits, source + 2, 6);
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			pixels[i] = XMVectorSelect(pixels[i], palette[(bits >> (i * 3)) & 7], g_XMSelect0001);
+		}
+	}
+
+	void DecodeBc7(const BYTE* source, block_pixels_t& pixels) {
+		UINT mode = 0;
+		while (mode < 8 && !(source[0] & (1 << mode))) {
+			mode++;
+		}
+		if (mode == 8) {
+			// Reserved mode, decoded as transparent black.
+			pixels.fill(XMVectorZero());
+			return;
+		}
+		if (mode < 4 || mode == 7) {
+			throw std::runtime_error(std::format("BlockCompressor: BC7 mode {} is not supported", mode));
+		}
+
+		BitReader reader(source);
+		reader.Read(mode + 1);
+		UINT rotation = mode == 6 ? 0 : reader.Read(2);
+		UINT index_selection = mode == 4 ? reader.Read(1) : 0;
+		UINT color_bits = mode == 4 ? 5 : 7;
+		UINT alpha_bits = mode == 4 ? 6 : mode == 5 ? 8 : 7;
+		UINT endpoints[2][4];
+		for (UINT channel = 0; channel < 3; channel++) {
+			endpoints[0][channel] = reader.Read(color_bits);
+			endpoints[1][channel] = reader.Read(color_bits);
+		}
+		endpoints[0][3] = reader.Read(alpha_bits);
+		endpoints[1][3] = reader.Read(alpha_bits);
+
+		UINT p_bits[2] = {};
+		if (mode == 6) {
+			p_bits[0] = reader.Read(1);
+			p_bits[1] = reader.Read(1);
+		}
+		XMVECTOR decoded[2];
+		for (UINT endpoint = 0; endpoint < 2; endpoint++) {
+			XMFLOAT4 channels;
+			for (UINT channel = 0; channel < 4; channel++) {
+				UINT value = endpoints[endpoint][channel];
+				if (mode == 6) {
+					value = value * 2 + p_bits[endpoint];
+				}
+				else {
+					// Replicates the high bits into the missing low bits.
+					UINT bits = channel < 3 ? color_bits : alpha_bits;
+					value <<= 8 - bits;
+					value |= value >> bits;
+				}
+				(&channels.x)[channel] = static_cast<FLOAT>(value);
+			}
+			decoded[endpoint] = XMLoadFloat4(&channels);
+		}
+
+		UINT primary_indices[BLOCK_PIXELS], secondary_indices[BLOCK_PIXELS] = {};
+		UINT primary_bits = mode == 6 ? 4 : 2;
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			primary_indices[i] = reader.Read(i == 0 ? primary_bits - 1 : primary_bits);
+		}
+		if (mode != 6) {
+			UINT secondary_bits = mode == 4 ? 3 : 2;
+			for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+				secondary_indices[i] = reader.Read(i == 0 ? secondary_bits - 1 : secondary_bits);
+			}
+		}
+
+		for (UINT i = 0; i < BLOCK_PIXELS; i++) {
+			XMVECTOR color, alpha;
+			if (mode == 6) {
+				color = alpha = Interpolate(decoded[0], decoded[1], BC7_WEIGHTS_4[primary_indices[i]]);
+			}
+			else if (mode == 5) {
+				color = Interpolate(decoded[0], decoded[1], BC7_WEIGHTS_2[primary_indices[i]]);
+				alpha = Interpolate(decoded[0], decoded[1], BC7_WEIGHTS_2[secondary_indices[i]]);
+			}
+			else {
+				// Mode 4 uses the 3-bit indices for color when the index selection bit is set.
+				UINT weight_2 = BC7_WEIGHTS_2[primary_indices[i]];
+				UINT weight_3 = BC7_WEIGHTS_3[secondary_indices[i]];
+				color = Interpolate(decoded[0], decoded[1], index_selection ? weight_3 : weight_2);
+				alpha = Interpolate(decoded[0], decoded[1], index_selection ? weight_2 : weight_3);
+			}
+			// Swapping again undoes the rotation.
+			pixels[i] = RotateChannels(XMVectorSelect(color, alpha, g_XMSelect0001), rotation);
+		}
+	}
+
+	void DecodeBlock(DXGI_FORMAT format, const BYTE* source, block_pixels_t& pixels) {
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM:
+			DecodeBc1Color(source, false, pixels);
+			break;
+		case DXGI_FORMAT_BC3_UNORM:
+			DecodeBc1Color(source + 8, true, pixels);
+			DecodeBc3Alpha(source, pixels);
+			break;
+		default:
+			DecodeBc7(source, pixels);
+			break;
+		}
+	}
+}
+
+bool CanBlockCompress(UINT width, UINT height) {
+	return width % 4 == 0 && height % 4 == 0;
+}
+
+texture_data_t CompressTexture(const texture_data_t& source, const compression_options_t& options) {
+	if (source.format != DXGI_FORMAT_R8G8B8A8_UNORM) {
+		throw std::runtime_error("BlockCompressor: only RGBA8 textures can be compressed");
+	}
+	texture_data_t texture = CreateBlockLayout(source, options.format);
+	UINT block_size = GetBlockSize(options.format);
+	quality_settings_t quality = GetQualitySettings(options.quality);
+
+	ForEachBlockRow(texture, options.thread_count, [&](UINT level, UINT block_y) {
+		const texture_level_t& source_level = source.levels[level];
+		const texture_level_t& block_level = texture.levels[level];
+		BYTE* row = texture.data.data() + block_level.offset + std::size_t(block_y) * block_level.row_pitch;
+		block_pixels_t pixels;
+		for (UINT block_x = 0; block_x < block_level.row_pitch / block_size; block_x++) {
+			LoadBlock(source.data.data() + source_level.offset, source_level, block_x, block_y, pixels);
+			EncodeBlock(options.format, pixels, quality, row + block_x * block_size);
+		}
+	});
+	return texture;
+}
+
+texture_data_t DecompressTexture(const texture_data_t& source, UINT thread_count) {
+	UINT block_size = GetBlockSize(source.format);
+	texture_data_t texture = { .format = DXGI_FORMAT_R8G8B8A8_UNORM };
+	std::size_t size = 0;
+	for (const texture_level_t& level : source.levels) {
+		texture.levels.push_back({
+			.width = level.width,
+			.height = level.height,
+			.offset = size,
+			.row_pitch = level.width * 4,
+			.row_count = level.height
+		});
+		size += std::size_t(level.width) * 4 * level.height;
+	}
+	texture.data.resize(size);
+
+	ForEachBlockRow(source, thread_count, [&](UINT level, UINT block_y) {
+		const texture_level_t& block_level = source.levels[level];
+		const BYTE* row = source.data.data() + block_level.offset + std::size_t(block_y) * block_level.row_pitch;
+		block_pixels_t pixels;
+		for (UINT block_x = 0; block_x < block_level.row_pitch / block_size; block_x++) {
+			pixels.fill(XMVectorReplicate(255.0f));
+			DecodeBlock(source.format, row + block_x * block_size, pixels);
+			StoreBlock(pixels, texture.levels[level], block_x, block_y, texture.data.data() + texture.levels[level].offset);
+		}
+	});
+	return texture;
+}
+
+double ComputePsnr(const texture_data_t& first, const texture_data_t& second) {
+	if (first.format != DXGI_FORMAT_R8G8B8A8_UNORM || second.format != DXGI_FORMAT_R8G8B8A8_UNORM ||
+		first.levels.size() != second.levels.size()) {
+		throw std::runtime_error("BlockCompressor: PSNR needs two RGBA8 textures of the same size");
+	}
+	double squared_error = 0.0;
+	std::size_t sample_count = 0;
+	for (std::size_t level = 0; level < first.levels.size(); level++) {
+		const texture_level_t& a = first.levels[level];
+		const texture_level_t& b = second.levels[level];
+		if (a.width != b.width || a.height != b.height) {
+			throw std::runtime_error("BlockCompressor: PSNR needs two RGBA8 textures of the same size");
+		}
+		for (UINT y = 0; y < a.height; y++) {
+			const BYTE* row_a = first.data.data() + a.offset + std::size_t(y) * a.row_pitch;
+			const BYTE* row_b = second.data.data() + b.offset + std::size_t(y) * b.row_pitch;
+			for (UINT i = 0; i < a.width * 4; i++) {
+				double difference = static_cast<double>(row_a[i]) - row_b[i];
+				squared_error += difference * difference;
+			}
+		}
+		sample_count += std::size_t(a.width) * a.height * 4;
+	}
+	if (squared_error == 0.0) {
+		return std::numeric_limits<double>::infinity();
+	}
+	return 10.0 * std::log10(255.0 * 255.0 * sample_count / squared_error);
+}
@@ -0,0 +1,34 @@
+#pragma once
+
+#include "TextureData.h"
+
+enum class compression_quality_t : UINT {
+	// Endpoints along the principal axis of each block, without refinement.
+	FAST,
+	// Refines the endpoints by least squares and tries an extra BC7 mode.
+	NORMAL,
+	// Refines further from two starting points and tries every BC7 mode and rotation the encoder supports.
+	HIGH
+};
+
+struct compression_options_t {
+	// DXGI_FORMAT_BC1_UNORM, DXGI_FORMAT_BC3_UNORM or DXGI_FORMAT_BC7_UNORM.
+	DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM;
+	compression_quality_t quality = compression_quality_t::NORMAL;
+	// Rows of blocks are encoded on up to this many threads.
+	UINT thread_count = 1;
+};
+
+// D3D12 only accepts block-compressed textures whose top level is a whole number of 4x4 blocks.
+bool CanBlockCompress(UINT width, UINT height);
+
+// Encodes every level of an RGBA8 texture. BC1 drops the alpha channel. The BC7 encoder only uses the
+// single-subset modes 5 and 6.
+texture_data_t CompressTexture(const texture_data_t& source, const compression_options_t& options);
+
+// Decodes a BC1, BC3 or BC7 texture back to RGBA8. BC7 blocks in the partitioned modes 0 to 3 and 7 are
+// not supported.
+texture_data_t DecompressTexture(const texture_data_t& source, UINT thread_count);
+
+// Peak signal-to-noise ratio in dB over every channel of every level of two RGBA8 textures of the same size.
+double ComputePsnr(const texture_data_t& first, const texture_data_t& second);
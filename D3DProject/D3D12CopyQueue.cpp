@@ -0,0 +1,94 @@
+#include "pch.h"
+#include "D3D12CopyQueue.h"
+
+D3D12CopyQueue::D3D12CopyQueue(GpuMemory& memory, UINT64 staging_size) {
+	device.copy_from(memory.GetDevice());
+
+	D3D12_COMMAND_QUEUE_DESC queue_desc = {
+		.Type = D3D12_COMMAND_LIST_TYPE_COPY,
+		.Priority = D3D12_COMMAND_QUEUE_PRIORITY_NORMAL,
+		.Flags = D3D12_COMMAND_QUEUE_FLAG_NONE,
+		.NodeMask = 0
+	};
+	winrt::check_hresult(device->CreateCommandQueue(&queue_desc, IID_PPV_ARGS(command_queue.put())));
+	fence = std::make_unique<D3D12FrameFence>(device.get(), command_queue.get());
+
+	winrt::check_hresult(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+		IID_PPV_ARGS(recording_allocator.put())));
+	winrt::check_hresult(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_COPY, recording_allocator.get(),
+		nullptr, IID_PPV_ARGS(command_list.put())));
+	winrt::check_hresult(command_list->Close());
+	command_allocators.push_back({ .allocator = std::move(recording_allocator), .fence_value = 0 });
+
+	staging_buffer = memory.CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, staging_size, D3D12_RESOURCE_STATE_GENERIC_READ);
+	BYTE* data_begin = nullptr;
+	D3D12_RANGE read_range = { 0, 0 };
+	winrt::check_hresult(staging_buffer->Map(0, &read_range, reinterpret_cast<void**>(&data_begin)));
+	staging_data = { data_begin, static_cast<std::size_t>(staging_size) };
+}
+
+std::span<BYTE> D3D12CopyQueue::GetStagingData() {
+	return staging_data;
+}
+
+void D3D12CopyQueue::RecordBufferCopy(ID3D12Resource* destination, UINT64 destination_offset,
+	UINT64 staging_offset, UINT64 size) {
+	BeginRecording();
+	command_list->CopyBufferRegion(destination, destination_offset, staging_buffer.get(), staging_offset, size);
+}
+
+void D3D12CopyQueue::RecordTextureCopy(ID3D12Resource* destination, UINT subresource,
+	const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) {
+	BeginRecording();
+	D3D12_TEXTURE_COPY_LOCATION destination_location = {
+		.pResource = destination,
+		.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
+		.SubresourceIndex = subresource
+	};
+	D3D12_TEXTURE_COPY_LOCATION source_location = {
+		.pResource = staging_buffer.get(),
+		.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
+		.PlacedFootprint = footprint
+	};
+	command_list->CopyTextureRegion(&destination_location, 0, 0, 0, &source_location, nullptr);
+}
+
+void D3D12CopyQueue::Submit(UINT64 fence_value) {
+	if (recording_allocator) {
+		winrt::check_hresult(command_list->Close());
+		ID3D12CommandList* command_lists[] = { command_list.get() };
+		command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
+		command_allocators.push_back({ .allocator = std::move(recording_allocator), .fence_value = fence_value });
+		recording_allocator = nullptr;
+	}
+	fence->Signal(fence_value);
+}
+
+UINT64 D3D12CopyQueue::GetCompletedValue() {
+	return fence->GetCompletedValue();
+}
+
+void D3D12CopyQueue::WaitForValue(UINT64 value) {
+	fence->WaitForValue(value);
+}
+
+void D3D12CopyQueue::WaitOnQueue(ID3D12CommandQueue* queue, UINT64 fence_value) {
+	fence->WaitOnQueue(queue, fence_value);
+}
+
+void D3D12CopyQueue::BeginRecording() {
+	if (recording_allocator) {
+		return;
+	}
+	if (!command_allocators.empty() && command_allocators.front().fence_value <= fence->GetCompletedValue()) {
+		recording_allocator = std::move(command_allocators.front().allocator);
+		command_allocators.pop_front();
+		winrt::check_hresult(recording_allocator->Reset());
+	}
+	else {
+		// Every allocator still holds copies in flight.
+		winrt::check_hresult(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_COPY,
+			IID_PPV_ARGS(recording_allocator.put())));
+	}
+	winrt::check_hresult(command_list->Reset(recording_allocator.get(), nullptr));
+}
@@ -0,0 +1,43 @@
+#pragma once
+
+#include "UploadScheduler.h"
+#include "D3D12FrameFence.h"
+#include "GpuMemory.h"
+
+// D3D12_COMMAND_LIST_TYPE_COPY queue with its own command list and an upload buffer for staging. Resources
+// copied on it are left in the common state, from which buffers are promoted implicitly, and textures need
+// a transition on the queue that uses them.
+class D3D12CopyQueue : public CopyQueue {
+public:
+	D3D12CopyQueue(GpuMemory& memory, UINT64 staging_size);
+
+	std::span<BYTE> GetStagingData() override;
+	void RecordBufferCopy(ID3D12Resource* destination, UINT64 destination_offset, UINT64 staging_offset,
+		UINT64 size) override;
+	void RecordTextureCopy(ID3D12Resource* destination, UINT subresource,
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) override;
+	void Submit(UINT64 fence_value) override;
+	UINT64 GetCompletedValue() override;
+	void WaitForValue(UINT64 value) override;
+	// Makes another queue wait on the GPU until the batch that signals fence_value has finished.
+	void WaitOnQueue(ID3D12CommandQueue* queue, UINT64 fence_value);
+private:
+	struct command_allocator_t {
+		winrt::com_ptr<ID3D12CommandAllocator> allocator;
+		// Signalled once the copies recorded with the allocator have finished.
+		UINT64 fence_value;
+	};
+
+	winrt::com_ptr<ID3D12Device> device;
+	winrt::com_ptr<ID3D12CommandQueue> command_queue;
+	std::unique_ptr<D3D12FrameFence> fence;
+	winrt::com_ptr<ID3D12GraphicsCommandList> command_list;
+	// Oldest first; reused once their copies have finished.
+	std::deque<command_allocator_t> command_allocators;
+	winrt::com_ptr<ID3D12CommandAllocator> recording_allocator;
+	PlacedResource staging_buffer;
+	std::span<BYTE> staging_data;
+
+	// Opens the command list for the next batch, if it is not open yet.
+	void BeginRecording();
+};
@@ -0,0 +1,35 @@
+#include "pch.h"
+#include "D3D12FrameFence.h"
+
+D3D12FrameFence::D3D12FrameFence(ID3D12Device* device, ID3D12CommandQueue* command_queue) {
+	this->command_queue.copy_from(command_queue);
+	winrt::check_hresult(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence.put())));
+
+	fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
+	if (fence_event == nullptr) {
+		winrt::check_hresult(HRESULT_FROM_WIN32(GetLastError()));
+	}
+}
+
+D3D12FrameFence::~D3D12FrameFence() {
+	CloseHandle(fence_event);
+}
+
+void D3D12FrameFence::Signal(UINT64 value) {
+	winrt::check_hresult(command_queue->Signal(fence.get(), value));
+}
+
+UINT64 D3D12FrameFence::GetCompletedValue() {
+	return fence->GetCompletedValue();
+}
+
+void D3D12FrameFence::WaitForValue(UINT64 value) {
+	if (fence->GetCompletedValue() < value) {
+		winrt::check_hresult(fence->SetEventOnCompletion(value, fence_event));
+		WaitForSingleObject(fence_event, INFINITE);
+	}
+}
+
+void D3D12FrameFence::WaitOnQueue(ID3D12CommandQueue* queue, UINT64 value) {
+	winrt::check_hresult(queue->Wait(fence.get(), value));
+}
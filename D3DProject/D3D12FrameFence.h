@@ -0,0 +1,21 @@
+#pragma once
+
+#include "FrameRing.h"
+
+class D3D12FrameFence : public FrameFence {
+public:
+	D3D12FrameFence(ID3D12Device* device, ID3D12CommandQueue* command_queue);
+	~D3D12FrameFence() override;
+	D3D12FrameFence(const D3D12FrameFence&) = delete;
+	D3D12FrameFence& operator=(const D3D12FrameFence&) = delete;
+
+	void Signal(UINT64 value) override;
+	UINT64 GetCompletedValue() override;
+	void WaitForValue(UINT64 value) override;
+	// Makes another queue wait on the GPU, without blocking the CPU, until the fence has reached value.
+	void WaitOnQueue(ID3D12CommandQueue* queue, UINT64 value);
+private:
+	winrt::com_ptr<ID3D12CommandQueue> command_queue;
+	winrt::com_ptr<ID3D12Fence1> fence;
+	HANDLE fence_event;
+};
@@ -1,16 +1,92 @@
 ﻿#include "pch.h"
 #include "D3DHandler.h"
 #include "Win32Application.h"
+#include "com_utils.h"
 #include "vertex_shader.h"
 #include "pixel_shader.h"
-#include "BitmapDefinition.h"
-#include "SceneData.h"
+
+namespace {
+#if defined(_DEBUG)
+	// Milliseconds since the process was created, for startup timings.
+	double GetProcessUptime() {
+		FILETIME creation_time, exit_time, kernel_time, user_time, now;
+		winrt::check_bool(GetProcessTimes(GetCurrentProcess(), &creation_time, &exit_time, &kernel_time, &user_time));
+		GetSystemTimePreciseAsFileTime(&now);
+		auto ticks = [](const FILETIME& time) {
+			return (static_cast<UINT64>(time.dwHighDateTime) << 32) | time.dwLowDateTime;
+		};
+		return (ticks(now) - ticks(creation_time)) / 10000.0;
+	}
+
+	double GetPeakWorkingSetMiB() {
+		PROCESS_MEMORY_COUNTERS memory_counters = { .cb = sizeof(memory_counters) };
+		winrt::check_bool(GetProcessMemoryInfo(GetCurrentProcess(), &memory_counters, sizeof(memory_counters)));
+		return memory_counters.PeakWorkingSetSize / (1024.0 * 1024.0);
+	}
+#endif
+
+	template <typename T>
+	bool IsReady(const std::future<T>& future) {
+		return future.valid() && future.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
+	}
+}
 
 D3DHandler::D3DHandler(UINT width, UINT height)
-	: frame_index(0), rtv_descriptor_size(0), viewport(0.0f, 0.0f, static_cast<FLOAT>(width),
+	: frame_index(0), viewport(0.0f, 0.0f, static_cast<FLOAT>(width),
 		static_cast<FLOAT>(height)), scissor_rect(0, 0, width, height), width(width), height(height) {
-	SceneData scene_data(SCENE_PATH);
-	triangle_data = scene_data.GetTriangleData();
+	// Loading starts before the window and the device exist, and overlaps with their creation. The scene is
+	// packed in system memory, so it never waits for the device.
+	std::promise<scene_textures_t> scene_textures;
+	std::future<scene_textures_t> scene_textures_future = scene_textures.get_future();
+	scene_future = std::async(std::launch::async, [scene_textures = std::move(scene_textures)]() mutable {
+		loaded_scene_t scene = { .buffers = std::make_unique<VectorSceneSink>() };
+		scene.scene_data = std::make_unique<SceneData>(SCENE_PATH, *scene.buffers, scene_options_t{
+			.thread_count = std::thread::hardware_concurrency(),
+			.vertex_format = VERTEX_FORMAT
+		});
+		// One texture array slice per distinct texture, as materials often share one, such as the fallback.
+		scene_textures_t textures;
+		for (const scene_material_t& material : scene.scene_data->GetMaterials()) {
+			std::string path = material.diffuse_texture.empty() ? TEXTURE_PATH : material.diffuse_texture;
+			auto found = std::find(textures.paths.begin(), textures.paths.end(), path);
+			textures.material_slices.push_back(static_cast<UINT>(found - textures.paths.begin()));
+			if (found == textures.paths.end()) {
+				textures.paths.push_back(std::move(path));
+			}
+		}
+		textures.usage = scene.scene_data->ComputeTextureUsage(textures.material_slices);
+		scene_textures.set_value(std::move(textures));
+		scene.chunks = BuildSceneChunks(*scene.scene_data);
+		return scene;
+	});
+	texture_future = std::async(std::launch::async, [scene_textures = std::move(scene_textures_future)]() mutable {
+		// WIC needs COM on the loader thread as well, until the loaded texture is returned or an exception
+		// leaves the thread.
+		ComInitializer com(COINIT_MULTITHREADED);
+		winrt::check_hresult(com.GetResult());
+		// The materials of the scene name the textures.
+		scene_textures_t textures = scene_textures.get();
+#if defined(_DEBUG)
+		auto start = std::chrono::steady_clock::now();
+#endif
+		loaded_texture_t loaded = {
+			.texture = std::make_unique<TextureArray>(textures.paths, texture_options_t{
+				.thread_count = std::thread::hardware_concurrency()
+			}, texture_batch_options_t{
+				.worker_count = std::thread::hardware_concurrency()
+			}),
+			.material_slices = std::move(textures.material_slices)
+		};
+		loaded.mip_streamer = std::make_unique<MipStreamer>(loaded.texture->GetLevels(), textures.usage,
+			MIP_STREAMING);
+#if defined(_DEBUG)
+		OutputDebugStringA(std::format("D3DHandler: texture loaded from the {} in {:.1f} ms, peak working set "
+			"{:.1f} MiB\n", loaded.texture->IsCached() ? "cache" : "source",
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+			GetPeakWorkingSetMiB()).c_str());
+#endif
+		return loaded;
+	});
 }
 
 void D3DHandler::OnInit() {
@@ -19,20 +95,43 @@ void D3DHandler::OnInit() {
 }
 
 void D3DHandler::OnRender() {
+	AttachLoadedAssets();
+
 	PopulateCommandList();
 
+	if (pending_upload_ticket) {
+		// The frame waits on the GPU for the copies of the assets that it draws, which the CPU does not.
+		upload_scheduler->Flush();
+		copy_queue->WaitOnQueue(command_queue.get(), *pending_upload_ticket);
+		pending_upload_ticket.reset();
+	}
 	ID3D12CommandList* command_lists[] = { command_list.get() };
 	command_queue->ExecuteCommandLists(_countof(command_lists), command_lists);
 
 	winrt::check_hresult(swap_chain->Present(1, 0));
 
-	WaitForPreviousFrame();
+	MoveToNextFrame();
+
+	StreamTextureLevels();
+
+	if (!frame_presented) {
+		frame_presented = true;
+#if defined(_DEBUG)
+		OutputDebugStringA(std::format("D3DHandler: first frame presented {:.1f} ms after process start\n",
+			GetProcessUptime()).c_str());
+#endif
+	}
 }
 
 void D3DHandler::OnDestroy() {
-	WaitForPreviousFrame();
+	frame_ring->WaitForIdle();
+	upload_scheduler->WaitForIdle();
 
-	CloseHandle(fence_event);
+#if defined(_DEBUG)
+	const frame_ring_stats_t& stats = frame_ring->GetStats();
+	OutputDebugStringA(std::format("D3DHandler: {} frames, {} waited for the GPU for {:.1f} ms in total\n",
+		stats.frames, stats.stalls, stats.stall_time).c_str());
+#endif
 }
 
 void D3DHandler::LoadPipeline() {
@@ -54,6 +153,7 @@ void D3DHandler::LoadPipeline() {
 	winrt::check_hresult(CreateDXGIFactory2(dxgi_factory_flags, IID_PPV_ARGS(factory.put())));
 
 	CreateDevice();
+	gpu_memory = std::make_unique<GpuMemory>(device.get());
 
 	CreateCommandQueue();
 
@@ -65,7 +165,7 @@ void D3DHandler::LoadPipeline() {
 
 	CreateFrameResources();
 
-	CreateCommandAllocator();
+	CreateCommandAllocators();
 }
 
 void D3DHandler::LoadAssets() {
@@ -75,28 +175,120 @@ void D3DHandler::LoadAssets() {
 
 	CreateCommandList();
 
-	CreateVertexBuffer();
+	CreateUploadRing();
 
-	CreateConstantBuffer();
+	CreateUploadScheduler();
 
 	CreateDepthBuffer();
 
-	CreateTextureAndSynchronizationResources();
+	CreateSynchronizationResources();
+}
+
+void D3DHandler::AttachLoadedAssets() {
+	if (IsReady(scene_future)) {
+		loaded_scene_t scene = scene_future.get();
+		CreateVertexBuffer(scene);
+	}
+	if (IsReady(texture_future)) {
+		loaded_texture_t loaded = texture_future.get();
+		texture = std::move(loaded.texture);
+		mip_streamer = std::move(loaded.mip_streamer);
+		material_slices = std::move(loaded.material_slices);
+		CreateTexture(mip_streamer->GetBootLevel());
+		streaming_start = std::chrono::steady_clock::now();
+	}
+
+	if (!assets_loaded && !scene_future.valid() && !texture_future.valid()) {
+		assets_loaded = true;
+#if defined(_DEBUG)
+		OutputDebugStringA(std::format("D3DHandler: full scene ready {:.1f} ms after process start, "
+			"peak working set {:.1f} MiB\n", GetProcessUptime(), GetPeakWorkingSetMiB()).c_str());
+		const upload_stats_t& upload_stats = upload_scheduler->GetStats();
+		OutputDebugStringA(std::format("D3DHandler: {:.1f} MiB uploaded on the copy queue in {} batches, {} waits "
+			"for the staging buffer took {:.1f} ms\n", upload_stats.bytes / (1024.0 * 1024.0), upload_stats.batches,
+			upload_stats.stalls, upload_stats.stall_time).c_str());
+		gpu_memory->LogStats();
+		descriptor_heap->LogStats("shader-visible");
+#endif
+	}
+}
+
+// Called once the context of the next frame is free, so that the levels that its last frame copied can be
+// sampled from the frames after it.
+void D3DHandler::StreamTextureLevels() {
+	if (!mip_streamer) {
+		return;
+	}
+
+	frame_context_t& frame = frame_contexts[frame_ring->GetFrameIndex()];
+	if (frame.level_uploads) {
+		for (const mip_upload_t& upload : frame.level_uploads->uploads) {
+			mip_streamer->CompleteUpload(upload);
+		}
+		frame.level_uploads.reset();
+	}
+	if (IsReady(level_uploads_future)) {
+		level_uploads = level_uploads_future.get();
+	}
+	else if (!level_uploads_future.valid()) {
+		std::vector<mip_upload_t> uploads = mip_streamer->ScheduleUploads();
+		if (!uploads.empty()) {
+			level_uploads_future = std::async(std::launch::async, [&memory = *gpu_memory,
+				texture_desc = texture_resource->GetDesc(), &source = *texture, uploads = std::move(uploads)]() mutable {
+				return PrepareLevelUploads(memory, texture_desc, source, std::move(uploads));
+			});
+		}
+	}
+
+	bool at_target = mip_streamer->IsAtTarget();
+	if (at_target && !textures_at_target) {
+#if defined(_DEBUG)
+		const mip_streaming_stats_t& stats = mip_streamer->GetStats();
+		OutputDebugStringA(std::format("D3DHandler: textures streamed to the target resolution in {:.1f} ms, "
+			"{:.1f} MiB resident, {:.1f} MiB streamed in total\n",
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - streaming_start).count(),
+			mip_streamer->GetResidentSize() / (1024.0 * 1024.0), stats.upload_bytes / (1024.0 * 1024.0)).c_str());
+#endif
+	}
+	else if (!at_target && textures_at_target) {
+		streaming_start = std::chrono::steady_clock::now();
+	}
+	textures_at_target = at_target;
 }
 
 void D3DHandler::PopulateCommandList() {
-	winrt::check_hresult(command_allocator->Reset());
-	winrt::check_hresult(command_list->Reset(command_allocator.get(), pipeline_state.get()));
+	const UINT frame_context = frame_ring->GetFrameIndex();
+	frame_context_t& frame = frame_contexts[frame_context];
+	winrt::check_hresult(frame.command_allocator->Reset());
+	winrt::check_hresult(command_list->Reset(frame.command_allocator.get(), pipeline_state.get()));
+
+	if (texture_barrier_pending) {
+		auto texture_barrier = CD3DX12_RESOURCE_BARRIER::Transition(texture_resource.get(),
+			D3D12_RESOURCE_STATE_COMMON, D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE);
+		command_list->ResourceBarrier(1, &texture_barrier);
+		texture_barrier_pending = false;
+	}
+	if (level_uploads) {
+		UINT mip_levels = static_cast<UINT>(texture->GetLevels().size());
+		std::vector<D3D12_RESOURCE_BARRIER> barriers;
+		for (const mip_upload_t& upload : level_uploads->uploads) {
+			barriers.push_back(CD3DX12_RESOURCE_BARRIER::Transition(texture_resource.get(),
+				D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE, D3D12_RESOURCE_STATE_COPY_DEST,
+				upload.level + upload.texture * mip_levels));
+		}
+		command_list->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		RecordLevelUploads(*level_uploads);
+		for (D3D12_RESOURCE_BARRIER& barrier : barriers) {
+			std::swap(barrier.Transition.StateBefore, barrier.Transition.StateAfter);
+		}
+		command_list->ResourceBarrier(static_cast<UINT>(barriers.size()), barriers.data());
+		// The upload buffer lives as long as the frame that copies from it.
+		frame.level_uploads = std::move(level_uploads);
+		level_uploads.reset();
+	}
 
 	command_list->SetGraphicsRootSignature(root_signature.get());
 
-	ID3D12DescriptorHeap* heaps[] = { cbv_heap.get() };
-	command_list->SetDescriptorHeaps(_countof(heaps), heaps);
-	D3D12_GPU_DESCRIPTOR_HANDLE gpu_desc_handle = cbv_heap->GetGPUDescriptorHandleForHeapStart();
-	command_list->SetGraphicsRootDescriptorTable(0, gpu_desc_handle);
-	gpu_desc_handle.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	command_list->SetGraphicsRootDescriptorTable(1, gpu_desc_handle);
-
 	command_list->RSSetViewports(1, &viewport);
 	command_list->RSSetScissorRects(1, &scissor_rect);
 
@@ -104,17 +296,31 @@ void D3DHandler::PopulateCommandList() {
 		D3D12_RESOURCE_STATE_PRESENT, D3D12_RESOURCE_STATE_RENDER_TARGET);
 	command_list->ResourceBarrier(1, &barrier);
 
-	CD3DX12_CPU_DESCRIPTOR_HANDLE rtv_handle(rtv_heap->GetCPUDescriptorHandleForHeapStart(),
-		frame_index, rtv_descriptor_size);
-	CD3DX12_CPU_DESCRIPTOR_HANDLE dsv_handle(dsv_heap->GetCPUDescriptorHandleForHeapStart());
+	D3D12_CPU_DESCRIPTOR_HANDLE rtv_handle = rtv_handles[frame_index];
 	command_list->OMSetRenderTargets(1, &rtv_handle, FALSE, &dsv_handle);
 
 	const float clearColor[] = { 0.0f, 0.2f, 0.4f, 1.0f };
 	command_list->ClearRenderTargetView(rtv_handle, clearColor, 0, nullptr);
 	command_list->ClearDepthStencilView(dsv_handle, D3D12_CLEAR_FLAG_DEPTH, 1.0f, 0, 0, nullptr);
-	command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
-	command_list->IASetVertexBuffers(0, 1, &vertex_buffer_view);
-	command_list->DrawInstanced(static_cast<UINT>(triangle_data.size()), 1, 0, 0);
+
+	// Until the assets are loaded the frame is only cleared.
+	if (assets_loaded) {
+		ID3D12DescriptorHeap* heaps[] = { descriptor_heap->get() };
+		command_list->SetDescriptorHeaps(_countof(heaps), heaps);
+		command_list->SetGraphicsRootConstantBufferView(0, const_buffer_address);
+		// The table of the frame is gathered from the staged views, the texture first.
+		D3D12_CPU_DESCRIPTOR_HANDLE table[] = { texture_view, material_views[frame_context] };
+		command_list->SetGraphicsRootDescriptorTable(1, descriptor_heap->CopyTransient(table).gpu);
+
+		command_list->IASetPrimitiveTopology(D3D_PRIMITIVE_TOPOLOGY_TRIANGLELIST);
+		D3D12_VERTEX_BUFFER_VIEW vertex_buffer_views[CONSTANT_COLOR_SLOT + 1] = { vertex_buffer_view };
+		vertex_buffer_views[CONSTANT_COLOR_SLOT] = constant_color_buffer_view;
+		command_list->IASetVertexBuffers(0, VERTEX_FORMAT.color ? 1 : _countof(vertex_buffer_views), vertex_buffer_views);
+		command_list->IASetIndexBuffer(&index_buffer_view);
+		for (const draw_range_t& range : draw_ranges) {
+			command_list->DrawIndexedInstanced(range.index_count, 1, range.first_index, 0, 0);
+		}
+	}
 
 	barrier = CD3DX12_RESOURCE_BARRIER::Transition(render_targets[frame_index].get(),
 		D3D12_RESOURCE_STATE_RENDER_TARGET, D3D12_RESOURCE_STATE_PRESENT);
@@ -123,15 +329,15 @@ void D3DHandler::PopulateCommandList() {
 	winrt::check_hresult(command_list->Close());
 }
 
-void D3DHandler::WaitForPreviousFrame() {
-	const UINT64 fence_tmp = fence_value;
-	winrt::check_hresult(command_queue->Signal(fence.get(), fence_tmp));
-	fence_value++;
-
-	if (fence->GetCompletedValue() < fence_tmp) {
-		winrt::check_hresult(fence->SetEventOnCompletion(fence_tmp, fence_event));
-		WaitForSingleObject(fence_event, INFINITE);
-	}
+// Only waits for the GPU when it is FRAME_COUNT - 1 frames behind, so that the next frame is recorded while
+// the previous ones execute.
+void D3DHandler::MoveToNextFrame() {
+	upload_ring->EndFrame(frame_ring->GetFrameFenceValue());
+	frame_ring->NextFrame();
+	UINT64 completed_fence_value = frame_fence->GetCompletedValue();
+	upload_ring->Reclaim(completed_fence_value);
+	descriptor_heap->Reclaim(completed_fence_value);
+	descriptor_heap->BeginFrame(frame_ring->GetFrameIndex());
 
 	frame_index = swap_chain->GetCurrentBackBufferIndex();
 }
@@ -142,6 +348,16 @@ void D3DHandler::CreateDevice() {
 		D3D_FEATURE_LEVEL_12_0,
 		IID_PPV_ARGS(device.put())
 	));
+
+#if defined(_DEBUG)
+	// Stops in the debugger at the first error or corruption that the debug layer reports, while the call
+	// that caused it is still on the stack. Without a debugger the messages are only logged.
+	winrt::com_ptr<ID3D12InfoQueue> info_queue = device.try_as<ID3D12InfoQueue>();
+	if (info_queue && IsDebuggerPresent()) {
+		info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_CORRUPTION, TRUE);
+		info_queue->SetBreakOnSeverity(D3D12_MESSAGE_SEVERITY_ERROR, TRUE);
+	}
+#endif
 }
 
 void D3DHandler::CreateCommandQueue() {
@@ -178,58 +394,37 @@ void D3DHandler::CreateSwapChain(IDXGIFactory7* factory) {
 }
 
 void D3DHandler::CreateDescriptorHeaps() {
-	D3D12_DESCRIPTOR_HEAP_DESC rtv_heap_desc = {};
-	rtv_heap_desc.NumDescriptors = FRAME_COUNT;
-	rtv_heap_desc.Type = D3D12_DESCRIPTOR_HEAP_TYPE_RTV;
-	rtv_heap_desc.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE;
-	winrt::check_hresult(device->CreateDescriptorHeap(&rtv_heap_desc, IID_PPV_ARGS(rtv_heap.put())));
-
-	rtv_descriptor_size = device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_RTV);
-
-	D3D12_DESCRIPTOR_HEAP_DESC descriptor_heap_desc = {
-		.Type = D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
-		.NumDescriptors = 2,
-		.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE,
-		.NodeMask = 0
-	};
-	winrt::check_hresult(device->CreateDescriptorHeap(&descriptor_heap_desc, IID_PPV_ARGS(cbv_heap.put())));
-
-	D3D12_DESCRIPTOR_HEAP_DESC dsv_heap_desc = {
-		.Type = D3D12_DESCRIPTOR_HEAP_TYPE_DSV,
-		.NumDescriptors = 1,
-		.Flags = D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
-		.NodeMask = 0
-	};
-	winrt::check_hresult(device->CreateDescriptorHeap(&dsv_heap_desc, IID_PPV_ARGS(dsv_heap.put())));
+	rtv_heap = std::make_unique<DescriptorHeap>(device.get(), D3D12_DESCRIPTOR_HEAP_TYPE_RTV,
+		descriptor_heap_options_t{ .persistent_count = FRAME_COUNT });
+	dsv_heap = std::make_unique<DescriptorHeap>(device.get(), D3D12_DESCRIPTOR_HEAP_TYPE_DSV,
+		descriptor_heap_options_t{ .persistent_count = 1 });
+	descriptor_heap = std::make_unique<DescriptorHeap>(device.get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+		SHADER_DESCRIPTORS);
+	staging_heap = std::make_unique<DescriptorHeap>(device.get(), D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV,
+		STAGING_DESCRIPTORS);
 }
 
 void D3DHandler::CreateFrameResources() {
-	D3D12_CPU_DESCRIPTOR_HANDLE rtvHandle = rtv_heap->GetCPUDescriptorHandleForHeapStart();
-
 	for (UINT n = 0; n < FRAME_COUNT; n++) {
 		winrt::check_hresult(swap_chain->GetBuffer(n, IID_PPV_ARGS(render_targets[n].put())));
-		device->CreateRenderTargetView(render_targets[n].get(), nullptr, rtvHandle);
-		rtvHandle.ptr += rtv_descriptor_size;
+		rtv_handles[n] = rtv_heap->AllocatePersistent().cpu;
+		device->CreateRenderTargetView(render_targets[n].get(), nullptr, rtv_handles[n]);
 	}
 }
 
-void D3DHandler::CreateCommandAllocator() {
-	winrt::check_hresult(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
-		IID_PPV_ARGS(command_allocator.put())));
+void D3DHandler::CreateCommandAllocators() {
+	for (frame_context_t& frame : frame_contexts) {
+		winrt::check_hresult(device->CreateCommandAllocator(D3D12_COMMAND_LIST_TYPE_DIRECT,
+			IID_PPV_ARGS(frame.command_allocator.put())));
+	}
 }
 
 void D3DHandler::CreateRootSignature() {
 	D3D12_DESCRIPTOR_RANGE descriptor_ranges[] = {
 	{
-		.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_CBV,
-		.NumDescriptors = 1,
-		.BaseShaderRegister = 0,
-		.RegisterSpace = 0,
-		.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND
-	},
-	{
+		// The texture array and the material buffer.
 		.RangeType = D3D12_DESCRIPTOR_RANGE_TYPE_SRV,
-		.NumDescriptors = 1,
+		.NumDescriptors = 2,
 		.BaseShaderRegister = 0,
 		.RegisterSpace = 0,
 		.OffsetInDescriptorsFromTableStart = D3D12_DESCRIPTOR_RANGE_OFFSET_APPEND
@@ -237,13 +432,14 @@ void D3DHandler::CreateRootSignature() {
 	};
 	D3D12_ROOT_PARAMETER root_parameters[] = {
 		{
-			.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE,
-			.DescriptorTable = { 1, descriptor_ranges },
+			// Set for every frame from the upload ring, so that it needs no descriptor.
+			.ParameterType = D3D12_ROOT_PARAMETER_TYPE_CBV,
+			.Descriptor = { .ShaderRegister = 0, .RegisterSpace = 0 },
 			.ShaderVisibility = D3D12_SHADER_VISIBILITY_VERTEX
 		},
 		{
 			.ParameterType = D3D12_ROOT_PARAMETER_TYPE_DESCRIPTOR_TABLE,
-			.DescriptorTable = { 1, descriptor_ranges + 1 },
+			.DescriptorTable = { 1, descriptor_ranges },
 			.ShaderVisibility = D3D12_SHADER_VISIBILITY_PIXEL
 		}
 	};
@@ -278,38 +474,10 @@ void D3DHandler::CreateRootSignature() {
 }
 
 void D3DHandler::CreatePipelineState() {
-	D3D12_INPUT_ELEMENT_DESC input_element_descs[] = {
-		{
-			.SemanticName = "POSITION",
-			.SemanticIndex = 0,
-			.Format = DXGI_FORMAT_R32G32B32_FLOAT,
-			.InputSlot = 0,
-			.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
-			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
-			.InstanceDataStepRate = 0
-		},
-		{
-			.SemanticName = "COLOR",
-			.SemanticIndex = 0,
-			.Format = DXGI_FORMAT_R32G32B32A32_FLOAT,
-			.InputSlot = 0,
-			.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
-			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
-			.InstanceDataStepRate = 0
-		},
-		{
-			.SemanticName = "TEXCOORD",
-			.SemanticIndex = 0,
-			.Format = DXGI_FORMAT_R32G32_FLOAT,
-			.InputSlot = 0,
-			.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
-			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
-			.InstanceDataStepRate = 0
-		},
-	};
+	std::vector<D3D12_INPUT_ELEMENT_DESC> input_element_descs = GetInputElementDescs(VERTEX_FORMAT);
 
 	D3D12_GRAPHICS_PIPELINE_STATE_DESC pso_desc = {};
-	pso_desc.InputLayout = { input_element_descs, _countof(input_element_descs) };
+	pso_desc.InputLayout = { input_element_descs.data(), static_cast<UINT>(input_element_descs.size()) };
 	pso_desc.pRootSignature = root_signature.get();
 	pso_desc.VS = { vs_main, sizeof(vs_main) };
 	pso_desc.PS = { ps_main, sizeof(ps_main) };
@@ -375,88 +543,58 @@ void D3DHandler::CreatePipelineState() {
 }
 
 void D3DHandler::CreateCommandList() {
-	winrt::check_hresult(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT, command_allocator.get(),
-		pipeline_state.get(), IID_PPV_ARGS(command_list.put())));
+	winrt::check_hresult(device->CreateCommandList(0, D3D12_COMMAND_LIST_TYPE_DIRECT,
+		frame_contexts[0].command_allocator.get(), pipeline_state.get(), IID_PPV_ARGS(command_list.put())));
+	winrt::check_hresult(command_list->Close());
 }
 
-void D3DHandler::CreateVertexBuffer() {
-	D3D12_HEAP_PROPERTIES heap_properties = {
-		.Type = D3D12_HEAP_TYPE_UPLOAD,
-		.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-		.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
-		.CreationNodeMask = 1,
-		.VisibleNodeMask = 1
-	};
-	D3D12_RESOURCE_DESC resource_desc = {
-		.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
-		.Alignment = 0,
-		.Width = triangle_data.size() * sizeof(vertex_t),
-		.Height = 1,
-		.DepthOrArraySize = 1,
-		.MipLevels = 1,
-		.Format = DXGI_FORMAT_UNKNOWN,
-		.SampleDesc = {.Count = 1, .Quality = 0 },
-		.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
-		.Flags = D3D12_RESOURCE_FLAG_NONE
-	};
-
-	device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(vertex_buffer.put()));
-
-	UINT8* vertex_data_begin = nullptr;
-	D3D12_RANGE read_range = { 0, 0 };
-	winrt::check_hresult(vertex_buffer->Map(0, &read_range, reinterpret_cast<void**>(&vertex_data_begin)));
-	memcpy(vertex_data_begin, triangle_data.data(), triangle_data.size() * sizeof(vertex_t));
-	vertex_buffer->Unmap(0, nullptr);
+void D3DHandler::CreateVertexBuffer(loaded_scene_t& scene) {
+	SceneData& scene_data = *scene.scene_data;
+	// The buffer holds every level of detail, of which UpdateDrawRanges picks one for each chunk to draw,
+	// one meshlet range at a time.
+	scene_chunks = std::move(scene.chunks);
+	position_dequantization = scene_data.GetPositionDequantization();
 
+	vertex_buffer = CreateStaticBuffer(scene_data.GetVertexData());
 	vertex_buffer_view.BufferLocation = vertex_buffer->GetGPUVirtualAddress();
-	vertex_buffer_view.StrideInBytes = sizeof(vertex_t);
-	vertex_buffer_view.SizeInBytes = static_cast<UINT>(triangle_data.size()) * sizeof(vertex_t);
+	vertex_buffer_view.StrideInBytes = scene_data.GetVertexStride();
+	vertex_buffer_view.SizeInBytes = static_cast<UINT>(scene_data.GetVertexData().size());
+
+	index_buffer = CreateStaticBuffer(scene_data.GetIndexData());
+	index_buffer_view.BufferLocation = index_buffer->GetGPUVirtualAddress();
+	index_buffer_view.Format = scene_data.GetIndexFormat();
+	index_buffer_view.SizeInBytes = static_cast<UINT>(scene_data.GetIndexData().size());
+
+	if (!VERTEX_FORMAT.color) {
+		constant_color_buffer = CreateStaticBuffer(
+			{ reinterpret_cast<const BYTE*>(&CONSTANT_COLOR), sizeof(CONSTANT_COLOR) });
+		constant_color_buffer_view.BufferLocation = constant_color_buffer->GetGPUVirtualAddress();
+		constant_color_buffer_view.StrideInBytes = sizeof(CONSTANT_COLOR);
+		constant_color_buffer_view.SizeInBytes = sizeof(CONSTANT_COLOR);
+	}
 }
 
-void D3DHandler::CreateConstantBuffer() {
-	D3D12_HEAP_PROPERTIES heap_properties = {
-		.Type = D3D12_HEAP_TYPE_UPLOAD,
-		.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-		.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
-		.CreationNodeMask = 1,
-		.VisibleNodeMask = 1
-	};
-	D3D12_RESOURCE_DESC resource_desc = {
-		.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
-		.Alignment = 0,
-		.Width = CONST_BUFFER_SIZE,
-		.Height = 1,
-		.DepthOrArraySize = 1,
-		.MipLevels = 1,
-		.Format = DXGI_FORMAT_UNKNOWN,
-		.SampleDesc = {.Count = 1, .Quality = 0 },
-		.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
-		.Flags = D3D12_RESOURCE_FLAG_NONE
-	};
-	device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ, nullptr, IID_PPV_ARGS(constant_buffer.put()));
+// The buffer is left in the common state, from which the draws promote it implicitly.
+PlacedResource D3DHandler::CreateStaticBuffer(std::span<const BYTE> data) {
+	PlacedResource buffer = gpu_memory->CreateBuffer(D3D12_HEAP_TYPE_DEFAULT, data.size(), D3D12_RESOURCE_STATE_COMMON);
+	upload_ticket_t ticket = upload_scheduler->UploadBuffer(buffer.get(), 0, data);
+	pending_upload_ticket = std::max(pending_upload_ticket.value_or(0), ticket);
+	return buffer;
+}
 
-	D3D12_CONSTANT_BUFFER_VIEW_DESC cbv_desc = {
-		.BufferLocation = constant_buffer->GetGPUVirtualAddress(),
-		.SizeInBytes = CONST_BUFFER_SIZE
-	};
-	device->CreateConstantBufferView(&cbv_desc, cbv_heap->GetCPUDescriptorHandleForHeapStart());
+void D3DHandler::CreateUploadRing() {
+	upload_ring = std::make_unique<UploadRing>(*gpu_memory, UPLOAD_RING_SIZE);
 
 	XMStoreFloat4x4(&const_buffer_data.matWorldViewProj, XMMatrixIdentity());
-	D3D12_RANGE read_range = { 0, 0 };
-	winrt::check_hresult(constant_buffer->Map(0, &read_range, reinterpret_cast<void**>(&cbv_data_begin)));
-	memcpy(cbv_data_begin, &const_buffer_data, sizeof(const_buffer_data));
+	const_buffer_address = upload_ring->Upload(const_buffer_data);
+}
+
+void D3DHandler::CreateUploadScheduler() {
+	copy_queue = std::make_unique<D3D12CopyQueue>(*gpu_memory, STAGING_RING_SIZE);
+	upload_scheduler = std::make_unique<UploadScheduler>(*copy_queue);
 }
 
 void D3DHandler::CreateDepthBuffer() {
-	D3D12_HEAP_PROPERTIES heap_properties = {
-		.Type = D3D12_HEAP_TYPE_DEFAULT,
-		.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-		.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
-		.CreationNodeMask = 1,
-		.VisibleNodeMask = 1
-	};
 	D3D12_RESOURCE_DESC resource_desc = {
 		.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D,
 		.Alignment = 0,
@@ -473,8 +611,8 @@ void D3DHandler::CreateDepthBuffer() {
 		.Format = DXGI_FORMAT_D32_FLOAT,
 		.DepthStencil = {.Depth = 1.0f, .Stencil = 0 }
 	};
-	device->CreateCommittedResource(&heap_properties, D3D12_HEAP_FLAG_NONE, &resource_desc,
-		D3D12_RESOURCE_STATE_DEPTH_WRITE, &clear_value, IID_PPV_ARGS(depth_buffer.put()));
+	depth_buffer = gpu_memory->CreateResource(D3D12_HEAP_TYPE_DEFAULT, resource_desc, D3D12_RESOURCE_STATE_DEPTH_WRITE,
+		&clear_value);
 
 	D3D12_DEPTH_STENCIL_VIEW_DESC dsv_desc = {
 		.Format = DXGI_FORMAT_D32_FLOAT,
@@ -482,169 +620,208 @@ void D3DHandler::CreateDepthBuffer() {
 		.Flags = D3D12_DSV_FLAG_NONE,
 		.Texture2D = {}
 	};
-	device->CreateDepthStencilView(depth_buffer.get(), &dsv_desc, dsv_heap->GetCPUDescriptorHandleForHeapStart());
+	dsv_handle = dsv_heap->AllocatePersistent().cpu;
+	device->CreateDepthStencilView(depth_buffer.get(), &dsv_desc, dsv_handle);
 }
 
-void D3DHandler::CreateTextureAndSynchronizationResources() {
-	winrt::com_ptr<IWICImagingFactory2> imaging_factory;
-	winrt::check_hresult(CoCreateInstance(
-		CLSID_WICImagingFactory2,
-		nullptr,
-		CLSCTX_INPROC_SERVER,
-		IID_PPV_ARGS(imaging_factory.put())
-	));
-	BitmapDefinition texture_bitmap(TEXTURE_PATH);
-	UINT bmp_width, bmp_height;
-	texture_bitmap.CreateDeviceIndependentResources(imaging_factory.get());
-	auto bmp_bits = texture_bitmap.GetBitmapAsBytes(&bmp_width, &bmp_height);
-
-	D3D12_HEAP_PROPERTIES tex_heap_prop = {
-		.Type = D3D12_HEAP_TYPE_DEFAULT,
-		.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-		.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
-		.CreationNodeMask = 1,
-		.VisibleNodeMask = 1
-	};
+void D3DHandler::CreateSynchronizationResources() {
+	frame_fence = std::make_unique<D3D12FrameFence>(device.get(), command_queue.get());
+	frame_ring = std::make_unique<FrameRing>(*frame_fence, FRAME_COUNT);
+}
+
+void D3DHandler::CreateTexture(UINT first_level) {
+	std::span<const texture_level_t> levels = texture->GetLevels();
+	UINT mip_levels = static_cast<UINT>(levels.size());
+	UINT slice_count = texture->GetSliceCount();
+
 	D3D12_RESOURCE_DESC tex_resource_desc = {
 		.Dimension = D3D12_RESOURCE_DIMENSION_TEXTURE2D,
 		.Alignment = 0,
-		.Width = bmp_width,
-		.Height = bmp_height,
-		.DepthOrArraySize = 1,
-		.MipLevels = 1,
-		.Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+		.Width = levels[0].width,
+		.Height = levels[0].height,
+		.DepthOrArraySize = static_cast<UINT16>(slice_count),
+		.MipLevels = static_cast<UINT16>(mip_levels),
+		.Format = texture->GetFormat(),
 		.SampleDesc = {.Count = 1, .Quality = 0 },
 		.Layout = D3D12_TEXTURE_LAYOUT_UNKNOWN,
 		.Flags = D3D12_RESOURCE_FLAG_NONE
 	};
-	device->CreateCommittedResource(
-		&tex_heap_prop, D3D12_HEAP_FLAG_NONE,
-		&tex_resource_desc, D3D12_RESOURCE_STATE_COPY_DEST,
-		nullptr, IID_PPV_ARGS(&texture_resource)
-	);
-
-	winrt::com_ptr<ID3D12Resource> texture_upload_buffer = nullptr;
-	UINT64 required_size = 0;
-	auto desc = texture_resource->GetDesc();
-	ID3D12Device* helper_device = nullptr;
-	texture_resource->GetDevice(__uuidof(*helper_device), reinterpret_cast<void**>(&helper_device));
-	helper_device->GetCopyableFootprints(&desc, 0, 1, 0, nullptr, nullptr, nullptr, &required_size);
-	helper_device->Release();
-
-	D3D12_HEAP_PROPERTIES tex_upload_heap_prop = {
-		.Type = D3D12_HEAP_TYPE_UPLOAD,
-		.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
-		.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
-		.CreationNodeMask = 1,
-		.VisibleNodeMask = 1
-	};
-	D3D12_RESOURCE_DESC tex_upload_resource_desc = {
-		.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
-		.Alignment = 0,
-		.Width = required_size,
-		.Height = 1,
-		.DepthOrArraySize = 1,
-		.MipLevels = 1,
-		.Format = DXGI_FORMAT_UNKNOWN,
-		.SampleDesc = {.Count = 1, .Quality = 0 },
-		.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
-		.Flags = D3D12_RESOURCE_FLAG_NONE
-	};
-	device->CreateCommittedResource(
-		&tex_upload_heap_prop, D3D12_HEAP_FLAG_NONE,
-		&tex_upload_resource_desc,
-		D3D12_RESOURCE_STATE_GENERIC_READ,
-		nullptr, IID_PPV_ARGS(&texture_upload_buffer)
-	);
-
-	D3D12_SUBRESOURCE_DATA texture_data = {
-		.pData = bmp_bits,
-		.RowPitch = bmp_width * BMP_PX_SIZE,
-		.SlicePitch = bmp_width * bmp_height * BMP_PX_SIZE
-	};
-	UINT const MAX_SUBRESOURCES = 1;
-	required_size = 0;
-	D3D12_PLACED_SUBRESOURCE_FOOTPRINT layouts[MAX_SUBRESOURCES];
-	UINT num_rows[MAX_SUBRESOURCES];
-	UINT64 row_sizes_in_bytes[MAX_SUBRESOURCES];
-	desc = texture_resource->GetDesc();
-	helper_device = nullptr;
-	texture_resource->GetDevice(__uuidof(*helper_device), reinterpret_cast<void**>(&helper_device));
-	helper_device->GetCopyableFootprints(&desc, 0, 1, 0, layouts, num_rows, row_sizes_in_bytes, &required_size);
-	helper_device->Release();
-
-	BYTE* map_tex_data = nullptr;
-	texture_upload_buffer->Map(0, nullptr, reinterpret_cast<void**>(&map_tex_data));
-	D3D12_MEMCPY_DEST dest_data = {
-		.pData = map_tex_data + layouts[0].Offset,
-		.RowPitch = layouts[0].Footprint.RowPitch,
-		.SlicePitch = SIZE_T(layouts[0].Footprint.RowPitch) * SIZE_T(num_rows[0])
-	};
-	for (UINT z = 0; z < layouts[0].Footprint.Depth; ++z) {
-		auto dest_slice = static_cast<UINT8*>(dest_data.pData) + dest_data.SlicePitch * z;
-		auto src_slice = static_cast<const UINT8*>(texture_data.pData) + texture_data.SlicePitch * LONG_PTR(z);
-		for (UINT y = 0; y < num_rows[0]; ++y) {
-			memcpy(
-				dest_slice + dest_data.RowPitch * y,
-				src_slice + texture_data.RowPitch * LONG_PTR(y),
-				static_cast<SIZE_T>(row_sizes_in_bytes[0])
-			);
+	texture_resource = gpu_memory->CreateResource(D3D12_HEAP_TYPE_DEFAULT, tex_resource_desc,
+		D3D12_RESOURCE_STATE_COMMON);
+
+	// Copied on the copy queue, which the first frame that samples the texture waits for, and transitioned
+	// by that frame.
+	upload_ticket_t ticket = 0;
+	for (UINT slice = 0; slice < slice_count; slice++) {
+		std::span<const BYTE> slice_data = texture->GetSliceData(slice);
+		for (UINT level = first_level; level < mip_levels; level++) {
+			UINT subresource = level + slice * mip_levels;
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint;
+			UINT num_rows = 0;
+			UINT64 row_size = 0;
+			device->GetCopyableFootprints(&tex_resource_desc, subresource, 1, 0, &footprint, &num_rows, &row_size,
+				nullptr);
+			ticket = upload_scheduler->UploadTexture(texture_resource.get(), subresource, footprint, num_rows,
+				row_size, slice_data.data() + levels[level].offset, levels[level].row_pitch);
 		}
 	}
-	texture_upload_buffer->Unmap(0, nullptr);
-
-	D3D12_TEXTURE_COPY_LOCATION dst = {
-		.pResource = texture_resource.get(),
-		.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
-		.SubresourceIndex = 0
-	};
-	D3D12_TEXTURE_COPY_LOCATION src = {
-		.pResource = texture_upload_buffer.get(),
-		.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
-		.PlacedFootprint = layouts[0]
-	};
-	command_list->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
-	D3D12_RESOURCE_BARRIER tex_upload_resource_barrier = {
-		.Type = D3D12_RESOURCE_BARRIER_TYPE_TRANSITION,
-		.Flags = D3D12_RESOURCE_BARRIER_FLAG_NONE,
-		.Transition = {
-			.pResource = texture_resource.get(),
-			.Subresource = D3D12_RESOURCE_BARRIER_ALL_SUBRESOURCES,
-			.StateBefore = D3D12_RESOURCE_STATE_COPY_DEST,
-			.StateAfter = D3D12_RESOURCE_STATE_PIXEL_SHADER_RESOURCE
-		},
-	};
-	command_list->ResourceBarrier(1, &tex_upload_resource_barrier);
-	command_list->Close();
-	ID3D12CommandList* cmd_list = command_list.get();
-	command_queue->ExecuteCommandLists(1, &cmd_list);
+	pending_upload_ticket = std::max(pending_upload_ticket.value_or(0), ticket);
+	texture_barrier_pending = true;
 
 	D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {
 		.Format = tex_resource_desc.Format,
-		.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2D,
+		.ViewDimension = D3D12_SRV_DIMENSION_TEXTURE2DARRAY,
 		.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
-		.Texture2D = {
+		.Texture2DArray = {
 			.MostDetailedMip = 0,
-			.MipLevels = 1,
+			.MipLevels = mip_levels,
+			.FirstArraySlice = 0,
+			.ArraySize = slice_count,
 			.PlaneSlice = 0,
 			.ResourceMinLODClamp = 0.0f
 		},
 	};
-	D3D12_CPU_DESCRIPTOR_HANDLE cpu_desc_handle = cbv_heap->GetCPUDescriptorHandleForHeapStart();
-	cpu_desc_handle.ptr += device->GetDescriptorHandleIncrementSize(D3D12_DESCRIPTOR_HEAP_TYPE_CBV_SRV_UAV);
-	device->CreateShaderResourceView(texture_resource.get(), &srv_desc, cpu_desc_handle);
+	texture_view = staging_heap->AllocatePersistent().cpu;
+	device->CreateShaderResourceView(texture_resource.get(), &srv_desc, texture_view);
+
+	CreateMaterialBuffer(first_level);
+}
 
-	winrt::check_hresult(device->CreateFence(0, D3D12_FENCE_FLAG_NONE, IID_PPV_ARGS(fence.put())));
-	fence_value = 1;
+void D3DHandler::CreateMaterialBuffer(UINT level) {
+	UINT material_count = static_cast<UINT>(material_slices.size());
+	material_buffer = gpu_memory->CreateBuffer(D3D12_HEAP_TYPE_UPLOAD,
+		sizeof(material_constants_t) * material_count * FRAME_COUNT, D3D12_RESOURCE_STATE_GENERIC_READ);
 
-	fence_event = CreateEvent(nullptr, FALSE, FALSE, nullptr);
-	if (fence_event == nullptr) {
-		winrt::check_hresult(HRESULT_FROM_WIN32(GetLastError()));
+	material_constants_t* material_data = nullptr;
+	D3D12_RANGE read_range = { 0, 0 };
+	winrt::check_hresult(material_buffer->Map(0, &read_range, reinterpret_cast<void**>(&material_data)));
+	for (UINT frame = 0; frame < FRAME_COUNT; frame++) {
+		for (UINT material = 0; material < material_count; material++) {
+			material_data[material_count * frame + material] = {
+				.slice = static_cast<FLOAT>(material_slices[material]),
+				.mip_clamp = static_cast<FLOAT>(level)
+			};
+		}
 	}
 
-	WaitForPreviousFrame();
+	for (UINT frame = 0; frame < FRAME_COUNT; frame++) {
+		D3D12_SHADER_RESOURCE_VIEW_DESC srv_desc = {
+			.Format = DXGI_FORMAT_R32G32_FLOAT,
+			.ViewDimension = D3D12_SRV_DIMENSION_BUFFER,
+			.Shader4ComponentMapping = D3D12_DEFAULT_SHADER_4_COMPONENT_MAPPING,
+			.Buffer = {
+				.FirstElement = UINT64(material_count) * frame,
+				.NumElements = material_count,
+				.StructureByteStride = 0,
+				.Flags = D3D12_BUFFER_SRV_FLAG_NONE
+			}
+		};
+		material_views[frame] = staging_heap->AllocatePersistent().cpu;
+		device->CreateShaderResourceView(material_buffer.get(), &srv_desc, material_views[frame]);
+		frame_contexts[frame].material_data = material_data + material_count * frame;
+	}
+}
+
+// Meshlets never span two chunks, and those of a level follow the chunk order, as do the index ranges of the
+// chunks within the level.
+std::vector<D3DHandler::scene_chunk_t> D3DHandler::BuildSceneChunks(SceneData& scene_data) {
+	std::span<const lod_level_t> chunk_levels = scene_data.GetLodChunkLevels();
+	std::size_t level_count = scene_data.GetLodLevels().size();
+	std::vector<scene_chunk_t> chunks(chunk_levels.size() / level_count);
+	for (std::size_t c = 0; c < chunks.size(); c++) {
+		chunks[c].levels.assign(chunk_levels.begin() + c * level_count, chunk_levels.begin() + (c + 1) * level_count);
+		chunks[c].level_meshlets.resize(level_count);
+	}
+
+	for (UINT level = 0; level < level_count; level++) {
+		std::size_t c = 0;
+		for (const meshlet_t& meshlet : scene_data.BuildMeshlets(level).meshlets) {
+			while (meshlet.first_index >= chunks[c].levels[level].first_index + chunks[c].levels[level].index_count) {
+				c++;
+			}
+			chunks[c].level_meshlets[level].push_back(meshlet);
+		}
+	}
+
+	for (scene_chunk_t& chunk : chunks) {
+		XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+		for (const meshlet_t& meshlet : chunk.level_meshlets[0]) {
+			minimum = XMVectorMin(minimum, XMLoadFloat3(&meshlet.aabb_min));
+			maximum = XMVectorMax(maximum, XMLoadFloat3(&meshlet.aabb_max));
+		}
+		XMStoreFloat3(&chunk.aabb_min, minimum);
+		XMStoreFloat3(&chunk.aabb_max, maximum);
+	}
+	return chunks;
+}
+
+// Runs on the streaming thread, and reads the levels from the texture data, which may be memory-mapped, so
+// that page faults stay off the render thread.
+D3DHandler::level_uploads_t D3DHandler::PrepareLevelUploads(GpuMemory& memory,
+	const D3D12_RESOURCE_DESC& texture_desc, const TextureArray& source, std::vector<mip_upload_t> uploads) {
+	level_uploads_t result = { .uploads = std::move(uploads) };
+	std::size_t upload_count = result.uploads.size();
+	result.layouts.resize(upload_count);
+	std::vector<UINT> num_rows(upload_count);
+	std::vector<UINT64> row_sizes_in_bytes(upload_count);
+	UINT64 required_size = 0;
+	for (std::size_t i = 0; i < upload_count; i++) {
+		const mip_upload_t& upload = result.uploads[i];
+		UINT64 subresource_size = 0;
+		UINT subresource = upload.level + upload.texture * texture_desc.MipLevels;
+		memory.GetDevice()->GetCopyableFootprints(&texture_desc, subresource, 1, 0, &result.layouts[i], &num_rows[i],
+			&row_sizes_in_bytes[i], &subresource_size);
+		required_size = (required_size + D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1) &
+			~UINT64(D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT - 1);
+		result.layouts[i].Offset = required_size;
+		required_size += subresource_size;
+	}
+
+	result.upload_buffer = memory.CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, required_size,
+		D3D12_RESOURCE_STATE_GENERIC_READ);
 
-	delete bmp_bits;
+	std::span<const texture_level_t> levels = source.GetLevels();
+	BYTE* map_tex_data = nullptr;
+	winrt::check_hresult(result.upload_buffer->Map(0, nullptr, reinterpret_cast<void**>(&map_tex_data)));
+	for (std::size_t i = 0; i < upload_count; i++) {
+		const texture_level_t& level = levels[result.uploads[i].level];
+		const BYTE* source_data = source.GetSliceData(result.uploads[i].texture).data() + level.offset;
+		BYTE* destination = map_tex_data + result.layouts[i].Offset;
+		if (level.row_pitch == result.layouts[i].Footprint.RowPitch) {
+			// Already laid out for the upload buffer.
+			memcpy(destination, source_data,
+				SIZE_T(level.row_pitch) * (num_rows[i] - 1) + static_cast<SIZE_T>(row_sizes_in_bytes[i]));
+			continue;
+		}
+		for (UINT y = 0; y < num_rows[i]; ++y) {
+			memcpy(
+				destination + SIZE_T(result.layouts[i].Footprint.RowPitch) * y,
+				source_data + SIZE_T(level.row_pitch) * y,
+				static_cast<SIZE_T>(row_sizes_in_bytes[i])
+			);
+		}
+	}
+	result.upload_buffer->Unmap(0, nullptr);
+	return result;
+}
+
+// The texture must be in the COPY_DEST state.
+void D3DHandler::RecordLevelUploads(const level_uploads_t& uploads) {
+	UINT mip_levels = static_cast<UINT>(texture->GetLevels().size());
+	for (std::size_t i = 0; i < uploads.uploads.size(); i++) {
+		D3D12_TEXTURE_COPY_LOCATION dst = {
+			.pResource = texture_resource.get(),
+			.Type = D3D12_TEXTURE_COPY_TYPE_SUBRESOURCE_INDEX,
+			.SubresourceIndex = uploads.uploads[i].level + uploads.uploads[i].texture * mip_levels
+		};
+		D3D12_TEXTURE_COPY_LOCATION src = {
+			.pResource = uploads.upload_buffer.get(),
+			.Type = D3D12_TEXTURE_COPY_TYPE_PLACED_FOOTPRINT,
+			.PlacedFootprint = uploads.layouts[i]
+		};
+		command_list->CopyTextureRegion(&dst, 0, 0, 0, &src, nullptr);
+	}
 }
 
 void D3DHandler::OnUpdate() {
@@ -663,21 +840,92 @@ void D3DHandler::OnUpdate() {
 		pos_z += -cos(angle) * MOVE_SPEED;
 	}
 
-	XMMATRIX wvp_matrix;
-	wvp_matrix = XMMatrixMultiply(
+	XMMATRIX projection = XMMatrixPerspectiveFovLH(
+		FIELD_OF_VIEW, viewport.Width / viewport.Height, 1.0f, 100.0f
+	);
+	XMMATRIX view_projection = XMMatrixMultiply(
 		XMMatrixTranslation(-pos_x, -pos_y, -pos_z),
 		XMMatrixRotationY(angle)
 	);
+	view_projection = XMMatrixMultiply(
+		view_projection,
+		projection
+	);
+	FLOAT pixels_per_unit = XMVectorGetY(projection.r[1]) * viewport.Height * 0.5f;
+	UpdateDrawRanges(view_projection, pixels_per_unit);
+
+	if (mip_streamer) {
+		// The cone around the view direction reaches the corners of the frustum.
+		FLOAT tan_half_width = 1.0f / XMVectorGetX(projection.r[0]);
+		FLOAT tan_half_height = 1.0f / XMVectorGetY(projection.r[1]);
+		mip_streamer->UpdateTargets({
+			.position = { pos_x, pos_y, pos_z },
+			.direction = { -std::sin(angle), 0.0f, std::cos(angle) },
+			.half_angle = std::atan(std::sqrt(tan_half_width * tan_half_width + tan_half_height * tan_half_height)),
+			.pixels_per_unit = pixels_per_unit
+		});
+		// The GPU has finished with the context of the next frame, so its clamps are not in use.
+		material_constants_t* material_data = frame_contexts[frame_ring->GetFrameIndex()].material_data;
+		for (UINT material = 0; material < material_slices.size(); material++) {
+			material_data[material].mip_clamp =
+				static_cast<FLOAT>(mip_streamer->GetResidentLevel(material_slices[material]));
+		}
+	}
+
+	XMMATRIX wvp_matrix;
+	wvp_matrix = XMMatrixMultiply(
+		XMMatrixScaling(position_dequantization.scale[0], position_dequantization.scale[1],
+			position_dequantization.scale[2]),
+		XMMatrixTranslation(position_dequantization.offset[0], position_dequantization.offset[1],
+			position_dequantization.offset[2])
+	);
 	wvp_matrix = XMMatrixMultiply(
 		wvp_matrix,
-		XMMatrixPerspectiveFovLH(
-			45.0f, viewport.Width / viewport.Height, 1.0f, 100.0f
-		)
+		view_projection
 	);
 	wvp_matrix = XMMatrixTranspose(wvp_matrix);
 	XMStoreFloat4x4(
 		&const_buffer_data.matWorldViewProj,
 		wvp_matrix
 	);
-	memcpy(cbv_data_begin, &const_buffer_data, sizeof(const_buffer_data));
+	const_buffer_address = upload_ring->Upload(const_buffer_data);
+}
+
+void D3DHandler::UpdateDrawRanges(FXMMATRIX view_projection, FLOAT pixels_per_unit) {
+	// Every chunk draws the level chosen by the distance to the nearest point of its own bounds, so that the
+	// chunks around the camera stay detailed while distant ones are simplified. Chunk borders are kept by
+	// every level, so neighbouring chunks at different levels still meet without cracks.
+	XMVECTOR camera_position = XMVectorSet(pos_x, pos_y, pos_z, 1.0f);
+	UINT triangle_count = 0;
+	draw_ranges.clear();
+	for (const scene_chunk_t& chunk : scene_chunks) {
+		XMVECTOR nearest = XMVectorClamp(camera_position, XMLoadFloat3(&chunk.aabb_min), XMLoadFloat3(&chunk.aabb_max));
+		FLOAT distance = XMVectorGetX(XMVector3Length(XMVectorSubtract(camera_position, nearest)));
+		UINT level = SelectLodLevel(chunk.levels, distance, pixels_per_unit, LOD_SCREEN_ERROR);
+		triangle_count += chunk.levels[level].index_count / 3;
+
+		const std::vector<meshlet_t>& meshlets = chunk.level_meshlets[level];
+		visible_meshlets.clear();
+		CullMeshlets(meshlets, view_projection, camera_position, visible_meshlets);
+
+		// Visible meshlets that follow each other in the index buffer are drawn together.
+		for (UINT i : visible_meshlets) {
+			const meshlet_t& meshlet = meshlets[i];
+			if (!draw_ranges.empty() &&
+				draw_ranges.back().first_index + draw_ranges.back().index_count == meshlet.first_index) {
+				draw_ranges.back().index_count += meshlet.triangle_count * 3;
+			}
+			else {
+				draw_ranges.push_back({ .first_index = meshlet.first_index,
+					.index_count = meshlet.triangle_count * 3 });
+			}
+		}
+	}
+	if (triangle_count != lod_triangle_count) {
+		lod_triangle_count = triangle_count;
+#if defined(_DEBUG)
+		OutputDebugStringA(std::format("D3DHandler: drawing {} triangles from the levels of {} chunks\n",
+			triangle_count, scene_chunks.size()).c_str());
+#endif
+	}
 }
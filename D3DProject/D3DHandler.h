@@ -1,6 +1,14 @@
 #pragma once
 
 #include "vertex.h"
+#include "SceneData.h"
+#include "TextureArray.h"
+#include "MipStreamer.h"
+#include "D3D12FrameFence.h"
+#include "GpuMemory.h"
+#include "UploadRing.h"
+#include "D3D12CopyQueue.h"
+#include "DescriptorHeap.h"
 
 using namespace DirectX;
 
@@ -19,71 +27,202 @@ private:
 		XMFLOAT4 padding[(256 - sizeof(XMFLOAT4X4)) / sizeof(XMFLOAT4)];
 	};
 
+	// Spatial chunk of the scene, which selects its level of detail by its own distance from the camera.
+	struct scene_chunk_t {
+		// Bounds of the full-detail level.
+		XMFLOAT3 aabb_min, aabb_max;
+		std::vector<lod_level_t> levels;
+		// Meshlets of each level of detail.
+		std::vector<std::vector<meshlet_t>> level_meshlets;
+	};
+
+	struct loaded_scene_t {
+		// The geometry is packed in system memory, and copied into the default heap once attached.
+		std::unique_ptr<VectorSceneSink> buffers;
+		// Declared after the buffers, as its spans may point into them.
+		std::unique_ptr<SceneData> scene_data;
+		std::vector<scene_chunk_t> chunks;
+	};
+
+	// What the texture loader needs from the scene: the distinct textures of the materials, one slice each,
+	// the slice of every material and where each texture is used.
+	struct scene_textures_t {
+		std::vector<std::string> paths;
+		std::vector<UINT> material_slices;
+		std::vector<texture_usage_t> usage;
+	};
+
+	struct loaded_texture_t {
+		std::unique_ptr<TextureArray> texture;
+		std::unique_ptr<MipStreamer> mip_streamer;
+		std::vector<UINT> material_slices;
+	};
+
+	// Element of the material buffer, which the pixel shader reads as a float2.
+	struct material_constants_t {
+		FLOAT slice;
+		// Finest mip level of the slice that may be sampled.
+		FLOAT mip_clamp;
+	};
+
+	// Mip levels copied into an upload buffer, placed for CopyTextureRegion.
+	struct level_uploads_t {
+		std::vector<mip_upload_t> uploads;
+		std::vector<D3D12_PLACED_SUBRESOURCE_FOOTPRINT> layouts;
+		PlacedResource upload_buffer;
+	};
+
+	// What a frame records into, reused once the GPU has finished the frame that last used it.
+	struct frame_context_t {
+		winrt::com_ptr<ID3D12CommandAllocator> command_allocator;
+		// The frame's part of the material buffer.
+		material_constants_t* material_data;
+		// Levels copied by the frame, resident once it has finished.
+		std::optional<level_uploads_t> level_uploads;
+	};
+
+	struct draw_range_t {
+		UINT first_index;
+		UINT index_count;
+	};
+
 	static constexpr UINT FRAME_COUNT = 2;
 	static constexpr std::size_t VERTEX_SIZE = sizeof(vertex_t) / sizeof(FLOAT);
-	static constexpr UINT BMP_PX_SIZE = 4;
 	static constexpr FLOAT ROTATION_SPEED = 0.03f;
 	static constexpr FLOAT MOVE_SPEED = 0.05f;
-	static constexpr std::size_t CONST_BUFFER_SIZE = sizeof(vs_const_buffer_t);
+	// Holds the constants of the frames in flight.
+	static constexpr UINT64 UPLOAD_RING_SIZE = UINT64(1) << 20;
+	// Stages the static geometry and the boot levels of the texture for the copy queue.
+	static constexpr UINT64 STAGING_RING_SIZE = UINT64(64) << 20;
+	static constexpr vertex_format_t VERTEX_FORMAT = {};
+	static constexpr FLOAT FIELD_OF_VIEW = 45.0f;
+	// Largest error, in pixels, that a simplified level of detail may show on screen.
+	static constexpr FLOAT LOD_SCREEN_ERROR = 1.0f;
+	static constexpr mip_streaming_options_t MIP_STREAMING = {};
+	// The descriptor tables of every frame. The shaders index no views by number, so there is no persistent part.
+	static constexpr descriptor_heap_options_t SHADER_DESCRIPTORS = {
+		.persistent_count = 0,
+		.frame_count = FRAME_COUNT,
+		.transient_count = 1024,
+		.shader_visible = true
+	};
+	// Views written once, and copied into the descriptor tables of every frame.
+	static constexpr descriptor_heap_options_t STAGING_DESCRIPTORS = { .persistent_count = 1024 };
 
-	static constexpr PCWSTR TEXTURE_PATH = L"Assets\\Texture.png";
+	// Used by materials without a diffuse texture of their own.
+	static constexpr char TEXTURE_PATH[] = "Assets\\Texture.png";
 	static constexpr char SCENE_PATH[] = "Assets\\SceneData.obj";
 
 	winrt::com_ptr<IDXGISwapChain4> swap_chain;
 	winrt::com_ptr<ID3D12Device5> device;
+	// Declared before every placed resource, as they give their memory back to it when destroyed.
+	std::unique_ptr<GpuMemory> gpu_memory;
+	std::unique_ptr<D3D12CopyQueue> copy_queue;
+	std::unique_ptr<UploadScheduler> upload_scheduler;
 	winrt::com_ptr<ID3D12CommandQueue> command_queue;
-	winrt::com_ptr<ID3D12DescriptorHeap> rtv_heap;
+	std::unique_ptr<DescriptorHeap> rtv_heap;
+	D3D12_CPU_DESCRIPTOR_HANDLE rtv_handles[FRAME_COUNT];
 	winrt::com_ptr<ID3D12Resource> render_targets[FRAME_COUNT];
-	winrt::com_ptr<ID3D12CommandAllocator> command_allocator;
 	winrt::com_ptr<ID3D12GraphicsCommandList2> command_list;
 	winrt::com_ptr<ID3D12PipelineState> pipeline_state;
 
 	winrt::com_ptr<ID3D12RootSignature> root_signature;
-	winrt::com_ptr<ID3D12Resource> vertex_buffer;
+	PlacedResource vertex_buffer;
 	D3D12_VERTEX_BUFFER_VIEW vertex_buffer_view;
+	PlacedResource constant_color_buffer;
+	D3D12_VERTEX_BUFFER_VIEW constant_color_buffer_view;
+	PlacedResource index_buffer;
+	D3D12_INDEX_BUFFER_VIEW index_buffer_view;
+
+	std::unique_ptr<DescriptorHeap> descriptor_heap;
+	std::unique_ptr<DescriptorHeap> staging_heap;
+	std::unique_ptr<UploadRing> upload_ring;
+	// Batch of the last static upload that the frames have not waited for yet.
+	std::optional<upload_ticket_t> pending_upload_ticket;
+
+	std::unique_ptr<DescriptorHeap> dsv_heap;
+	D3D12_CPU_DESCRIPTOR_HANDLE dsv_handle;
+	PlacedResource depth_buffer;
+
+	PlacedResource texture_resource;
+	// Set while the texture, copied on the copy queue, is still in the common state.
+	bool texture_barrier_pending = false;
+	// Staged view of the texture.
+	D3D12_CPU_DESCRIPTOR_HANDLE texture_view;
+	// Texture slice of every material and the finest mip level the pixel shader may sample from it; left
+	// mapped.
+	PlacedResource material_buffer;
+	// Staged view of the part of the material buffer of every frame.
+	D3D12_CPU_DESCRIPTOR_HANDLE material_views[FRAME_COUNT];
+
+	std::unique_ptr<D3D12FrameFence> frame_fence;
+	std::unique_ptr<FrameRing> frame_ring;
+	frame_context_t frame_contexts[FRAME_COUNT];
 
-	winrt::com_ptr<ID3D12DescriptorHeap> cbv_heap;
-	winrt::com_ptr<ID3D12Resource> constant_buffer;
-
-	winrt::com_ptr<ID3D12DescriptorHeap> dsv_heap;
-	winrt::com_ptr<ID3D12Resource> depth_buffer;
-
-	winrt::com_ptr<ID3D12Resource> texture_resource;
-
-	winrt::com_ptr<ID3D12Fence1> fence;
-	HANDLE fence_event;
-	UINT64 fence_value;
-
-	UINT rtv_descriptor_size;
 	UINT frame_index;
 	CD3DX12_VIEWPORT viewport;
 	CD3DX12_RECT scissor_rect;
 
-	UINT8* cbv_data_begin;
 	vs_const_buffer_t const_buffer_data;
+	// Constants of the frame being recorded, in the upload ring.
+	D3D12_GPU_VIRTUAL_ADDRESS const_buffer_address;
 
 	UINT width, height;
-	std::vector<vertex_t> triangle_data;
+	// Assets load on background threads and are attached by OnRender once ready.
+	std::future<loaded_scene_t> scene_future;
+	std::future<loaded_texture_t> texture_future;
+	bool assets_loaded = false;
+	bool frame_presented = false;
+	// Kept after the boot levels are uploaded, as the source of the streamed levels.
+	std::unique_ptr<TextureArray> texture;
+	std::unique_ptr<MipStreamer> mip_streamer;
+	std::vector<UINT> material_slices;
+	// Levels prepared on a background thread, then handed to the context of the next frame, which copies them.
+	std::future<level_uploads_t> level_uploads_future;
+	std::optional<level_uploads_t> level_uploads;
+	bool textures_at_target = false;
+	std::chrono::steady_clock::time_point streaming_start;
+	std::vector<scene_chunk_t> scene_chunks;
+	// Triangles of the levels of detail drawn by the current frame, before culling.
+	UINT lod_triangle_count = 0;
+	std::vector<UINT> visible_meshlets;
+	std::vector<draw_range_t> draw_ranges;
+	position_dequantization_t position_dequantization;
 	FLOAT pos_x = 1.0f, pos_y = 1.0f, pos_z = 0.0f;
 	FLOAT angle = 0.0f;
 
 	void LoadPipeline();
 	void LoadAssets();
 	void PopulateCommandList();
-	void WaitForPreviousFrame();
+	void MoveToNextFrame();
+	void UpdateDrawRanges(FXMMATRIX view_projection, FLOAT pixels_per_unit);
+	void AttachLoadedAssets();
+	void StreamTextureLevels();
+	void RecordLevelUploads(const level_uploads_t& uploads);
 
 	void CreateDevice();
 	void CreateCommandQueue();
 	void CreateSwapChain(IDXGIFactory7* factory);
 	void CreateDescriptorHeaps();
 	void CreateFrameResources();
-	void CreateCommandAllocator();
+	void CreateCommandAllocators();
 	void CreateRootSignature();
 	void CreatePipelineState();
 	void CreateCommandList();
-	void CreateVertexBuffer();
-	void CreateConstantBuffer();
+	void CreateVertexBuffer(loaded_scene_t& scene);
+	// Creates a buffer in the default heap and uploads data into it on the copy queue.
+	PlacedResource CreateStaticBuffer(std::span<const BYTE> data);
+	void CreateUploadRing();
+	void CreateUploadScheduler();
 	void CreateDepthBuffer();
-	void CreateTextureAndSynchronizationResources();
+	void CreateSynchronizationResources();
+	// Uploads the levels from first_level on; the finer ones are streamed in later.
+	void CreateTexture(UINT first_level);
+	void CreateMaterialBuffer(UINT level);
+
+	// Splits the levels and meshlets of the scene into its chunks.
+	static std::vector<scene_chunk_t> BuildSceneChunks(SceneData& scene_data);
+	static level_uploads_t PrepareLevelUploads(GpuMemory& memory, const D3D12_RESOURCE_DESC& texture_desc,
+		const TextureArray& source, std::vector<mip_upload_t> uploads);
 
 };
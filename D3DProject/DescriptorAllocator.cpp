@@ -0,0 +1,91 @@
+#include "pch.h"
+#include "DescriptorAllocator.h"
+
+DescriptorAllocator::DescriptorAllocator(UINT persistent_count, UINT frame_count, UINT transient_count)
+	: persistent_count(persistent_count), frame_count(frame_count), transient_count(transient_count),
+	states(persistent_count, descriptor_state_t::FREE) {
+	if (UINT64(persistent_count) + UINT64(frame_count) * transient_count > UINT_MAX) {
+		throw std::runtime_error("DescriptorAllocator: too many descriptors");
+	}
+
+	free_indices.resize(persistent_count);
+	for (UINT i = 0; i < persistent_count; i++) {
+		free_indices[i] = persistent_count - 1 - i;
+	}
+}
+
+UINT DescriptorAllocator::GetCount() const {
+	return persistent_count + frame_count * transient_count;
+}
+
+std::optional<UINT> DescriptorAllocator::AllocatePersistent() {
+	if (free_indices.empty()) {
+		return std::nullopt;
+	}
+	UINT index = free_indices.back();
+	free_indices.pop_back();
+	states[index] = descriptor_state_t::ALLOCATED;
+	return index;
+}
+
+void DescriptorAllocator::FreePersistent(UINT index) {
+	CheckAllocated(index);
+	states[index] = descriptor_state_t::FREE;
+	free_indices.push_back(index);
+}
+
+void DescriptorAllocator::FreePersistentAfter(UINT index, UINT64 fence_value) {
+	CheckAllocated(index);
+	if (!pending_frees.empty() && pending_frees.back().fence_value > fence_value) {
+		throw std::runtime_error("DescriptorAllocator: fence values must not decrease");
+	}
+	states[index] = descriptor_state_t::PENDING_FREE;
+	pending_frees.push_back({ .fence_value = fence_value, .index = index });
+}
+
+void DescriptorAllocator::Reclaim(UINT64 completed_fence_value) {
+	while (!pending_frees.empty() && pending_frees.front().fence_value <= completed_fence_value) {
+		UINT index = pending_frees.front().index;
+		states[index] = descriptor_state_t::FREE;
+		free_indices.push_back(index);
+		pending_frees.pop_front();
+	}
+}
+
+void DescriptorAllocator::BeginFrame(UINT frame) {
+	if (frame >= frame_count) {
+		throw std::runtime_error("DescriptorAllocator: no such frame");
+	}
+	this->frame = frame;
+	transient_used = 0;
+}
+
+std::optional<UINT> DescriptorAllocator::AllocateTransient(UINT count) {
+	if (count == 0 || frame_count == 0) {
+		throw std::runtime_error("DescriptorAllocator: invalid transient allocation");
+	}
+	if (count > transient_count - transient_used) {
+		return std::nullopt;
+	}
+	UINT index = persistent_count + frame * transient_count + transient_used;
+	transient_used += count;
+	return index;
+}
+
+UINT DescriptorAllocator::GetPersistentUsedCount() const {
+	return persistent_count - static_cast<UINT>(free_indices.size());
+}
+
+UINT DescriptorAllocator::GetPendingFreeCount() const {
+	return static_cast<UINT>(pending_frees.size());
+}
+
+UINT DescriptorAllocator::GetTransientUsedCount() const {
+	return transient_used;
+}
+
+void DescriptorAllocator::CheckAllocated(UINT index) const {
+	if (index >= persistent_count || states[index] != descriptor_state_t::ALLOCATED) {
+		throw std::runtime_error("DescriptorAllocator: descriptor is not allocated");
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+
+// Hands out indices into a range of descriptors, independent of the heap that holds them. The range starts
+// with persistent_count persistent descriptors, such as the views of textures that shaders index by number,
+// which are allocated one by one from a free list. Then follow frame_count transient regions of
+// transient_count descriptors each, one per frame context, allocated linearly and freed all at once when
+// the context is used again. Meant for a single recording thread.
+class DescriptorAllocator {
+public:
+	DescriptorAllocator(UINT persistent_count, UINT frame_count, UINT transient_count);
+
+	UINT GetCount() const;
+
+	// Returns nothing when every persistent descriptor is in use or waiting to be freed.
+	std::optional<UINT> AllocatePersistent();
+	// For descriptors that the GPU never reads, such as those of a CPU-only heap.
+	void FreePersistent(UINT index);
+	// Frees the descriptor once the frame that signals fence_value has finished, as frames before it may
+	// still read it. Fence values must not decrease from one call to the next.
+	void FreePersistentAfter(UINT index, UINT64 fence_value);
+	// Frees the descriptors waiting for the frames that signalled up to completed_fence_value.
+	void Reclaim(UINT64 completed_fence_value);
+
+	// Empties the transient region of the frame context, which the GPU must have finished with.
+	void BeginFrame(UINT frame);
+	// Returns the first of count consecutive descriptors in the region of the current frame, or nothing
+	// when the region is full.
+	std::optional<UINT> AllocateTransient(UINT count);
+
+	// Including those waiting to be freed.
+	UINT GetPersistentUsedCount() const;
+	UINT GetPendingFreeCount() const;
+	UINT GetTransientUsedCount() const;
+private:
+	enum class descriptor_state_t : UINT {
+		FREE,
+		ALLOCATED,
+		// Freed, but possibly still read by frames in flight.
+		PENDING_FREE
+	};
+
+	struct pending_free_t {
+		UINT64 fence_value;
+		UINT index;
+	};
+
+	UINT persistent_count;
+	UINT frame_count;
+	UINT transient_count;
+	// Taken from the back, which starts at index 0.
+	std::vector<UINT> free_indices;
+	std::vector<descriptor_state_t> states;
+	std::deque<pending_free_t> pending_frees;
+	UINT frame = 0;
+	UINT transient_used = 0;
+
+	void CheckAllocated(UINT index) const;
+};
@@ -0,0 +1,82 @@
+#include "pch.h"
+#include "DescriptorHeap.h"
+
+DescriptorHeap::DescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type,
+	const descriptor_heap_options_t& options)
+	: type(type), allocator(options.persistent_count, options.frame_count, options.transient_count) {
+	this->device.copy_from(device);
+
+	D3D12_DESCRIPTOR_HEAP_DESC heap_desc = {
+		.Type = type,
+		.NumDescriptors = allocator.GetCount(),
+		.Flags = options.shader_visible ? D3D12_DESCRIPTOR_HEAP_FLAG_SHADER_VISIBLE : D3D12_DESCRIPTOR_HEAP_FLAG_NONE,
+		.NodeMask = 0
+	};
+	winrt::check_hresult(device->CreateDescriptorHeap(&heap_desc, IID_PPV_ARGS(heap.put())));
+	descriptor_size = device->GetDescriptorHandleIncrementSize(type);
+	cpu_start = heap->GetCPUDescriptorHandleForHeapStart();
+	if (options.shader_visible) {
+		gpu_start = heap->GetGPUDescriptorHandleForHeapStart();
+	}
+}
+
+ID3D12DescriptorHeap* DescriptorHeap::get() const {
+	return heap.get();
+}
+
+descriptor_handle_t DescriptorHeap::GetHandle(UINT index) const {
+	descriptor_handle_t handle = { .cpu = cpu_start, .gpu = gpu_start, .index = index };
+	handle.cpu.ptr += SIZE_T(index) * descriptor_size;
+	if (handle.gpu.ptr != 0) {
+		handle.gpu.ptr += UINT64(index) * descriptor_size;
+	}
+	return handle;
+}
+
+descriptor_handle_t DescriptorHeap::AllocatePersistent() {
+	std::optional<UINT> index = allocator.AllocatePersistent();
+	if (!index) {
+		throw std::runtime_error(std::format("DescriptorHeap: all {} persistent descriptors are in use",
+			allocator.GetPersistentUsedCount()));
+	}
+	return GetHandle(*index);
+}
+
+void DescriptorHeap::FreePersistent(UINT index) {
+	allocator.FreePersistent(index);
+}
+
+void DescriptorHeap::FreePersistentAfter(UINT index, UINT64 fence_value) {
+	allocator.FreePersistentAfter(index, fence_value);
+}
+
+void DescriptorHeap::Reclaim(UINT64 completed_fence_value) {
+	allocator.Reclaim(completed_fence_value);
+}
+
+void DescriptorHeap::BeginFrame(UINT frame) {
+	allocator.BeginFrame(frame);
+}
+
+descriptor_handle_t DescriptorHeap::AllocateTransient(UINT count) {
+	std::optional<UINT> index = allocator.AllocateTransient(count);
+	if (!index) {
+		throw std::runtime_error(std::format("DescriptorHeap: no room for {} transient descriptors, {} in use",
+			count, allocator.GetTransientUsedCount()));
+	}
+	return GetHandle(*index);
+}
+
+descriptor_handle_t DescriptorHeap::CopyTransient(std::span<const D3D12_CPU_DESCRIPTOR_HANDLE> sources) {
+	UINT count = static_cast<UINT>(sources.size());
+	descriptor_handle_t table = AllocateTransient(count);
+	// Without source range sizes, every source is a single descriptor.
+	device->CopyDescriptors(1, &table.cpu, &count, count, sources.data(), nullptr, type);
+	return table;
+}
+
+void DescriptorHeap::LogStats(const char* name) const {
+	OutputDebugStringA(std::format("DescriptorHeap: {}: {} persistent descriptors in use, {} waiting to be freed, "
+		"{} transient in the current frame\n", name, allocator.GetPersistentUsedCount(),
+		allocator.GetPendingFreeCount(), allocator.GetTransientUsedCount()).c_str());
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "DescriptorAllocator.h"
+
+struct descriptor_handle_t {
+	D3D12_CPU_DESCRIPTOR_HANDLE cpu;
+	// Zero in a CPU-only heap.
+	D3D12_GPU_DESCRIPTOR_HANDLE gpu;
+	// Position in the heap, by which shaders find a persistent descriptor.
+	UINT index;
+};
+
+struct descriptor_heap_options_t {
+	UINT persistent_count = 1024;
+	// One transient region of transient_count descriptors per frame context; none in a CPU-only heap.
+	UINT frame_count = 0;
+	UINT transient_count = 0;
+	bool shader_visible = false;
+};
+
+// Descriptor heap whose descriptors are handed out by a DescriptorAllocator. The shader-visible heap holds
+// the descriptors that shaders index directly in its persistent part, and the descriptor tables of every
+// frame in its transient part. CPU-only heaps stage the views that are copied into the tables, and hold
+// render target and depth stencil views.
+class DescriptorHeap {
+public:
+	DescriptorHeap(ID3D12Device* device, D3D12_DESCRIPTOR_HEAP_TYPE type, const descriptor_heap_options_t& options);
+
+	ID3D12DescriptorHeap* get() const;
+	descriptor_handle_t GetHandle(UINT index) const;
+
+	// See DescriptorAllocator. Allocations throw when the heap or the region of the frame is full.
+	descriptor_handle_t AllocatePersistent();
+	void FreePersistent(UINT index);
+	void FreePersistentAfter(UINT index, UINT64 fence_value);
+	void Reclaim(UINT64 completed_fence_value);
+	void BeginFrame(UINT frame);
+	descriptor_handle_t AllocateTransient(UINT count);
+	// Copies descriptors of a CPU-only heap into consecutive transient descriptors, to be bound as a table.
+	descriptor_handle_t CopyTransient(std::span<const D3D12_CPU_DESCRIPTOR_HANDLE> sources);
+
+	void LogStats(const char* name) const;
+private:
+	winrt::com_ptr<ID3D12Device> device;
+	winrt::com_ptr<ID3D12DescriptorHeap> heap;
+	D3D12_DESCRIPTOR_HEAP_TYPE type;
+	UINT descriptor_size;
+	D3D12_CPU_DESCRIPTOR_HANDLE cpu_start;
+	D3D12_GPU_DESCRIPTOR_HANDLE gpu_start = {};
+	DescriptorAllocator allocator;
+};
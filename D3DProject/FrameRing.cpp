@@ -0,0 +1,45 @@
+#include "pch.h"
+#include "FrameRing.h"
+
+FrameRing::FrameRing(FrameFence& fence, UINT frame_count) : fence(fence), frame_fence_values(frame_count) {
+	if (frame_count == 0) {
+		throw std::runtime_error("FrameRing: no frames");
+	}
+}
+
+UINT FrameRing::GetFrameIndex() const {
+	return frame_index;
+}
+
+UINT64 FrameRing::GetFrameFenceValue() const {
+	return next_fence_value;
+}
+
+void FrameRing::NextFrame() {
+	fence.Signal(next_fence_value);
+	frame_fence_values[frame_index] = next_fence_value++;
+	stats.frames++;
+
+	frame_index = (frame_index + 1) % frame_fence_values.size();
+	WaitForFrame(frame_fence_values[frame_index]);
+}
+
+void FrameRing::WaitForIdle() {
+	fence.Signal(next_fence_value);
+	fence.WaitForValue(next_fence_value++);
+}
+
+const frame_ring_stats_t& FrameRing::GetStats() const {
+	return stats;
+}
+
+void FrameRing::WaitForFrame(UINT64 fence_value) {
+	if (fence.GetCompletedValue() >= fence_value) {
+		return;
+	}
+
+	auto start = std::chrono::steady_clock::now();
+	fence.WaitForValue(fence_value);
+	stats.stalls++;
+	stats.stall_time += std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+// The fence of a command queue, as far as FrameRing uses it, so that the ring can also be driven by a queue
+// that only simulates the GPU. Values signalled on a fence only increase.
+class FrameFence {
+public:
+	virtual ~FrameFence() = default;
+	// Sets the fence to value once the work submitted to the queue so far has finished.
+	virtual void Signal(UINT64 value) = 0;
+	virtual UINT64 GetCompletedValue() = 0;
+	// Blocks until the fence has reached value.
+	virtual void WaitForValue(UINT64 value) = 0;
+};
+
+struct frame_ring_stats_t {
+	UINT64 frames = 0;
+	// Frames that had to wait for the GPU before their context was free, and the time spent waiting.
+	UINT64 stalls = 0;
+	double stall_time = 0.0;
+};
+
+// Hands out frame_count frame contexts in turn, each one holding what a frame records into: its command
+// allocator and transient resources. A context is only handed out again once the GPU has finished the frame
+// that last used it, so that the CPU can record up to frame_count - 1 frames ahead of the GPU.
+class FrameRing {
+public:
+	FrameRing(FrameFence& fence, UINT frame_count);
+
+	// Context of the frame being recorded, which the GPU no longer uses.
+	UINT GetFrameIndex() const;
+	// Fence value that the frame being recorded signals once it has finished.
+	UINT64 GetFrameFenceValue() const;
+	// Ends the frame once all of its work has been submitted, and moves to the next context, waiting until
+	// the GPU has finished with it.
+	void NextFrame();
+	// Waits until the GPU has finished all work submitted so far, which frees every context.
+	void WaitForIdle();
+	const frame_ring_stats_t& GetStats() const;
+private:
+	FrameFence& fence;
+	// Value signalled at the end of the last frame of every context, or zero before its first one.
+	std::vector<UINT64> frame_fence_values;
+	UINT64 next_fence_value = 1;
+	UINT frame_index = 0;
+	frame_ring_stats_t stats;
+
+	void WaitForFrame(UINT64 fence_value);
+};
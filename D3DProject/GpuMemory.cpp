@@ -0,0 +1,225 @@
+#include "pch.h"
+#include "GpuMemory.h"
+
+namespace {
+	D3D12_HEAP_FLAGS GetHeapFlags(const D3D12_RESOURCE_DESC& desc) {
+		if (desc.Dimension == D3D12_RESOURCE_DIMENSION_BUFFER) {
+			return D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS;
+		}
+		if (desc.Flags & (D3D12_RESOURCE_FLAG_ALLOW_RENDER_TARGET | D3D12_RESOURCE_FLAG_ALLOW_DEPTH_STENCIL)) {
+			return D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES;
+		}
+		return D3D12_HEAP_FLAG_ALLOW_ONLY_NON_RT_DS_TEXTURES;
+	}
+
+	// Only render target and depth stencil textures can be multisampled, and need the larger alignment then.
+	UINT64 GetHeapAlignment(D3D12_HEAP_FLAGS heap_flags) {
+		return heap_flags == D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES ?
+			D3D12_DEFAULT_MSAA_RESOURCE_PLACEMENT_ALIGNMENT : D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT;
+	}
+
+	const char* GetPoolName(D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags) {
+		bool upload = heap_type == D3D12_HEAP_TYPE_UPLOAD;
+		switch (heap_flags) {
+		case D3D12_HEAP_FLAG_ALLOW_ONLY_BUFFERS: return upload ? "upload buffers" : "buffers";
+		case D3D12_HEAP_FLAG_ALLOW_ONLY_RT_DS_TEXTURES: return "render target textures";
+		default: return upload ? "upload textures" : "textures";
+		}
+	}
+}
+
+PlacedResource::PlacedResource(PlacedResource&& other) noexcept {
+	*this = std::move(other);
+}
+
+PlacedResource& PlacedResource::operator=(PlacedResource&& other) noexcept {
+	if (this != &other) {
+		Release();
+		resource = std::move(other.resource);
+		memory = std::exchange(other.memory, nullptr);
+		heap = std::exchange(other.heap, nullptr);
+		block = other.block;
+	}
+	return *this;
+}
+
+PlacedResource::~PlacedResource() {
+	Release();
+}
+
+ID3D12Resource* PlacedResource::get() const {
+	return resource.get();
+}
+
+ID3D12Resource* PlacedResource::operator->() const {
+	return resource.get();
+}
+
+PlacedResource::operator bool() const {
+	return static_cast<bool>(resource);
+}
+
+void PlacedResource::Release() {
+	resource = nullptr;
+	if (memory != nullptr) {
+		memory->Free(static_cast<GpuMemory::heap_t*>(heap), block);
+		memory = nullptr;
+	}
+}
+
+GpuMemory::GpuMemory(ID3D12Device* device, const gpu_memory_options_t& options) : heap_size(options.heap_size) {
+	this->device.copy_from(device);
+}
+
+ID3D12Device* GpuMemory::GetDevice() const {
+	return device.get();
+}
+
+PlacedResource GpuMemory::CreateResource(D3D12_HEAP_TYPE heap_type, const D3D12_RESOURCE_DESC& desc,
+	D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE* clear_value) {
+	D3D12_RESOURCE_ALLOCATION_INFO allocation_info = device->GetResourceAllocationInfo(0, 1, &desc);
+	if (allocation_info.SizeInBytes == UINT64_MAX) {
+		throw std::runtime_error("GpuMemory: invalid resource description");
+	}
+
+	PlacedResource placed;
+	UINT64 offset;
+	{
+		std::lock_guard lock(mutex);
+		D3D12_HEAP_FLAGS heap_flags = GetHeapFlags(desc);
+		pool_t& pool = GetPool(heap_type, heap_flags);
+		std::optional<tlsf_allocation_t> allocation;
+		heap_t* heap = nullptr;
+		for (std::unique_ptr<heap_t>& pool_heap : pool.heaps) {
+			if (!pool_heap->dedicated) {
+				allocation = pool_heap->allocator.Allocate(allocation_info.SizeInBytes, allocation_info.Alignment);
+				if (allocation) {
+					heap = pool_heap.get();
+					break;
+				}
+			}
+		}
+		if (!allocation) {
+			UINT64 heap_alignment = GetHeapAlignment(heap_flags);
+			bool dedicated = allocation_info.SizeInBytes > heap_size;
+			UINT64 size = dedicated ?
+				(allocation_info.SizeInBytes + heap_alignment - 1) & ~(heap_alignment - 1) : heap_size;
+			heap = &CreateHeap(pool, size, heap_alignment, dedicated);
+			allocation = heap->allocator.Allocate(allocation_info.SizeInBytes, allocation_info.Alignment);
+			if (!allocation) {
+				throw std::runtime_error("GpuMemory: resource does not fit in a new heap");
+			}
+		}
+		placed.memory = this;
+		placed.heap = heap;
+		placed.block = allocation->block;
+		offset = allocation->offset;
+	}
+
+	// Should this fail, the destructor of placed gives the memory back.
+	winrt::check_hresult(device->CreatePlacedResource(static_cast<heap_t*>(placed.heap)->heap.get(), offset, &desc,
+		initial_state, clear_value, IID_PPV_ARGS(placed.resource.put())));
+	return placed;
+}
+
+PlacedResource GpuMemory::CreateBuffer(D3D12_HEAP_TYPE heap_type, UINT64 size, D3D12_RESOURCE_STATES initial_state) {
+	D3D12_RESOURCE_DESC resource_desc = {
+		.Dimension = D3D12_RESOURCE_DIMENSION_BUFFER,
+		.Alignment = 0,
+		.Width = size,
+		.Height = 1,
+		.DepthOrArraySize = 1,
+		.MipLevels = 1,
+		.Format = DXGI_FORMAT_UNKNOWN,
+		.SampleDesc = {.Count = 1, .Quality = 0 },
+		.Layout = D3D12_TEXTURE_LAYOUT_ROW_MAJOR,
+		.Flags = D3D12_RESOURCE_FLAG_NONE
+	};
+	return CreateResource(heap_type, resource_desc, initial_state);
+}
+
+gpu_memory_stats_t GpuMemory::GetStats() const {
+	std::lock_guard lock(mutex);
+	gpu_memory_stats_t stats;
+	for (const pool_t& pool : pools) {
+		for (const std::unique_ptr<heap_t>& heap : pool.heaps) {
+			AddStats(*heap, stats);
+		}
+	}
+	return stats;
+}
+
+void GpuMemory::LogStats() const {
+	std::lock_guard lock(mutex);
+	for (const pool_t& pool : pools) {
+		gpu_memory_stats_t stats;
+		for (const std::unique_ptr<heap_t>& heap : pool.heaps) {
+			AddStats(*heap, stats);
+		}
+		UINT64 free_size = stats.heap_size - stats.used_size;
+		OutputDebugStringA(std::format("GpuMemory: {}: {} resources using {:.1f} of {:.1f} MiB in {} heaps, {} free "
+			"blocks, largest {:.1f} MiB, fragmentation {:.2f}\n", GetPoolName(pool.heap_type, pool.heap_flags),
+			stats.allocation_count, stats.used_size / (1024.0 * 1024.0), stats.heap_size / (1024.0 * 1024.0),
+			stats.heap_count, stats.free_block_count, stats.largest_free_block / (1024.0 * 1024.0),
+			free_size == 0 ? 0.0 : 1.0 - static_cast<double>(stats.largest_free_block) / free_size).c_str());
+	}
+}
+
+GpuMemory::pool_t& GpuMemory::GetPool(D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags) {
+	for (pool_t& pool : pools) {
+		if (pool.heap_type == heap_type && pool.heap_flags == heap_flags) {
+			return pool;
+		}
+	}
+	return pools.emplace_back(pool_t{ .heap_type = heap_type, .heap_flags = heap_flags });
+}
+
+GpuMemory::heap_t& GpuMemory::CreateHeap(pool_t& pool, UINT64 size, UINT64 alignment, bool dedicated) {
+	D3D12_HEAP_DESC heap_desc = {
+		.SizeInBytes = size,
+		.Properties = {
+			.Type = pool.heap_type,
+			.CPUPageProperty = D3D12_CPU_PAGE_PROPERTY_UNKNOWN,
+			.MemoryPoolPreference = D3D12_MEMORY_POOL_UNKNOWN,
+			.CreationNodeMask = 1,
+			.VisibleNodeMask = 1
+		},
+		.Alignment = alignment,
+		.Flags = pool.heap_flags
+	};
+	winrt::com_ptr<ID3D12Heap> heap;
+	winrt::check_hresult(device->CreateHeap(&heap_desc, IID_PPV_ARGS(heap.put())));
+	// Offsets only need to be multiples of the smallest placement alignment.
+	pool.heaps.push_back(std::make_unique<heap_t>(heap_t{
+		.heap = std::move(heap),
+		.allocator = TlsfAllocator(size, D3D12_DEFAULT_RESOURCE_PLACEMENT_ALIGNMENT),
+		.dedicated = dedicated
+	}));
+	return *pool.heaps.back();
+}
+
+void GpuMemory::Free(heap_t* heap, UINT32 block) {
+	std::lock_guard lock(mutex);
+	heap->allocator.Free(block);
+	if (!heap->dedicated || heap->allocator.GetAllocationCount() != 0) {
+		return;
+	}
+	for (pool_t& pool : pools) {
+		auto found = std::find_if(pool.heaps.begin(), pool.heaps.end(), [&](const std::unique_ptr<heap_t>& pool_heap) {
+			return pool_heap.get() == heap;
+		});
+		if (found != pool.heaps.end()) {
+			pool.heaps.erase(found);
+			return;
+		}
+	}
+}
+
+void GpuMemory::AddStats(const heap_t& heap, gpu_memory_stats_t& stats) {
+	stats.heap_count++;
+	stats.heap_size += heap.allocator.GetSize();
+	stats.used_size += heap.allocator.GetUsedSize();
+	stats.allocation_count += heap.allocator.GetAllocationCount();
+	stats.free_block_count += heap.allocator.GetFreeBlockCount();
+	stats.largest_free_block = std::max(stats.largest_free_block, heap.allocator.GetLargestFreeBlock());
+}
@@ -0,0 +1,89 @@
+#pragma once
+
+#include "TlsfAllocator.h"
+
+class GpuMemory;
+
+// Resource placed in a heap of a GpuMemory, which gets its memory back when the resource is destroyed. Used
+// like a winrt::com_ptr<ID3D12Resource>; must be destroyed before the GpuMemory, once the GPU has finished
+// with it.
+class PlacedResource {
+public:
+	PlacedResource() = default;
+	PlacedResource(PlacedResource&& other) noexcept;
+	PlacedResource& operator=(PlacedResource&& other) noexcept;
+	~PlacedResource();
+
+	ID3D12Resource* get() const;
+	ID3D12Resource* operator->() const;
+	explicit operator bool() const;
+private:
+	friend class GpuMemory;
+
+	winrt::com_ptr<ID3D12Resource> resource;
+	GpuMemory* memory = nullptr;
+	void* heap = nullptr;
+	UINT32 block = 0;
+
+	void Release();
+};
+
+struct gpu_memory_options_t {
+	// Resources larger than this get a heap of their own.
+	UINT64 heap_size = UINT64(64) << 20;
+};
+
+struct gpu_memory_stats_t {
+	UINT heap_count = 0;
+	UINT64 heap_size = 0;
+	UINT64 used_size = 0;
+	UINT allocation_count = 0;
+	UINT free_block_count = 0;
+	UINT64 largest_free_block = 0;
+};
+
+// Places resources in large heaps instead of giving each its own committed resource and implicit heap. Heaps
+// are kept per heap type and per resource category (buffers, textures, render target and depth stencil
+// textures), as resource heap tier 1 requires, and each one is sub-allocated by a TlsfAllocator with the
+// alignment that the device reports for the resource. May be used from any thread.
+class GpuMemory {
+public:
+	GpuMemory(ID3D12Device* device, const gpu_memory_options_t& options = {});
+	GpuMemory(const GpuMemory&) = delete;
+	GpuMemory& operator=(const GpuMemory&) = delete;
+
+	ID3D12Device* GetDevice() const;
+	PlacedResource CreateResource(D3D12_HEAP_TYPE heap_type, const D3D12_RESOURCE_DESC& desc,
+		D3D12_RESOURCE_STATES initial_state, const D3D12_CLEAR_VALUE* clear_value = nullptr);
+	PlacedResource CreateBuffer(D3D12_HEAP_TYPE heap_type, UINT64 size, D3D12_RESOURCE_STATES initial_state);
+
+	// Totals over all heaps.
+	gpu_memory_stats_t GetStats() const;
+	// Logs the statistics and fragmentation of every pool of heaps.
+	void LogStats() const;
+private:
+	friend class PlacedResource;
+
+	struct heap_t {
+		winrt::com_ptr<ID3D12Heap> heap;
+		TlsfAllocator allocator;
+		// Created for a single resource larger than the heap size, and released with it.
+		bool dedicated;
+	};
+
+	struct pool_t {
+		D3D12_HEAP_TYPE heap_type;
+		D3D12_HEAP_FLAGS heap_flags;
+		std::vector<std::unique_ptr<heap_t>> heaps;
+	};
+
+	winrt::com_ptr<ID3D12Device> device;
+	UINT64 heap_size;
+	mutable std::mutex mutex;
+	std::vector<pool_t> pools;
+
+	pool_t& GetPool(D3D12_HEAP_TYPE heap_type, D3D12_HEAP_FLAGS heap_flags);
+	heap_t& CreateHeap(pool_t& pool, UINT64 size, UINT64 alignment, bool dedicated);
+	void Free(heap_t* heap, UINT32 block);
+	static void AddStats(const heap_t& heap, gpu_memory_stats_t& stats);
+};
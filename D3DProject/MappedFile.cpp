@@ -0,0 +1,37 @@
+#include "pch.h"
+#include "MappedFile.h"
+
+MappedFile::MappedFile(const std::string& path) {
+	file.attach(CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING,
+		FILE_ATTRIBUTE_NORMAL | FILE_FLAG_SEQUENTIAL_SCAN, nullptr));
+	if (!file) {
+		winrt::throw_last_error();
+	}
+
+	LARGE_INTEGER file_size;
+	winrt::check_bool(GetFileSizeEx(file.get(), &file_size));
+	size = static_cast<std::size_t>(file_size.QuadPart);
+	if (size == 0) {
+		return; // Empty files cannot be mapped.
+	}
+
+	mapping.attach(CreateFileMappingW(file.get(), nullptr, PAGE_READONLY, 0, 0, nullptr));
+	if (!mapping) {
+		winrt::throw_last_error();
+	}
+
+	view = static_cast<const char*>(MapViewOfFile(mapping.get(), FILE_MAP_READ, 0, 0, 0));
+	if (view == nullptr) {
+		winrt::throw_last_error();
+	}
+}
+
+MappedFile::~MappedFile() {
+	if (view != nullptr) {
+		UnmapViewOfFile(view);
+	}
+}
+
+std::span<const char> MappedFile::GetData() const {
+	return { view, size };
+}
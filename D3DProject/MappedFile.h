@@ -0,0 +1,17 @@
+#pragma once
+
+class MappedFile {
+public:
+	MappedFile(const std::string& path);
+	~MappedFile();
+
+	MappedFile(const MappedFile&) = delete;
+	MappedFile& operator=(const MappedFile&) = delete;
+
+	std::span<const char> GetData() const;
+private:
+	winrt::file_handle file;
+	winrt::handle mapping;
+	const char* view = nullptr;
+	std::size_t size = 0;
+};
@@ -0,0 +1,144 @@
+#include "pch.h"
+#include "MeshOptimizer.h"
+
+namespace {
+	constexpr UINT NO_VERTEX = UINT_MAX;
+
+	// Triangles using each vertex, stored as one array with per-vertex offsets.
+	struct vertex_adjacency_t {
+		std::vector<UINT> offsets;
+		std::vector<UINT> triangles;
+	};
+
+	vertex_adjacency_t BuildAdjacency(std::span<const UINT> indices, std::size_t vertex_count) {
+		vertex_adjacency_t adjacency;
+		adjacency.offsets.assign(vertex_count + 1, 0);
+		for (UINT index : indices) {
+			adjacency.offsets[index + 1]++;
+		}
+		for (std::size_t vertex = 0; vertex < vertex_count; vertex++) {
+			adjacency.offsets[vertex + 1] += adjacency.offsets[vertex];
+		}
+
+		adjacency.triangles.resize(indices.size());
+		std::vector<UINT> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); i++) {
+			adjacency.triangles[next[indices[i]]++] = static_cast<UINT>(i / 3);
+		}
+		return adjacency;
+	}
+}
+
+vertex_cache_stats_t AnalyzeVertexCache(std::span<const UINT> indices, std::size_t vertex_count, UINT cache_size) {
+	// A vertex is in a FIFO cache as long as fewer than cache_size misses happened since it was loaded.
+	std::vector<UINT64> load_times(vertex_count, 0);
+	UINT64 misses = 0;
+	for (UINT index : indices) {
+		if (load_times[index] == 0 || misses - load_times[index] >= cache_size) {
+			misses++;
+			load_times[index] = misses;
+		}
+	}
+
+	std::size_t triangle_count = indices.size() / 3;
+	return {
+		.acmr = triangle_count == 0 ? 0.0f : static_cast<FLOAT>(misses) / triangle_count,
+		.atvr = vertex_count == 0 ? 0.0f : static_cast<FLOAT>(misses) / vertex_count
+	};
+}
+
+void OptimizeVertexCache(std::span<UINT> indices, std::size_t vertex_count, UINT cache_size) {
+	std::size_t triangle_count = indices.size() / 3;
+	if (triangle_count == 0) {
+		return;
+	}
+
+	vertex_adjacency_t adjacency = BuildAdjacency(indices, vertex_count);
+	std::vector<UINT> live_triangles(vertex_count);
+	for (std::size_t vertex = 0; vertex < vertex_count; vertex++) {
+		live_triangles[vertex] = adjacency.offsets[vertex + 1] - adjacency.offsets[vertex];
+	}
+
+	std::vector<UINT> output;
+	output.reserve(indices.size());
+	std::vector<UINT64> cache_times(vertex_count, 0);
+	std::vector<bool> emitted(triangle_count, false);
+	std::vector<UINT> dead_end;
+	std::vector<UINT> candidates;
+	UINT64 time = cache_size + 1;
+	std::size_t cursor = 0;
+
+	UINT fanning_vertex = 0;
+	while (fanning_vertex != NO_VERTEX) {
+		// Emit every remaining triangle around the fanning vertex.
+		candidates.clear();
+		for (UINT i = adjacency.offsets[fanning_vertex]; i < adjacency.offsets[fanning_vertex + 1]; i++) {
+			UINT triangle = adjacency.triangles[i];
+			if (emitted[triangle]) {
+				continue;
+			}
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				UINT vertex = indices[triangle * 3 + corner];
+				output.push_back(vertex);
+				dead_end.push_back(vertex);
+				candidates.push_back(vertex);
+				live_triangles[vertex]--;
+				if (time - cache_times[vertex] > cache_size) {
+					cache_times[vertex] = time++;
+				}
+			}
+			emitted[triangle] = true;
+		}
+
+		// Continue with the candidate that stays in the cache longest while still having triangles left.
+		fanning_vertex = NO_VERTEX;
+		UINT64 best_priority = 0;
+		for (UINT vertex : candidates) {
+			if (live_triangles[vertex] == 0) {
+				continue;
+			}
+			UINT64 priority = 0;
+			if (time - cache_times[vertex] + 2 * live_triangles[vertex] <= cache_size) {
+				priority = time - cache_times[vertex];
+			}
+			if (fanning_vertex == NO_VERTEX || priority > best_priority) {
+				fanning_vertex = vertex;
+				best_priority = priority;
+			}
+		}
+
+		// Otherwise backtrack to recently used vertices, and finally to the next unprocessed vertex.
+		while (fanning_vertex == NO_VERTEX && !dead_end.empty()) {
+			UINT vertex = dead_end.back();
+			dead_end.pop_back();
+			if (live_triangles[vertex] > 0) {
+				fanning_vertex = vertex;
+			}
+		}
+		while (fanning_vertex == NO_VERTEX && cursor < vertex_count) {
+			if (live_triangles[cursor] > 0) {
+				fanning_vertex = static_cast<UINT>(cursor);
+			}
+			cursor++;
+		}
+	}
+
+	std::copy(output.begin(), output.end(), indices.begin());
+}
+
+void OptimizeVertexFetch(std::span<UINT> indices, std::vector<vertex_t>& vertices) {
+	std::vector<UINT> remap(vertices.size(), NO_VERTEX);
+	std::vector<vertex_t> reordered(vertices.size());
+	UINT next_vertex = 0;
+	for (UINT& index : indices) {
+		if (remap[index] == NO_VERTEX) {
+			reordered[next_vertex] = vertices[index];
+			remap[index] = next_vertex++;
+		}
+		index = remap[index];
+	}
+
+	// Vertices not referenced by any triangle are dropped.
+	reordered.resize(next_vertex);
+	vertices = std::move(reordered);
+}
@@ -0,0 +1,20 @@
+#pragma once
+
+#include "vertex.h"
+
+struct vertex_cache_stats_t {
+	// Average cache miss ratio: transformed vertices per triangle.
+	FLOAT acmr;
+	// Average transform to vertex ratio: transformed vertices per unique vertex; 1.0 is optimal.
+	FLOAT atvr;
+};
+
+// Simulates a FIFO post-transform cache of the given size over the triangle list.
+vertex_cache_stats_t AnalyzeVertexCache(std::span<const UINT> indices, std::size_t vertex_count, UINT cache_size);
+
+// Reorders the triangles for a post-transform cache of the given size (Tipsify, Sander et al. 2007).
+// Runs in time linear in the number of indices.
+void OptimizeVertexCache(std::span<UINT> indices, std::size_t vertex_count, UINT cache_size);
+
+// Reorders the vertices in order of first use by the triangle list and updates the indices to match.
+void OptimizeVertexFetch(std::span<UINT> indices, std::vector<vertex_t>& vertices);
@@ -0,0 +1,852 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "parallel_utils.h"
+
+using namespace DirectX;
+
+namespace {
+	constexpr UINT NO_VERTEX = UINT_MAX;
+	constexpr UINT MAX_PASSES = 64;
+	// Weight of the planes added along open borders and texture seams, relative to the triangle planes.
+	constexpr double BORDER_WEIGHT = 10.0;
+	// Chunks smaller than this are not worth a thread of their own.
+	constexpr std::size_t MIN_CHUNK_TRIANGLES = 1024;
+	// A level that keeps more than this fraction of the previous one ends the chain.
+	constexpr FLOAT MIN_LEVEL_REDUCTION = 0.95f;
+
+	enum class vertex_kind_t : BYTE {
+		// Interior vertex with a single wedge; collapses in any direction.
+		MANIFOLD,
+		// Vertex on an open border; collapses only along the border.
+		BORDER,
+		// Vertex on a texture seam with two wedges; both wedges collapse together along the seam.
+		SEAM,
+		LOCKED
+	};
+
+	// Sum of squared distances to a set of weighted planes: p^T A p + 2 b^T p + c.
+	struct quadric_t {
+		double a00 = 0, a11 = 0, a22 = 0, a01 = 0, a02 = 0, a12 = 0;
+		double b0 = 0, b1 = 0, b2 = 0;
+		double c = 0;
+		double weight = 0;
+
+		// Adds the plane n . p + d = 0, with n normalized.
+		void AddPlane(const XMFLOAT3& n, double d, double plane_weight) {
+			a00 += plane_weight * n.x * n.x;
+			a11 += plane_weight * n.y * n.y;
+			a22 += plane_weight * n.z * n.z;
+			a01 += plane_weight * n.x * n.y;
+			a02 += plane_weight * n.x * n.z;
+			a12 += plane_weight * n.y * n.z;
+			b0 += plane_weight * n.x * d;
+			b1 += plane_weight * n.y * d;
+			b2 += plane_weight * n.z * d;
+			c += plane_weight * d * d;
+			weight += plane_weight;
+		}
+
+		void Add(const quadric_t& other) {
+			a00 += other.a00; a11 += other.a11; a22 += other.a22;
+			a01 += other.a01; a02 += other.a02; a12 += other.a12;
+			b0 += other.b0; b1 += other.b1; b2 += other.b2;
+			c += other.c;
+			weight += other.weight;
+		}
+
+		// Weighted mean squared distance of p to the planes.
+		double Evaluate(const XMFLOAT3& p) const {
+			double x = p.x, y = p.y, z = p.z;
+			double error = a00 * x * x + a11 * y * y + a22 * z * z +
+				2 * (a01 * x * y + a02 * x * z + a12 * y * z) +
+				2 * (b0 * x + b1 * y + b2 * z) + c;
+			return weight > 0 ? std::max(error, 0.0) / weight : 0.0;
+		}
+	};
+
+	struct collapse_t {
+		UINT source;
+		UINT target;
+		double error;
+	};
+
+	UINT64 EdgeKey(UINT from, UINT to) {
+		return (static_cast<UINT64>(from) << 32) | to;
+	}
+
+	// Sorted directed edges of a triangle list, either between vertices or between positions.
+	class EdgeSet {
+	public:
+		EdgeSet(std::span<const UINT> indices, std::span<const UINT> remap) {
+			edges.reserve(indices.size());
+			for (std::size_t i = 0; i < indices.size(); i += 3) {
+				for (std::size_t corner = 0; corner < 3; corner++) {
+					UINT from = indices[i + corner];
+					UINT to = indices[i + (corner + 1) % 3];
+					edges.push_back(remap.empty() ? EdgeKey(from, to) : EdgeKey(remap[from], remap[to]));
+				}
+			}
+			std::sort(edges.begin(), edges.end());
+		}
+
+		bool Contains(UINT from, UINT to) const {
+			return std::binary_search(edges.begin(), edges.end(), EdgeKey(from, to));
+		}
+
+		// An edge is open when no triangle uses it in the opposite direction.
+		bool IsOpen(UINT from, UINT to) const {
+			return !Contains(from, to) || !Contains(to, from);
+		}
+
+	private:
+		std::vector<UINT64> edges;
+	};
+
+	struct vertex_adjacency_t {
+		std::vector<UINT> offsets;
+		std::vector<UINT> triangles;
+	};
+
+	vertex_adjacency_t BuildAdjacency(std::span<const UINT> indices, std::size_t vertex_count) {
+		vertex_adjacency_t adjacency;
+		adjacency.offsets.assign(vertex_count + 1, 0);
+		for (UINT index : indices) {
+			adjacency.offsets[index + 1]++;
+		}
+		for (std::size_t vertex = 0; vertex < vertex_count; vertex++) {
+			adjacency.offsets[vertex + 1] += adjacency.offsets[vertex];
+		}
+
+		adjacency.triangles.resize(indices.size());
+		std::vector<UINT> next(adjacency.offsets.begin(), adjacency.offsets.end() - 1);
+		for (std::size_t i = 0; i < indices.size(); i++) {
+			adjacency.triangles[next[indices[i]]++] = static_cast<UINT>(i / 3);
+		}
+		return adjacency;
+	}
+
+	bool PositionLess(const XMFLOAT3& a, const XMFLOAT3& b) {
+		if (a.x != b.x) return a.x < b.x;
+		if (a.y != b.y) return a.y < b.y;
+		return a.z < b.z;
+	}
+
+	bool PositionEqual(const XMFLOAT3& a, const XMFLOAT3& b) {
+		return a.x == b.x && a.y == b.y && a.z == b.z;
+	}
+
+	// Groups the vertices sharing a position: reps maps each vertex to the first vertex of its group, and
+	// wedges links the vertices of each group into a cycle.
+	void BuildPositionGroups(std::span<const XMFLOAT3> positions, std::vector<UINT>& reps, std::vector<UINT>& wedges) {
+		std::vector<UINT> order(positions.size());
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](UINT a, UINT b) {
+			return PositionLess(positions[a], positions[b]);
+		});
+
+		reps.resize(positions.size());
+		wedges.resize(positions.size());
+		std::size_t group_begin = 0;
+		for (std::size_t i = 1; i <= order.size(); i++) {
+			if (i < order.size() && PositionEqual(positions[order[i]], positions[order[group_begin]])) {
+				continue;
+			}
+			for (std::size_t j = group_begin; j < i; j++) {
+				reps[order[j]] = order[group_begin];
+				wedges[order[j]] = order[j + 1 < i ? j + 1 : group_begin];
+			}
+			group_begin = i;
+		}
+	}
+
+	std::vector<vertex_kind_t> ClassifyVertices(std::span<const UINT> indices, std::span<const UINT> reps,
+		std::span<const UINT> wedges, std::span<const BYTE> locked, const EdgeSet& vertex_edges,
+		const EdgeSet& position_edges) {
+		std::size_t vertex_count = reps.size();
+		std::vector<UINT> open_out(vertex_count, 0), open_in(vertex_count, 0);
+		std::vector<UINT> seam_out(vertex_count, 0), seam_in(vertex_count, 0);
+		for (std::size_t i = 0; i < indices.size(); i += 3) {
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				UINT from = indices[i + corner];
+				UINT to = indices[i + (corner + 1) % 3];
+				if (!position_edges.Contains(reps[to], reps[from])) {
+					open_out[reps[from]]++;
+					open_in[reps[to]]++;
+				}
+				if (!vertex_edges.Contains(to, from)) {
+					seam_out[from]++;
+					seam_in[to]++;
+				}
+			}
+		}
+
+		std::vector<vertex_kind_t> kinds(vertex_count, vertex_kind_t::LOCKED);
+		for (std::size_t vertex = 0; vertex < vertex_count; vertex++) {
+			UINT rep = reps[vertex];
+			UINT sibling = wedges[vertex];
+			if (locked[vertex]) {
+				continue;
+			}
+			if (sibling == vertex) {
+				if (open_out[rep] == 0 && open_in[rep] == 0) {
+					kinds[vertex] = vertex_kind_t::MANIFOLD;
+				}
+				else if (open_out[rep] == 1 && open_in[rep] == 1) {
+					kinds[vertex] = vertex_kind_t::BORDER;
+				}
+			}
+			else if (wedges[sibling] == vertex && !locked[sibling] && open_out[rep] == 0 && open_in[rep] == 0 &&
+				seam_out[vertex] == 1 && seam_in[vertex] == 1 && seam_out[sibling] == 1 && seam_in[sibling] == 1) {
+				kinds[vertex] = vertex_kind_t::SEAM;
+			}
+		}
+		return kinds;
+	}
+
+	XMVECTOR TriangleNormal(const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2) {
+		XMVECTOR v0 = XMLoadFloat3(&p0);
+		return XMVector3Cross(XMVectorSubtract(XMLoadFloat3(&p1), v0), XMVectorSubtract(XMLoadFloat3(&p2), v0));
+	}
+
+	// Squared distance from p to the nearest point of the triangle abc, found by the Voronoi region of the
+	// triangle that p projects into (Ericson, Real-Time Collision Detection, 5.1.5).
+	FLOAT PointTriangleDistanceSq(const XMFLOAT3& point, const XMFLOAT3& p0, const XMFLOAT3& p1, const XMFLOAT3& p2) {
+		XMVECTOR p = XMLoadFloat3(&point);
+		XMVECTOR a = XMLoadFloat3(&p0), b = XMLoadFloat3(&p1), c = XMLoadFloat3(&p2);
+		auto dot = [](FXMVECTOR u, FXMVECTOR v) { return XMVectorGetX(XMVector3Dot(u, v)); };
+		auto distance_sq = [&](FXMVECTOR nearest) {
+			return XMVectorGetX(XMVector3LengthSq(XMVectorSubtract(p, nearest)));
+		};
+
+		XMVECTOR ab = XMVectorSubtract(b, a), ac = XMVectorSubtract(c, a);
+		XMVECTOR ap = XMVectorSubtract(p, a), bp = XMVectorSubtract(p, b), cp = XMVectorSubtract(p, c);
+		FLOAT d1 = dot(ab, ap), d2 = dot(ac, ap);
+		FLOAT d3 = dot(ab, bp), d4 = dot(ac, bp);
+		FLOAT d5 = dot(ab, cp), d6 = dot(ac, cp);
+		if (d1 <= 0.0f && d2 <= 0.0f) {
+			return distance_sq(a);
+		}
+		if (d3 >= 0.0f && d4 <= d3) {
+			return distance_sq(b);
+		}
+		if (d6 >= 0.0f && d5 <= d6) {
+			return distance_sq(c);
+		}
+		FLOAT vc = d1 * d4 - d3 * d2;
+		if (vc <= 0.0f && d1 >= 0.0f && d3 <= 0.0f) {
+			return distance_sq(XMVectorMultiplyAdd(XMVectorReplicate(d1 / (d1 - d3)), ab, a));
+		}
+		FLOAT vb = d5 * d2 - d1 * d6;
+		if (vb <= 0.0f && d2 >= 0.0f && d6 <= 0.0f) {
+			return distance_sq(XMVectorMultiplyAdd(XMVectorReplicate(d2 / (d2 - d6)), ac, a));
+		}
+		FLOAT va = d3 * d6 - d5 * d4;
+		if (va <= 0.0f && d4 - d3 >= 0.0f && d5 - d6 >= 0.0f) {
+			return distance_sq(XMVectorMultiplyAdd(XMVectorReplicate((d4 - d3) / ((d4 - d3) + (d5 - d6))),
+				XMVectorSubtract(c, b), b));
+		}
+		FLOAT sum = va + vb + vc;
+		if (sum <= 0.0f) {
+			// A degenerate triangle that none of the regions above caught; its corners are close enough.
+			return std::min({ distance_sq(a), distance_sq(b), distance_sq(c) });
+		}
+		return distance_sq(XMVectorMultiplyAdd(XMVectorReplicate(vc / sum), ac,
+			XMVectorMultiplyAdd(XMVectorReplicate(vb / sum), ab, a)));
+	}
+
+	// Accumulates the plane of every triangle, weighted by area, and planes perpendicular to the open borders
+	// and the texture seams, the edges whose opposite edge uses other vertices or does not exist, so that
+	// both keep their shape.
+	std::vector<quadric_t> ComputeQuadrics(std::span<const UINT> indices, std::span<const XMFLOAT3> positions,
+		std::span<const UINT> reps, const EdgeSet& vertex_edges) {
+		std::vector<quadric_t> quadrics(positions.size());
+		for (std::size_t i = 0; i < indices.size(); i += 3) {
+			const XMFLOAT3& p0 = positions[indices[i]];
+			XMVECTOR normal = TriangleNormal(p0, positions[indices[i + 1]], positions[indices[i + 2]]);
+			FLOAT length = XMVectorGetX(XMVector3Length(normal));
+			if (length == 0.0f) {
+				continue;
+			}
+			XMFLOAT3 n;
+			XMStoreFloat3(&n, XMVectorScale(normal, 1.0f / length));
+			double d = -(n.x * p0.x + n.y * p0.y + n.z * p0.z);
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				quadrics[reps[indices[i + corner]]].AddPlane(n, d, length * 0.5);
+			}
+
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				UINT from_vertex = indices[i + corner];
+				UINT to_vertex = indices[i + (corner + 1) % 3];
+				if (vertex_edges.Contains(to_vertex, from_vertex)) {
+					continue;
+				}
+				UINT from = reps[from_vertex];
+				UINT to = reps[to_vertex];
+				XMVECTOR edge = XMVectorSubtract(XMLoadFloat3(&positions[to]), XMLoadFloat3(&positions[from]));
+				XMVECTOR perpendicular = XMVector3Cross(edge, normal);
+				FLOAT perpendicular_length = XMVectorGetX(XMVector3Length(perpendicular));
+				if (perpendicular_length == 0.0f) {
+					continue;
+				}
+				XMFLOAT3 border_n;
+				XMStoreFloat3(&border_n, XMVectorScale(perpendicular, 1.0f / perpendicular_length));
+				const XMFLOAT3& origin = positions[from];
+				double border_d = -(border_n.x * origin.x + border_n.y * origin.y + border_n.z * origin.z);
+				double edge_weight = BORDER_WEIGHT * XMVectorGetX(XMVector3LengthSq(edge));
+				quadrics[from].AddPlane(border_n, border_d, edge_weight);
+				quadrics[to].AddPlane(border_n, border_d, edge_weight);
+			}
+		}
+		return quadrics;
+	}
+}
+
+namespace {
+	// Triangles binned into a uniform grid of cells about the size of a triangle, for finding the nearest
+	// one to a point without testing them all.
+	class TriangleGrid {
+	public:
+		TriangleGrid(std::span<const UINT> indices, std::span<const XMFLOAT3> positions)
+			: indices(indices), positions(positions) {
+			std::size_t triangle_count = indices.size() / 3;
+			XMVECTOR minimum = XMVectorReplicate(FLT_MAX), maximum = XMVectorReplicate(-FLT_MAX);
+			FLOAT size_sum = 0.0f;
+			for (std::size_t i = 0; i < indices.size(); i += 3) {
+				XMVECTOR triangle_min, triangle_max;
+				GetBounds(i, triangle_min, triangle_max);
+				minimum = XMVectorMin(minimum, triangle_min);
+				maximum = XMVectorMax(maximum, triangle_max);
+				XMFLOAT3 size;
+				XMStoreFloat3(&size, XMVectorSubtract(triangle_max, triangle_min));
+				size_sum += std::max({ size.x, size.y, size.z });
+			}
+			XMStoreFloat3(&grid_min, minimum);
+			XMFLOAT3 extent;
+			XMStoreFloat3(&extent, XMVectorSubtract(maximum, minimum));
+
+			// At most a few cells per triangle, however thin the triangles are.
+			FLOAT largest_extent = std::max({ extent.x, extent.y, extent.z });
+			cell_size = std::max(size_sum / triangle_count, largest_extent / 1024.0f);
+			while (cell_size > 0.0f && CellCount(extent) > 4 * triangle_count + 64) {
+				cell_size *= 1.5f;
+			}
+			if (cell_size == 0.0f) {
+				// Every triangle collapses to the same point.
+				cell_size = 1.0f;
+			}
+			for (UINT axis = 0; axis < 3; axis++) {
+				dimensions[axis] = static_cast<UINT>((&extent.x)[axis] / cell_size) + 1;
+			}
+
+			// The triangles of each cell, in two passes: counting, then filling.
+			cell_offsets.assign(dimensions[0] * dimensions[1] * dimensions[2] + 1, 0);
+			std::vector<UINT> next;
+			for (int pass = 0; pass < 2; pass++) {
+				for (std::size_t i = 0; i < indices.size(); i += 3) {
+					XMVECTOR triangle_min, triangle_max;
+					GetBounds(i, triangle_min, triangle_max);
+					UINT first[3], last[3];
+					GetCell(triangle_min, first);
+					GetCell(triangle_max, last);
+					for (UINT z = first[2]; z <= last[2]; z++) {
+						for (UINT y = first[1]; y <= last[1]; y++) {
+							for (UINT x = first[0]; x <= last[0]; x++) {
+								UINT cell = CellIndex(x, y, z);
+								if (pass == 0) {
+									cell_offsets[cell + 1]++;
+								}
+								else {
+									cell_triangles[next[cell]++] = static_cast<UINT>(i / 3);
+								}
+							}
+						}
+					}
+				}
+				if (pass == 0) {
+					std::partial_sum(cell_offsets.begin(), cell_offsets.end(), cell_offsets.begin());
+					cell_triangles.resize(cell_offsets.back());
+					next.assign(cell_offsets.begin(), cell_offsets.end() - 1);
+				}
+			}
+		}
+
+		// Squared distance from point to the nearest triangle, searching shells of cells around the cell of
+		// the point until the next shell cannot hold anything nearer.
+		FLOAT DistanceSq(const XMFLOAT3& point) const {
+			UINT center[3];
+			GetCell(XMLoadFloat3(&point), center);
+			UINT max_radius = std::max({ dimensions[0], dimensions[1], dimensions[2] });
+			FLOAT best = FLT_MAX;
+			for (UINT radius = 0; radius <= max_radius; radius++) {
+				// A point outside the grid is at least as far from every cell as its nearest point in the
+				// grid, so the bound holds for it too.
+				FLOAT bound = radius * cell_size;
+				if (radius > 0 && best <= bound * bound) {
+					break;
+				}
+				UINT first[3], last[3];
+				for (UINT axis = 0; axis < 3; axis++) {
+					first[axis] = center[axis] >= radius ? center[axis] - radius : 0;
+					last[axis] = std::min(center[axis] + radius, dimensions[axis] - 1);
+				}
+				for (UINT z = first[2]; z <= last[2]; z++) {
+					for (UINT y = first[1]; y <= last[1]; y++) {
+						for (UINT x = first[0]; x <= last[0]; x++) {
+							// Only the shell; the cells inside it were searched with the smaller radii.
+							if (std::max({ Distance(x, center[0]), Distance(y, center[1]), Distance(z, center[2]) }) !=
+								radius) {
+								continue;
+							}
+							UINT cell = CellIndex(x, y, z);
+							for (UINT i = cell_offsets[cell]; i < cell_offsets[cell + 1]; i++) {
+								const UINT* triangle = &indices[cell_triangles[i] * 3];
+								best = std::min(best, PointTriangleDistanceSq(point, positions[triangle[0]],
+									positions[triangle[1]], positions[triangle[2]]));
+							}
+						}
+					}
+				}
+			}
+			return best;
+		}
+
+	private:
+		std::span<const UINT> indices;
+		std::span<const XMFLOAT3> positions;
+		XMFLOAT3 grid_min;
+		FLOAT cell_size;
+		UINT dimensions[3];
+		std::vector<UINT> cell_offsets;
+		std::vector<UINT> cell_triangles;
+
+		void GetBounds(std::size_t first_index, XMVECTOR& minimum, XMVECTOR& maximum) const {
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[first_index]]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[indices[first_index + 1]]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[indices[first_index + 2]]);
+			minimum = XMVectorMin(XMVectorMin(p0, p1), p2);
+			maximum = XMVectorMax(XMVectorMax(p0, p1), p2);
+		}
+
+		std::size_t CellCount(const XMFLOAT3& extent) const {
+			std::size_t count = 1;
+			for (UINT axis = 0; axis < 3; axis++) {
+				count *= static_cast<std::size_t>((&extent.x)[axis] / cell_size) + 1;
+			}
+			return count;
+		}
+
+		// The cell containing the point, or the nearest one for a point outside the grid.
+		void GetCell(FXMVECTOR point, UINT cell[3]) const {
+			XMFLOAT3 offset;
+			XMStoreFloat3(&offset, XMVectorScale(XMVectorSubtract(point, XMLoadFloat3(&grid_min)), 1.0f / cell_size));
+			for (UINT axis = 0; axis < 3; axis++) {
+				FLOAT coordinate = std::clamp((&offset.x)[axis], 0.0f, static_cast<FLOAT>(dimensions[axis] - 1));
+				cell[axis] = static_cast<UINT>(coordinate);
+			}
+		}
+
+		UINT CellIndex(UINT x, UINT y, UINT z) const {
+			return (z * dimensions[1] + y) * dimensions[0] + x;
+		}
+
+		static UINT Distance(UINT a, UINT b) {
+			return a > b ? a - b : b - a;
+		}
+	};
+
+	// Largest distance of a vertex of the original triangles from the simplified ones, sampling the original
+	// surface at its vertices. Vertices that are still used have no error.
+	FLOAT MeasureSimplifiedError(std::span<const UINT> indices, std::span<const UINT> simplified,
+		std::span<const XMFLOAT3> positions) {
+		if (simplified.empty()) {
+			// Nothing is left to be near the original surface.
+			return indices.empty() ? 0.0f : std::numeric_limits<FLOAT>::infinity();
+		}
+
+		std::vector<BYTE> measured(positions.size(), 0);
+		for (UINT vertex : simplified) {
+			measured[vertex] = 1;
+		}
+		TriangleGrid grid(simplified, positions);
+		FLOAT error_sq = 0.0f;
+		for (UINT vertex : indices) {
+			if (!measured[vertex]) {
+				measured[vertex] = 1;
+				error_sq = std::max(error_sq, grid.DistanceSq(positions[vertex]));
+			}
+		}
+		return std::sqrt(error_sq);
+	}
+}
+
+std::size_t SimplifyMesh(std::span<UINT> destination, std::span<const UINT> indices,
+	std::span<const XMFLOAT3> positions, std::span<const BYTE> locked, std::size_t target_index_count,
+	FLOAT target_error, FLOAT& result_error) {
+	std::size_t vertex_count = positions.size();
+	std::vector<UINT> result(indices.begin(), indices.end());
+	result_error = 0.0f;
+
+	std::vector<UINT> reps, wedges;
+	BuildPositionGroups(positions, reps, wedges);
+
+	std::vector<vertex_kind_t> kinds;
+	std::vector<quadric_t> quadrics;
+	{
+		EdgeSet vertex_edges(result, {});
+		EdgeSet position_edges(result, reps);
+		kinds = ClassifyVertices(result, reps, wedges, locked, vertex_edges, position_edges);
+		quadrics = ComputeQuadrics(result, positions, reps, vertex_edges);
+	}
+
+	// Errors are compared squared, as the quadrics measure them.
+	const double error_limit = static_cast<double>(target_error) * target_error;
+	std::vector<UINT> remap(vertex_count);
+	std::vector<BYTE> pass_locked(vertex_count);
+	std::vector<collapse_t> collapses;
+
+	for (UINT pass = 0; pass < MAX_PASSES && result.size() > target_index_count; pass++) {
+		EdgeSet vertex_edges(result, {});
+		EdgeSet position_edges(result, reps);
+		vertex_adjacency_t adjacency = BuildAdjacency(result, vertex_count);
+
+		auto can_collapse = [&](UINT source, UINT target) {
+			if (reps[source] == reps[target]) {
+				return false;
+			}
+			vertex_kind_t target_kind = kinds[target];
+			switch (kinds[source]) {
+			case vertex_kind_t::MANIFOLD:
+				return true;
+			case vertex_kind_t::BORDER:
+				return (target_kind == vertex_kind_t::BORDER || target_kind == vertex_kind_t::LOCKED) &&
+					position_edges.IsOpen(reps[source], reps[target]);
+			case vertex_kind_t::SEAM:
+				return (target_kind == vertex_kind_t::SEAM || target_kind == vertex_kind_t::LOCKED) &&
+					vertex_edges.IsOpen(source, target);
+			default:
+				return false;
+			}
+		};
+
+		// The wedge of target's position connected to source's seam sibling, which collapses along with it.
+		auto find_sibling_target = [&](UINT source, UINT target) {
+			UINT sibling = wedges[source];
+			UINT candidate = target;
+			do {
+				if (candidate != target && (vertex_edges.Contains(sibling, candidate) ||
+					vertex_edges.Contains(candidate, sibling))) {
+					return candidate;
+				}
+				candidate = wedges[candidate];
+			} while (candidate != target);
+			return NO_VERTEX;
+		};
+
+		// Moving source onto target must not turn any remaining triangle around source upside down.
+		auto has_flips = [&](UINT source, UINT target) {
+			for (UINT i = adjacency.offsets[source]; i < adjacency.offsets[source + 1]; i++) {
+				const UINT* triangle = &result[adjacency.triangles[i] * 3];
+				if (reps[triangle[0]] == reps[target] || reps[triangle[1]] == reps[target] ||
+					reps[triangle[2]] == reps[target]) {
+					continue;
+				}
+				XMFLOAT3 moved[3];
+				for (std::size_t corner = 0; corner < 3; corner++) {
+					moved[corner] = positions[triangle[corner] == source ? target : triangle[corner]];
+				}
+				XMVECTOR before = TriangleNormal(positions[triangle[0]], positions[triangle[1]], positions[triangle[2]]);
+				XMVECTOR after = TriangleNormal(moved[0], moved[1], moved[2]);
+				if (XMVectorGetX(XMVector3Dot(before, after)) <= 0.0f) {
+					return true;
+				}
+			}
+			return false;
+		};
+
+		auto count_collapsed = [&](UINT source, UINT target) {
+			std::size_t count = 0;
+			for (UINT i = adjacency.offsets[source]; i < adjacency.offsets[source + 1]; i++) {
+				const UINT* triangle = &result[adjacency.triangles[i] * 3];
+				count += triangle[0] == target || triangle[1] == target || triangle[2] == target;
+			}
+			return count;
+		};
+
+		auto lock_ring = [&](UINT vertex) {
+			for (UINT i = adjacency.offsets[vertex]; i < adjacency.offsets[vertex + 1]; i++) {
+				const UINT* triangle = &result[adjacency.triangles[i] * 3];
+				pass_locked[triangle[0]] = pass_locked[triangle[1]] = pass_locked[triangle[2]] = 1;
+			}
+		};
+
+		collapses.clear();
+		for (std::size_t i = 0; i < result.size(); i += 3) {
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				UINT a = result[i + corner];
+				UINT b = result[i + (corner + 1) % 3];
+				for (auto [source, target] : { std::pair(a, b), std::pair(b, a) }) {
+					if (!can_collapse(source, target)) {
+						continue;
+					}
+					quadric_t merged = quadrics[reps[source]];
+					merged.Add(quadrics[reps[target]]);
+					collapses.push_back({ source, target, merged.Evaluate(positions[target]) });
+				}
+			}
+		}
+		std::sort(collapses.begin(), collapses.end(), [](const collapse_t& a, const collapse_t& b) {
+			return a.error < b.error;
+		});
+
+		// Apply the cheapest collapses whose neighbourhoods do not overlap.
+		std::iota(remap.begin(), remap.end(), 0u);
+		std::fill(pass_locked.begin(), pass_locked.end(), BYTE{ 0 });
+		std::size_t triangle_count = result.size() / 3;
+		std::size_t target_triangle_count = target_index_count / 3;
+		std::size_t applied = 0;
+		for (const collapse_t& collapse : collapses) {
+			if (collapse.error > error_limit || triangle_count <= target_triangle_count) {
+				break;
+			}
+			UINT source = collapse.source;
+			UINT target = collapse.target;
+			if (pass_locked[source] || pass_locked[target]) {
+				continue;
+			}
+
+			UINT sibling = NO_VERTEX, sibling_target = NO_VERTEX;
+			if (kinds[source] == vertex_kind_t::SEAM) {
+				sibling = wedges[source];
+				sibling_target = find_sibling_target(source, target);
+				if (sibling_target == NO_VERTEX || pass_locked[sibling] || pass_locked[sibling_target]) {
+					continue;
+				}
+			}
+			if (has_flips(source, target) || (sibling != NO_VERTEX && has_flips(sibling, sibling_target))) {
+				continue;
+			}
+
+			remap[source] = target;
+			triangle_count -= count_collapsed(source, target);
+			lock_ring(source);
+			lock_ring(target);
+			if (sibling != NO_VERTEX) {
+				remap[sibling] = sibling_target;
+				triangle_count -= count_collapsed(sibling, sibling_target);
+				lock_ring(sibling);
+				lock_ring(sibling_target);
+			}
+			quadrics[reps[target]].Add(quadrics[reps[source]]);
+			applied++;
+		}
+		if (applied == 0) {
+			break;
+		}
+
+		// Collapsed vertices are never targets in the same pass, so a single remap step is enough.
+		std::size_t write = 0;
+		for (std::size_t i = 0; i < result.size(); i += 3) {
+			UINT i0 = remap[result[i]], i1 = remap[result[i + 1]], i2 = remap[result[i + 2]];
+			if (reps[i0] == reps[i1] || reps[i1] == reps[i2] || reps[i0] == reps[i2]) {
+				continue;
+			}
+			result[write++] = i0;
+			result[write++] = i1;
+			result[write++] = i2;
+		}
+		result.resize(write);
+	}
+
+	result_error = MeasureSimplifiedError(indices, result, positions);
+	std::copy(result.begin(), result.end(), destination.begin());
+	return result.size();
+}
+
+namespace {
+	// Vertices and triangles of one chunk, with the vertices renumbered from zero.
+	struct lod_chunk_t {
+		std::vector<UINT> vertices;
+		std::vector<XMFLOAT3> positions;
+		std::vector<BYTE> locked;
+		std::vector<UINT> indices;
+	};
+
+	UINT SpreadBits(UINT value) {
+		// Interleaves the low 10 bits with two zero bits each, for a 30-bit Morton code.
+		value &= 0x3ff;
+		value = (value | (value << 16)) & 0x030000ff;
+		value = (value | (value << 8)) & 0x0300f00f;
+		value = (value | (value << 4)) & 0x030c30c3;
+		value = (value | (value << 2)) & 0x09249249;
+		return value;
+	}
+
+	// Splits the triangles into chunks of equal size along the Morton order of their centroids.
+	std::vector<std::vector<UINT>> SplitIntoChunks(std::span<const UINT> indices, std::span<const XMFLOAT3> positions,
+		std::size_t chunk_count, XMVECTOR minimum, XMVECTOR extent) {
+		std::size_t triangle_count = indices.size() / 3;
+		XMVECTOR scale = XMVectorDivide(XMVectorReplicate(1023.0f), XMVectorMax(extent, XMVectorReplicate(FLT_MIN)));
+		std::vector<UINT> codes(triangle_count);
+		for (std::size_t triangle = 0; triangle < triangle_count; triangle++) {
+			XMVECTOR centroid = XMVectorAdd(XMVectorAdd(
+				XMLoadFloat3(&positions[indices[triangle * 3]]), XMLoadFloat3(&positions[indices[triangle * 3 + 1]])),
+				XMLoadFloat3(&positions[indices[triangle * 3 + 2]]));
+			XMVECTOR cell = XMVectorMultiply(XMVectorSubtract(XMVectorScale(centroid, 1.0f / 3.0f), minimum), scale);
+			XMFLOAT3 grid;
+			XMStoreFloat3(&grid, XMVectorClamp(cell, XMVectorZero(), XMVectorReplicate(1023.0f)));
+			codes[triangle] = SpreadBits(static_cast<UINT>(grid.x)) | (SpreadBits(static_cast<UINT>(grid.y)) << 1) |
+				(SpreadBits(static_cast<UINT>(grid.z)) << 2);
+		}
+
+		std::vector<UINT> order(triangle_count);
+		std::iota(order.begin(), order.end(), 0u);
+		std::stable_sort(order.begin(), order.end(), [&](UINT a, UINT b) { return codes[a] < codes[b]; });
+
+		std::vector<std::vector<UINT>> chunks(chunk_count);
+		for (std::size_t chunk = 0; chunk < chunk_count; chunk++) {
+			std::size_t begin = triangle_count * chunk / chunk_count;
+			std::size_t end = triangle_count * (chunk + 1) / chunk_count;
+			chunks[chunk].assign(order.begin() + begin, order.begin() + end);
+		}
+		return chunks;
+	}
+}
+
+std::vector<lod_level_t> GenerateLodChain(std::vector<UINT>& indices, std::span<const vertex_t> vertices,
+	const lod_options_t& options, UINT thread_count, std::vector<lod_level_t>& chunk_levels) {
+	std::vector<lod_level_t> levels = { { .first_index = 0, .index_count = static_cast<UINT>(indices.size()), .error = 0.0f } };
+	if (options.level_count == 0 || indices.empty()) {
+		chunk_levels = levels;
+		return levels;
+	}
+
+	std::vector<XMFLOAT3> positions(vertices.size());
+	XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+	XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+	for (std::size_t i = 0; i < vertices.size(); i++) {
+		positions[i] = { vertices[i].position[0], vertices[i].position[1], vertices[i].position[2] };
+		XMVECTOR position = XMLoadFloat3(&positions[i]);
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+	XMFLOAT3 extent;
+	XMStoreFloat3(&extent, XMVectorSubtract(maximum, minimum));
+	FLOAT error_limit = options.target_error * std::max({ extent.x, extent.y, extent.z });
+
+	std::size_t triangle_count = indices.size() / 3;
+	std::size_t chunk_count = std::clamp<std::size_t>(triangle_count / MIN_CHUNK_TRIANGLES, 1,
+		std::max(options.chunk_count, 1u));
+	std::vector<std::vector<UINT>> chunk_triangles = SplitIntoChunks(indices, positions, chunk_count, minimum,
+		XMLoadFloat3(&extent));
+	for (std::vector<UINT>& triangles : chunk_triangles) {
+		std::sort(triangles.begin(), triangles.end());
+	}
+
+	// Positions used by more than one chunk are locked, wherever they appear.
+	constexpr UINT UNUSED = UINT_MAX, SHARED = UINT_MAX - 1;
+	std::vector<UINT> reps, wedges;
+	BuildPositionGroups(positions, reps, wedges);
+	std::vector<UINT> position_chunks(vertices.size(), UNUSED);
+	for (std::size_t chunk = 0; chunk < chunk_count; chunk++) {
+		for (UINT triangle : chunk_triangles[chunk]) {
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				UINT& owner = position_chunks[reps[indices[triangle * 3 + corner]]];
+				owner = owner == UNUSED || owner == chunk ? static_cast<UINT>(chunk) : SHARED;
+			}
+		}
+	}
+
+	std::size_t worker_count = std::clamp<std::size_t>(thread_count, 1, chunk_count);
+	std::vector<lod_chunk_t> chunks(chunk_count);
+	ParallelFor(worker_count, [&](std::size_t worker) {
+		for (std::size_t c = worker; c < chunk_count; c += worker_count) {
+			lod_chunk_t& chunk = chunks[c];
+			for (UINT triangle : chunk_triangles[c]) {
+				chunk.vertices.insert(chunk.vertices.end(), &indices[triangle * 3], &indices[triangle * 3] + 3);
+			}
+			std::sort(chunk.vertices.begin(), chunk.vertices.end());
+			chunk.vertices.erase(std::unique(chunk.vertices.begin(), chunk.vertices.end()), chunk.vertices.end());
+
+			for (UINT vertex : chunk.vertices) {
+				chunk.positions.push_back(positions[vertex]);
+				chunk.locked.push_back(position_chunks[reps[vertex]] == SHARED);
+			}
+			chunk.indices.reserve(chunk_triangles[c].size() * 3);
+			for (UINT triangle : chunk_triangles[c]) {
+				for (std::size_t corner = 0; corner < 3; corner++) {
+					auto local = std::lower_bound(chunk.vertices.begin(), chunk.vertices.end(), indices[triangle * 3 + corner]);
+					chunk.indices.push_back(static_cast<UINT>(local - chunk.vertices.begin()));
+				}
+			}
+		}
+	});
+
+	// Level 0 is regrouped by chunk, like the simplified levels, so that each chunk can select its own level.
+	std::vector<std::vector<lod_level_t>> chunk_lods(chunk_count);
+	std::vector<UINT> full_detail(indices.begin(), indices.end());
+	std::size_t write = 0;
+	for (std::size_t c = 0; c < chunk_count; c++) {
+		chunk_lods[c].push_back({ .first_index = static_cast<UINT>(write),
+			.index_count = static_cast<UINT>(chunk_triangles[c].size() * 3), .error = 0.0f });
+		for (UINT triangle : chunk_triangles[c]) {
+			std::copy_n(&full_detail[triangle * 3], 3, &indices[write]);
+			write += 3;
+		}
+	}
+
+	// Every level is simplified from level 0, so that its error is measured against the full-detail mesh.
+	std::vector<std::vector<UINT>> chunk_results(chunk_count);
+	std::vector<FLOAT> chunk_errors(chunk_count);
+	FLOAT ratio = 1.0f;
+	for (UINT level = 1; level <= options.level_count; level++) {
+		ratio *= options.target_ratio;
+		ParallelFor(worker_count, [&](std::size_t worker) {
+			for (std::size_t c = worker; c < chunk_count; c += worker_count) {
+				const lod_chunk_t& chunk = chunks[c];
+				std::size_t target_index_count = static_cast<std::size_t>(chunk.indices.size() / 3 * ratio) * 3;
+				chunk_results[c].resize(chunk.indices.size());
+				std::size_t index_count = SimplifyMesh(chunk_results[c], chunk.indices, chunk.positions, chunk.locked,
+					target_index_count, error_limit, chunk_errors[c]);
+				chunk_results[c].resize(index_count);
+			}
+		});
+
+		std::size_t index_count = 0;
+		for (const auto& result : chunk_results) {
+			index_count += result.size();
+		}
+		if (index_count > levels.back().index_count * MIN_LEVEL_REDUCTION) {
+			break;
+		}
+
+		lod_level_t lod = {
+			.first_index = static_cast<UINT>(indices.size()),
+			.index_count = static_cast<UINT>(index_count),
+			.error = *std::max_element(chunk_errors.begin(), chunk_errors.end())
+		};
+		for (std::size_t c = 0; c < chunk_count; c++) {
+			chunk_lods[c].push_back({ .first_index = static_cast<UINT>(indices.size()),
+				.index_count = static_cast<UINT>(chunk_results[c].size()), .error = chunk_errors[c] });
+			for (UINT local : chunk_results[c]) {
+				indices.push_back(chunks[c].vertices[local]);
+			}
+		}
+		levels.push_back(lod);
+	}
+
+	chunk_levels.clear();
+	for (const std::vector<lod_level_t>& lods : chunk_lods) {
+		chunk_levels.insert(chunk_levels.end(), lods.begin(), lods.end());
+	}
+	return levels;
+}
+
+UINT SelectLodLevel(std::span<const lod_level_t> levels, FLOAT distance, FLOAT pixels_per_unit,
+	FLOAT max_screen_error) {
+	for (std::size_t level = levels.size(); level-- > 1;) {
+		if (levels[level].error * pixels_per_unit <= max_screen_error * distance) {
+			return static_cast<UINT>(level);
+		}
+	}
+	return 0;
+}
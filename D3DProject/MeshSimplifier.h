@@ -0,0 +1,50 @@
+#pragma once
+
+#include "vertex.h"
+
+struct lod_options_t {
+	// Number of simplified levels generated after the full-detail level 0; 0 disables LOD generation.
+	UINT level_count = 3;
+	// Fraction of the triangles of the previous level each level aims to keep.
+	FLOAT target_ratio = 0.5f;
+	// Limit on the error of every collapse, relative to the largest extent of the mesh. Collapses are measured
+	// by their quadric error, the root mean square distance from the planes of the triangles merged into the
+	// collapsed vertex, so the largest distance of a level can exceed it.
+	FLOAT target_error = 0.01f;
+	// Number of spatial chunks simplified independently, and in parallel.
+	UINT chunk_count = 16;
+};
+
+struct lod_level_t {
+	UINT first_index;
+	UINT index_count;
+	// Largest distance of a vertex of the full-detail mesh from the nearest triangle of the level, in scene
+	// units.
+	FLOAT error;
+};
+
+// Simplifies a triangle list with quadric error metrics, collapsing vertices onto their neighbours until
+// the index count reaches target_index_count or the quadric error of the next collapse would exceed
+// target_error. Borders and texture seams are preserved, and vertices flagged in locked never move. Writes
+// the simplified indices to destination, which must be as large as indices, and returns their count.
+// result_error receives the largest distance of a vertex of indices from the simplified triangles, as
+// lod_level_t::error describes.
+std::size_t SimplifyMesh(std::span<UINT> destination, std::span<const UINT> indices,
+	std::span<const DirectX::XMFLOAT3> positions, std::span<const BYTE> locked, std::size_t target_index_count,
+	FLOAT target_error, FLOAT& result_error);
+
+// Appends the simplified levels to indices, which initially hold only level 0, and returns the ranges of
+// all levels, each with the largest error of its chunks. The mesh is split into spatial chunks that are
+// simplified on up to thread_count threads, with vertices on chunk boundaries locked, so that neighbouring
+// chunks stay connected whichever levels they are drawn at. The triangles of every level, level 0 included,
+// are grouped by chunk in the same chunk order; level 0 keeps the order of its triangles within a chunk.
+// chunk_levels receives the ranges and errors of the levels of each chunk, as many per chunk as there are
+// levels, the chunks one after another.
+std::vector<lod_level_t> GenerateLodChain(std::vector<UINT>& indices, std::span<const vertex_t> vertices,
+	const lod_options_t& options, UINT thread_count, std::vector<lod_level_t>& chunk_levels);
+
+// Returns the coarsest level whose error, seen from distance, covers at most max_screen_error pixels, where
+// one scene unit at a distance of one unit covers pixels_per_unit pixels. Level 0 has no error, so it is
+// returned when nothing coarser qualifies, such as at a distance of 0.
+UINT SelectLodLevel(std::span<const lod_level_t> levels, FLOAT distance, FLOAT pixels_per_unit,
+	FLOAT max_screen_error);
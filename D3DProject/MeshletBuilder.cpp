@@ -0,0 +1,147 @@
+#include "pch.h"
+#include "MeshletBuilder.h"
+
+using namespace DirectX;
+
+namespace {
+	constexpr BYTE NO_LOCAL_VERTEX = 0xff;
+	// Normal cones wider than this (minimum cosine to the axis) are not worth testing.
+	constexpr FLOAT MIN_CONE_SPREAD = 0.1f;
+
+	void ComputeBounds(meshlet_t& meshlet, std::span<const UINT> indices, std::span<const XMFLOAT3> positions) {
+		XMVECTOR minimum = XMVectorReplicate(FLT_MAX);
+		XMVECTOR maximum = XMVectorReplicate(-FLT_MAX);
+		XMVECTOR normal_sum = XMVectorZero();
+		std::vector<XMVECTOR> normals;
+		normals.reserve(meshlet.triangle_count);
+		for (UINT i = 0; i < meshlet.triangle_count * 3; i += 3) {
+			XMVECTOR p0 = XMLoadFloat3(&positions[indices[meshlet.first_index + i]]);
+			XMVECTOR p1 = XMLoadFloat3(&positions[indices[meshlet.first_index + i + 1]]);
+			XMVECTOR p2 = XMLoadFloat3(&positions[indices[meshlet.first_index + i + 2]]);
+			minimum = XMVectorMin(minimum, XMVectorMin(p0, XMVectorMin(p1, p2)));
+			maximum = XMVectorMax(maximum, XMVectorMax(p0, XMVectorMax(p1, p2)));
+
+			// Front faces are clockwise, so this normal points toward the side they are seen from.
+			XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0));
+			if (XMVectorGetX(XMVector3LengthSq(normal)) > 0.0f) {
+				normal = XMVector3Normalize(normal);
+				normals.push_back(normal);
+				normal_sum = XMVectorAdd(normal_sum, normal);
+			}
+		}
+
+		XMStoreFloat3(&meshlet.aabb_min, minimum);
+		XMStoreFloat3(&meshlet.aabb_max, maximum);
+		XMVECTOR center = XMVectorScale(XMVectorAdd(minimum, maximum), 0.5f);
+		XMStoreFloat3(&meshlet.center, center);
+		FLOAT radius_sq = 0.0f;
+		for (UINT i = 0; i < meshlet.triangle_count * 3; i++) {
+			XMVECTOR offset = XMVectorSubtract(XMLoadFloat3(&positions[indices[meshlet.first_index + i]]), center);
+			radius_sq = std::max(radius_sq, XMVectorGetX(XMVector3LengthSq(offset)));
+		}
+		meshlet.radius = std::sqrt(radius_sq);
+
+		meshlet.cone_axis = { 0.0f, 0.0f, 0.0f };
+		meshlet.cone_cutoff = 1.0f;
+		if (normals.empty() || XMVectorGetX(XMVector3LengthSq(normal_sum)) == 0.0f) {
+			return;
+		}
+		XMVECTOR axis = XMVector3Normalize(normal_sum);
+		FLOAT min_dot = 1.0f;
+		for (XMVECTOR normal : normals) {
+			min_dot = std::min(min_dot, XMVectorGetX(XMVector3Dot(normal, axis)));
+		}
+		XMStoreFloat3(&meshlet.cone_axis, axis);
+		if (min_dot > MIN_CONE_SPREAD) {
+			// Sine of the cone half-angle: the view direction must be this close to the axis.
+			meshlet.cone_cutoff = std::sqrt(1.0f - min_dot * min_dot);
+		}
+	}
+}
+
+meshlet_data_t BuildMeshlets(std::span<const UINT> indices, std::span<const XMFLOAT3> positions) {
+	meshlet_data_t data;
+	data.triangles.reserve(indices.size());
+	std::vector<BYTE> local_vertices(positions.size(), NO_LOCAL_VERTEX);
+
+	meshlet_t meshlet = {};
+	auto finish_meshlet = [&](UINT next_index) {
+		if (meshlet.triangle_count == 0) {
+			return;
+		}
+		for (UINT i = meshlet.vertex_offset; i < meshlet.vertex_offset + meshlet.vertex_count; i++) {
+			local_vertices[data.vertices[i]] = NO_LOCAL_VERTEX;
+		}
+		ComputeBounds(meshlet, indices, positions);
+		data.meshlets.push_back(meshlet);
+		meshlet = {
+			.first_index = next_index,
+			.vertex_offset = static_cast<UINT>(data.vertices.size()),
+			.triangle_offset = static_cast<UINT>(data.triangles.size())
+		};
+	};
+
+	for (std::size_t i = 0; i < indices.size(); i += 3) {
+		UINT new_vertices = 0;
+		for (std::size_t corner = 0; corner < 3; corner++) {
+			new_vertices += local_vertices[indices[i + corner]] == NO_LOCAL_VERTEX;
+		}
+		if (meshlet.vertex_count + new_vertices > MESHLET_MAX_VERTICES ||
+			meshlet.triangle_count == MESHLET_MAX_TRIANGLES) {
+			finish_meshlet(static_cast<UINT>(i));
+		}
+
+		for (std::size_t corner = 0; corner < 3; corner++) {
+			BYTE& local = local_vertices[indices[i + corner]];
+			if (local == NO_LOCAL_VERTEX) {
+				local = static_cast<BYTE>(meshlet.vertex_count++);
+				data.vertices.push_back(indices[i + corner]);
+			}
+			data.triangles.push_back(local);
+		}
+		meshlet.triangle_count++;
+	}
+	finish_meshlet(static_cast<UINT>(indices.size()));
+	return data;
+}
+
+std::size_t CullMeshlets(std::span<const meshlet_t> meshlets, FXMMATRIX view_projection, FXMVECTOR camera_position,
+	std::vector<UINT>& visible) {
+	// Frustum planes from the columns of the row-vector view-projection matrix, pointing inward, with the
+	// D3D depth range of [0, w].
+	XMMATRIX columns = XMMatrixTranspose(view_projection);
+	const XMVECTOR planes[6] = {
+		XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[0])),
+		XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[0])),
+		XMPlaneNormalize(XMVectorAdd(columns.r[3], columns.r[1])),
+		XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[1])),
+		XMPlaneNormalize(columns.r[2]),
+		XMPlaneNormalize(XMVectorSubtract(columns.r[3], columns.r[2]))
+	};
+
+	std::size_t triangle_count = 0;
+	for (std::size_t i = 0; i < meshlets.size(); i++) {
+		const meshlet_t& meshlet = meshlets[i];
+		XMVECTOR center = XMLoadFloat3(&meshlet.center);
+		bool inside = true;
+		for (const XMVECTOR& plane : planes) {
+			inside = inside && XMVectorGetX(XMPlaneDotCoord(plane, center)) >= -meshlet.radius;
+		}
+		if (!inside) {
+			continue;
+		}
+
+		// Every triangle faces away when the direction from the camera to any point of the bounding sphere
+		// lies within the cone around the axis.
+		XMVECTOR view = XMVectorSubtract(center, camera_position);
+		FLOAT distance = XMVectorGetX(XMVector3Length(view));
+		if (XMVectorGetX(XMVector3Dot(view, XMLoadFloat3(&meshlet.cone_axis))) >=
+			meshlet.cone_cutoff * distance + meshlet.radius) {
+			continue;
+		}
+
+		visible.push_back(static_cast<UINT>(i));
+		triangle_count += meshlet.triangle_count;
+	}
+	return triangle_count;
+}
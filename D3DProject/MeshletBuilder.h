@@ -0,0 +1,39 @@
+#pragma once
+
+constexpr UINT MESHLET_MAX_VERTICES = 64;
+constexpr UINT MESHLET_MAX_TRIANGLES = 124;
+
+struct meshlet_t {
+	// Bounds in the space of the source positions.
+	DirectX::XMFLOAT3 center;
+	FLOAT radius;
+	DirectX::XMFLOAT3 aabb_min;
+	DirectX::XMFLOAT3 aabb_max;
+	// Cone containing every triangle normal; cone_cutoff is 1 when the normals are too spread to cull.
+	DirectX::XMFLOAT3 cone_axis;
+	FLOAT cone_cutoff;
+	// Range of the triangles in the source index list; the meshlets partition it in order.
+	UINT first_index;
+	UINT triangle_count;
+	// Ranges in meshlet_data_t::vertices and meshlet_data_t::triangles.
+	UINT vertex_offset;
+	UINT vertex_count;
+	UINT triangle_offset;
+};
+
+struct meshlet_data_t {
+	std::vector<meshlet_t> meshlets;
+	// Source vertex indices used by each meshlet.
+	std::vector<UINT> vertices;
+	// Three indices into the meshlet's vertices per triangle.
+	std::vector<BYTE> triangles;
+};
+
+// Splits the triangle list into meshlets of consecutive triangles, so that the order optimized for the
+// vertex cache is kept and each meshlet can be drawn as a range of the original index buffer.
+meshlet_data_t BuildMeshlets(std::span<const UINT> indices, std::span<const DirectX::XMFLOAT3> positions);
+
+// Appends to visible the meshlets that are inside the frustum and not entirely back-facing as seen from
+// camera_position, and returns the number of their triangles. Clockwise triangles are front-facing.
+std::size_t CullMeshlets(std::span<const meshlet_t> meshlets, DirectX::FXMMATRIX view_projection,
+	DirectX::FXMVECTOR camera_position, std::vector<UINT>& visible);
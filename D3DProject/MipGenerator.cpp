@@ -0,0 +1,264 @@
+#include "pch.h"
+#include "MipGenerator.h"
+#include "parallel_utils.h"
+
+using namespace DirectX;
+
+namespace {
+	// Entries of the linear-to-sRGB table; enough for every dark sRGB value to stay within one step.
+	constexpr UINT LINEAR_TO_SRGB_SIZE = 4096;
+	// Radius of the Kaiser window in destination pixels, and its shape parameter.
+	constexpr FLOAT KAISER_RADIUS = 1.5f;
+	constexpr FLOAT KAISER_ALPHA = 4.0f;
+	// Rows below which a level is not worth splitting further between threads.
+	constexpr UINT MIN_ROWS_PER_BLOCK = 16;
+
+	struct srgb_tables_t {
+		std::array<FLOAT, 256> to_linear;
+		std::array<BYTE, LINEAR_TO_SRGB_SIZE> to_srgb;
+	};
+
+	const srgb_tables_t& GetSrgbTables() {
+		static const srgb_tables_t tables = [] {
+			srgb_tables_t tables;
+			for (UINT i = 0; i < tables.to_linear.size(); i++) {
+				FLOAT value = i / 255.0f;
+				tables.to_linear[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
+			}
+			for (UINT i = 0; i < tables.to_srgb.size(); i++) {
+				FLOAT value = static_cast<FLOAT>(i) / (LINEAR_TO_SRGB_SIZE - 1);
+				value = value <= 0.0031308f ? value * 12.92f : 1.055f * std::pow(value, 1.0f / 2.4f) - 0.055f;
+				tables.to_srgb[i] = static_cast<BYTE>(value * 255.0f + 0.5f);
+			}
+			return tables;
+		}();
+		return tables;
+	}
+
+	// Zeroth-order modified Bessel function of the first kind, from its power series.
+	FLOAT BesselI0(FLOAT x) {
+		FLOAT sum = 1.0f;
+		FLOAT term = 1.0f;
+		for (UINT k = 1; k < 32 && term > sum * 1e-7f; k++) {
+			FLOAT factor = x / (2.0f * k);
+			term *= factor * factor;
+			sum += term;
+		}
+		return sum;
+	}
+
+	FLOAT Kaiser(FLOAT x) {
+		FLOAT t = x / KAISER_RADIUS;
+		if (t <= -1.0f || t >= 1.0f) {
+			return 0.0f;
+		}
+		FLOAT window = BesselI0(KAISER_ALPHA * std::sqrt(1.0f - t * t)) / BesselI0(KAISER_ALPHA);
+		FLOAT sinc = x == 0.0f ? 1.0f : std::sin(XM_PI * x) / (XM_PI * x);
+		return sinc * window;
+	}
+
+	// Source pixels and normalized weights of every destination pixel along one axis, padded with zero
+	// weights to the same number of taps.
+	struct filter_taps_t {
+		UINT tap_count = 0;
+		std::vector<UINT> sources;
+		std::vector<FLOAT> weights;
+	};
+
+	filter_taps_t BuildTaps(UINT source_size, UINT destination_size, const mip_options_t& options) {
+		FLOAT scale = static_cast<FLOAT>(source_size) / destination_size;
+		// When enlarging, the filter keeps the width of one source pixel and interpolates between them.
+		FLOAT filter_scale = std::max(scale, 1.0f);
+		FLOAT half_width = options.filter == mip_filter_t::BOX ? 0.5f * filter_scale : KAISER_RADIUS * filter_scale;
+
+		std::vector<std::vector<std::pair<INT, FLOAT>>> pixel_taps(destination_size);
+		filter_taps_t taps;
+		for (UINT i = 0; i < destination_size; i++) {
+			FLOAT center = (i + 0.5f) * scale;
+			INT first = static_cast<INT>(std::floor(center - half_width));
+			INT last = static_cast<INT>(std::ceil(center + half_width));
+			FLOAT total = 0.0f;
+			for (INT source = first; source < last; source++) {
+				FLOAT weight;
+				if (options.filter == mip_filter_t::BOX) {
+					// Coverage of the source pixel by the footprint of the destination pixel.
+					weight = std::min(source + 1.0f, center + half_width) - std::max(static_cast<FLOAT>(source), center - half_width);
+				}
+				else {
+					weight = Kaiser((source + 0.5f - center) / filter_scale);
+				}
+				if (weight == 0.0f || (options.filter == mip_filter_t::BOX && weight < 0.0f)) {
+					continue;
+				}
+				pixel_taps[i].emplace_back(source, weight);
+				total += weight;
+			}
+			for (auto& tap : pixel_taps[i]) {
+				tap.second /= total;
+			}
+			taps.tap_count = std::max(taps.tap_count, static_cast<UINT>(pixel_taps[i].size()));
+		}
+
+		INT size = static_cast<INT>(source_size);
+		taps.sources.assign(std::size_t(destination_size) * taps.tap_count, 0);
+		taps.weights.assign(std::size_t(destination_size) * taps.tap_count, 0.0f);
+		for (UINT i = 0; i < destination_size; i++) {
+			for (std::size_t tap = 0; tap < pixel_taps[i].size(); tap++) {
+				auto [source, weight] = pixel_taps[i][tap];
+				source = options.wrap ? (source % size + size) % size : std::clamp(source, 0, size - 1);
+				taps.sources[i * taps.tap_count + tap] = static_cast<UINT>(source);
+				taps.weights[i * taps.tap_count + tap] = weight;
+			}
+		}
+		return taps;
+	}
+
+	// Runs function(first_row, end_row) over blocks of the rows on up to thread_count threads.
+	template <typename Function>
+	void ForEachRowBlock(UINT row_count, UINT thread_count, Function&& function) {
+		UINT block_count = std::clamp((row_count + MIN_ROWS_PER_BLOCK - 1) / MIN_ROWS_PER_BLOCK, 1u, std::max(thread_count, 1u));
+		ParallelFor(block_count, [&](std::size_t block) {
+			function(static_cast<UINT>(block * row_count / block_count),
+				static_cast<UINT>((block + 1) * row_count / block_count));
+		});
+	}
+
+	// One pixel per vector, with the color channels in linear space.
+	using linear_image_t = std::vector<XMFLOAT4A>;
+
+	linear_image_t Resample(const linear_image_t& source, UINT width, UINT height, UINT next_width, UINT next_height,
+		const mip_options_t& options) {
+		filter_taps_t horizontal = BuildTaps(width, next_width, options);
+		filter_taps_t vertical = BuildTaps(height, next_height, options);
+
+		// Separable filter: rows first, at the source height, then columns.
+		linear_image_t rows(std::size_t(next_width) * height);
+		ForEachRowBlock(height, options.thread_count, [&](UINT first_row, UINT end_row) {
+			for (UINT y = first_row; y < end_row; y++) {
+				const XMFLOAT4A* source_row = &source[std::size_t(y) * width];
+				for (UINT x = 0; x < next_width; x++) {
+					const UINT* sources = &horizontal.sources[std::size_t(x) * horizontal.tap_count];
+					const FLOAT* weights = &horizontal.weights[std::size_t(x) * horizontal.tap_count];
+					XMVECTOR sum = XMVectorZero();
+					for (UINT tap = 0; tap < horizontal.tap_count; tap++) {
+						sum = XMVectorMultiplyAdd(XMLoadFloat4A(&source_row[sources[tap]]), XMVectorReplicate(weights[tap]), sum);
+					}
+					XMStoreFloat4A(&rows[std::size_t(y) * next_width + x], sum);
+				}
+			}
+		});
+
+		linear_image_t destination(std::size_t(next_width) * next_height);
+		ForEachRowBlock(next_height, options.thread_count, [&](UINT first_row, UINT end_row) {
+			for (UINT y = first_row; y < end_row; y++) {
+				const UINT* sources = &vertical.sources[std::size_t(y) * vertical.tap_count];
+				const FLOAT* weights = &vertical.weights[std::size_t(y) * vertical.tap_count];
+				XMFLOAT4A* destination_row = &destination[std::size_t(y) * next_width];
+				for (UINT x = 0; x < next_width; x++) {
+					XMVECTOR sum = XMVectorZero();
+					for (UINT tap = 0; tap < vertical.tap_count; tap++) {
+						sum = XMVectorMultiplyAdd(XMLoadFloat4A(&rows[std::size_t(sources[tap]) * next_width + x]),
+							XMVectorReplicate(weights[tap]), sum);
+					}
+					// The negative lobes of the Kaiser filter can overshoot.
+					XMStoreFloat4A(&destination_row[x], XMVectorSaturate(sum));
+				}
+			}
+		});
+		return destination;
+	}
+
+	linear_image_t Decode(const BYTE* pixels, UINT width, UINT height, std::size_t row_pitch, const mip_options_t& options) {
+		const srgb_tables_t& tables = GetSrgbTables();
+		linear_image_t image(std::size_t(width) * height);
+		ForEachRowBlock(height, options.thread_count, [&](UINT first_row, UINT end_row) {
+			for (UINT y = first_row; y < end_row; y++) {
+				const BYTE* row = pixels + std::size_t(y) * row_pitch;
+				XMFLOAT4A* linear_row = &image[std::size_t(y) * width];
+				for (UINT x = 0; x < width; x++) {
+					const BYTE* pixel = row + x * 4;
+					linear_row[x] = options.srgb ?
+						XMFLOAT4A(tables.to_linear[pixel[0]], tables.to_linear[pixel[1]], tables.to_linear[pixel[2]], pixel[3] / 255.0f) :
+						XMFLOAT4A(pixel[0] / 255.0f, pixel[1] / 255.0f, pixel[2] / 255.0f, pixel[3] / 255.0f);
+				}
+			}
+		});
+		return image;
+	}
+
+	void Encode(const linear_image_t& image, const texture_level_t& level, BYTE* destination, const mip_options_t& options) {
+		const srgb_tables_t& tables = GetSrgbTables();
+		const XMVECTOR scale = options.srgb ?
+			XMVectorSet(LINEAR_TO_SRGB_SIZE - 1.0f, LINEAR_TO_SRGB_SIZE - 1.0f, LINEAR_TO_SRGB_SIZE - 1.0f, 255.0f) :
+			XMVectorReplicate(255.0f);
+		ForEachRowBlock(level.height, options.thread_count, [&](UINT first_row, UINT end_row) {
+			for (UINT y = first_row; y < end_row; y++) {
+				BYTE* row = destination + std::size_t(y) * level.row_pitch;
+				for (UINT x = 0; x < level.width; x++) {
+					XMVECTOR value = XMVectorRound(XMVectorMultiply(XMLoadFloat4A(&image[std::size_t(y) * level.width + x]), scale));
+					XMUINT4 channels;
+					XMStoreUInt4(&channels, XMVectorClamp(value, XMVectorZero(), scale));
+					BYTE* pixel = row + x * 4;
+					pixel[0] = options.srgb ? tables.to_srgb[channels.x] : static_cast<BYTE>(channels.x);
+					pixel[1] = options.srgb ? tables.to_srgb[channels.y] : static_cast<BYTE>(channels.y);
+					pixel[2] = options.srgb ? tables.to_srgb[channels.z] : static_cast<BYTE>(channels.z);
+					pixel[3] = static_cast<BYTE>(channels.w);
+				}
+			}
+		});
+	}
+}
+
+UINT GetMipLevelCount(UINT width, UINT height) {
+	UINT count = 1;
+	for (UINT size = std::max(width, height); size > 1; size >>= 1) {
+		count++;
+	}
+	return count;
+}
+
+texture_data_t AllocateMipChain(UINT width, UINT height, UINT row_alignment, UINT level_alignment) {
+	if (width == 0 || height == 0) {
+		throw std::runtime_error("MipGenerator: empty image");
+	}
+
+	auto align_up = [](std::size_t value, std::size_t alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	};
+	texture_data_t texture = { .format = DXGI_FORMAT_R8G8B8A8_UNORM };
+	std::size_t size = 0;
+	for (UINT level = 0, level_count = GetMipLevelCount(width, height); level < level_count; level++) {
+		UINT level_width = std::max(width >> level, 1u);
+		UINT level_height = std::max(height >> level, 1u);
+		size = align_up(size, level_alignment);
+		texture.levels.push_back({
+			.width = level_width,
+			.height = level_height,
+			.offset = size,
+			.row_pitch = static_cast<UINT>(align_up(std::size_t(level_width) * 4, row_alignment)),
+			.row_count = level_height
+		});
+		size += std::size_t(texture.levels.back().row_pitch) * level_height;
+	}
+	texture.data.resize(size);
+	return texture;
+}
+
+void GenerateMipLevels(texture_data_t& texture, const mip_options_t& options) {
+	const texture_level_t& top = texture.levels[0];
+	linear_image_t image = Decode(texture.data.data() + top.offset, top.width, top.height, top.row_pitch, options);
+	for (std::size_t level = 1; level < texture.levels.size(); level++) {
+		const texture_level_t& previous = texture.levels[level - 1];
+		const texture_level_t& current = texture.levels[level];
+		image = Resample(image, previous.width, previous.height, current.width, current.height, options);
+		Encode(image, current, texture.data.data() + current.offset, options);
+	}
+}
+
+void ResampleImage(const BYTE* pixels, UINT width, UINT height, std::size_t row_pitch, texture_data_t& texture,
+	const mip_options_t& options) {
+	const texture_level_t& top = texture.levels[0];
+	linear_image_t image = Resample(Decode(pixels, width, height, row_pitch, options), width, height, top.width,
+		top.height, options);
+	Encode(image, top, texture.data.data() + top.offset, options);
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+#include "TextureData.h"
+
+enum class mip_filter_t : UINT {
+	// Average of the source pixels covered by each destination pixel.
+	BOX,
+	// Kaiser-windowed sinc; sharper than the box filter, with less aliasing.
+	KAISER
+};
+
+struct mip_options_t {
+	mip_filter_t filter = mip_filter_t::KAISER;
+	// Color channels are sRGB-encoded and filtered in linear space. Alpha is always filtered as is.
+	bool srgb = true;
+	// Filters across the edges like a sampler with WRAP addressing; otherwise the edges are clamped.
+	bool wrap = true;
+	// Each level is split into blocks of rows processed on up to this many threads.
+	UINT thread_count = 1;
+};
+
+UINT GetMipLevelCount(UINT width, UINT height);
+
+// Lays out a full RGBA8 mip chain, down to 1x1, with rows padded to a multiple of row_alignment and levels
+// starting at multiples of level_alignment; both must be powers of two. The image is written straight into
+// the first level, so that it needs no copy before or after the mip levels are generated.
+texture_data_t AllocateMipChain(UINT width, UINT height, UINT row_alignment = 1, UINT level_alignment = 1);
+
+// Fills the levels after the first of a chain from AllocateMipChain. Each level is filtered from the
+// previous one, kept in linear floating point between levels.
+void GenerateMipLevels(texture_data_t& texture, const mip_options_t& options);
+
+// Fills the first level of a chain from AllocateMipChain with an RGBA8 image of another size, filtered like
+// the mip levels.
+void ResampleImage(const BYTE* pixels, UINT width, UINT height, std::size_t row_pitch, texture_data_t& texture,
+	const mip_options_t& options);
@@ -0,0 +1,226 @@
+#include "pch.h"
+#include "MipStreamer.h"
+
+using namespace DirectX;
+
+namespace {
+	// Keeps the texel density finite for a camera on or inside the geometry.
+	constexpr FLOAT MIN_DISTANCE = 1e-3f;
+
+	// Whether the bounding sphere of the box reaches into the cone of half_angle around direction, which
+	// holds the view frustum.
+	bool IsInView(FXMVECTOR aabb_min, FXMVECTOR aabb_max, FXMVECTOR position, GXMVECTOR direction,
+		FLOAT half_angle) {
+		XMVECTOR center = XMVectorScale(XMVectorAdd(aabb_min, aabb_max), 0.5f);
+		FLOAT radius = 0.5f * XMVectorGetX(XMVector3Length(XMVectorSubtract(aabb_max, aabb_min)));
+		XMVECTOR to_center = XMVectorSubtract(center, position);
+		FLOAT distance = XMVectorGetX(XMVector3Length(to_center));
+		if (distance <= radius) {
+			return true;
+		}
+		FLOAT cosine = std::clamp(XMVectorGetX(XMVector3Dot(to_center, direction)) / distance, -1.0f, 1.0f);
+		return std::acos(cosine) - std::asin(radius / distance) <= half_angle;
+	}
+}
+
+std::vector<texture_usage_t> ComputeTextureUsage(std::span<const vertex_t> vertices, std::span<const UINT> indices,
+	std::span<const UINT> material_textures) {
+	UINT texture_count = material_textures.empty() ? 0 :
+		*std::max_element(material_textures.begin(), material_textures.end()) + 1;
+	std::vector<texture_usage_t> usage(texture_count, {
+		.aabb_min = { FLT_MAX, FLT_MAX, FLT_MAX },
+		.aabb_max = { -FLT_MAX, -FLT_MAX, -FLT_MAX },
+		.uv_per_unit = 0.0f
+	});
+	std::vector<double> scene_areas(texture_count), uv_areas(texture_count);
+	for (std::size_t i = 0; i + 2 < indices.size(); i += 3) {
+		const vertex_t& v0 = vertices[indices[i]];
+		const vertex_t& v1 = vertices[indices[i + 1]];
+		const vertex_t& v2 = vertices[indices[i + 2]];
+		if (v0.material >= material_textures.size()) {
+			throw std::runtime_error("MipStreamer: material out of range");
+		}
+		UINT texture_index = material_textures[v0.material];
+
+		XMVECTOR p0 = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(v0.position));
+		XMVECTOR p1 = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(v1.position));
+		XMVECTOR p2 = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(v2.position));
+		texture_usage_t& texture = usage[texture_index];
+		XMStoreFloat3(&texture.aabb_min,
+			XMVectorMin(XMLoadFloat3(&texture.aabb_min), XMVectorMin(p0, XMVectorMin(p1, p2))));
+		XMStoreFloat3(&texture.aabb_max,
+			XMVectorMax(XMLoadFloat3(&texture.aabb_max), XMVectorMax(p0, XMVectorMax(p1, p2))));
+
+		scene_areas[texture_index] += 0.5 * XMVectorGetX(XMVector3Length(
+			XMVector3Cross(XMVectorSubtract(p1, p0), XMVectorSubtract(p2, p0))));
+		FLOAT du1 = v1.tex_coord[0] - v0.tex_coord[0], dv1 = v1.tex_coord[1] - v0.tex_coord[1];
+		FLOAT du2 = v2.tex_coord[0] - v0.tex_coord[0], dv2 = v2.tex_coord[1] - v0.tex_coord[1];
+		uv_areas[texture_index] += 0.5 * std::abs(du1 * dv2 - du2 * dv1);
+	}
+
+	for (UINT i = 0; i < texture_count; i++) {
+		if (scene_areas[i] > 0.0) {
+			usage[i].uv_per_unit = static_cast<FLOAT>(std::sqrt(uv_areas[i] / scene_areas[i]));
+		}
+	}
+	return usage;
+}
+
+MipStreamer::MipStreamer(std::span<const texture_level_t> levels, std::span<const texture_usage_t> usage,
+	const mip_streaming_options_t& options)
+	: budget(options.budget), upload_size(options.upload_size), outside_view_scale(options.outside_view_scale) {
+	if (levels.empty() || usage.empty()) {
+		throw std::runtime_error("MipStreamer: no textures");
+	}
+
+	boot_level = static_cast<UINT>(levels.size()) - 1;
+	for (UINT level = 0; level < levels.size(); level++) {
+		level_sizes.push_back(std::size_t(levels[level].row_pitch) * levels[level].row_count);
+		if (level < boot_level && std::max(levels[level].width, levels[level].height) <= options.boot_size) {
+			boot_level = level;
+		}
+	}
+
+	for (const texture_usage_t& texture_usage : usage) {
+		textures.push_back({
+			.usage = texture_usage,
+			.resident_level = boot_level,
+			.scheduled_level = boot_level,
+			.target_level = boot_level,
+			.screen_size = 0.0f
+		});
+	}
+	resident_size = textures.size() * std::accumulate(level_sizes.begin() + boot_level, level_sizes.end(),
+		std::size_t(0));
+	texel_count = static_cast<FLOAT>(std::max(levels[0].width, levels[0].height));
+}
+
+void MipStreamer::UpdateTargets(const stream_view_t& view) {
+	XMVECTOR position = XMLoadFloat3(&view.position);
+	XMVECTOR direction = XMLoadFloat3(&view.direction);
+	for (texture_state_t& texture : textures) {
+		texture.target_level = boot_level;
+		texture.screen_size = 0.0f;
+		XMVECTOR aabb_min = XMLoadFloat3(&texture.usage.aabb_min);
+		XMVECTOR aabb_max = XMLoadFloat3(&texture.usage.aabb_max);
+		if (texture.usage.uv_per_unit <= 0.0f || texture.usage.aabb_min.x > texture.usage.aabb_max.x) {
+			continue;
+		}
+
+		// The nearest geometry needs the finest level.
+		XMVECTOR nearest = XMVectorClamp(position, aabb_min, aabb_max);
+		FLOAT distance = std::max(XMVectorGetX(XMVector3Length(XMVectorSubtract(position, nearest))),
+			MIN_DISTANCE);
+		FLOAT pixels_per_unit = view.pixels_per_unit / distance;
+		if (!IsInView(aabb_min, aabb_max, position, direction, view.half_angle)) {
+			pixels_per_unit *= outside_view_scale;
+		}
+		FLOAT texels_per_unit = texture.usage.uv_per_unit * texel_count;
+		FLOAT level = std::floor(std::log2(texels_per_unit / pixels_per_unit));
+		texture.target_level = level <= 0.0f ? 0 : std::min(static_cast<UINT>(level), boot_level);
+		texture.screen_size = XMVectorGetX(XMVector3Length(XMVectorSubtract(aabb_max, aabb_min))) * pixels_per_unit;
+	}
+}
+
+std::vector<mip_upload_t> MipStreamer::ScheduleUploads() {
+	std::vector<UINT> candidates;
+	for (UINT i = 0; i < textures.size(); i++) {
+		if (textures[i].scheduled_level > textures[i].target_level) {
+			candidates.push_back(i);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [&](UINT a, UINT b) {
+		return textures[a].screen_size != textures[b].screen_size ?
+			textures[a].screen_size > textures[b].screen_size : a < b;
+	});
+
+	std::vector<mip_upload_t> uploads;
+	std::size_t scheduled_size = 0;
+	for (UINT i : candidates) {
+		texture_state_t& texture = textures[i];
+		while (texture.scheduled_level > texture.target_level) {
+			UINT level = texture.scheduled_level - 1;
+			std::size_t size = level_sizes[level];
+			if (scheduled_size != 0 && scheduled_size + size > upload_size) {
+				return uploads;
+			}
+			if (resident_size + size > budget && !Evict(resident_size + size - budget, i)) {
+				break;
+			}
+			uploads.push_back({ .texture = i, .level = level });
+			texture.scheduled_level = level;
+			resident_size += size;
+			scheduled_size += size;
+		}
+	}
+	return uploads;
+}
+
+void MipStreamer::CompleteUpload(const mip_upload_t& upload) {
+	texture_state_t& texture = textures.at(upload.texture);
+	if (upload.level + 1 != texture.resident_level || upload.level < texture.scheduled_level) {
+		throw std::runtime_error("MipStreamer: upload was not scheduled");
+	}
+	texture.resident_level = upload.level;
+	stats.uploads++;
+	stats.upload_bytes += level_sizes[upload.level];
+}
+
+UINT MipStreamer::GetBootLevel() const {
+	return boot_level;
+}
+
+UINT MipStreamer::GetResidentLevel(UINT texture) const {
+	return textures.at(texture).resident_level;
+}
+
+UINT MipStreamer::GetTargetLevel(UINT texture) const {
+	return textures.at(texture).target_level;
+}
+
+bool MipStreamer::IsAtTarget() const {
+	return std::all_of(textures.begin(), textures.end(), [](const texture_state_t& texture) {
+		return texture.resident_level <= texture.target_level;
+	});
+}
+
+std::size_t MipStreamer::GetResidentSize() const {
+	return resident_size;
+}
+
+const mip_streaming_stats_t& MipStreamer::GetStats() const {
+	return stats;
+}
+
+// Drops levels finer than needed from the textures with the least screen space first, except from textures
+// with uploads in flight, until size bytes are freed. Returns whether enough was freed.
+bool MipStreamer::Evict(std::size_t size, UINT keep_texture) {
+	std::vector<UINT> candidates;
+	for (UINT i = 0; i < textures.size(); i++) {
+		const texture_state_t& texture = textures[i];
+		if (i != keep_texture && texture.resident_level < texture.target_level &&
+			texture.scheduled_level == texture.resident_level) {
+			candidates.push_back(i);
+		}
+	}
+	std::sort(candidates.begin(), candidates.end(), [&](UINT a, UINT b) {
+		return textures[a].screen_size != textures[b].screen_size ?
+			textures[a].screen_size < textures[b].screen_size : a < b;
+	});
+
+	std::size_t freed = 0;
+	for (UINT i : candidates) {
+		texture_state_t& texture = textures[i];
+		while (freed < size && texture.resident_level < texture.target_level) {
+			freed += level_sizes[texture.resident_level];
+			resident_size -= level_sizes[texture.resident_level];
+			texture.resident_level++;
+			texture.scheduled_level++;
+			stats.evictions++;
+		}
+		if (freed >= size) {
+			return true;
+		}
+	}
+	return false;
+}
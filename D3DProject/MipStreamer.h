@@ -0,0 +1,108 @@
+#pragma once
+
+#include "vertex.h"
+#include "TextureData.h"
+
+// Where a texture is used in the scene, for estimating how many of its texels reach the screen.
+struct texture_usage_t {
+	// Bounds in scene space of the triangles using the texture; empty (min above max) when none does.
+	DirectX::XMFLOAT3 aabb_min;
+	DirectX::XMFLOAT3 aabb_max;
+	// Texture coordinate units per scene space unit, from the ratio of the texture and scene areas of the
+	// triangles.
+	FLOAT uv_per_unit;
+};
+
+// Usage of each texture by the triangles of an index list, where each triangle uses the material of its first
+// vertex and material_textures gives the texture of every material. Materials may share a texture.
+std::vector<texture_usage_t> ComputeTextureUsage(std::span<const vertex_t> vertices, std::span<const UINT> indices,
+	std::span<const UINT> material_textures);
+
+struct mip_streaming_options_t {
+	// Levels up to this many texels wide and high are loaded up front and never dropped.
+	UINT boot_size = 64;
+	// Bytes of the levels that may be resident over all textures, including the boot levels.
+	std::size_t budget = std::size_t(256) << 20;
+	// Bytes that each ScheduleUploads may return; a single level larger than that is still scheduled alone.
+	std::size_t upload_size = std::size_t(8) << 20;
+	// Scale of the screen-space size of textures whose geometry is outside the view, so that they target
+	// coarser levels and give way to the visible ones, yet still have more than the boot level when the
+	// camera turns to them.
+	FLOAT outside_view_scale = 0.25f;
+};
+
+struct stream_view_t {
+	DirectX::XMFLOAT3 position;
+	// Unit vector along which the camera looks.
+	DirectX::XMFLOAT3 direction;
+	// Half the apex angle of a cone around direction that contains the view frustum, in radians.
+	FLOAT half_angle;
+	// Screen pixels covered by one scene space unit at a distance of one unit: the vertical scale of the
+	// projection times half the viewport height.
+	FLOAT pixels_per_unit;
+};
+
+struct mip_upload_t {
+	UINT texture;
+	UINT level;
+};
+
+struct mip_streaming_stats_t {
+	UINT64 uploads = 0;
+	UINT64 upload_bytes = 0;
+	// Levels dropped to make room in the budget.
+	UINT64 evictions = 0;
+};
+
+// Decides which mip levels of the slices of a texture array are resident. Each texture gets a target level
+// from the screen-space size of its texels on the geometry nearest to the camera, scaled down when that
+// geometry is outside the view, and levels are streamed in from the coarsest. The GPU resource itself is
+// created by the caller, which clamps the sampled level of each texture to GetResidentLevel.
+class MipStreamer {
+public:
+	// Takes the level layout shared by the textures and the usage of each texture.
+	MipStreamer(std::span<const texture_level_t> levels, std::span<const texture_usage_t> usage,
+		const mip_streaming_options_t& options = {});
+
+	void UpdateTargets(const stream_view_t& view);
+	// Returns the next levels to upload, finest last within each texture, for the textures covering the most
+	// screen space first. Levels finer than their target are dropped while the budget is exceeded; levels
+	// that still do not fit wait until they do.
+	std::vector<mip_upload_t> ScheduleUploads();
+	// Makes a level returned by ScheduleUploads resident once its data is on the GPU.
+	void CompleteUpload(const mip_upload_t& upload);
+
+	// Finest level uploaded to the GPU up front, for every texture.
+	UINT GetBootLevel() const;
+	// Finest level that may be sampled.
+	UINT GetResidentLevel(UINT texture) const;
+	UINT GetTargetLevel(UINT texture) const;
+	// Whether every texture is resident down to its target level.
+	bool IsAtTarget() const;
+	std::size_t GetResidentSize() const;
+	const mip_streaming_stats_t& GetStats() const;
+private:
+	struct texture_state_t {
+		texture_usage_t usage;
+		UINT resident_level;
+		// Finest level returned by ScheduleUploads; finer than resident_level while uploads are in flight.
+		UINT scheduled_level;
+		UINT target_level;
+		// Approximate height in pixels of the geometry on the screen.
+		FLOAT screen_size;
+	};
+
+	std::vector<std::size_t> level_sizes;
+	// Texels along the longer side of the first level.
+	FLOAT texel_count;
+	UINT boot_level;
+	std::size_t budget;
+	std::size_t upload_size;
+	FLOAT outside_view_scale;
+	std::vector<texture_state_t> textures;
+	// Bytes of the resident and scheduled levels.
+	std::size_t resident_size = 0;
+	mip_streaming_stats_t stats;
+
+	bool Evict(std::size_t size, UINT keep_texture);
+};
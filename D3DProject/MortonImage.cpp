@@ -0,0 +1,110 @@
+#include "pch.h"
+#include "MortonImage.h"
+
+namespace {
+	// Moves the low 16 bits of value to the even bits.
+	UINT32 SpreadBits(UINT32 value) {
+		value &= 0x0000ffff;
+		value = (value | (value << 8)) & 0x00ff00ff;
+		value = (value | (value << 4)) & 0x0f0f0f0f;
+		value = (value | (value << 2)) & 0x33333333;
+		value = (value | (value << 1)) & 0x55555555;
+		return value;
+	}
+
+	UINT32 CompactBits(UINT32 value) {
+		value &= 0x55555555;
+		value = (value | (value >> 1)) & 0x33333333;
+		value = (value | (value >> 2)) & 0x0f0f0f0f;
+		value = (value | (value >> 4)) & 0x00ff00ff;
+		value = (value | (value >> 8)) & 0x0000ffff;
+		return value;
+	}
+}
+
+UINT32 EncodeMorton(UINT x, UINT y) {
+	return SpreadBits(x) | (SpreadBits(y) << 1);
+}
+
+void DecodeMorton(UINT32 code, UINT* x, UINT* y) {
+	*x = CompactBits(code);
+	*y = CompactBits(code >> 1);
+}
+
+MortonImage::MortonImage(UINT width, UINT height) : width(width), height(height) {
+	if (width == 0 || height == 0) {
+		throw std::runtime_error("MortonImage: empty image");
+	}
+	tile_columns = (width + TILE_SIZE - 1) / TILE_SIZE;
+	UINT tile_rows = (height + TILE_SIZE - 1) / TILE_SIZE;
+	texels.resize(std::size_t(tile_columns) * tile_rows * TILE_TEXELS);
+}
+
+// Interior tiles are converted two rows at a time: four texels of each row make the two 2x2 quads that are
+// contiguous in the tile, so that only the quads need Morton addressing.
+void MortonImage::CopyFromLinear(const BYTE* pixels, std::size_t row_pitch) {
+	std::size_t tile_count = texels.size() / TILE_TEXELS;
+	for (std::size_t tile_index = 0; tile_index < tile_count; tile_index++) {
+		UINT x0 = static_cast<UINT>(tile_index % tile_columns) * TILE_SIZE;
+		UINT y0 = static_cast<UINT>(tile_index / tile_columns) * TILE_SIZE;
+		UINT32* tile = texels.data() + tile_index * TILE_TEXELS;
+		if (x0 + TILE_SIZE > width || y0 + TILE_SIZE > height) {
+			for (UINT y = 0; y < TILE_SIZE; y++) {
+				const BYTE* row = pixels + std::min(y0 + y, height - 1) * row_pitch;
+				for (UINT x = 0; x < TILE_SIZE; x++) {
+					memcpy(&tile[EncodeMorton(x, y)], row + std::min(x0 + x, width - 1) * 4, 4);
+				}
+			}
+			continue;
+		}
+
+		for (UINT y = 0; y < TILE_SIZE; y += 2) {
+			const BYTE* row = pixels + (y0 + y) * row_pitch + x0 * 4;
+			for (UINT x = 0; x < TILE_SIZE; x += 4) {
+				__m128i top = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + x * 4));
+				__m128i bottom = _mm_loadu_si128(reinterpret_cast<const __m128i*>(row + row_pitch + x * 4));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(tile + EncodeMorton(x, y)),
+					_mm_unpacklo_epi64(top, bottom));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(tile + EncodeMorton(x + 2, y)),
+					_mm_unpackhi_epi64(top, bottom));
+			}
+		}
+	}
+}
+
+void MortonImage::CopyToLinear(BYTE* pixels, std::size_t row_pitch) const {
+	std::size_t tile_count = texels.size() / TILE_TEXELS;
+	for (std::size_t tile_index = 0; tile_index < tile_count; tile_index++) {
+		UINT x0 = static_cast<UINT>(tile_index % tile_columns) * TILE_SIZE;
+		UINT y0 = static_cast<UINT>(tile_index / tile_columns) * TILE_SIZE;
+		const UINT32* tile = texels.data() + tile_index * TILE_TEXELS;
+		if (x0 + TILE_SIZE > width || y0 + TILE_SIZE > height) {
+			for (UINT y = 0; y < std::min(TILE_SIZE, height - y0); y++) {
+				BYTE* row = pixels + (y0 + y) * row_pitch;
+				for (UINT x = 0; x < std::min(TILE_SIZE, width - x0); x++) {
+					memcpy(row + (x0 + x) * 4, &tile[EncodeMorton(x, y)], 4);
+				}
+			}
+			continue;
+		}
+
+		for (UINT y = 0; y < TILE_SIZE; y += 2) {
+			BYTE* row = pixels + (y0 + y) * row_pitch + x0 * 4;
+			for (UINT x = 0; x < TILE_SIZE; x += 4) {
+				__m128i left = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + EncodeMorton(x, y)));
+				__m128i right = _mm_loadu_si128(reinterpret_cast<const __m128i*>(tile + EncodeMorton(x + 2, y)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row + x * 4), _mm_unpacklo_epi64(left, right));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row + row_pitch + x * 4),
+					_mm_unpackhi_epi64(left, right));
+			}
+		}
+	}
+}
+
+UINT MortonImage::GetWidth() const {
+	return width;
+}
+
+UINT MortonImage::GetHeight() const {
+	return height;
+}
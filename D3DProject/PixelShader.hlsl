@@ -2,11 +2,16 @@ struct ps_input_t {
 	float4 position : SV_POSITION;
 	float4 color : COLOR;
 	float2 tex : TEXCOORD;
+	nointerpolation uint material : MATERIAL;
 };
 
-Texture2D texture_ps;
+Texture2DArray texture_ps : register(t0);
+// Texture array slice of each material, and the finest mip level of that slice streamed in so far.
+Buffer<float2> materials_ps : register(t1);
 SamplerState sampler_ps;
 
 float4 main(ps_input_t input) : SV_TARGET {
-	return input.color * texture_ps.Sample(sampler_ps, input.tex);
+	float2 material = materials_ps[input.material];
+	float level = max(texture_ps.CalculateLevelOfDetail(sampler_ps, input.tex), material.y);
+	return input.color * texture_ps.SampleLevel(sampler_ps, float3(input.tex, material.x), level);
 }
@@ -0,0 +1,709 @@
+#include "pch.h"
+#include "PngDecoder.h"
+
+namespace {
+	constexpr BYTE PNG_SIGNATURE[8] = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+	constexpr BYTE COLOR_GRAY = 0;
+	constexpr BYTE COLOR_RGB = 2;
+	constexpr BYTE COLOR_PALETTE = 3;
+	constexpr BYTE COLOR_GRAY_ALPHA = 4;
+	constexpr BYTE COLOR_RGBA = 6;
+
+	// Origin and spacing of the pixels of each Adam7 pass.
+	struct interlace_pass_t {
+		UINT x, y, step_x, step_y;
+	};
+	constexpr interlace_pass_t ADAM7_PASSES[7] = {
+		{ 0, 0, 8, 8 }, { 4, 0, 8, 8 }, { 0, 4, 4, 8 }, { 2, 0, 4, 4 }, { 0, 2, 2, 4 }, { 1, 0, 2, 2 }, { 0, 1, 1, 2 }
+	};
+	constexpr interlace_pass_t FULL_IMAGE = { 0, 0, 1, 1 };
+
+	UINT ReadBigEndian(const BYTE* data) {
+		return (static_cast<UINT>(data[0]) << 24) | (static_cast<UINT>(data[1]) << 16) |
+			(static_cast<UINT>(data[2]) << 8) | data[3];
+	}
+
+	UINT GetChannelCount(BYTE color_type) {
+		switch (color_type) {
+		case COLOR_RGB: return 3;
+		case COLOR_GRAY_ALPHA: return 2;
+		case COLOR_RGBA: return 4;
+		default: return 1;
+		}
+	}
+
+	bool IsValidFormat(BYTE color_type, BYTE bit_depth) {
+		switch (color_type) {
+		case COLOR_GRAY: return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8 || bit_depth == 16;
+		case COLOR_PALETTE: return bit_depth == 1 || bit_depth == 2 || bit_depth == 4 || bit_depth == 8;
+		case COLOR_RGB:
+		case COLOR_GRAY_ALPHA:
+		case COLOR_RGBA: return bit_depth == 8 || bit_depth == 16;
+		default: return false;
+		}
+	}
+
+	// Least significant bit first, as deflate streams are packed. Reads past the end return zeros and are
+	// reported by IsOverrun.
+	class BitStream {
+	public:
+		explicit BitStream(std::span<const BYTE> data) : data(data) {}
+
+		void Refill() {
+			while (bit_count <= 56) {
+				UINT64 byte = position < data.size() ? data[position] : 0;
+				position++;
+				buffer |= byte << bit_count;
+				bit_count += 8;
+			}
+		}
+
+		// Valid for up to 57 bits after Refill.
+		UINT Peek(UINT count) const {
+			return static_cast<UINT>(buffer & ((1ull << count) - 1));
+		}
+
+		void Consume(UINT count) {
+			buffer >>= count;
+			bit_count -= count;
+		}
+
+		UINT Read(UINT count) {
+			Refill();
+			UINT value = Peek(count);
+			Consume(count);
+			return value;
+		}
+
+		// Drops the buffered bits up to the next byte boundary and returns the remaining input from there.
+		std::span<const BYTE> AlignToByte() {
+			Consume(bit_count % 8);
+			position -= bit_count / 8;
+			buffer = 0;
+			bit_count = 0;
+			return data.subspan(std::min(position, data.size()));
+		}
+
+		void Skip(std::size_t byte_count) {
+			position += byte_count;
+		}
+
+		bool IsOverrun() const {
+			return position - bit_count / 8 > data.size();
+		}
+
+	private:
+		std::span<const BYTE> data;
+		std::size_t position = 0;
+		UINT64 buffer = 0;
+		UINT bit_count = 0;
+	};
+
+	UINT ReverseBits(UINT value, UINT count) {
+		UINT reversed = 0;
+		for (UINT i = 0; i < count; i++) {
+			reversed = (reversed << 1) | ((value >> i) & 1);
+		}
+		return reversed;
+	}
+
+	constexpr UINT MAX_CODE_LENGTH = 15;
+	// Codes up to this length are decoded with a single table lookup.
+	constexpr UINT FAST_BITS = 10;
+
+	// Canonical Huffman code of deflate.
+	class HuffmanTable {
+	public:
+		void Build(const BYTE* lengths, UINT symbol_count) {
+			UINT counts[MAX_CODE_LENGTH + 1] = {};
+			for (UINT symbol = 0; symbol < symbol_count; symbol++) {
+				counts[lengths[symbol]]++;
+			}
+			counts[0] = 0;
+
+			fast.fill(0);
+			UINT code = 0, index = 0;
+			for (UINT length = 1; length <= MAX_CODE_LENGTH; length++) {
+				first_code[length] = code;
+				first_symbol[length] = index;
+				code += counts[length];
+				index += counts[length];
+				if (code > (1u << length)) {
+					throw std::runtime_error("PngDecoder: over-subscribed Huffman code");
+				}
+				max_code[length] = code << (16 - length);
+				code <<= 1;
+			}
+
+			UINT next[MAX_CODE_LENGTH + 1];
+			std::copy(std::begin(first_symbol), std::end(first_symbol), next);
+			for (UINT symbol = 0; symbol < symbol_count; symbol++) {
+				UINT length = lengths[symbol];
+				if (length == 0) {
+					continue;
+				}
+				UINT symbol_code = first_code[length] + next[length] - first_symbol[length];
+				symbols[next[length]++] = static_cast<UINT16>(symbol);
+				if (length <= FAST_BITS) {
+					for (UINT i = ReverseBits(symbol_code, length); i < fast.size(); i += 1u << length) {
+						fast[i] = static_cast<UINT16>((symbol << 4) | length);
+					}
+				}
+			}
+		}
+
+		UINT Decode(BitStream& bits) const {
+			bits.Refill();
+			UINT entry = fast[bits.Peek(FAST_BITS)];
+			if (entry != 0) {
+				bits.Consume(entry & 15);
+				return entry >> 4;
+			}
+			// Longer codes are compared most significant bit first against the end of each length's range.
+			UINT code = ReverseBits(bits.Peek(16), 16);
+			for (UINT length = FAST_BITS + 1; length <= MAX_CODE_LENGTH; length++) {
+				if (code < max_code[length]) {
+					bits.Consume(length);
+					return symbols[(code >> (16 - length)) - first_code[length] + first_symbol[length]];
+				}
+			}
+			throw std::runtime_error("PngDecoder: invalid Huffman code");
+		}
+
+	private:
+		// (symbol << 4) | length, or 0 for codes longer than FAST_BITS.
+		std::array<UINT16, 1 << FAST_BITS> fast;
+		UINT first_code[MAX_CODE_LENGTH + 1];
+		UINT first_symbol[MAX_CODE_LENGTH + 1];
+		UINT max_code[MAX_CODE_LENGTH + 1];
+		// Symbols ordered by code.
+		std::array<UINT16, 288> symbols;
+	};
+
+	constexpr UINT16 LENGTH_BASE[29] = {
+		3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67, 83, 99, 115, 131, 163, 195, 227, 258
+	};
+	constexpr BYTE LENGTH_EXTRA_BITS[29] = {
+		0, 0, 0, 0, 0, 0, 0, 0, 1, 1, 1, 1, 2, 2, 2, 2, 3, 3, 3, 3, 4, 4, 4, 4, 5, 5, 5, 5, 0
+	};
+	constexpr UINT16 DISTANCE_BASE[30] = {
+		1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513, 769, 1025, 1537, 2049, 3073,
+		4097, 6145, 8193, 12289, 16385, 24577
+	};
+	constexpr BYTE DISTANCE_EXTRA_BITS[30] = {
+		0, 0, 0, 0, 1, 1, 2, 2, 3, 3, 4, 4, 5, 5, 6, 6, 7, 7, 8, 8, 9, 9, 10, 10, 11, 11, 12, 12, 13, 13
+	};
+	constexpr BYTE CODE_LENGTH_ORDER[19] = { 16, 17, 18, 0, 8, 7, 9, 6, 10, 5, 11, 4, 12, 3, 13, 2, 14, 1, 15 };
+
+	void ReadDynamicTables(BitStream& bits, HuffmanTable& literals, HuffmanTable& distances) {
+		UINT literal_count = bits.Read(5) + 257;
+		UINT distance_count = bits.Read(5) + 1;
+		UINT code_length_count = bits.Read(4) + 4;
+		BYTE code_length_lengths[19] = {};
+		for (UINT i = 0; i < code_length_count; i++) {
+			code_length_lengths[CODE_LENGTH_ORDER[i]] = static_cast<BYTE>(bits.Read(3));
+		}
+		HuffmanTable code_lengths;
+		code_lengths.Build(code_length_lengths, 19);
+
+		BYTE lengths[286 + 30] = {};
+		for (UINT i = 0; i < literal_count + distance_count;) {
+			UINT symbol = code_lengths.Decode(bits);
+			if (symbol < 16) {
+				lengths[i++] = static_cast<BYTE>(symbol);
+				continue;
+			}
+			BYTE value = 0;
+			UINT repeat;
+			if (symbol == 16) {
+				if (i == 0) {
+					throw std::runtime_error("PngDecoder: code length repeat without a previous length");
+				}
+				value = lengths[i - 1];
+				repeat = bits.Read(2) + 3;
+			}
+			else {
+				repeat = symbol == 17 ? bits.Read(3) + 3 : bits.Read(7) + 11;
+			}
+			if (repeat > literal_count + distance_count - i) {
+				throw std::runtime_error("PngDecoder: code lengths overflow");
+			}
+			std::fill_n(lengths + i, repeat, value);
+			i += repeat;
+		}
+		literals.Build(lengths, literal_count);
+		distances.Build(lengths + literal_count, distance_count);
+	}
+
+	void BuildFixedTables(HuffmanTable& literals, HuffmanTable& distances) {
+		BYTE lengths[288];
+		std::fill_n(lengths, 144, BYTE(8));
+		std::fill_n(lengths + 144, 112, BYTE(9));
+		std::fill_n(lengths + 256, 24, BYTE(7));
+		std::fill_n(lengths + 280, 8, BYTE(8));
+		literals.Build(lengths, 288);
+		std::fill_n(lengths, 30, BYTE(5));
+		distances.Build(lengths, 30);
+	}
+
+	UINT ComputeAdler32(std::span<const BYTE> data) {
+		// Largest number of bytes before the sums can overflow 32 bits.
+		constexpr std::size_t BLOCK_SIZE = 5552;
+		UINT a = 1, b = 0;
+		for (std::size_t begin = 0; begin < data.size(); begin += BLOCK_SIZE) {
+			std::size_t end = std::min(begin + BLOCK_SIZE, data.size());
+			for (std::size_t i = begin; i < end; i++) {
+				a += data[i];
+				b += a;
+			}
+			a %= 65521;
+			b %= 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	// Inflates a zlib stream into output, which must be exactly the size of the uncompressed data.
+	void Inflate(std::span<const BYTE> stream, std::span<BYTE> output) {
+		if (stream.size() < 6 || (stream[0] & 0x0f) != 8 || (stream[1] & 0x20) != 0 ||
+			((stream[0] << 8) | stream[1]) % 31 != 0) {
+			throw std::runtime_error("PngDecoder: invalid zlib header");
+		}
+
+		BitStream bits(stream.subspan(2));
+		BYTE* out = output.data();
+		BYTE* const out_end = out + output.size();
+		HuffmanTable literals, distances;
+		for (bool final_block = false; !final_block;) {
+			final_block = bits.Read(1) != 0;
+			UINT block_type = bits.Read(2);
+			if (block_type == 0) {
+				std::span<const BYTE> rest = bits.AlignToByte();
+				if (rest.size() < 4 || (rest[0] | (rest[1] << 8)) != (~(rest[2] | (rest[3] << 8)) & 0xffff)) {
+					throw std::runtime_error("PngDecoder: invalid stored block");
+				}
+				std::size_t length = rest[0] | (rest[1] << 8);
+				if (length > rest.size() - 4 || length > static_cast<std::size_t>(out_end - out)) {
+					throw std::runtime_error("PngDecoder: stored block out of range");
+				}
+				memcpy(out, rest.data() + 4, length);
+				out += length;
+				bits.Skip(4 + length);
+				continue;
+			}
+			if (block_type == 1) {
+				BuildFixedTables(literals, distances);
+			}
+			else if (block_type == 2) {
+				ReadDynamicTables(bits, literals, distances);
+			}
+			else {
+				throw std::runtime_error("PngDecoder: invalid block type");
+			}
+
+			for (;;) {
+				UINT symbol = literals.Decode(bits);
+				if (symbol < 256) {
+					if (out == out_end) {
+						throw std::runtime_error("PngDecoder: image data too long");
+					}
+					*out++ = static_cast<BYTE>(symbol);
+					continue;
+				}
+				if (symbol == 256) {
+					break;
+				}
+				symbol -= 257;
+				if (symbol >= 29) {
+					throw std::runtime_error("PngDecoder: invalid length code");
+				}
+				std::size_t length = LENGTH_BASE[symbol] + bits.Read(LENGTH_EXTRA_BITS[symbol]);
+				UINT distance_symbol = distances.Decode(bits);
+				if (distance_symbol >= 30) {
+					throw std::runtime_error("PngDecoder: invalid distance code");
+				}
+				std::size_t distance = DISTANCE_BASE[distance_symbol] + bits.Read(DISTANCE_EXTRA_BITS[distance_symbol]);
+				if (distance > static_cast<std::size_t>(out - output.data()) || length > static_cast<std::size_t>(out_end - out)) {
+					throw std::runtime_error("PngDecoder: back reference out of range");
+				}
+				const BYTE* from = out - distance;
+				if (distance >= length) {
+					memcpy(out, from, length);
+				}
+				else if (distance == 1) {
+					memset(out, *from, length);
+				}
+				else {
+					// Overlapping copies repeat the last distance bytes.
+					for (std::size_t i = 0; i < length; i++) {
+						out[i] = from[i];
+					}
+				}
+				out += length;
+			}
+			if (bits.IsOverrun()) {
+				throw std::runtime_error("PngDecoder: truncated image data");
+			}
+		}
+
+		std::span<const BYTE> trailer = bits.AlignToByte();
+		if (out != out_end || trailer.size() < 4) {
+			throw std::runtime_error("PngDecoder: truncated image data");
+		}
+		if (ReadBigEndian(trailer.data()) != ComputeAdler32(output)) {
+			throw std::runtime_error("PngDecoder: image data checksum mismatch");
+		}
+	}
+
+	// Filters of pixels of three or four bytes, which carry a dependency from one pixel to the next, keep one
+	// pixel in the low lanes of an SSE2 register.
+	template <UINT BYTES>
+	__m128i LoadPixel(const BYTE* pixel) {
+		int value = 0;
+		memcpy(&value, pixel, BYTES);
+		return _mm_cvtsi32_si128(value);
+	}
+
+	template <UINT BYTES>
+	void StorePixel(BYTE* pixel, __m128i value) {
+		int stored = _mm_cvtsi128_si32(value);
+		memcpy(pixel, &stored, BYTES);
+	}
+
+	template <UINT BYTES>
+	void UnfilterSub(BYTE* row, std::size_t size) {
+		__m128i left = _mm_setzero_si128();
+		for (std::size_t i = 0; i < size; i += BYTES) {
+			left = _mm_add_epi8(LoadPixel<BYTES>(row + i), left);
+			StorePixel<BYTES>(row + i, left);
+		}
+	}
+
+	template <UINT BYTES>
+	void UnfilterAverage(BYTE* row, const BYTE* previous, std::size_t size) {
+		const __m128i ones = _mm_set1_epi8(1);
+		__m128i left = _mm_setzero_si128();
+		for (std::size_t i = 0; i < size; i += BYTES) {
+			__m128i up = LoadPixel<BYTES>(previous + i);
+			// _mm_avg_epu8 rounds up, while the filter rounds down.
+			__m128i average = _mm_sub_epi8(_mm_avg_epu8(left, up), _mm_and_si128(_mm_xor_si128(left, up), ones));
+			left = _mm_add_epi8(LoadPixel<BYTES>(row + i), average);
+			StorePixel<BYTES>(row + i, left);
+		}
+	}
+
+	__m128i Absolute16(__m128i value) {
+		return _mm_max_epi16(value, _mm_sub_epi16(_mm_setzero_si128(), value));
+	}
+
+	__m128i Select(__m128i condition, __m128i if_true, __m128i if_false) {
+		return _mm_or_si128(_mm_and_si128(condition, if_true), _mm_andnot_si128(condition, if_false));
+	}
+
+	template <UINT BYTES>
+	void UnfilterPaeth(BYTE* row, const BYTE* previous, std::size_t size) {
+		const __m128i zero = _mm_setzero_si128();
+		// Left, up and up-left neighbors, widened to 16 bits.
+		__m128i a = zero, c = zero;
+		for (std::size_t i = 0; i < size; i += BYTES) {
+			__m128i b = _mm_unpacklo_epi8(LoadPixel<BYTES>(previous + i), zero);
+			__m128i b_minus_c = _mm_sub_epi16(b, c);
+			__m128i a_minus_c = _mm_sub_epi16(a, c);
+			// Distances of a + b - c to a, b and c.
+			__m128i pa = Absolute16(b_minus_c);
+			__m128i pb = Absolute16(a_minus_c);
+			__m128i pc = Absolute16(_mm_add_epi16(b_minus_c, a_minus_c));
+			__m128i smallest = _mm_min_epi16(pc, _mm_min_epi16(pa, pb));
+			// Ties prefer a, then b.
+			__m128i predictor = Select(_mm_cmpeq_epi16(smallest, pa), a,
+				Select(_mm_cmpeq_epi16(smallest, pb), b, c));
+			__m128i value = _mm_add_epi8(LoadPixel<BYTES>(row + i), _mm_packus_epi16(predictor, predictor));
+			StorePixel<BYTES>(row + i, value);
+			a = _mm_unpacklo_epi8(value, zero);
+			c = b;
+		}
+	}
+
+	BYTE PaethPredictor(INT a, INT b, INT c) {
+		INT pa = std::abs(b - c), pb = std::abs(a - c), pc = std::abs(a + b - 2 * c);
+		return static_cast<BYTE>(pa <= pb && pa <= pc ? a : pb <= pc ? b : c);
+	}
+
+	// Reverses the filter of one row in place; previous is the unfiltered row above, all zeros for the first.
+	void UnfilterRow(BYTE filter, BYTE* row, const BYTE* previous, std::size_t size, UINT pixel_bytes) {
+		switch (filter) {
+		case 0:
+			return;
+		case 1:
+			if (pixel_bytes == 4) {
+				UnfilterSub<4>(row, size);
+			}
+			else if (pixel_bytes == 3) {
+				UnfilterSub<3>(row, size);
+			}
+			else {
+				for (std::size_t i = pixel_bytes; i < size; i++) {
+					row[i] = static_cast<BYTE>(row[i] + row[i - pixel_bytes]);
+				}
+			}
+			return;
+		case 2: {
+			std::size_t i = 0;
+			for (; i + 16 <= size; i += 16) {
+				__m128i sum = _mm_add_epi8(_mm_loadu_si128(reinterpret_cast<const __m128i*>(row + i)),
+					_mm_loadu_si128(reinterpret_cast<const __m128i*>(previous + i)));
+				_mm_storeu_si128(reinterpret_cast<__m128i*>(row + i), sum);
+			}
+			for (; i < size; i++) {
+				row[i] = static_cast<BYTE>(row[i] + previous[i]);
+			}
+			return;
+		}
+		case 3:
+			if (pixel_bytes == 4) {
+				UnfilterAverage<4>(row, previous, size);
+			}
+			else if (pixel_bytes == 3) {
+				UnfilterAverage<3>(row, previous, size);
+			}
+			else {
+				for (std::size_t i = 0; i < size; i++) {
+					UINT left = i >= pixel_bytes ? row[i - pixel_bytes] : 0;
+					row[i] = static_cast<BYTE>(row[i] + ((left + previous[i]) >> 1));
+				}
+			}
+			return;
+		case 4:
+			if (pixel_bytes == 4) {
+				UnfilterPaeth<4>(row, previous, size);
+			}
+			else if (pixel_bytes == 3) {
+				UnfilterPaeth<3>(row, previous, size);
+			}
+			else {
+				for (std::size_t i = 0; i < size; i++) {
+					INT left = i >= pixel_bytes ? row[i - pixel_bytes] : 0;
+					INT up_left = i >= pixel_bytes ? previous[i - pixel_bytes] : 0;
+					row[i] = static_cast<BYTE>(row[i] + PaethPredictor(left, previous[i], up_left));
+				}
+			}
+			return;
+		default:
+			throw std::runtime_error("PngDecoder: invalid filter type");
+		}
+	}
+
+	struct png_state_t {
+		png_header_t header;
+		UINT channel_count = 0;
+		std::array<std::array<BYTE, 4>, 256> palette = {};
+		UINT palette_size = 0;
+		// Samples of the fully transparent color of gray and RGB images, at the image bit depth.
+		bool has_transparent_color = false;
+		UINT transparent_color[3] = {};
+	};
+
+	UINT ReadSample(const BYTE* row, std::size_t index, UINT bit_depth) {
+		switch (bit_depth) {
+		case 8:
+			return row[index];
+		case 16:
+			return (static_cast<UINT>(row[index * 2]) << 8) | row[index * 2 + 1];
+		default: {
+			// Packed from the most significant bit.
+			std::size_t bit = index * bit_depth;
+			return (row[bit / 8] >> (8 - bit_depth - bit % 8)) & ((1u << bit_depth) - 1);
+		}
+		}
+	}
+
+	BYTE ScaleSample(UINT sample, UINT bit_depth) {
+		switch (bit_depth) {
+		case 8: return static_cast<BYTE>(sample);
+		case 16: return static_cast<BYTE>(sample >> 8);
+		default: return static_cast<BYTE>(sample * 255 / ((1u << bit_depth) - 1));
+		}
+	}
+
+	// Converts count pixels of an unfiltered row to RGBA, written step bytes apart.
+	void ExpandRow(const png_state_t& state, const BYTE* row, UINT count, BYTE* destination, std::size_t step) {
+		const png_header_t& header = state.header;
+		if (header.bit_depth == 8 && header.color_type == COLOR_RGBA && step == 4) {
+			memcpy(destination, row, std::size_t(count) * 4);
+			return;
+		}
+		for (UINT x = 0; x < count; x++, destination += step) {
+			std::size_t first = std::size_t(x) * state.channel_count;
+			switch (header.color_type) {
+			case COLOR_PALETTE: {
+				UINT index = ReadSample(row, first, header.bit_depth);
+				if (index >= state.palette_size) {
+					throw std::runtime_error("PngDecoder: palette index out of range");
+				}
+				memcpy(destination, state.palette[index].data(), 4);
+				break;
+			}
+			case COLOR_GRAY:
+			case COLOR_GRAY_ALPHA: {
+				UINT gray = ReadSample(row, first, header.bit_depth);
+				destination[0] = destination[1] = destination[2] = ScaleSample(gray, header.bit_depth);
+				if (header.color_type == COLOR_GRAY_ALPHA) {
+					destination[3] = ScaleSample(ReadSample(row, first + 1, header.bit_depth), header.bit_depth);
+				}
+				else {
+					destination[3] = state.has_transparent_color && gray == state.transparent_color[0] ? 0 : 255;
+				}
+				break;
+			}
+			default: {
+				UINT samples[4] = { 0, 0, 0, 0 };
+				for (UINT channel = 0; channel < state.channel_count; channel++) {
+					samples[channel] = ReadSample(row, first + channel, header.bit_depth);
+					destination[channel] = ScaleSample(samples[channel], header.bit_depth);
+				}
+				if (header.color_type == COLOR_RGB) {
+					destination[3] = state.has_transparent_color && samples[0] == state.transparent_color[0] &&
+						samples[1] == state.transparent_color[1] && samples[2] == state.transparent_color[2] ? 0 : 255;
+				}
+				break;
+			}
+			}
+		}
+	}
+
+	std::size_t GetRowSize(const png_state_t& state, UINT width) {
+		return (std::size_t(width) * state.channel_count * state.header.bit_depth + 7) / 8;
+	}
+
+	UINT GetPassSize(UINT size, UINT origin, UINT step) {
+		return size > origin ? (size - origin + step - 1) / step : 0;
+	}
+}
+
+png_header_t ReadPngHeader(std::span<const BYTE> file) {
+	constexpr std::size_t HEADER_END = sizeof(PNG_SIGNATURE) + 8 + 13;
+	if (file.size() < HEADER_END + 4 || memcmp(file.data(), PNG_SIGNATURE, sizeof(PNG_SIGNATURE)) != 0 ||
+		ReadBigEndian(file.data() + 8) != 13 || memcmp(file.data() + 12, "IHDR", 4) != 0) {
+		throw std::runtime_error("PngDecoder: not a PNG file");
+	}
+	const BYTE* data = file.data() + 16;
+	png_header_t header = {
+		.width = ReadBigEndian(data),
+		.height = ReadBigEndian(data + 4),
+		.bit_depth = data[8],
+		.color_type = data[9],
+		.interlace_method = data[12]
+	};
+	// Compression and filter methods only have one defined value.
+	if (header.width == 0 || header.height == 0 || header.width > PNG_MAX_DIMENSION ||
+		header.height > PNG_MAX_DIMENSION || !IsValidFormat(header.color_type, header.bit_depth) || data[10] != 0 ||
+		data[11] != 0 || header.interlace_method > 1) {
+		throw std::runtime_error("PngDecoder: unsupported image header");
+	}
+	return header;
+}
+
+void DecodePng(std::span<const BYTE> file, BYTE* destination, std::size_t row_pitch) {
+	png_state_t state = { .header = ReadPngHeader(file) };
+	const png_header_t& header = state.header;
+	state.channel_count = GetChannelCount(header.color_type);
+
+	// Image data may be split over several IDAT chunks, which are only copied together when there is more
+	// than one.
+	std::vector<std::span<const BYTE>> data_chunks;
+	for (std::size_t offset = sizeof(PNG_SIGNATURE);;) {
+		if (file.size() - offset < 12) {
+			throw std::runtime_error("PngDecoder: truncated chunk");
+		}
+		std::size_t length = ReadBigEndian(file.data() + offset);
+		if (length > file.size() - offset - 12) {
+			throw std::runtime_error("PngDecoder: truncated chunk");
+		}
+		const char* type = reinterpret_cast<const char*>(file.data() + offset + 4);
+		std::span<const BYTE> data = file.subspan(offset + 8, length);
+		offset += length + 12;
+
+		if (memcmp(type, "IEND", 4) == 0) {
+			break;
+		}
+		if (memcmp(type, "IDAT", 4) == 0) {
+			data_chunks.push_back(data);
+		}
+		else if (memcmp(type, "PLTE", 4) == 0) {
+			if (length % 3 != 0 || length / 3 > 256) {
+				throw std::runtime_error("PngDecoder: invalid palette");
+			}
+			state.palette_size = static_cast<UINT>(length / 3);
+			for (UINT i = 0; i < state.palette_size; i++) {
+				state.palette[i] = { data[i * 3], data[i * 3 + 1], data[i * 3 + 2], 255 };
+			}
+		}
+		else if (memcmp(type, "tRNS", 4) == 0) {
+			if (header.color_type == COLOR_PALETTE) {
+				for (std::size_t i = 0; i < std::min<std::size_t>(length, 256); i++) {
+					state.palette[i][3] = data[i];
+				}
+			}
+			else if ((header.color_type == COLOR_GRAY && length >= 2) || (header.color_type == COLOR_RGB && length >= 6)) {
+				state.has_transparent_color = true;
+				for (UINT channel = 0; channel < state.channel_count; channel++) {
+					state.transparent_color[channel] = (static_cast<UINT>(data[channel * 2]) << 8) | data[channel * 2 + 1];
+				}
+			}
+		}
+	}
+	if (header.color_type == COLOR_PALETTE && state.palette_size == 0) {
+		throw std::runtime_error("PngDecoder: missing palette");
+	}
+
+	std::vector<BYTE> joined_data;
+	std::span<const BYTE> stream;
+	if (data_chunks.size() == 1) {
+		stream = data_chunks[0];
+	}
+	else {
+		for (std::span<const BYTE> chunk : data_chunks) {
+			joined_data.insert(joined_data.end(), chunk.begin(), chunk.end());
+		}
+		stream = joined_data;
+	}
+
+	std::span<const interlace_pass_t> passes = header.interlace_method ?
+		std::span<const interlace_pass_t>(ADAM7_PASSES) : std::span<const interlace_pass_t>(&FULL_IMAGE, 1);
+	std::size_t filtered_size = 0;
+	for (const interlace_pass_t& pass : passes) {
+		UINT width = GetPassSize(header.width, pass.x, pass.step_x);
+		UINT height = GetPassSize(header.height, pass.y, pass.step_y);
+		if (width > 0) {
+			filtered_size += (GetRowSize(state, width) + 1) * height;
+		}
+	}
+	// Deflate expands a byte to at most 1032, as runs of 258-byte matches, so a stream that cannot fill the
+	// image is rejected before the image is allocated.
+	constexpr std::size_t MAX_INFLATE_RATIO = 1032;
+	if (filtered_size / MAX_INFLATE_RATIO > stream.size()) {
+		throw std::runtime_error("PngDecoder: image data too short");
+	}
+	std::vector<BYTE> filtered(filtered_size);
+	Inflate(stream, filtered);
+
+	// Filters work on whole bytes, using the previous pixel for depths of at least a byte.
+	UINT pixel_bytes = std::max(1u, state.channel_count * header.bit_depth / 8);
+	std::vector<BYTE> zero_row(GetRowSize(state, header.width));
+	BYTE* row = filtered.data();
+	for (const interlace_pass_t& pass : passes) {
+		UINT width = GetPassSize(header.width, pass.x, pass.step_x);
+		UINT height = GetPassSize(header.height, pass.y, pass.step_y);
+		if (width == 0) {
+			continue;
+		}
+		std::size_t row_size = GetRowSize(state, width);
+		const BYTE* previous = zero_row.data();
+		for (UINT y = 0; y < height; y++) {
+			UnfilterRow(row[0], row + 1, previous, row_size, pixel_bytes);
+			ExpandRow(state, row + 1, width, destination + (pass.y + std::size_t(y) * pass.step_y) * row_pitch + pass.x * 4,
+				std::size_t(pass.step_x) * 4);
+			previous = row + 1;
+			row += row_size + 1;
+		}
+	}
+}
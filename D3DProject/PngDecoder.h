@@ -0,0 +1,24 @@
+#pragma once
+
+// PNG decoding without WIC or COM, so that asset tools can read textures on any platform.
+
+struct png_header_t {
+	UINT width;
+	UINT height;
+	BYTE bit_depth;
+	BYTE color_type;
+	BYTE interlace_method;
+};
+
+// Largest width and height that ReadPngHeader accepts, the largest texture of Direct3D 12, so that callers can
+// allocate the decoded image, at most 1 GiB of RGBA, from the header alone.
+constexpr UINT PNG_MAX_DIMENSION = 16384;
+
+// Reads the image header; throws if the data does not start with a valid PNG signature and header, or if the
+// image is larger than PNG_MAX_DIMENSION.
+png_header_t ReadPngHeader(std::span<const BYTE> file);
+
+// Decodes every color type and bit depth, including Adam7-interlaced images, into 8-bit RGBA rows that
+// start row_pitch bytes apart, the same layout as the 32bppRGBA output of WIC. 16-bit samples keep their
+// high byte, and transparency comes from the tRNS chunk; gamma and color profile chunks are ignored.
+void DecodePng(std::span<const BYTE> file, BYTE* destination, std::size_t row_pitch);
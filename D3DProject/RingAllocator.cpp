@@ -0,0 +1,62 @@
+#include "pch.h"
+#include "RingAllocator.h"
+
+RingAllocator::RingAllocator(UINT64 size) : size(size) {
+	if (size == 0) {
+		throw std::runtime_error("RingAllocator: empty buffer");
+	}
+}
+
+std::optional<UINT64> RingAllocator::Allocate(UINT64 allocation_size, UINT64 alignment) {
+	if (allocation_size == 0 || allocation_size > size || !std::has_single_bit(alignment) || size % alignment != 0) {
+		throw std::runtime_error("RingAllocator: invalid allocation");
+	}
+
+	if (head == tail && frames.empty() && head % size != 0) {
+		// Nothing is in use, so the whole buffer is free from its beginning on.
+		head += size - head % size;
+		tail = head;
+	}
+
+	UINT64 offset = head % size;
+	UINT64 aligned_offset = (offset + alignment - 1) & ~(alignment - 1);
+	if (aligned_offset + allocation_size > size) {
+		// Skips the rest of the buffer, so that the range does not wrap.
+		aligned_offset = size;
+	}
+	UINT64 new_head = head - offset + aligned_offset + allocation_size;
+	if (new_head - tail > size) {
+		return std::nullopt;
+	}
+	head = new_head;
+	return aligned_offset % size;
+}
+
+void RingAllocator::EndFrame(UINT64 fence_value) {
+	if (!frames.empty() && frames.back().fence_value >= fence_value) {
+		throw std::runtime_error("RingAllocator: fence values must increase");
+	}
+	frames.push_back({ .fence_value = fence_value, .end = head });
+}
+
+void RingAllocator::Reclaim(UINT64 completed_fence_value) {
+	while (!frames.empty() && frames.front().fence_value <= completed_fence_value) {
+		tail = frames.front().end;
+		frames.pop_front();
+	}
+}
+
+UINT64 RingAllocator::GetSize() const {
+	return size;
+}
+
+UINT64 RingAllocator::GetUsedSize() const {
+	return head - tail;
+}
+
+std::optional<UINT64> RingAllocator::GetPendingFenceValue() const {
+	if (frames.empty()) {
+		return std::nullopt;
+	}
+	return frames.front().fence_value;
+}
@@ -0,0 +1,36 @@
+#pragma once
+
+// Hands out ranges of a buffer of the given size in order, wrapping around at its end, for data that lives
+// until the GPU has finished the frame it was allocated for. Allocation never waits: it fails instead when
+// the ranges still in use by the GPU leave no room. Meant for a single recording thread.
+class RingAllocator {
+public:
+	RingAllocator(UINT64 size);
+
+	// Returns the offset of allocation_size bytes aligned to alignment, a power of two that the buffer size
+	// is a multiple of, or nothing when the buffer is full.
+	std::optional<UINT64> Allocate(UINT64 allocation_size, UINT64 alignment);
+	// Tags the ranges allocated since the last call with the fence value that their frame signals.
+	void EndFrame(UINT64 fence_value);
+	// Frees the ranges of the frames that signalled up to completed_fence_value.
+	void Reclaim(UINT64 completed_fence_value);
+
+	UINT64 GetSize() const;
+	// Bytes allocated and not yet freed, including the padding skipped for alignment and at the end.
+	UINT64 GetUsedSize() const;
+	// Fence value of the oldest frame whose ranges are not freed yet, or nothing.
+	std::optional<UINT64> GetPendingFenceValue() const;
+private:
+	struct frame_t {
+		UINT64 fence_value;
+		// Value of head at the end of the frame.
+		UINT64 end;
+	};
+
+	UINT64 size;
+	// Bytes ever allocated and freed; their difference is the part of the buffer in use, starting at
+	// tail % size.
+	UINT64 head = 0;
+	UINT64 tail = 0;
+	std::deque<frame_t> frames;
+};
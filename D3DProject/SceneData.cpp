@@ -1,61 +1,882 @@
 #include "pch.h"
 #include "SceneData.h"
+#include "parallel_utils.h"
+#include "asset_cache.h"
+#include "MeshOptimizer.h"
 
-struct obj_vertex {
-	FLOAT position[3];
-};
-struct obj_texture {
-	FLOAT position[2];
-};
+namespace {
+	struct obj_vertex {
+		FLOAT position[3];
+	};
+	struct obj_texture {
+		FLOAT position[2];
+	};
 
-SceneData::SceneData(const std::string& scene_path) {
-	std::ifstream scene_stream(scene_path);
+	struct obj_index_pair {
+		std::size_t vertex;
+		std::size_t texture;
+		UINT material;
+	};
+	struct obj_chunk_counts {
+		std::size_t vertices = 0;
+		std::size_t textures = 0;
+		std::size_t faces = 0;
+	};
+	// Material records of one chunk, which refer to names in the mapped file.
+	struct obj_chunk_materials {
+		std::string_view library;
+		// In the order of the usemtl records.
+		std::vector<std::string_view> names;
+		// Faces before the first usemtl record use the material of the previous chunks.
+		bool faces_before_first_name = false;
+	};
 
-	std::vector<obj_vertex> vertices;
-	std::vector<obj_texture> texture_positions;
+	constexpr UINT NO_MATERIAL = UINT_MAX;
 
-	std::string type;
-	while (scene_stream >> type) {
-		if (type == "v") {
-			FLOAT x, y, z;
-			scene_stream >> x >> y >> z;
-			vertices.push_back({ x, y, z });
+	// Open-addressing hash map from a face corner's position and texture indices and material to its vertex.
+	class CornerIndexMap {
+	public:
+		CornerIndexMap(std::size_t max_entries) {
+			std::size_t capacity = 16;
+			while (capacity < max_entries * 2) {
+				capacity *= 2;
+			}
+			slots.resize(capacity);
+			mask = capacity - 1;
+		}
+
+		// Returns the vertex assigned to the corner and whether new_vertex was assigned by this call.
+		std::pair<UINT, bool> Insert(const obj_index_pair& pair, UINT new_vertex) {
+			UINT64 key = (static_cast<UINT64>(pair.vertex) << 32) | static_cast<UINT64>(pair.texture);
+			for (std::size_t slot = Hash(key ^ (static_cast<UINT64>(pair.material) << 48)) & mask;; slot = (slot + 1) & mask) {
+				if (slots[slot].key == key && slots[slot].material == pair.material) {
+					return { slots[slot].vertex, false };
+				}
+				if (slots[slot].key == EMPTY_KEY) {
+					slots[slot] = { key, pair.material, new_vertex };
+					return { new_vertex, true };
+				}
+			}
+		}
+	private:
+		static constexpr UINT64 EMPTY_KEY = ~0ull;
+
+		struct slot_t {
+			UINT64 key = EMPTY_KEY;
+			UINT material = 0;
+			UINT vertex = 0;
+		};
+		std::vector<slot_t> slots;
+		std::size_t mask;
+
+		static std::size_t Hash(UINT64 key) {
+			key ^= key >> 33;
+			key *= 0xff51afd7ed558ccdull;
+			key ^= key >> 33;
+			return static_cast<std::size_t>(key);
+		}
+	};
+
+	enum class obj_record {
+		OTHER, VERTEX, TEXTURE, FACE, MATERIAL_LIBRARY, USE_MATERIAL
+	};
+
+	// Cursor over a single line of the mapped file. Never touches the heap.
+	class ObjLine {
+	public:
+		ObjLine(const char* begin, const char* end) : current(begin), end(end) {}
+
+		std::string_view NextToken() {
+			SkipSpaces();
+			const char* token_begin = current;
+			while (current != end && !IsSpace(*current)) {
+				current++;
+			}
+			return { token_begin, static_cast<std::size_t>(current - token_begin) };
+		}
+
+		FLOAT ParseFloat() {
+			SkipSpaces();
+			if (current != end && *current == '+') {
+				current++; // from_chars does not accept an explicit plus sign.
+			}
+			FLOAT value;
+			auto [ptr, ec] = std::from_chars(current, end, value);
+			if (ec != std::errc()) {
+				throw std::runtime_error("SceneData: malformed floating point value");
+			}
+			current = ptr;
+			return value;
+		}
+
+		obj_index_pair ParseIndexPair(UINT material) {
+			SkipSpaces();
+			std::size_t vertex_index = ParseIndex();
+			if (current == end || *current != '/') {
+				throw std::runtime_error("SceneData: face corner without a texture index");
+			}
+			current++; // Skip '/' between the indices.
+			std::size_t texture_index = ParseIndex();
+			// Skip an optional normal index, which is not used.
+			while (current != end && !IsSpace(*current)) {
+				current++;
+			}
+			return { vertex_index, texture_index, material };
+		}
+	private:
+		const char* current;
+		const char* end;
+
+		static bool IsSpace(char c) {
+			return c == ' ' || c == '\t' || c == '\r';
+		}
+
+		void SkipSpaces() {
+			while (current != end && IsSpace(*current)) {
+				current++;
+			}
+		}
+
+		std::size_t ParseIndex() {
+			std::size_t value;
+			auto [ptr, ec] = std::from_chars(current, end, value);
+			if (ec != std::errc()) {
+				throw std::runtime_error("SceneData: malformed face index");
+			}
+			current = ptr;
+			return value;
+		}
+	};
+
+	obj_record ClassifyLine(const char* begin, const char* end) {
+		while (begin != end && (*begin == ' ' || *begin == '\t')) {
+			begin++;
+		}
+		std::size_t length = end - begin;
+		if (length >= 2 && begin[0] == 'v' && (begin[1] == ' ' || begin[1] == '\t')) {
+			return obj_record::VERTEX;
+		}
+		if (length >= 3 && begin[0] == 'v' && begin[1] == 't' && (begin[2] == ' ' || begin[2] == '\t')) {
+			return obj_record::TEXTURE;
+		}
+		if (length >= 2 && begin[0] == 'f' && (begin[1] == ' ' || begin[1] == '\t')) {
+			return obj_record::FACE;
+		}
+		if (length >= 7 && (begin[6] == ' ' || begin[6] == '\t')) {
+			std::string_view keyword(begin, 6);
+			if (keyword == "mtllib") {
+				return obj_record::MATERIAL_LIBRARY;
+			}
+			if (keyword == "usemtl") {
+				return obj_record::USE_MATERIAL;
+			}
+		}
+		return obj_record::OTHER;
+	}
+
+	// Chunks smaller than this are not worth a thread of their own.
+	constexpr std::size_t MIN_CHUNK_SIZE = 256 * 1024;
+
+	// Splits the file into at most thread_count chunks of similar size, each ending at a line boundary.
+	std::vector<std::span<const char>> SplitIntoChunks(std::span<const char> data, UINT thread_count) {
+		std::size_t chunk_count = std::clamp<std::size_t>(data.size() / MIN_CHUNK_SIZE, 1,
+			std::max<std::size_t>(thread_count, 1));
+
+		std::vector<std::span<const char>> chunks;
+		chunks.reserve(chunk_count);
+		const char* end = data.data() + data.size();
+		const char* chunk_begin = data.data();
+		for (std::size_t chunk = 1; chunk <= chunk_count && chunk_begin != end; chunk++) {
+			const char* chunk_end = end;
+			if (chunk < chunk_count) {
+				chunk_end = std::max(chunk_begin, data.data() + data.size() * chunk / chunk_count);
+				chunk_end = static_cast<const char*>(std::memchr(chunk_end, '\n', end - chunk_end));
+				chunk_end = chunk_end == nullptr ? end : chunk_end + 1;
+			}
+			chunks.emplace_back(chunk_begin, chunk_end);
+			chunk_begin = chunk_end;
+		}
+		return chunks;
+	}
+
+	template <typename Callback>
+	void ForEachLine(std::span<const char> data, Callback&& callback) {
+		const char* current = data.data();
+		const char* end = current + data.size();
+		while (current != end) {
+			const char* line_end = static_cast<const char*>(std::memchr(current, '\n', end - current));
+			if (line_end == nullptr) {
+				line_end = end;
+			}
+			callback(current, line_end);
+			current = line_end == end ? end : line_end + 1;
+		}
+	}
+
+	void BuildIndexedMesh(std::span<const obj_index_pair> face_corners, std::span<const obj_vertex> positions,
+		std::span<const obj_texture> texture_positions, std::vector<vertex_t>& vertices, std::vector<UINT>& indices) {
+		// Corners sharing the position and texture indices and the material become a single vertex. Vertices
+		// are numbered in order of first use.
+		CornerIndexMap corner_map(face_corners.size());
+		std::vector<UINT> first_corners;
+		first_corners.reserve(face_corners.size());
+		indices.resize(face_corners.size());
+		for (std::size_t corner = 0; corner < face_corners.size(); corner++) {
+			auto [vertex, inserted] = corner_map.Insert(face_corners[corner], static_cast<UINT>(first_corners.size()));
+			if (inserted) {
+				first_corners.push_back(static_cast<UINT>(corner));
+			}
+			indices[corner] = vertex;
+		}
+
+		vertices.resize(first_corners.size());
+		for (std::size_t vertex = 0; vertex < vertices.size(); vertex++) {
+			const obj_index_pair& index_pair = face_corners[first_corners[vertex]];
+			const FLOAT* vertex_position = positions[index_pair.vertex].position;
+			const FLOAT* texture_position = texture_positions[index_pair.texture].position;
+			vertices[vertex] = { { vertex_position[0], vertex_position[1], vertex_position[2] },
+				{ 1.0f, 1.0f, 1.0f, 1.0f }, { texture_position[0], texture_position[1] }, index_pair.material };
+		}
+	}
+
+	std::size_t IndexSize(DXGI_FORMAT index_format) {
+		return index_format == DXGI_FORMAT_R16_UINT ? sizeof(UINT16) : sizeof(UINT);
+	}
+
+	UINT ReadIndex(std::span<const BYTE> index_data, DXGI_FORMAT index_format, std::size_t i) {
+		if (index_format == DXGI_FORMAT_R16_UINT) {
+			UINT16 index;
+			memcpy(&index, index_data.data() + i * sizeof(UINT16), sizeof(index));
+			return index;
+		}
+		UINT index;
+		memcpy(&index, index_data.data() + i * sizeof(UINT), sizeof(index));
+		return index;
+	}
+
+	constexpr char SCENE_CACHE_MAGIC[4] = { 'S', 'C', 'N', 'C' };
+	constexpr UINT SCENE_CACHE_VERSION = 8;
+	// Sections start at cache-line boundaries of the mapped file.
+	constexpr UINT64 SCENE_CACHE_ALIGNMENT = 64;
+
+	struct scene_cache_header_t {
+		char magic[4];
+		UINT version;
+		UINT64 source_size;
+		UINT64 source_write_time;
+		UINT64 source_hash;
+		UINT64 options_hash;
+		// Hash of everything that follows the header.
+		UINT64 payload_hash;
+		UINT vertex_count;
+		UINT vertex_stride;
+		UINT position_encoding;
+		UINT half_tex_coord;
+		UINT color;
+		position_dequantization_t position_dequantization;
+		UINT index_count;
+		UINT index_format;
+		UINT lod_count;
+		// Levels of the chunks, stored after those of the whole scene.
+		UINT lod_chunk_level_count;
+		UINT material_count;
+		UINT64 vertex_offset;
+		UINT64 index_offset;
+		UINT64 lod_offset;
+		// The material library followed by the material names, each terminated by a null character.
+		UINT64 material_offset;
+		UINT64 material_size;
+	};
+
+	// Hash of the options that change the cached mesh.
+	UINT64 HashSceneOptions(const scene_options_t& options) {
+		const UINT affecting_options[] = {
+			options.vertex_cache_size,
+			static_cast<UINT>(options.vertex_format.position_encoding),
+			options.vertex_format.half_tex_coord,
+			options.vertex_format.color,
+			options.lod.level_count,
+			std::bit_cast<UINT>(options.lod.target_ratio),
+			std::bit_cast<UINT>(options.lod.target_error),
+			options.lod.chunk_count
+		};
+		return HashBytes({ reinterpret_cast<const char*>(affecting_options), sizeof(affecting_options) });
+	}
+
+	UINT64 AlignCacheOffset(UINT64 offset) {
+		return (offset + SCENE_CACHE_ALIGNMENT - 1) & ~(SCENE_CACHE_ALIGNMENT - 1);
+	}
+
+	// Checks that the header belongs to a cache of the current version whose sections lie within the file.
+	bool ReadCacheHeader(std::span<const char> cache, scene_cache_header_t& header) {
+		if (cache.size() < sizeof(header)) {
+			return false;
 		}
-		else if (type == "vt") {
-			FLOAT u, v;
-			scene_stream >> u >> v;
-			texture_positions.push_back({ u, v });
+		memcpy(&header, cache.data(), sizeof(header));
+		if (memcmp(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != SCENE_CACHE_VERSION || header.position_encoding > static_cast<UINT>(position_encoding_t::UNORM10) ||
+			(header.index_format != DXGI_FORMAT_R16_UINT && header.index_format != DXGI_FORMAT_R32_UINT)) {
+			return false;
 		}
-		else if (type == "s") {
-			bool smooth_shading;
-			scene_stream >> smooth_shading;
-			// Ignore
+		vertex_format_t format = {
+			.position_encoding = static_cast<position_encoding_t>(header.position_encoding),
+			.half_tex_coord = header.half_tex_coord != 0,
+			.color = header.color != 0
+		};
+		if (header.vertex_stride != GetVertexStride(format)) {
+			return false;
 		}
-		else if (type == "usemtl") {
-			std::string material;
-			scene_stream >> material;
-			// Ignore
+		UINT64 vertex_size = static_cast<UINT64>(header.vertex_count) * header.vertex_stride;
+		UINT64 index_size = static_cast<UINT64>(header.index_count) *
+			IndexSize(static_cast<DXGI_FORMAT>(header.index_format));
+		UINT64 lod_size =
+			(static_cast<UINT64>(header.lod_count) + header.lod_chunk_level_count) * sizeof(lod_level_t);
+		return header.vertex_offset >= sizeof(header) && header.vertex_offset % sizeof(UINT) == 0 &&
+			header.vertex_offset <= cache.size() && vertex_size <= cache.size() - header.vertex_offset &&
+			header.index_offset >= header.vertex_offset + vertex_size &&
+			header.index_offset <= cache.size() && index_size <= cache.size() - header.index_offset &&
+			header.lod_count > 0 && header.lod_chunk_level_count % header.lod_count == 0 &&
+			header.lod_chunk_level_count > 0 && header.lod_offset >= header.index_offset + index_size &&
+			header.lod_offset <= cache.size() && lod_size <= cache.size() - header.lod_offset &&
+			header.material_offset >= header.lod_offset + lod_size &&
+			header.material_offset <= cache.size() && header.material_size <= cache.size() - header.material_offset;
+	}
+
+	// Directory part of the path, including the trailing separator, or an empty string.
+	std::string GetDirectory(const std::string& path) {
+		std::size_t separator = path.find_last_of("\\/");
+		return separator == std::string::npos ? std::string() : path.substr(0, separator + 1);
+	}
+
+	// Sets the diffuse texture of every material the library defines with map_Kd. A missing library only
+	// leaves the textures empty, as the renderer falls back to its default texture.
+	void ReadMaterialTextures(const std::string& library_path, std::span<scene_material_t> materials) {
+		std::ifstream library(library_path);
+		if (!library) {
+#if defined(_DEBUG)
+			OutputDebugStringA(std::format("SceneData: material library {} not found\n", library_path).c_str());
+#endif
+			return;
 		}
-		else if (type == "f") {
-			for (std::size_t i = 0; i < 3; i++) {
-				auto index_pair = GetIndexPair(scene_stream);
-				FLOAT* vertex_position = vertices[index_pair.first - 1].position;
-				FLOAT* texture_position = texture_positions[index_pair.second - 1].position;
-				triangle_data.push_back({ { vertex_position[0], vertex_position[1], vertex_position[2] },
-					{ 1.0f, 1.0f, 1.0f, 1.0f }, { texture_position[0], texture_position[1] } });
+
+		const std::string directory = GetDirectory(library_path);
+		scene_material_t* material = nullptr;
+		for (std::string text; std::getline(library, text);) {
+			ObjLine line(text.data(), text.data() + text.size());
+			std::string_view keyword = line.NextToken();
+			if (keyword == "newmtl") {
+				std::string_view name = line.NextToken();
+				auto found = std::find_if(materials.begin(), materials.end(), [&](const scene_material_t& candidate) {
+					return candidate.name == name;
+				});
+				material = found == materials.end() ? nullptr : &*found;
+			}
+			else if (keyword == "map_Kd" && material != nullptr) {
+				// The file name comes after any options.
+				std::string_view file_name;
+				for (std::string_view token = line.NextToken(); !token.empty(); token = line.NextToken()) {
+					file_name = token;
+				}
+				material->diffuse_texture = directory + std::string(file_name);
 			}
 		}
 	}
 }
 
+SceneData::SceneData(const std::string& source_path, const scene_options_t& options) {
+	Load(source_path, options, storage);
+}
+
+SceneData::SceneData(const std::string& source_path, SceneSink& sink, const scene_options_t& options) {
+	if (Load(source_path, options, sink)) {
+		std::span<BYTE> vertex_destination = sink.AllocateVertexData(vertex_data.size());
+		memcpy(vertex_destination.data(), vertex_data.data(), vertex_data.size());
+		std::span<BYTE> index_destination = sink.AllocateIndexData(index_data.size());
+		memcpy(index_destination.data(), index_data.data(), index_data.size());
+	}
+}
+
+bool SceneData::Load(const std::string& source_path, const scene_options_t& options, SceneSink& sink) {
+	const std::string cache_path = source_path + ".cache";
+	const UINT64 options_hash = HashSceneOptions(options);
+	if (LoadCache(cache_path, source_path, options_hash)) {
+		load_stats.cached = true;
+		ResolveMaterialTextures(source_path);
+		return true;
+	}
+
+	MappedFile source_file(source_path);
+	std::vector<vertex_t> vertices;
+	std::vector<UINT> indices;
+	ParseSource(source_file.GetData(), options, vertices, indices);
+
+	// The sizes are known before anything is packed, so the sink allocates each buffer once.
+	std::span<BYTE> vertex_destination = sink.AllocateVertexData(static_cast<std::size_t>(vertex_count) * GetVertexStride());
+	std::span<BYTE> index_destination = sink.AllocateIndexData(static_cast<std::size_t>(index_count) * IndexSize(index_format));
+	PackGeometry(vertices, indices, vertex_destination.data(), index_destination.data());
+	vertex_data = vertex_destination;
+	index_data = index_destination;
+
+	WriteCache(cache_path, source_path, HashBytes(source_file.GetData()), options_hash, vertices, indices);
+	ResolveMaterialTextures(source_path);
+	return false;
+}
+
+void SceneData::ResolveMaterialTextures(const std::string& source_path) {
+	// The library is read on every load rather than cached, so that editing it takes effect immediately.
+	if (!material_library.empty()) {
+		ReadMaterialTextures(GetDirectory(source_path) + material_library, materials);
+	}
+#if defined(_DEBUG)
+	OutputDebugStringA(std::format("SceneData: {} materials\n", materials.size()).c_str());
+#endif
+}
+
+void SceneData::ParseSource(std::span<const char> source, const scene_options_t& options,
+	std::vector<vertex_t>& vertices, std::vector<UINT>& indices) {
+	auto parse_start = std::chrono::steady_clock::now();
+	std::vector<std::span<const char>> chunks = SplitIntoChunks(source, options.thread_count);
+	std::vector<obj_chunk_counts> chunk_counts(chunks.size());
+	std::vector<obj_chunk_materials> chunk_materials(chunks.size());
+
+	// First pass only counts the records, so that every array is allocated once, and collects the material
+	// names, which are few.
+	ParallelFor(chunks.size(), [&](std::size_t chunk) {
+		obj_chunk_counts& counts = chunk_counts[chunk];
+		obj_chunk_materials& material_records = chunk_materials[chunk];
+		ForEachLine(chunks[chunk], [&](const char* begin, const char* end) {
+			obj_record record = ClassifyLine(begin, end);
+			switch (record) {
+			case obj_record::VERTEX: counts.vertices++; break;
+			case obj_record::TEXTURE: counts.textures++; break;
+			case obj_record::FACE:
+				counts.faces++;
+				material_records.faces_before_first_name |= material_records.names.empty();
+				break;
+			case obj_record::MATERIAL_LIBRARY:
+			case obj_record::USE_MATERIAL: {
+				ObjLine line(begin, end);
+				line.NextToken();
+				std::string_view name = line.NextToken();
+				if (record == obj_record::USE_MATERIAL) {
+					material_records.names.push_back(name);
+				}
+				else if (material_records.library.empty()) {
+					material_records.library = name;
+				}
+				break;
+			}
+			default: break;
+			}
+		});
+	});
+
+	// Materials are numbered in the order of their first usemtl record. Faces before any usemtl record get a
+	// material with an empty name.
+	std::unordered_map<std::string_view, UINT> material_indices;
+	std::vector<UINT> chunk_initial_materials(chunks.size());
+	UINT active_material = NO_MATERIAL;
+	auto add_material = [&](std::string_view name) {
+		auto [entry, inserted] = material_indices.try_emplace(name, static_cast<UINT>(materials.size()));
+		if (inserted) {
+			materials.push_back({ .name = std::string(name) });
+		}
+		return entry->second;
+	};
+	materials.clear();
+	material_library.clear();
+	for (std::size_t chunk = 0; chunk < chunks.size(); chunk++) {
+		if (chunk_materials[chunk].faces_before_first_name && active_material == NO_MATERIAL) {
+			active_material = add_material("");
+		}
+		chunk_initial_materials[chunk] = active_material;
+		for (std::string_view name : chunk_materials[chunk].names) {
+			active_material = add_material(name);
+		}
+		if (material_library.empty()) {
+			material_library = chunk_materials[chunk].library;
+		}
+	}
+
+	// Prefix sums turn the per-chunk counts into offsets of each chunk's records in the global arrays.
+	std::vector<obj_chunk_counts> chunk_offsets(chunks.size());
+	obj_chunk_counts totals;
+	for (std::size_t chunk = 0; chunk < chunks.size(); chunk++) {
+		chunk_offsets[chunk] = totals;
+		totals.vertices += chunk_counts[chunk].vertices;
+		totals.textures += chunk_counts[chunk].textures;
+		totals.faces += chunk_counts[chunk].faces;
+	}
+
+	std::vector<obj_vertex> positions(totals.vertices);
+	std::vector<obj_texture> texture_positions(totals.textures);
+	std::vector<obj_index_pair> face_corners(totals.faces * 3);
+
+	// Second pass parses every chunk into its own slice of the global arrays. Face records keep the raw
+	// indices, since they may refer to positions parsed by other chunks.
+	ParallelFor(chunks.size(), [&](std::size_t chunk) {
+		obj_vertex* next_vertex = positions.data() + chunk_offsets[chunk].vertices;
+		obj_texture* next_texture = texture_positions.data() + chunk_offsets[chunk].textures;
+		obj_index_pair* next_corner = face_corners.data() + chunk_offsets[chunk].faces * 3;
+		UINT material = chunk_initial_materials[chunk];
+		ForEachLine(chunks[chunk], [&](const char* begin, const char* end) {
+			obj_record record = ClassifyLine(begin, end);
+			if (record == obj_record::OTHER || record == obj_record::MATERIAL_LIBRARY) {
+				return; // Comments, objects and smoothing groups are ignored.
+			}
+
+			ObjLine line(begin, end);
+			line.NextToken();
+			if (record == obj_record::USE_MATERIAL) {
+				material = material_indices.at(line.NextToken());
+			}
+			else if (record == obj_record::VERTEX) {
+				FLOAT x = line.ParseFloat();
+				FLOAT y = line.ParseFloat();
+				FLOAT z = line.ParseFloat();
+				*next_vertex++ = { x, y, z };
+			}
+			else if (record == obj_record::TEXTURE) {
+				FLOAT u = line.ParseFloat();
+				FLOAT v = line.ParseFloat();
+				*next_texture++ = { u, v };
+			}
+			else {
+				for (std::size_t i = 0; i < 3; i++) {
+					*next_corner++ = line.ParseIndexPair(material);
+				}
+			}
+		});
+	});
+
+	// Third pass checks the face corners against the complete position and texture arrays and makes
+	// their indices zero-based.
+	ParallelFor(chunks.size(), [&](std::size_t chunk) {
+		std::size_t corner_begin = chunk_offsets[chunk].faces * 3;
+		std::size_t corner_end = corner_begin + chunk_counts[chunk].faces * 3;
+		for (std::size_t corner = corner_begin; corner < corner_end; corner++) {
+			obj_index_pair& index_pair = face_corners[corner];
+			if (index_pair.vertex - 1 >= positions.size() || index_pair.texture - 1 >= texture_positions.size()) {
+				throw std::runtime_error("SceneData: face index out of range");
+			}
+			index_pair.vertex--;
+			index_pair.texture--;
+		}
+	});
+
+	load_stats.parse_time =
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - parse_start).count();
+
+	auto index_start = std::chrono::steady_clock::now();
+	BuildIndexedMesh(face_corners, positions, texture_positions, vertices, indices);
+	load_stats.index_time =
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - index_start).count();
+
+#if defined(_DEBUG)
+	vertex_cache_stats_t exported_stats = AnalyzeVertexCache(indices, vertices.size(), options.vertex_cache_size);
+#endif
+
+	// Every level of every chunk is ordered for the vertex cache on its own, so that the triangles of a chunk
+	// stay together whichever level it is drawn at, while the vertex order follows the triangles of level 0.
+	lod_levels = GenerateLodChain(indices, vertices, options.lod, options.thread_count, lod_chunk_levels);
+	for (const lod_level_t& lod : lod_chunk_levels) {
+		OptimizeVertexCache(std::span(indices).subspan(lod.first_index, lod.index_count), vertices.size(),
+			options.vertex_cache_size);
+	}
+	OptimizeVertexFetch(indices, vertices);
+#if defined(_DEBUG)
+	vertex_cache_stats_t optimized_stats = AnalyzeVertexCache(std::span(indices).first(lod_levels[0].index_count),
+		vertices.size(), options.vertex_cache_size);
+	OutputDebugStringA(std::format("SceneData: ACMR {:.3f} -> {:.3f}, ATVR {:.3f} -> {:.3f} (cache size {})\n",
+		exported_stats.acmr, optimized_stats.acmr, exported_stats.atvr, optimized_stats.atvr,
+		options.vertex_cache_size).c_str());
+	for (std::size_t level = 1; level < lod_levels.size(); level++) {
+		OutputDebugStringA(std::format("SceneData: LOD {} has {} triangles, error {:.4f}, in {} chunks\n",
+			level, lod_levels[level].index_count / 3, lod_levels[level].error,
+			lod_chunk_levels.size() / lod_levels.size()).c_str());
+	}
+#endif
+
+	vertex_format = options.vertex_format;
+	vertex_count = static_cast<UINT>(vertices.size());
+	position_dequantization = ComputePositionDequantization(vertices, vertex_format.position_encoding);
+#if defined(_DEBUG)
+	OutputDebugStringA(std::format("SceneData: {} vertices packed from {} to {} bytes each\n",
+		vertex_count, sizeof(vertex_t), ::GetVertexStride(vertex_format)).c_str());
+#endif
+
+	index_count = static_cast<UINT>(indices.size());
+	index_format = vertex_count <= UINT16_MAX ? DXGI_FORMAT_R16_UINT : DXGI_FORMAT_R32_UINT;
+}
+
+void SceneData::PackGeometry(std::span<const vertex_t> vertices, std::span<const UINT> indices,
+	BYTE* vertex_destination, BYTE* index_destination) {
+	PackVertices(vertices, vertex_format, position_dequantization, vertex_destination);
+	if (index_format == DXGI_FORMAT_R16_UINT) {
+		UINT16* short_indices = reinterpret_cast<UINT16*>(index_destination);
+		for (std::size_t i = 0; i < indices.size(); i++) {
+			short_indices[i] = static_cast<UINT16>(indices[i]);
+		}
+	}
+	else {
+		memcpy(index_destination, indices.data(), indices.size_bytes());
+	}
+}
+
 const std::vector<vertex_t>& SceneData::GetTriangleData() {
+	UINT level_index_count = lod_levels[0].index_count;
+	if (triangle_data.size() != level_index_count) {
+		std::vector<vertex_t> vertices(vertex_count);
+		UnpackVertices(readable_vertex_data, vertex_format, position_dequantization, vertices.data());
+		triangle_data.resize(level_index_count);
+		for (UINT i = 0; i < level_index_count; i++) {
+			triangle_data[i] = vertices[ReadIndex(readable_index_data, index_format, i)];
+		}
+	}
 	return triangle_data;
 }
 
-std::pair<std::size_t, std::size_t> SceneData::GetIndexPair(std::ifstream& input_stream) {
-	std::size_t vertex_index, texture_index;
-	input_stream >> vertex_index;
-	input_stream.ignore(1); // Ignore '/' between the indices.
-	input_stream >> texture_index;
-	return { vertex_index, texture_index };
+std::span<const BYTE> SceneData::GetVertexData() {
+	return vertex_data;
+}
+
+UINT SceneData::GetVertexCount() {
+	return vertex_count;
+}
+
+UINT SceneData::GetVertexStride() {
+	return ::GetVertexStride(vertex_format);
+}
+
+const position_dequantization_t& SceneData::GetPositionDequantization() {
+	return position_dequantization;
+}
+
+std::span<const BYTE> SceneData::GetIndexData() {
+	return index_data;
+}
+
+DXGI_FORMAT SceneData::GetIndexFormat() {
+	return index_format;
+}
+
+UINT SceneData::GetIndexCount() {
+	return index_count;
+}
+
+std::span<const lod_level_t> SceneData::GetLodLevels() {
+	return lod_levels;
+}
+
+std::span<const lod_level_t> SceneData::GetLodChunkLevels() {
+	return lod_chunk_levels;
+}
+
+std::span<const scene_material_t> SceneData::GetMaterials() {
+	return materials;
+}
+
+const scene_load_stats_t& SceneData::GetLoadStats() {
+	return load_stats;
+}
+
+meshlet_data_t SceneData::BuildMeshlets(UINT level) {
+	std::vector<vertex_t> vertices(vertex_count);
+	UnpackVertices(readable_vertex_data, vertex_format, position_dequantization, vertices.data());
+	std::vector<DirectX::XMFLOAT3> positions(vertex_count);
+	for (UINT i = 0; i < vertex_count; i++) {
+		positions[i] = { vertices[i].position[0], vertices[i].position[1], vertices[i].position[2] };
+	}
+
+	// Built chunk by chunk, so that no meshlet has triangles of two chunks.
+	meshlet_data_t meshlets;
+	UINT level_count = static_cast<UINT>(lod_levels.size());
+	if (level >= level_count) {
+		throw std::runtime_error("SceneData: level of detail out of range");
+	}
+	for (std::size_t chunk = level; chunk < lod_chunk_levels.size(); chunk += level_count) {
+		const lod_level_t& lod = lod_chunk_levels[chunk];
+		std::vector<UINT> indices(lod.index_count);
+		for (UINT i = 0; i < lod.index_count; i++) {
+			indices[i] = ReadIndex(readable_index_data, index_format, lod.first_index + i);
+		}
+
+		meshlet_data_t chunk_meshlets = ::BuildMeshlets(indices, positions);
+		for (meshlet_t& meshlet : chunk_meshlets.meshlets) {
+			meshlet.first_index += lod.first_index;
+			meshlet.vertex_offset += static_cast<UINT>(meshlets.vertices.size());
+			meshlet.triangle_offset += static_cast<UINT>(meshlets.triangles.size());
+		}
+		meshlets.meshlets.insert(meshlets.meshlets.end(), chunk_meshlets.meshlets.begin(),
+			chunk_meshlets.meshlets.end());
+		meshlets.vertices.insert(meshlets.vertices.end(), chunk_meshlets.vertices.begin(),
+			chunk_meshlets.vertices.end());
+		meshlets.triangles.insert(meshlets.triangles.end(), chunk_meshlets.triangles.begin(),
+			chunk_meshlets.triangles.end());
+	}
+	return meshlets;
+}
+
+std::vector<texture_usage_t> SceneData::ComputeTextureUsage(std::span<const UINT> material_textures) {
+	std::vector<vertex_t> vertices(vertex_count);
+	UnpackVertices(readable_vertex_data, vertex_format, position_dequantization, vertices.data());
+
+	const lod_level_t& lod = lod_levels[0];
+	std::vector<UINT> indices(lod.index_count);
+	for (UINT i = 0; i < lod.index_count; i++) {
+		indices[i] = ReadIndex(readable_index_data, index_format, lod.first_index + i);
+	}
+	return ::ComputeTextureUsage(vertices, indices, material_textures);
+}
+
+bool SceneData::LoadCache(const std::string& cache_path, const std::string& source_path, UINT64 options_hash) {
+	if (GetFileAttributesA(cache_path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+		return false;
+	}
+
+	try {
+		cache_file.emplace(cache_path);
+	}
+	catch (const winrt::hresult_error&) {
+		return false;
+	}
+
+	std::span<const char> cache = cache_file->GetData();
+	scene_cache_header_t header;
+	if (!ReadCacheHeader(cache, header) || header.options_hash != options_hash) {
+		cache_file.reset();
+		return false;
+	}
+
+	// A modified timestamp alone does not invalidate the cache, as long as the contents are the same.
+	source_stamp_t source_stamp = GetSourceStamp(source_path);
+	bool source_matches = header.source_size == source_stamp.size &&
+		(header.source_write_time == source_stamp.write_time ||
+			header.source_hash == HashBytes(MappedFile(source_path).GetData()));
+	if (!source_matches || header.payload_hash != HashBytes(cache.subspan(sizeof(header)))) {
+		cache_file.reset();
+		return false;
+	}
+
+	// Records the new timestamp, so that later starts do not hash the source again. The payload hash does not
+	// cover the header, and the cache is still used if the header cannot be written.
+	if (header.source_write_time != source_stamp.write_time) {
+		header.source_write_time = source_stamp.write_time;
+		std::size_t cache_size = cache.size();
+		cache_file.reset();
+		UpdateCacheHeader(cache_path, { reinterpret_cast<const char*>(&header), sizeof(header) });
+		try {
+			cache_file.emplace(cache_path);
+		}
+		catch (const winrt::hresult_error&) {
+			return false;
+		}
+		cache = cache_file->GetData();
+		if (cache.size() != cache_size) {
+			cache_file.reset();
+			return false;
+		}
+	}
+
+	vertex_format = {
+		.position_encoding = static_cast<position_encoding_t>(header.position_encoding),
+		.half_tex_coord = header.half_tex_coord != 0,
+		.color = header.color != 0
+	};
+	position_dequantization = header.position_dequantization;
+	vertex_count = header.vertex_count;
+	vertex_data = { reinterpret_cast<const BYTE*>(cache.data() + header.vertex_offset),
+		static_cast<std::size_t>(header.vertex_count) * header.vertex_stride };
+	index_data = { reinterpret_cast<const BYTE*>(cache.data() + header.index_offset),
+		static_cast<std::size_t>(header.index_count) * IndexSize(static_cast<DXGI_FORMAT>(header.index_format)) };
+	index_format = static_cast<DXGI_FORMAT>(header.index_format);
+	index_count = header.index_count;
+	readable_vertex_data = vertex_data;
+	readable_index_data = index_data;
+
+	lod_levels.resize(header.lod_count);
+	memcpy(lod_levels.data(), cache.data() + header.lod_offset, lod_levels.size() * sizeof(lod_level_t));
+	lod_chunk_levels.resize(header.lod_chunk_level_count);
+	memcpy(lod_chunk_levels.data(), cache.data() + header.lod_offset + lod_levels.size() * sizeof(lod_level_t),
+		lod_chunk_levels.size() * sizeof(lod_level_t));
+	for (const std::vector<lod_level_t>* ranges : { &lod_levels, &lod_chunk_levels }) {
+		for (const lod_level_t& level : *ranges) {
+			if (level.first_index > index_count || level.index_count > index_count - level.first_index) {
+				lod_levels.clear();
+				lod_chunk_levels.clear();
+				cache_file.reset();
+				return false;
+			}
+		}
+	}
+
+	std::string_view names(cache.data() + header.material_offset, static_cast<std::size_t>(header.material_size));
+	if (names.empty() || names.back() != '\0' ||
+		std::count(names.begin(), names.end(), '\0') != static_cast<std::ptrdiff_t>(header.material_count) + 1) {
+		lod_levels.clear();
+		lod_chunk_levels.clear();
+		cache_file.reset();
+		return false;
+	}
+	material_library = names.data();
+	materials.clear();
+	for (std::size_t name = material_library.size() + 1; name < names.size(); name += materials.back().name.size() + 1) {
+		materials.push_back({ .name = names.data() + name });
+	}
+	return true;
+}
+
+void SceneData::WriteCache(const std::string& cache_path, const std::string& source_path, UINT64 source_hash,
+	UINT64 options_hash, std::span<const vertex_t> vertices, std::span<const UINT> indices) {
+	source_stamp_t source_stamp = GetSourceStamp(source_path);
+	scene_cache_header_t header = {
+		.version = SCENE_CACHE_VERSION,
+		.source_size = source_stamp.size,
+		.source_write_time = source_stamp.write_time,
+		.source_hash = source_hash,
+		.options_hash = options_hash,
+		.vertex_count = vertex_count,
+		.vertex_stride = GetVertexStride(),
+		.position_encoding = static_cast<UINT>(vertex_format.position_encoding),
+		.half_tex_coord = vertex_format.half_tex_coord,
+		.color = vertex_format.color,
+		.position_dequantization = position_dequantization,
+		.index_count = index_count,
+		.index_format = static_cast<UINT>(index_format),
+		.lod_count = static_cast<UINT>(lod_levels.size()),
+		.lod_chunk_level_count = static_cast<UINT>(lod_chunk_levels.size()),
+		.material_count = static_cast<UINT>(materials.size()),
+		.vertex_offset = AlignCacheOffset(sizeof(scene_cache_header_t)),
+	};
+	memcpy(header.magic, SCENE_CACHE_MAGIC, sizeof(header.magic));
+	header.index_offset = AlignCacheOffset(header.vertex_offset + vertex_data.size());
+	header.lod_offset = AlignCacheOffset(header.index_offset + index_data.size());
+	const std::size_t lod_size = (lod_levels.size() + lod_chunk_levels.size()) * sizeof(lod_level_t);
+	std::string names = material_library + '\0';
+	for (const scene_material_t& material : materials) {
+		names += material.name + '\0';
+	}
+	header.material_offset = header.lod_offset + lod_size;
+	header.material_size = names.size();
+
+	std::vector<char> payload(header.material_offset + names.size() - sizeof(header));
+	// Packed again from the unpacked geometry rather than read back from the sink, whose memory may be
+	// slow to read, such as a write-combined upload heap.
+	PackGeometry(vertices, indices, reinterpret_cast<BYTE*>(payload.data() + header.vertex_offset - sizeof(header)),
+		reinterpret_cast<BYTE*>(payload.data() + header.index_offset - sizeof(header)));
+	memcpy(payload.data() + header.lod_offset - sizeof(header), lod_levels.data(),
+		lod_levels.size() * sizeof(lod_level_t));
+	memcpy(payload.data() + header.lod_offset - sizeof(header) + lod_levels.size() * sizeof(lod_level_t),
+		lod_chunk_levels.data(), lod_chunk_levels.size() * sizeof(lod_level_t));
+	memcpy(payload.data() + header.material_offset - sizeof(header), names.data(), names.size());
+	header.payload_hash = HashBytes(payload);
+
+	// The cache only speeds up later starts, so failing to write it is not an error.
+	WriteCacheFile(cache_path, { { reinterpret_cast<const char*>(&header), sizeof(header) }, payload });
+
+	// Kept as the readable copy of the geometry, which is what the mapped cache serves as on later starts.
+	cache_payload = std::move(payload);
+	const BYTE* payload_data = reinterpret_cast<const BYTE*>(cache_payload.data());
+	readable_vertex_data = { payload_data + (header.vertex_offset - sizeof(header)), vertex_data.size() };
+	readable_index_data = { payload_data + (header.index_offset - sizeof(header)), index_data.size() };
 }
@@ -1,14 +1,114 @@
 #pragma once
 
 #include "vertex.h"
+#include "VertexFormat.h"
+#include "MappedFile.h"
+#include "MeshSimplifier.h"
+#include "MeshletBuilder.h"
+#include "MipStreamer.h"
+#include "SceneSink.h"
+
+struct scene_options_t {
+	// Limits how many chunks of the file are parsed in parallel; small files use a single chunk.
+	UINT thread_count = 1;
+	// Size of the post-transform vertex cache the triangle order is optimized for.
+	UINT vertex_cache_size = 16;
+	vertex_format_t vertex_format;
+	// Simplified levels of detail stored after the full-detail triangles in the index data.
+	lod_options_t lod;
+};
+
+struct scene_material_t {
+	std::string name;
+	// Diffuse texture (map_Kd) from the material library, relative to the working directory; empty when the
+	// library does not give one.
+	std::string diffuse_texture;
+};
+
+// Where the time of a load went, for the benchmarks. Times are in milliseconds.
+struct scene_load_stats_t {
+	// Whether the geometry came from the cache, which skips the parsing and the steps after it.
+	bool cached = false;
+	// Reading the records of the source into the position, texture and face corner arrays.
+	double parse_time = 0.0;
+	// Merging the face corners into one vertex per unique (position, texture) index pair.
+	double index_time = 0.0;
+};
 
 class SceneData {
 public:
-	SceneData(const std::string& source_path);
+	// The indexed mesh is cached in a binary file next to the source, which is used instead of parsing the
+	// source as long as the source and the options affecting the output are unchanged.
+	SceneData(const std::string& source_path, const scene_options_t& options = {});
+	// Writes the packed vertices and indices into the sink instead of memory owned by the object. A parsed
+	// source is packed straight into the sink, and a cached one is copied into it from the mapped cache.
+	SceneData(const std::string& source_path, SceneSink& sink, const scene_options_t& options = {});
 
+	// Non-indexed triangles of the full-detail level.
 	const std::vector<vertex_t>& GetTriangleData();
+
+	// Indexed form of the triangle data, with one vertex per unique (position, texture) index pair,
+	// packed in the vertex format from the options. The spans may point into the memory-mapped cache or
+	// the sink, and stay valid for the lifetime of the object.
+	std::span<const BYTE> GetVertexData();
+	UINT GetVertexCount();
+	UINT GetVertexStride();
+	const position_dequantization_t& GetPositionDequantization();
+	std::span<const BYTE> GetIndexData();
+	DXGI_FORMAT GetIndexFormat();
+	// Number of indices of all levels together.
+	UINT GetIndexCount();
+	// Index ranges of the levels of detail, starting with the full-detail level.
+	std::span<const lod_level_t> GetLodLevels();
+	// Index ranges of the levels of each spatial chunk, as many per chunk as there are levels, the chunks one
+	// after another. The ranges of a level follow each other in the same chunk order and together make up the
+	// range of the level, and each has its own error, so that every chunk can select a level by its own
+	// distance from the camera.
+	std::span<const lod_level_t> GetLodChunkLevels();
+	// Meshlets of one level of detail, none spanning two chunks, with bounds in scene space and index ranges
+	// into the index data. Like the triangle data and the texture usage, built from a copy of the geometry in
+	// CPU memory rather than read back from the sink.
+	meshlet_data_t BuildMeshlets(UINT level = 0);
+	// Materials in the order of their usemtl records, with faces before any usemtl record using one with an
+	// empty name. The material of each vertex is an index into them.
+	std::span<const scene_material_t> GetMaterials();
+	// Where each texture is used by the full-detail level, for mip streaming, with material_textures giving
+	// the texture of every material.
+	std::vector<texture_usage_t> ComputeTextureUsage(std::span<const UINT> material_textures);
+	const scene_load_stats_t& GetLoadStats();
 private:
 	std::vector<vertex_t> triangle_data;
 
-	std::pair<std::size_t, std::size_t> GetIndexPair(std::ifstream& input_stream);
+	VectorSceneSink storage;
+	std::optional<MappedFile> cache_file;
+
+	vertex_format_t vertex_format;
+	position_dequantization_t position_dequantization;
+	UINT vertex_count = 0;
+	std::span<const BYTE> vertex_data;
+	std::span<const BYTE> index_data;
+	// The packed geometry in memory that is cheap to read, unlike a sink in a write-combined upload heap: the
+	// mapped cache, or the payload written to it when the source was parsed.
+	std::span<const BYTE> readable_vertex_data;
+	std::span<const BYTE> readable_index_data;
+	std::vector<char> cache_payload;
+	DXGI_FORMAT index_format = DXGI_FORMAT_UNKNOWN;
+	UINT index_count = 0;
+	std::vector<lod_level_t> lod_levels;
+	std::vector<lod_level_t> lod_chunk_levels;
+	// As named by the mtllib record, relative to the source.
+	std::string material_library;
+	std::vector<scene_material_t> materials;
+	scene_load_stats_t load_stats;
+
+	// Returns whether the geometry was loaded from the cache; otherwise it was parsed into the sink.
+	bool Load(const std::string& source_path, const scene_options_t& options, SceneSink& sink);
+	void ParseSource(std::span<const char> source, const scene_options_t& options, std::vector<vertex_t>& vertices,
+		std::vector<UINT>& indices);
+	void ResolveMaterialTextures(const std::string& source_path);
+	void PackGeometry(std::span<const vertex_t> vertices, std::span<const UINT> indices, BYTE* vertex_destination,
+		BYTE* index_destination);
+	bool LoadCache(const std::string& cache_path, const std::string& source_path, UINT64 options_hash);
+	void WriteCache(const std::string& cache_path, const std::string& source_path, UINT64 source_hash,
+		UINT64 options_hash, std::span<const vertex_t> vertices, std::span<const UINT> indices);
 };
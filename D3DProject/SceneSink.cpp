@@ -0,0 +1,20 @@
+#include "pch.h"
+#include "SceneSink.h"
+
+std::span<BYTE> VectorSceneSink::AllocateVertexData(std::size_t size) {
+	vertex_data.resize(size);
+	return vertex_data;
+}
+
+std::span<BYTE> VectorSceneSink::AllocateIndexData(std::size_t size) {
+	index_data.resize(size);
+	return index_data;
+}
+
+std::span<const BYTE> VectorSceneSink::GetVertexData() const {
+	return vertex_data;
+}
+
+std::span<const BYTE> VectorSceneSink::GetIndexData() const {
+	return index_data;
+}
@@ -0,0 +1,25 @@
+#pragma once
+
+// Destination of the packed scene geometry. SceneData asks for each buffer once, with its final size,
+// before writing to it, so the destination can be allocated in place, for example in a mapped upload heap.
+class SceneSink {
+public:
+	virtual ~SceneSink() = default;
+
+	// The returned spans must hold size bytes and stay valid as long as the SceneData that filled them.
+	virtual std::span<BYTE> AllocateVertexData(std::size_t size) = 0;
+	virtual std::span<BYTE> AllocateIndexData(std::size_t size) = 0;
+};
+
+// Keeps the geometry in CPU memory.
+class VectorSceneSink : public SceneSink {
+public:
+	std::span<BYTE> AllocateVertexData(std::size_t size) override;
+	std::span<BYTE> AllocateIndexData(std::size_t size) override;
+
+	std::span<const BYTE> GetVertexData() const;
+	std::span<const BYTE> GetIndexData() const;
+private:
+	std::vector<BYTE> vertex_data;
+	std::vector<BYTE> index_data;
+};
@@ -0,0 +1,75 @@
+#include "pch.h"
+#include "TextureArray.h"
+
+TextureArray::TextureArray(std::span<const std::string> paths, const texture_options_t& options,
+	const texture_batch_options_t& batch_options) {
+	if (paths.empty()) {
+		throw std::runtime_error("TextureArray: no textures");
+	}
+
+	std::vector<std::string> unique_paths;
+	for (const std::string& path : paths) {
+		auto found = std::find(unique_paths.begin(), unique_paths.end(), path);
+		slice_textures.push_back(static_cast<UINT>(found - unique_paths.begin()));
+		if (found == unique_paths.end()) {
+			unique_paths.push_back(path);
+		}
+	}
+
+	texture_options_t slice_options = options;
+	if (slice_options.width == 0 || slice_options.height == 0) {
+		// Only the headers are read here; the textures may still come from their caches.
+		winrt::com_ptr<IWICImagingFactory2> imaging_factory;
+		if (options.decoder == bitmap_decoder_t::WIC) {
+			winrt::check_hresult(CoCreateInstance(
+				CLSID_WICImagingFactory2,
+				nullptr,
+				CLSCTX_INPROC_SERVER,
+				IID_PPV_ARGS(imaging_factory.put())
+			));
+		}
+		UINT max_width = 0, max_height = 0;
+		for (const std::string& path : unique_paths) {
+			std::wstring uri(winrt::to_hstring(path));
+			BitmapDefinition bitmap(uri.c_str(), options.decoder);
+			bitmap.CreateDeviceIndependentResources(imaging_factory.get());
+			UINT width, height;
+			bitmap.GetSize(&width, &height);
+			max_width = std::max(max_width, width);
+			max_height = std::max(max_height, height);
+		}
+		slice_options.width = slice_options.width != 0 ? slice_options.width : max_width;
+		slice_options.height = slice_options.height != 0 ? slice_options.height : max_height;
+	}
+
+	textures.resize(unique_paths.size());
+	LoadTextures(unique_paths, slice_options, batch_options, [&](UINT index, std::unique_ptr<TextureAsset> texture) {
+		textures[index] = std::move(texture);
+	});
+#if defined(_DEBUG)
+	OutputDebugStringA(std::format("TextureArray: {} slices of {}x{} from {} textures\n", slice_textures.size(),
+		slice_options.width, slice_options.height, textures.size()).c_str());
+#endif
+}
+
+UINT TextureArray::GetSliceCount() const {
+	return static_cast<UINT>(slice_textures.size());
+}
+
+DXGI_FORMAT TextureArray::GetFormat() const {
+	return textures[0]->GetFormat();
+}
+
+std::span<const texture_level_t> TextureArray::GetLevels() const {
+	return textures[0]->GetLevels();
+}
+
+std::span<const BYTE> TextureArray::GetSliceData(UINT slice) const {
+	return textures[slice_textures.at(slice)]->GetData();
+}
+
+bool TextureArray::IsCached() const {
+	return std::all_of(textures.begin(), textures.end(), [](const std::unique_ptr<TextureAsset>& texture) {
+		return texture->IsCached();
+	});
+}
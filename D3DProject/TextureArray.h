@@ -0,0 +1,25 @@
+#pragma once
+
+#include "TextureLoader.h"
+
+class TextureArray {
+public:
+	// Loads one slice per path, all resampled to the options' size or, where that is zero, to the largest
+	// width and height among the images, so that they form a single Texture2DArray. Paths that repeat share
+	// one loaded texture. The textures are loaded by LoadTextures, concurrently as the batch options allow.
+	// Decoding with WIC requires COM to be initialized on the calling thread.
+	TextureArray(std::span<const std::string> paths, const texture_options_t& options = {},
+		const texture_batch_options_t& batch_options = {});
+
+	UINT GetSliceCount() const;
+	DXGI_FORMAT GetFormat() const;
+	// Levels of every slice, which all share the same layout.
+	std::span<const texture_level_t> GetLevels() const;
+	std::span<const BYTE> GetSliceData(UINT slice) const;
+	// Whether every slice was loaded from its cache.
+	bool IsCached() const;
+private:
+	std::vector<std::unique_ptr<TextureAsset>> textures;
+	// Index into textures of every slice.
+	std::vector<UINT> slice_textures;
+};
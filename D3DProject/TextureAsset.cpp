@@ -0,0 +1,337 @@
+#include "pch.h"
+#include "TextureAsset.h"
+#include "asset_cache.h"
+
+namespace {
+	constexpr char TEXTURE_CACHE_MAGIC[4] = { 'T', 'E', 'X', 'C' };
+	constexpr UINT TEXTURE_CACHE_VERSION = 1;
+	// The level data starts at an upload-buffer placement boundary of the mapped file.
+	constexpr UINT64 TEXTURE_CACHE_ALIGNMENT = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT;
+
+	struct texture_cache_header_t {
+		char magic[4];
+		UINT version;
+		UINT64 source_size;
+		UINT64 source_write_time;
+		UINT64 source_hash;
+		UINT64 options_hash;
+		// Hash of everything that follows the header.
+		UINT64 payload_hash;
+		UINT format;
+		UINT level_count;
+		UINT64 level_offset;
+		UINT64 data_offset;
+		UINT64 data_size;
+	};
+
+	UINT64 HashTextureOptions(const texture_options_t& options) {
+		const UINT affecting_options[] = {
+			static_cast<UINT>(options.mip_filter),
+			static_cast<UINT>(options.format),
+			static_cast<UINT>(options.quality),
+			options.width,
+			options.height
+		};
+		return HashBytes({ reinterpret_cast<const char*>(affecting_options), sizeof(affecting_options) });
+	}
+
+	UINT64 AlignUp(UINT64 value, UINT64 alignment) {
+		return (value + alignment - 1) & ~(alignment - 1);
+	}
+
+	// Bytes in one row of pixels, or of 4x4 blocks for block-compressed formats; 0 for other formats.
+	UINT GetRowSize(DXGI_FORMAT format, UINT width) {
+		switch (format) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM: return width * 4;
+		case DXGI_FORMAT_BC1_UNORM: return (width + 3) / 4 * 8;
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC7_UNORM: return (width + 3) / 4 * 16;
+		default: return 0;
+		}
+	}
+
+	// Copies the levels to the row pitch and placement alignment that GetCopyableFootprints gives for them,
+	// unless they already have it.
+	texture_data_t AlignForUpload(texture_data_t source) {
+		bool aligned = std::all_of(source.levels.begin(), source.levels.end(), [](const texture_level_t& level) {
+			return level.offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT == 0 && level.row_pitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT == 0;
+		});
+		if (aligned) {
+			return source;
+		}
+
+		texture_data_t texture = { .format = source.format };
+		UINT64 size = 0;
+		for (const texture_level_t& level : source.levels) {
+			size = AlignUp(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+			UINT row_pitch = static_cast<UINT>(AlignUp(level.row_pitch, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT));
+			texture.levels.push_back({
+				.width = level.width,
+				.height = level.height,
+				.offset = static_cast<std::size_t>(size),
+				.row_pitch = row_pitch,
+				.row_count = level.row_count
+			});
+			size += static_cast<UINT64>(row_pitch) * level.row_count;
+		}
+		texture.data.resize(static_cast<std::size_t>(size));
+		for (std::size_t i = 0; i < source.levels.size(); i++) {
+			const texture_level_t& from = source.levels[i];
+			const texture_level_t& to = texture.levels[i];
+			for (UINT row = 0; row < from.row_count; row++) {
+				memcpy(texture.data.data() + to.offset + std::size_t(row) * to.row_pitch,
+					source.data.data() + from.offset + std::size_t(row) * from.row_pitch, from.row_pitch);
+			}
+		}
+		return texture;
+	}
+
+	// Checks that the header belongs to a cache of the current version whose sections lie within the file.
+	bool ReadCacheHeader(std::span<const char> cache, texture_cache_header_t& header) {
+		if (cache.size() < sizeof(header)) {
+			return false;
+		}
+		memcpy(&header, cache.data(), sizeof(header));
+		if (memcmp(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic)) != 0 ||
+			header.version != TEXTURE_CACHE_VERSION || GetRowSize(static_cast<DXGI_FORMAT>(header.format), 1) == 0 ||
+			header.level_count == 0 || header.level_count > D3D12_REQ_MIP_LEVELS) {
+			return false;
+		}
+		UINT64 level_size = static_cast<UINT64>(header.level_count) * sizeof(texture_level_t);
+		return header.level_offset >= sizeof(header) && header.level_offset % sizeof(UINT64) == 0 &&
+			header.level_offset <= cache.size() && level_size <= cache.size() - header.level_offset &&
+			header.data_offset >= header.level_offset + level_size && header.data_offset % TEXTURE_CACHE_ALIGNMENT == 0 &&
+			header.data_offset <= cache.size() && header.data_size <= cache.size() - header.data_offset;
+	}
+
+	// Checks that the levels form a mip chain stored within the data in the row layout of the format.
+	bool ValidateLevels(DXGI_FORMAT format, std::span<const texture_level_t> levels, UINT64 data_size) {
+		bool block_compressed = format != DXGI_FORMAT_R8G8B8A8_UNORM;
+		for (std::size_t i = 0; i < levels.size(); i++) {
+			const texture_level_t& level = levels[i];
+			if (level.width == 0 || level.height == 0 ||
+				level.width != std::max(levels[0].width >> i, 1u) || level.height != std::max(levels[0].height >> i, 1u) ||
+				level.row_count != (block_compressed ? (level.height + 3) / 4 : level.height) ||
+				level.row_pitch < GetRowSize(format, level.width) ||
+				level.offset > data_size || static_cast<UINT64>(level.row_pitch) * level.row_count > data_size - level.offset) {
+				return false;
+			}
+		}
+		return levels.size() == GetMipLevelCount(levels[0].width, levels[0].height) &&
+			(!block_compressed || CanBlockCompress(levels[0].width, levels[0].height));
+	}
+}
+
+TextureAsset::TextureAsset(const std::string& source_path, const texture_options_t& options) {
+	const std::string cache_path = source_path + ".cache";
+	const UINT64 options_hash = HashTextureOptions(options);
+	if (LoadCache(cache_path, source_path, options_hash)) {
+		return;
+	}
+
+	texture = AlignForUpload(ProcessSource(source_path, options));
+	data = texture.data;
+	WriteCache(cache_path, source_path, options_hash);
+}
+
+std::optional<std::size_t> TextureAsset::GetCachedSize(const std::string& source_path,
+	const texture_options_t& options) {
+	const std::string cache_path = source_path + ".cache";
+	if (GetFileAttributesA(cache_path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+		return std::nullopt;
+	}
+
+	try {
+		MappedFile cache_file(cache_path);
+		texture_cache_header_t header;
+		source_stamp_t source_stamp = GetSourceStamp(source_path);
+		if (ReadCacheHeader(cache_file.GetData(), header) && header.options_hash == HashTextureOptions(options) &&
+			header.source_size == source_stamp.size && header.source_write_time == source_stamp.write_time) {
+			return cache_file.GetData().size();
+		}
+	}
+	catch (const winrt::hresult_error&) {
+	}
+	return std::nullopt;
+}
+
+DXGI_FORMAT TextureAsset::GetFormat() const {
+	return texture.format;
+}
+
+std::span<const texture_level_t> TextureAsset::GetLevels() const {
+	return texture.levels;
+}
+
+std::span<const BYTE> TextureAsset::GetData() const {
+	return data;
+}
+
+bool TextureAsset::IsCached() const {
+	return cache_file.has_value();
+}
+
+texture_data_t TextureAsset::ProcessSource(const std::string& source_path, const texture_options_t& options) {
+	const mip_options_t mip_options = {
+		.filter = options.mip_filter,
+		.thread_count = options.thread_count
+	};
+	UINT width = 0, height = 0;
+	texture_data_t mip_chain;
+#if defined(_DEBUG)
+	auto start = std::chrono::steady_clock::now();
+#endif
+	{
+		winrt::com_ptr<IWICImagingFactory2> imaging_factory;
+		if (options.decoder == bitmap_decoder_t::WIC) {
+			winrt::check_hresult(CoCreateInstance(
+				CLSID_WICImagingFactory2,
+				nullptr,
+				CLSCTX_INPROC_SERVER,
+				IID_PPV_ARGS(imaging_factory.put())
+			));
+		}
+		std::wstring uri(winrt::to_hstring(source_path));
+		BitmapDefinition bitmap(uri.c_str(), options.decoder);
+		bitmap.CreateDeviceIndependentResources(imaging_factory.get());
+		bitmap.GetSize(&width, &height);
+		UINT target_width = options.width != 0 ? options.width : width;
+		UINT target_height = options.height != 0 ? options.height : height;
+		// Laid out for upload from the start, so that an uncompressed texture is not copied again.
+		mip_chain = AllocateMipChain(target_width, target_height, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT,
+			D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		const texture_level_t& top = mip_chain.levels[0];
+		if (target_width == width && target_height == height) {
+			bitmap.CopyPixels(mip_chain.data.data() + top.offset, top.row_pitch);
+		}
+		else {
+			std::vector<BYTE> pixels(std::size_t(width) * height * 4);
+			bitmap.CopyPixels(pixels.data(), width * 4);
+			ResampleImage(pixels.data(), width, height, std::size_t(width) * 4, mip_chain, mip_options);
+		}
+	}
+
+#if defined(_DEBUG)
+	auto decoded = std::chrono::steady_clock::now();
+#endif
+	GenerateMipLevels(mip_chain, mip_options);
+#if defined(_DEBUG)
+	auto generated = std::chrono::steady_clock::now();
+	double decode_time = std::chrono::duration<double, std::milli>(decoded - start).count();
+	OutputDebugStringA(std::format("TextureAsset: {}x{} texture decoded with {} in {:.1f} ms, {:.1f} MP/s, {} mip "
+		"levels generated in {:.1f} ms\n", width, height, options.decoder == bitmap_decoder_t::WIC ? "WIC" : "the portable decoder",
+		decode_time, std::size_t(width) * height / (decode_time * 1000.0), mip_chain.levels.size(),
+		std::chrono::duration<double, std::milli>(generated - decoded).count()).c_str());
+#endif
+
+	const texture_level_t& top = mip_chain.levels[0];
+	if (options.format == DXGI_FORMAT_R8G8B8A8_UNORM || !CanBlockCompress(top.width, top.height)) {
+		return mip_chain;
+	}
+	texture_data_t compressed = CompressTexture(mip_chain, {
+		.format = options.format,
+		.quality = options.quality,
+		.thread_count = options.thread_count
+	});
+#if defined(_DEBUG)
+	double compress_time = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - generated).count();
+	std::size_t pixel_count = 0;
+	for (const texture_level_t& level : mip_chain.levels) {
+		pixel_count += std::size_t(level.width) * level.height;
+	}
+	OutputDebugStringA(std::format("TextureAsset: texture compressed from {} to {} bytes in {:.1f} ms, "
+		"{:.1f} MP/s\n", mip_chain.data.size(), compressed.data.size(), compress_time,
+		pixel_count / (compress_time * 1000.0)).c_str());
+	OutputDebugStringA(std::format("TextureAsset: compressed texture PSNR {:.2f} dB\n",
+		ComputePsnr(mip_chain, DecompressTexture(compressed, options.thread_count))).c_str());
+#endif
+	return compressed;
+}
+
+bool TextureAsset::LoadCache(const std::string& cache_path, const std::string& source_path, UINT64 options_hash) {
+	if (GetFileAttributesA(cache_path.c_str()) == INVALID_FILE_ATTRIBUTES) {
+		return false;
+	}
+
+	try {
+		cache_file.emplace(cache_path);
+	}
+	catch (const winrt::hresult_error&) {
+		return false;
+	}
+
+	std::span<const char> cache = cache_file->GetData();
+	texture_cache_header_t header;
+	if (!ReadCacheHeader(cache, header) || header.options_hash != options_hash) {
+		cache_file.reset();
+		return false;
+	}
+
+	// A modified timestamp alone does not invalidate the cache, as long as the contents are the same.
+	source_stamp_t source_stamp = GetSourceStamp(source_path);
+	bool source_matches = header.source_size == source_stamp.size &&
+		(header.source_write_time == source_stamp.write_time ||
+			header.source_hash == HashBytes(MappedFile(source_path).GetData()));
+	if (!source_matches || header.payload_hash != HashBytes(cache.subspan(sizeof(header)))) {
+		cache_file.reset();
+		return false;
+	}
+
+	// Records the new timestamp, so that later starts do not hash the source again and GetCachedSize reports
+	// the cache. The payload hash does not cover the header, and the cache is still used if the header cannot
+	// be written.
+	if (header.source_write_time != source_stamp.write_time) {
+		header.source_write_time = source_stamp.write_time;
+		std::size_t cache_size = cache.size();
+		cache_file.reset();
+		UpdateCacheHeader(cache_path, { reinterpret_cast<const char*>(&header), sizeof(header) });
+		try {
+			cache_file.emplace(cache_path);
+		}
+		catch (const winrt::hresult_error&) {
+			return false;
+		}
+		cache = cache_file->GetData();
+		if (cache.size() != cache_size) {
+			cache_file.reset();
+			return false;
+		}
+	}
+
+	texture.format = static_cast<DXGI_FORMAT>(header.format);
+	texture.levels.resize(header.level_count);
+	memcpy(texture.levels.data(), cache.data() + header.level_offset, texture.levels.size() * sizeof(texture_level_t));
+	if (!ValidateLevels(texture.format, texture.levels, header.data_size)) {
+		texture = {};
+		cache_file.reset();
+		return false;
+	}
+	data = { reinterpret_cast<const BYTE*>(cache.data() + header.data_offset), static_cast<std::size_t>(header.data_size) };
+	return true;
+}
+
+void TextureAsset::WriteCache(const std::string& cache_path, const std::string& source_path, UINT64 options_hash) {
+	source_stamp_t source_stamp = GetSourceStamp(source_path);
+	texture_cache_header_t header = {
+		.version = TEXTURE_CACHE_VERSION,
+		.source_size = source_stamp.size,
+		.source_write_time = source_stamp.write_time,
+		.source_hash = HashBytes(MappedFile(source_path).GetData()),
+		.options_hash = options_hash,
+		.format = static_cast<UINT>(texture.format),
+		.level_count = static_cast<UINT>(texture.levels.size()),
+		.level_offset = AlignUp(sizeof(texture_cache_header_t), sizeof(UINT64)),
+		.data_size = texture.data.size()
+	};
+	memcpy(header.magic, TEXTURE_CACHE_MAGIC, sizeof(header.magic));
+	const std::size_t level_size = texture.levels.size() * sizeof(texture_level_t);
+	header.data_offset = AlignUp(header.level_offset + level_size, TEXTURE_CACHE_ALIGNMENT);
+
+	std::vector<char> payload(header.data_offset + texture.data.size() - sizeof(header));
+	memcpy(payload.data() + header.level_offset - sizeof(header), texture.levels.data(), level_size);
+	memcpy(payload.data() + header.data_offset - sizeof(header), texture.data.data(), texture.data.size());
+	header.payload_hash = HashBytes(payload);
+
+	// The cache only speeds up later starts, so failing to write it is not an error.
+	WriteCacheFile(cache_path, { { reinterpret_cast<const char*>(&header), sizeof(header) }, payload });
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include "TextureData.h"
+#include "BitmapDefinition.h"
+#include "MipGenerator.h"
+#include "BlockCompressor.h"
+#include "MappedFile.h"
+
+struct texture_options_t {
+	// Limits how many threads generate and compress the mip levels.
+	UINT thread_count = 1;
+	mip_filter_t mip_filter = mip_filter_t::KAISER;
+	// DXGI_FORMAT_R8G8B8A8_UNORM keeps the texture uncompressed, which is also what block-compressed formats
+	// fall back to for textures that are not a whole number of blocks.
+	DXGI_FORMAT format = DXGI_FORMAT_BC7_UNORM;
+	compression_quality_t quality = compression_quality_t::NORMAL;
+	// Resamples the image to this size first, unless zero, which keeps the size of the source.
+	UINT width = 0;
+	UINT height = 0;
+	// Both decoders give the same pixels, so the choice does not invalidate the cache.
+	bitmap_decoder_t decoder = bitmap_decoder_t::WIC;
+};
+
+class TextureAsset {
+public:
+	// The processed mip chain is cached in a container next to the source, which is memory-mapped instead of
+	// decoding the source as long as the source and the options affecting the output are unchanged. Decoding
+	// with WIC requires COM to be initialized on the calling thread.
+	TextureAsset(const std::string& source_path, const texture_options_t& options = {});
+
+	// Size of the cache that loading the source with these options would map, or nothing if it would process
+	// the source, reading no more of the cache than its header. Only the timestamp of the source is compared;
+	// loading records a new timestamp in the cache when the contents of the source are unchanged.
+	static std::optional<std::size_t> GetCachedSize(const std::string& source_path,
+		const texture_options_t& options);
+
+	DXGI_FORMAT GetFormat() const;
+	// Levels are placed with the row pitch and subresource alignment of D3D12 upload buffers, so that each
+	// one can be copied with a single memcpy.
+	std::span<const texture_level_t> GetLevels() const;
+	// May point into the memory-mapped cache; stays valid for the lifetime of the object.
+	std::span<const BYTE> GetData() const;
+	bool IsCached() const;
+private:
+	texture_data_t texture;
+	std::optional<MappedFile> cache_file;
+	std::span<const BYTE> data;
+
+	texture_data_t ProcessSource(const std::string& source_path, const texture_options_t& options);
+	bool LoadCache(const std::string& cache_path, const std::string& source_path, UINT64 options_hash);
+	void WriteCache(const std::string& cache_path, const std::string& source_path, UINT64 options_hash);
+};
@@ -0,0 +1,18 @@
+#pragma once
+
+struct texture_level_t {
+	UINT width;
+	UINT height;
+	// Position of the level in texture_data_t::data. Rows are rows of pixels, or of 4x4 blocks for
+	// block-compressed formats.
+	std::size_t offset;
+	UINT row_pitch;
+	UINT row_count;
+};
+
+// Texture with all its mip levels, stored level after level in one array.
+struct texture_data_t {
+	DXGI_FORMAT format = DXGI_FORMAT_UNKNOWN;
+	std::vector<texture_level_t> levels;
+	std::vector<BYTE> data;
+};
@@ -0,0 +1,121 @@
+#include "pch.h"
+#include "TextureLoader.h"
+#include "com_utils.h"
+#include "parallel_utils.h"
+
+namespace {
+	// Bytes per pixel of the loaded size, on top of the decoded source: about 6 for the RGBA8 mip chain, 32 for
+	// the linear floating-point images that the levels are filtered through and 2 for the compressed output.
+	constexpr std::size_t WORKING_BYTES_PER_PIXEL = 6 + 2 * sizeof(DirectX::XMFLOAT4) + 2;
+
+	// Estimates the memory that loading a texture takes while it is in flight. A cached texture is only mapped,
+	// so it takes the size of its cache; any other is estimated from the size in its header.
+	std::size_t EstimateLoadSize(const std::string& path, const texture_options_t& options,
+		IWICImagingFactory* imaging_factory) {
+		if (std::optional<std::size_t> cached_size = TextureAsset::GetCachedSize(path, options)) {
+			return *cached_size;
+		}
+
+		std::wstring uri(winrt::to_hstring(path));
+		BitmapDefinition bitmap(uri.c_str(), options.decoder);
+		bitmap.CreateDeviceIndependentResources(imaging_factory);
+		UINT width, height;
+		bitmap.GetSize(&width, &height);
+		std::size_t target_pixels = std::size_t(options.width != 0 ? options.width : width) *
+			(options.height != 0 ? options.height : height);
+		return std::size_t(width) * height * 4 + target_pixels * WORKING_BYTES_PER_PIXEL;
+	}
+}
+
+void LoadTextures(std::span<const std::string> paths, const texture_options_t& options,
+	const texture_batch_options_t& batch_options,
+	const std::function<void(UINT, std::unique_ptr<TextureAsset>)>& on_loaded) {
+	const UINT worker_count = std::clamp(batch_options.worker_count, 1u,
+		std::max(static_cast<UINT>(paths.size()), 1u));
+	texture_options_t worker_options = options;
+	worker_options.thread_count = std::max(options.thread_count / worker_count, 1u);
+
+	// Workers take the next texture and wait for room in the budget one at a time, under admission_mutex, so
+	// that a large texture is not overtaken forever by smaller ones.
+	std::mutex admission_mutex;
+	std::size_t next_texture = 0;
+	std::mutex budget_mutex;
+	std::condition_variable budget_released;
+	std::size_t bytes_in_flight = 0;
+	std::size_t peak_bytes_in_flight = 0;
+	std::mutex result_mutex;
+
+#if defined(_DEBUG)
+	auto start = std::chrono::steady_clock::now();
+#endif
+	ParallelFor(worker_count, [&](std::size_t) {
+		std::optional<ComInitializer> com;
+		if (options.decoder == bitmap_decoder_t::WIC) {
+			// Fails harmlessly on a caller thread that already is in a single-threaded apartment.
+			com.emplace(COINIT_MULTITHREADED);
+		}
+
+		try {
+			// Released before COM is uninitialized.
+			winrt::com_ptr<IWICImagingFactory2> imaging_factory;
+			if (options.decoder == bitmap_decoder_t::WIC) {
+				winrt::check_hresult(CoCreateInstance(
+					CLSID_WICImagingFactory2,
+					nullptr,
+					CLSCTX_INPROC_SERVER,
+					IID_PPV_ARGS(imaging_factory.put())
+				));
+			}
+
+			while (true) {
+				std::size_t index, size;
+				{
+					std::lock_guard admission(admission_mutex);
+					if (next_texture >= paths.size()) {
+						break;
+					}
+					index = next_texture++;
+					size = EstimateLoadSize(paths[index], options, imaging_factory.get());
+
+					std::unique_lock budget(budget_mutex);
+					budget_released.wait(budget, [&] {
+						return bytes_in_flight == 0 || bytes_in_flight + size <= batch_options.memory_budget;
+					});
+					bytes_in_flight += size;
+					peak_bytes_in_flight = std::max(peak_bytes_in_flight, bytes_in_flight);
+				}
+
+				std::unique_ptr<TextureAsset> texture;
+				try {
+					texture = std::make_unique<TextureAsset>(paths[index], worker_options);
+				}
+				catch (...) {
+					std::lock_guard budget(budget_mutex);
+					bytes_in_flight -= size;
+					budget_released.notify_all();
+					throw;
+				}
+				{
+					std::lock_guard budget(budget_mutex);
+					bytes_in_flight -= size;
+				}
+				budget_released.notify_all();
+
+				std::lock_guard result(result_mutex);
+				on_loaded(static_cast<UINT>(index), std::move(texture));
+			}
+		}
+		catch (...) {
+			std::lock_guard admission(admission_mutex);
+			next_texture = paths.size();
+			throw;
+		}
+	});
+
+#if defined(_DEBUG)
+	OutputDebugStringA(std::format("TextureLoader: {} textures loaded on {} workers in {:.1f} ms, peak {:.1f} MiB "
+		"in flight\n", paths.size(), worker_count,
+		std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count(),
+		peak_bytes_in_flight / double(1 << 20)).c_str());
+#endif
+}
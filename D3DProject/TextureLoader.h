@@ -0,0 +1,21 @@
+#pragma once
+
+#include "TextureAsset.h"
+
+struct texture_batch_options_t {
+	// Textures loaded at the same time. The threads of the texture options are shared out between them, so
+	// that a single texture still generates and compresses its mip levels on all of them.
+	UINT worker_count = 1;
+	// Estimated bytes that textures being decoded may take at the same time. A texture larger than that is
+	// still loaded, once nothing else is in flight.
+	std::size_t memory_budget = std::size_t(1) << 30;
+};
+
+// Loads the texture of every path on a pool of worker threads, starting them in the order of the paths.
+// Calls on_loaded(index, texture) on the worker that loaded it as soon as it is done, one call at a time, so
+// the calls come in the order the textures finish in. The first exception thrown by a load or by on_loaded
+// stops the remaining loads and is rethrown once the workers have finished. Initializes COM on the workers
+// when decoding with WIC.
+void LoadTextures(std::span<const std::string> paths, const texture_options_t& options,
+	const texture_batch_options_t& batch_options,
+	const std::function<void(UINT, std::unique_ptr<TextureAsset>)>& on_loaded);
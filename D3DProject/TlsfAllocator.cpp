@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "TlsfAllocator.h"
+
+TlsfAllocator::TlsfAllocator(UINT64 size, UINT64 granularity) : size(size) {
+	if (!std::has_single_bit(granularity) || size == 0 || size % granularity != 0) {
+		throw std::runtime_error("TlsfAllocator: size must be a nonzero multiple of a power of two granularity");
+	}
+
+	granularity_log2 = static_cast<UINT>(std::countr_zero(granularity));
+	for (auto& lists : free_lists) {
+		std::fill(std::begin(lists), std::end(lists), NO_BLOCK);
+	}
+	InsertFreeBlock(CreateBlock(0, size));
+}
+
+std::optional<tlsf_allocation_t> TlsfAllocator::Allocate(UINT64 allocation_size, UINT64 alignment) {
+	if (allocation_size == 0 || !std::has_single_bit(alignment)) {
+		throw std::runtime_error("TlsfAllocator: invalid allocation");
+	}
+	if (allocation_size > size) {
+		return std::nullopt;
+	}
+
+	UINT64 granules = ((allocation_size - 1) >> granularity_log2) + 1;
+	UINT64 alignment_granules = std::max(alignment >> granularity_log2, UINT64(1));
+	// Large enough for any offset of the found block to be aligned.
+	UINT64 search_granules = granules + alignment_granules - 1;
+	UINT32 block = FindLargerClassBlock(search_granules);
+	if (block == NO_BLOCK) {
+		// The class of the size itself also holds blocks that are just large enough, such as the single block
+		// of a range made to fit one allocation.
+		block = FindFittingBlock(search_granules, granules << granularity_log2, alignment);
+		if (block == NO_BLOCK) {
+			return std::nullopt;
+		}
+	}
+
+	RemoveFreeBlock(block);
+	UINT64 aligned_offset = (blocks[block].offset + alignment - 1) & ~(alignment - 1);
+	if (aligned_offset != blocks[block].offset) {
+		// The padding in front stays free.
+		UINT32 padding = block;
+		SplitBlock(padding, aligned_offset - blocks[padding].offset);
+		block = blocks[padding].next_physical;
+		RemoveFreeBlock(block);
+		InsertFreeBlock(padding);
+	}
+	UINT64 block_size = granules << granularity_log2;
+	if (blocks[block].size > block_size) {
+		SplitBlock(block, block_size);
+	}
+
+	used_size += blocks[block].size;
+	allocation_count++;
+	return tlsf_allocation_t{ .offset = blocks[block].offset, .block = block };
+}
+
+void TlsfAllocator::Free(UINT32 block) {
+	if (block >= blocks.size() || blocks[block].free || blocks[block].size == 0) {
+		throw std::runtime_error("TlsfAllocator: block is not allocated");
+	}
+
+	used_size -= blocks[block].size;
+	allocation_count--;
+	UINT32 next = blocks[block].next_physical;
+	if (next != NO_BLOCK && blocks[next].free) {
+		RemoveFreeBlock(next);
+		MergeWithNext(block);
+	}
+	UINT32 previous = blocks[block].previous_physical;
+	if (previous != NO_BLOCK && blocks[previous].free) {
+		RemoveFreeBlock(previous);
+		MergeWithNext(previous);
+		block = previous;
+	}
+	InsertFreeBlock(block);
+}
+
+UINT64 TlsfAllocator::GetSize() const {
+	return size;
+}
+
+UINT64 TlsfAllocator::GetUsedSize() const {
+	return used_size;
+}
+
+UINT TlsfAllocator::GetAllocationCount() const {
+	return allocation_count;
+}
+
+UINT TlsfAllocator::GetFreeBlockCount() const {
+	return free_block_count;
+}
+
+UINT64 TlsfAllocator::GetLargestFreeBlock() const {
+	if (first_level_bitmap == 0) {
+		return 0;
+	}
+	UINT first_level = static_cast<UINT>(std::bit_width(first_level_bitmap) - 1);
+	UINT second_level = static_cast<UINT>(std::bit_width(second_level_bitmaps[first_level]) - 1);
+	UINT64 largest = 0;
+	for (UINT32 block = free_lists[first_level][second_level]; block != NO_BLOCK; block = blocks[block].next_free) {
+		largest = std::max(largest, blocks[block].size);
+	}
+	return largest;
+}
+
+double TlsfAllocator::GetFragmentation() const {
+	UINT64 free_size = size - used_size;
+	return free_size == 0 ? 0.0 : 1.0 - static_cast<double>(GetLargestFreeBlock()) / free_size;
+}
+
+void TlsfAllocator::MapSize(UINT64 granules, UINT* first_level, UINT* second_level) {
+	if (granules < SECOND_LEVEL_COUNT) {
+		*first_level = 0;
+		*second_level = static_cast<UINT>(granules);
+		return;
+	}
+	UINT most_significant_bit = static_cast<UINT>(std::bit_width(granules) - 1);
+	*first_level = most_significant_bit - SECOND_LEVEL_LOG2 + 1;
+	*second_level = static_cast<UINT>(granules >> (most_significant_bit - SECOND_LEVEL_LOG2)) - SECOND_LEVEL_COUNT;
+}
+
+UINT32 TlsfAllocator::FindLargerClassBlock(UINT64 granules) const {
+	if (granules >= SECOND_LEVEL_COUNT) {
+		// Rounds up to the next size class, whose blocks are all large enough.
+		granules += (UINT64(1) << (std::bit_width(granules) - 1 - SECOND_LEVEL_LOG2)) - 1;
+	}
+	UINT first_level, second_level;
+	MapSize(granules, &first_level, &second_level);
+	if (first_level >= FIRST_LEVEL_COUNT) {
+		return NO_BLOCK;
+	}
+
+	UINT32 second_level_map = second_level_bitmaps[first_level] & (~UINT32(0) << second_level);
+	if (second_level_map == 0) {
+		UINT64 first_level_map = first_level + 1 < 64 ? first_level_bitmap & (~UINT64(0) << (first_level + 1)) : 0;
+		if (first_level_map == 0) {
+			return NO_BLOCK;
+		}
+		first_level = static_cast<UINT>(std::countr_zero(first_level_map));
+		second_level_map = second_level_bitmaps[first_level];
+	}
+	second_level = static_cast<UINT>(std::countr_zero(second_level_map));
+	return free_lists[first_level][second_level];
+}
+
+UINT32 TlsfAllocator::FindFittingBlock(UINT64 granules, UINT64 block_size, UINT64 alignment) const {
+	UINT first_level, second_level;
+	MapSize(granules, &first_level, &second_level);
+	UINT32 block = free_lists[first_level][second_level];
+	for (UINT n = 0; n < FIT_SEARCH_LIMIT && block != NO_BLOCK; n++, block = blocks[block].next_free) {
+		UINT64 aligned_offset = (blocks[block].offset + alignment - 1) & ~(alignment - 1);
+		if (aligned_offset + block_size <= blocks[block].offset + blocks[block].size) {
+			return block;
+		}
+	}
+	return NO_BLOCK;
+}
+
+UINT32 TlsfAllocator::CreateBlock(UINT64 offset, UINT64 block_size) {
+	UINT32 block = unused_blocks;
+	if (block != NO_BLOCK) {
+		unused_blocks = blocks[block].next_free;
+	}
+	else {
+		block = static_cast<UINT32>(blocks.size());
+		blocks.emplace_back();
+	}
+	blocks[block] = {
+		.offset = offset,
+		.size = block_size,
+		.previous_physical = NO_BLOCK,
+		.next_physical = NO_BLOCK,
+		.previous_free = NO_BLOCK,
+		.next_free = NO_BLOCK,
+		.free = false
+	};
+	return block;
+}
+
+void TlsfAllocator::ReleaseBlock(UINT32 block) {
+	blocks[block].size = 0;
+	blocks[block].next_free = unused_blocks;
+	unused_blocks = block;
+}
+
+void TlsfAllocator::InsertFreeBlock(UINT32 block) {
+	UINT first_level, second_level;
+	MapSize(blocks[block].size >> granularity_log2, &first_level, &second_level);
+	UINT32& head = free_lists[first_level][second_level];
+	blocks[block].previous_free = NO_BLOCK;
+	blocks[block].next_free = head;
+	if (head != NO_BLOCK) {
+		blocks[head].previous_free = block;
+	}
+	head = block;
+	first_level_bitmap |= UINT64(1) << first_level;
+	second_level_bitmaps[first_level] |= UINT32(1) << second_level;
+	blocks[block].free = true;
+	free_block_count++;
+}
+
+void TlsfAllocator::RemoveFreeBlock(UINT32 block) {
+	block_t& removed = blocks[block];
+	if (removed.previous_free != NO_BLOCK) {
+		blocks[removed.previous_free].next_free = removed.next_free;
+	}
+	else {
+		UINT first_level, second_level;
+		MapSize(removed.size >> granularity_log2, &first_level, &second_level);
+		free_lists[first_level][second_level] = removed.next_free;
+		if (removed.next_free == NO_BLOCK) {
+			second_level_bitmaps[first_level] &= ~(UINT32(1) << second_level);
+			if (second_level_bitmaps[first_level] == 0) {
+				first_level_bitmap &= ~(UINT64(1) << first_level);
+			}
+		}
+	}
+	if (removed.next_free != NO_BLOCK) {
+		blocks[removed.next_free].previous_free = removed.previous_free;
+	}
+	removed.previous_free = NO_BLOCK;
+	removed.next_free = NO_BLOCK;
+	removed.free = false;
+	free_block_count--;
+}
+
+void TlsfAllocator::SplitBlock(UINT32 block, UINT64 block_size) {
+	UINT32 rest = CreateBlock(blocks[block].offset + block_size, blocks[block].size - block_size);
+	blocks[block].size = block_size;
+	blocks[rest].previous_physical = block;
+	blocks[rest].next_physical = blocks[block].next_physical;
+	if (blocks[rest].next_physical != NO_BLOCK) {
+		blocks[blocks[rest].next_physical].previous_physical = rest;
+	}
+	blocks[block].next_physical = rest;
+	InsertFreeBlock(rest);
+}
+
+void TlsfAllocator::MergeWithNext(UINT32 block) {
+	UINT32 next = blocks[block].next_physical;
+	blocks[block].size += blocks[next].size;
+	blocks[block].next_physical = blocks[next].next_physical;
+	if (blocks[block].next_physical != NO_BLOCK) {
+		blocks[blocks[block].next_physical].previous_physical = block;
+	}
+	ReleaseBlock(next);
+}
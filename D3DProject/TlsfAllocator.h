@@ -0,0 +1,80 @@
+#pragma once
+
+struct tlsf_allocation_t {
+	UINT64 offset;
+	// Identifies the allocation when it is freed.
+	UINT32 block;
+};
+
+// Two-level segregated fit allocator over a range of size bytes, independent of what the range is. Free
+// blocks are kept in lists by size class, a power of two split into SECOND_LEVEL_COUNT linear steps, with a
+// bitmap of the non-empty lists, so that allocating and freeing take constant time. Allocation takes a block of
+// the next larger class, and only falls back to looking at the first FIT_SEARCH_LIMIT blocks of the class of
+// the size itself, so it may fail while a block deeper in that list would fit. Freed blocks are merged with
+// free neighbours straight away. Offsets and sizes are multiples of the granularity, a power of two.
+class TlsfAllocator {
+public:
+	static constexpr UINT SECOND_LEVEL_LOG2 = 4;
+	static constexpr UINT SECOND_LEVEL_COUNT = 1 << SECOND_LEVEL_LOG2;
+
+	TlsfAllocator(UINT64 size, UINT64 granularity);
+
+	// Alignment must be a power of two. Returns nothing when no free block fits.
+	std::optional<tlsf_allocation_t> Allocate(UINT64 allocation_size, UINT64 alignment);
+	void Free(UINT32 block);
+
+	UINT64 GetSize() const;
+	// Bytes in allocated blocks, after rounding up to the granularity.
+	UINT64 GetUsedSize() const;
+	UINT GetAllocationCount() const;
+	UINT GetFreeBlockCount() const;
+	// Walks the list of the largest non-empty size class.
+	UINT64 GetLargestFreeBlock() const;
+	// Share of the free bytes that are not in the largest free block, from 0 with all of them in one block
+	// towards 1 when they are split into many small ones.
+	double GetFragmentation() const;
+private:
+	static constexpr UINT32 NO_BLOCK = UINT32_MAX;
+	static constexpr UINT FIT_SEARCH_LIMIT = 8;
+	static constexpr UINT FIRST_LEVEL_COUNT = 64 - SECOND_LEVEL_LOG2 + 1;
+
+	struct block_t {
+		UINT64 offset;
+		UINT64 size;
+		// Neighbours in the range, by offset.
+		UINT32 previous_physical;
+		UINT32 next_physical;
+		// Neighbours in the free list of the size class, while free.
+		UINT32 previous_free;
+		UINT32 next_free;
+		bool free;
+	};
+
+	UINT64 size;
+	UINT granularity_log2;
+	std::vector<block_t> blocks;
+	// Entries of blocks that are not in use, linked through next_free.
+	UINT32 unused_blocks = NO_BLOCK;
+	UINT64 first_level_bitmap = 0;
+	UINT32 second_level_bitmaps[FIRST_LEVEL_COUNT] = {};
+	UINT32 free_lists[FIRST_LEVEL_COUNT][SECOND_LEVEL_COUNT];
+	UINT64 used_size = 0;
+	UINT allocation_count = 0;
+	UINT free_block_count = 0;
+
+	// Size class of a block of the given number of granules.
+	static void MapSize(UINT64 granules, UINT* first_level, UINT* second_level);
+	// First block of the smallest non-empty size class whose blocks all hold granules, or NO_BLOCK.
+	UINT32 FindLargerClassBlock(UINT64 granules) const;
+	// First of the first FIT_SEARCH_LIMIT blocks of the size class of granules that holds block_size bytes once
+	// aligned, or NO_BLOCK.
+	UINT32 FindFittingBlock(UINT64 granules, UINT64 block_size, UINT64 alignment) const;
+	UINT32 CreateBlock(UINT64 offset, UINT64 block_size);
+	void ReleaseBlock(UINT32 block);
+	void InsertFreeBlock(UINT32 block);
+	void RemoveFreeBlock(UINT32 block);
+	// Splits the end of the block off into a free block, from block_size bytes on.
+	void SplitBlock(UINT32 block, UINT64 block_size);
+	// Merges the block with the next one in the range, which must be free and out of its free list.
+	void MergeWithNext(UINT32 block);
+};
@@ -0,0 +1,29 @@
+#include "pch.h"
+#include "UploadRing.h"
+
+UploadRing::UploadRing(GpuMemory& memory, UINT64 size) : allocator(size) {
+	buffer = memory.CreateBuffer(D3D12_HEAP_TYPE_UPLOAD, size, D3D12_RESOURCE_STATE_GENERIC_READ);
+
+	D3D12_RANGE read_range = { 0, 0 };
+	winrt::check_hresult(buffer->Map(0, &read_range, reinterpret_cast<void**>(&data_begin)));
+}
+
+upload_allocation_t UploadRing::Allocate(std::size_t size, UINT64 alignment) {
+	std::optional<UINT64> offset = allocator.Allocate(size, alignment);
+	if (!offset) {
+		throw std::runtime_error(std::format("UploadRing: no room for {} bytes, {} of {} in use", size,
+			allocator.GetUsedSize(), allocator.GetSize()));
+	}
+	return {
+		.cpu_address = data_begin + *offset,
+		.gpu_address = buffer->GetGPUVirtualAddress() + *offset
+	};
+}
+
+void UploadRing::EndFrame(UINT64 fence_value) {
+	allocator.EndFrame(fence_value);
+}
+
+void UploadRing::Reclaim(UINT64 completed_fence_value) {
+	allocator.Reclaim(completed_fence_value);
+}
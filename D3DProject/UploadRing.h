@@ -0,0 +1,35 @@
+#pragma once
+
+#include "RingAllocator.h"
+#include "GpuMemory.h"
+
+struct upload_allocation_t {
+	BYTE* cpu_address;
+	D3D12_GPU_VIRTUAL_ADDRESS gpu_address;
+};
+
+// Upload buffer, mapped for its whole lifetime, for data written by the CPU every frame, such as constants.
+// Allocations are placed by a RingAllocator, so that the data of a frame stays untouched until the GPU has
+// finished it.
+class UploadRing {
+public:
+	UploadRing(GpuMemory& memory, UINT64 size);
+
+	// Aligned for constant buffer views by default. Throws when the frames in flight leave no room.
+	upload_allocation_t Allocate(std::size_t size,
+		UINT64 alignment = D3D12_CONSTANT_BUFFER_DATA_PLACEMENT_ALIGNMENT);
+	// Allocates and copies the data.
+	template <typename T>
+	D3D12_GPU_VIRTUAL_ADDRESS Upload(const T& data) {
+		upload_allocation_t allocation = Allocate(sizeof(T));
+		memcpy(allocation.cpu_address, &data, sizeof(T));
+		return allocation.gpu_address;
+	}
+	// See RingAllocator.
+	void EndFrame(UINT64 fence_value);
+	void Reclaim(UINT64 completed_fence_value);
+private:
+	PlacedResource buffer;
+	BYTE* data_begin;
+	RingAllocator allocator;
+};
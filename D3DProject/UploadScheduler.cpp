@@ -0,0 +1,127 @@
+#include "pch.h"
+#include "UploadScheduler.h"
+
+namespace {
+	// Copies of buffers have no alignment requirement; this keeps the staged data aligned for memcpy.
+	constexpr UINT64 BUFFER_STAGING_ALIGNMENT = 16;
+}
+
+UploadScheduler::UploadScheduler(CopyQueue& queue, const upload_scheduler_options_t& options)
+	: queue(queue), staging_data(queue.GetStagingData()), ring(staging_data.size()), batch_size(options.batch_size) {
+	if (batch_size == 0 || batch_size > staging_data.size() ||
+		staging_data.size() % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT != 0) {
+		throw std::runtime_error("UploadScheduler: invalid staging buffer or batch size");
+	}
+}
+
+upload_ticket_t UploadScheduler::UploadBuffer(ID3D12Resource* destination, UINT64 destination_offset,
+	std::span<const BYTE> data) {
+	if (data.empty()) {
+		throw std::runtime_error("UploadScheduler: empty upload");
+	}
+
+	upload_ticket_t ticket = 0;
+	for (std::size_t offset = 0; offset < data.size(); ) {
+		UINT64 size = std::min(UINT64(data.size() - offset), batch_size);
+		UINT64 staging_offset = AllocateStaging(size, BUFFER_STAGING_ALIGNMENT);
+		memcpy(staging_data.data() + staging_offset, data.data() + offset, static_cast<std::size_t>(size));
+		queue.RecordBufferCopy(destination, destination_offset + offset, staging_offset, size);
+		ticket = EndCopy(size);
+		offset += static_cast<std::size_t>(size);
+	}
+	return ticket;
+}
+
+upload_ticket_t UploadScheduler::UploadTexture(ID3D12Resource* destination, UINT subresource,
+	const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint, UINT num_rows, UINT64 row_size, const BYTE* source,
+	UINT64 source_row_pitch) {
+	if (num_rows == 0) {
+		throw std::runtime_error("UploadScheduler: empty upload");
+	}
+	UINT64 size = UINT64(footprint.Footprint.RowPitch) * (num_rows - 1) + row_size;
+	if (size > staging_data.size()) {
+		throw std::runtime_error(std::format("UploadScheduler: subresource of {} bytes does not fit in the {} byte "
+			"staging buffer", size, staging_data.size()));
+	}
+
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT staged_footprint = footprint;
+	staged_footprint.Offset = AllocateStaging(size, D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+	BYTE* destination_data = staging_data.data() + staged_footprint.Offset;
+	if (source_row_pitch == footprint.Footprint.RowPitch) {
+		memcpy(destination_data, source, static_cast<std::size_t>(size));
+	}
+	else {
+		for (UINT y = 0; y < num_rows; y++) {
+			memcpy(destination_data + SIZE_T(footprint.Footprint.RowPitch) * y, source + source_row_pitch * y,
+				static_cast<std::size_t>(row_size));
+		}
+	}
+	queue.RecordTextureCopy(destination, subresource, staged_footprint);
+	return EndCopy(size);
+}
+
+void UploadScheduler::Flush() {
+	if (batch_copies == 0) {
+		return;
+	}
+	queue.Submit(next_fence_value);
+	ring.EndFrame(next_fence_value);
+	next_fence_value++;
+	batch_bytes = 0;
+	batch_copies = 0;
+	stats.batches++;
+}
+
+bool UploadScheduler::IsComplete(upload_ticket_t ticket) {
+	return queue.GetCompletedValue() >= ticket;
+}
+
+void UploadScheduler::Wait(upload_ticket_t ticket) {
+	if (ticket >= next_fence_value) {
+		Flush();
+	}
+	queue.WaitForValue(ticket);
+}
+
+void UploadScheduler::WaitForIdle() {
+	Flush();
+	queue.WaitForValue(next_fence_value - 1);
+	ring.Reclaim(next_fence_value - 1);
+}
+
+const upload_stats_t& UploadScheduler::GetStats() const {
+	return stats;
+}
+
+UINT64 UploadScheduler::AllocateStaging(UINT64 size, UINT64 alignment) {
+	for (;;) {
+		ring.Reclaim(queue.GetCompletedValue());
+		if (std::optional<UINT64> offset = ring.Allocate(size, alignment)) {
+			return *offset;
+		}
+		// The ranges of the batch being recorded are only freed once it has been submitted and has finished.
+		Flush();
+
+		std::optional<UINT64> fence_value = ring.GetPendingFenceValue();
+		if (!fence_value) {
+			throw std::runtime_error("UploadScheduler: no room in an empty staging buffer");
+		}
+		auto start = std::chrono::steady_clock::now();
+		queue.WaitForValue(*fence_value);
+		stats.stalls++;
+		stats.stall_time +=
+			std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+upload_ticket_t UploadScheduler::EndCopy(UINT64 size) {
+	upload_ticket_t ticket = next_fence_value;
+	batch_bytes += size;
+	batch_copies++;
+	stats.copies++;
+	stats.bytes += size;
+	if (batch_bytes >= batch_size) {
+		Flush();
+	}
+	return ticket;
+}
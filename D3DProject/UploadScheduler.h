@@ -0,0 +1,84 @@
+#pragma once
+
+#include "RingAllocator.h"
+
+// Identifies the batch that an upload was recorded into: the fence value that the copy queue signals once
+// the batch has finished.
+using upload_ticket_t = UINT64;
+
+// A copy queue and the staging buffer that its copies read from, as far as UploadScheduler uses them, so
+// that uploads can also be scheduled against a queue that only simulates the GPU.
+class CopyQueue {
+public:
+	virtual ~CopyQueue() = default;
+	// Mapped for the lifetime of the queue.
+	virtual std::span<BYTE> GetStagingData() = 0;
+	virtual void RecordBufferCopy(ID3D12Resource* destination, UINT64 destination_offset, UINT64 staging_offset,
+		UINT64 size) = 0;
+	// The offset of the footprint is the one of the data in the staging buffer.
+	virtual void RecordTextureCopy(ID3D12Resource* destination, UINT subresource,
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) = 0;
+	// Executes the copies recorded since the last call, then signals fence_value once they have finished.
+	virtual void Submit(UINT64 fence_value) = 0;
+	virtual UINT64 GetCompletedValue() = 0;
+	// Blocks until the fence has reached value.
+	virtual void WaitForValue(UINT64 value) = 0;
+};
+
+struct upload_scheduler_options_t {
+	// A batch is submitted once this many bytes are staged for it, so that the GPU copies it while the next
+	// one is staged. Larger buffers are split into batches of this size. At most the size of the staging
+	// buffer.
+	UINT64 batch_size = UINT64(8) << 20;
+};
+
+struct upload_stats_t {
+	UINT64 batches = 0;
+	UINT64 copies = 0;
+	UINT64 bytes = 0;
+	// Uploads that had to wait for an earlier batch to finish before the staging buffer had room, and the
+	// time spent waiting.
+	UINT64 stalls = 0;
+	double stall_time = 0.0;
+};
+
+// Stages buffer and texture data in the staging buffer of a copy queue, managed as a ring whose ranges are
+// freed as their batches finish, and records the copies in batches. Every upload returns the ticket of its
+// batch, to poll or wait for; the copies only start once the batch is submitted, when it is full or on
+// Flush. Waits for the GPU only when the staging buffer is full. Meant for a single thread.
+class UploadScheduler {
+public:
+	UploadScheduler(CopyQueue& queue, const upload_scheduler_options_t& options = {});
+
+	upload_ticket_t UploadBuffer(ID3D12Resource* destination, UINT64 destination_offset,
+		std::span<const BYTE> data);
+	// Copies num_rows rows of row_size bytes, source_row_pitch apart in the source, into the subresource,
+	// laid out as the footprint from GetCopyableFootprints says. Its offset is not used.
+	upload_ticket_t UploadTexture(ID3D12Resource* destination, UINT subresource,
+		const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint, UINT num_rows, UINT64 row_size, const BYTE* source,
+		UINT64 source_row_pitch);
+	// Submits the batch being recorded, if it holds any copy.
+	void Flush();
+	bool IsComplete(upload_ticket_t ticket);
+	// Submits the batch of the ticket if it has not been yet, and blocks until it has finished.
+	void Wait(upload_ticket_t ticket);
+	// Submits and waits for every upload so far.
+	void WaitForIdle();
+	const upload_stats_t& GetStats() const;
+private:
+	CopyQueue& queue;
+	std::span<BYTE> staging_data;
+	RingAllocator ring;
+	UINT64 batch_size;
+	// Ticket of the batch being recorded.
+	UINT64 next_fence_value = 1;
+	UINT64 batch_bytes = 0;
+	UINT batch_copies = 0;
+	upload_stats_t stats;
+
+	// Returns the offset of size bytes in the staging buffer, submitting the batch being recorded and waiting
+	// for earlier ones until there is room.
+	UINT64 AllocateStaging(UINT64 size, UINT64 alignment);
+	// Counts a copy into the batch being recorded, and submits the batch once it is full.
+	upload_ticket_t EndCopy(UINT64 size);
+};
@@ -0,0 +1,207 @@
+#include "pch.h"
+#include "VertexFormat.h"
+
+using namespace DirectX;
+using namespace DirectX::PackedVector;
+
+namespace {
+	UINT GetPositionSize(position_encoding_t encoding) {
+		switch (encoding) {
+		case position_encoding_t::UNORM16: return sizeof(XMUSHORTN4);
+		case position_encoding_t::UNORM10: return sizeof(XMUDECN4);
+		default: return sizeof(XMFLOAT3);
+		}
+	}
+
+	DXGI_FORMAT GetPositionFormat(position_encoding_t encoding) {
+		switch (encoding) {
+		case position_encoding_t::UNORM16: return DXGI_FORMAT_R16G16B16A16_UNORM;
+		case position_encoding_t::UNORM10: return DXGI_FORMAT_R10G10B10A2_UNORM;
+		default: return DXGI_FORMAT_R32G32B32_FLOAT;
+		}
+	}
+
+	UINT GetTexCoordSize(const vertex_format_t& format) {
+		return format.half_tex_coord ? sizeof(XMHALF2) : sizeof(XMFLOAT2);
+	}
+
+	// The material follows the other elements.
+	UINT GetMaterialOffset(const vertex_format_t& format) {
+		return GetPositionSize(format.position_encoding) + GetTexCoordSize(format) +
+			(format.color ? sizeof(XMUBYTEN4) : 0);
+	}
+}
+
+UINT GetVertexStride(const vertex_format_t& format) {
+	// Padded so that every vertex starts 4-byte aligned.
+	return (GetMaterialOffset(format) + sizeof(UINT16) + 3) & ~3u;
+}
+
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetInputElementDescs(const vertex_format_t& format) {
+	std::vector<D3D12_INPUT_ELEMENT_DESC> input_element_descs = {
+		{
+			.SemanticName = "POSITION",
+			.SemanticIndex = 0,
+			.Format = GetPositionFormat(format.position_encoding),
+			.InputSlot = 0,
+			.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			.InstanceDataStepRate = 0
+		},
+		{
+			.SemanticName = "TEXCOORD",
+			.SemanticIndex = 0,
+			.Format = format.half_tex_coord ? DXGI_FORMAT_R16G16_FLOAT : DXGI_FORMAT_R32G32_FLOAT,
+			.InputSlot = 0,
+			.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			.InstanceDataStepRate = 0
+		}
+	};
+	if (format.color) {
+		input_element_descs.push_back({
+			.SemanticName = "COLOR",
+			.SemanticIndex = 0,
+			.Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+			.InputSlot = 0,
+			.AlignedByteOffset = D3D12_APPEND_ALIGNED_ELEMENT,
+			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+			.InstanceDataStepRate = 0
+		});
+	}
+	else {
+		// Every instance reads the single element of the constant color buffer.
+		input_element_descs.push_back({
+			.SemanticName = "COLOR",
+			.SemanticIndex = 0,
+			.Format = DXGI_FORMAT_R8G8B8A8_UNORM,
+			.InputSlot = CONSTANT_COLOR_SLOT,
+			.AlignedByteOffset = 0,
+			.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA,
+			.InstanceDataStepRate = 1
+		});
+	}
+	input_element_descs.push_back({
+		.SemanticName = "MATERIAL",
+		.SemanticIndex = 0,
+		.Format = DXGI_FORMAT_R16_UINT,
+		.InputSlot = 0,
+		.AlignedByteOffset = GetMaterialOffset(format),
+		.InputSlotClass = D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA,
+		.InstanceDataStepRate = 0
+	});
+	return input_element_descs;
+}
+
+position_dequantization_t ComputePositionDequantization(std::span<const vertex_t> vertices,
+	position_encoding_t encoding) {
+	if (encoding == position_encoding_t::FLOAT3 || vertices.empty()) {
+		return { { 1.0f, 1.0f, 1.0f }, { 0.0f, 0.0f, 0.0f } };
+	}
+
+	XMVECTOR minimum = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertices[0].position));
+	XMVECTOR maximum = minimum;
+	for (const vertex_t& vertex : vertices) {
+		XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertex.position));
+		minimum = XMVectorMin(minimum, position);
+		maximum = XMVectorMax(maximum, position);
+	}
+
+	position_dequantization_t dequantization;
+	XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(dequantization.scale), XMVectorSubtract(maximum, minimum));
+	XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(dequantization.offset), minimum);
+	return dequantization;
+}
+
+void PackVertices(std::span<const vertex_t> vertices, const vertex_format_t& format,
+	const position_dequantization_t& dequantization, BYTE* destination) {
+	const UINT position_size = GetPositionSize(format.position_encoding);
+	const UINT tex_coord_size = GetTexCoordSize(format);
+	const UINT material_offset = GetMaterialOffset(format);
+	const UINT stride = GetVertexStride(format);
+
+	// Flat axes have a zero scale and are encoded as 0.
+	XMVECTOR scale = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(dequantization.scale));
+	XMVECTOR inverse_scale = XMVectorSelect(XMVectorReciprocal(scale), XMVectorZero(),
+		XMVectorEqual(scale, XMVectorZero()));
+	XMVECTOR offset = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(dequantization.offset));
+
+	for (const vertex_t& vertex : vertices) {
+		XMVECTOR position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(vertex.position));
+		XMVECTOR normalized = XMVectorMultiply(XMVectorSubtract(position, offset), inverse_scale);
+		switch (format.position_encoding) {
+		case position_encoding_t::UNORM16:
+			XMStoreUShortN4(reinterpret_cast<XMUSHORTN4*>(destination), normalized);
+			break;
+		case position_encoding_t::UNORM10:
+			XMStoreUDecN4(reinterpret_cast<XMUDECN4*>(destination), normalized);
+			break;
+		default:
+			XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(destination), position);
+			break;
+		}
+
+		XMVECTOR tex_coord = XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(vertex.tex_coord));
+		if (format.half_tex_coord) {
+			XMStoreHalf2(reinterpret_cast<XMHALF2*>(destination + position_size), tex_coord);
+		}
+		else {
+			XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(destination + position_size), tex_coord);
+		}
+
+		if (format.color) {
+			XMStoreUByteN4(reinterpret_cast<XMUBYTEN4*>(destination + position_size + tex_coord_size),
+				XMLoadFloat4(reinterpret_cast<const XMFLOAT4*>(vertex.color)));
+		}
+
+		if (vertex.material > UINT16_MAX) {
+			throw std::runtime_error("VertexFormat: material out of range");
+		}
+		UINT16 material = static_cast<UINT16>(vertex.material);
+		memcpy(destination + material_offset, &material, sizeof(material));
+		memset(destination + material_offset + sizeof(material), 0, stride - material_offset - sizeof(material));
+		destination += stride;
+	}
+}
+
+void UnpackVertices(std::span<const BYTE> packed, const vertex_format_t& format,
+	const position_dequantization_t& dequantization, vertex_t* destination) {
+	const UINT position_size = GetPositionSize(format.position_encoding);
+	const UINT tex_coord_size = GetTexCoordSize(format);
+	const UINT material_offset = GetMaterialOffset(format);
+	const UINT stride = GetVertexStride(format);
+
+	XMVECTOR scale = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(dequantization.scale));
+	XMVECTOR offset = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(dequantization.offset));
+
+	for (const BYTE* source = packed.data(); source + stride <= packed.data() + packed.size(); source += stride) {
+		vertex_t& vertex = *destination++;
+		XMVECTOR position;
+		switch (format.position_encoding) {
+		case position_encoding_t::UNORM16:
+			position = XMVectorMultiplyAdd(XMLoadUShortN4(reinterpret_cast<const XMUSHORTN4*>(source)), scale, offset);
+			break;
+		case position_encoding_t::UNORM10:
+			position = XMVectorMultiplyAdd(XMLoadUDecN4(reinterpret_cast<const XMUDECN4*>(source)), scale, offset);
+			break;
+		default:
+			position = XMLoadFloat3(reinterpret_cast<const XMFLOAT3*>(source));
+			break;
+		}
+		XMStoreFloat3(reinterpret_cast<XMFLOAT3*>(vertex.position), position);
+
+		XMVECTOR tex_coord = format.half_tex_coord ?
+			XMLoadHalf2(reinterpret_cast<const XMHALF2*>(source + position_size)) :
+			XMLoadFloat2(reinterpret_cast<const XMFLOAT2*>(source + position_size));
+		XMStoreFloat2(reinterpret_cast<XMFLOAT2*>(vertex.tex_coord), tex_coord);
+
+		XMVECTOR color = format.color ?
+			XMLoadUByteN4(reinterpret_cast<const XMUBYTEN4*>(source + position_size + tex_coord_size)) :
+			XMVectorSplatOne();
+		XMStoreFloat4(reinterpret_cast<XMFLOAT4*>(vertex.color), color);
+
+		UINT16 material;
+		memcpy(&material, source + material_offset, sizeof(material));
+		vertex.material = material;
+	}
+}
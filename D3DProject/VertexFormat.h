@@ -0,0 +1,46 @@
+#pragma once
+
+#include "vertex.h"
+
+enum class position_encoding_t : UINT {
+	// 3 x 32-bit float, 12 bytes.
+	FLOAT3,
+	// 4 x 16-bit UNORM relative to the mesh bounds, 8 bytes.
+	UNORM16,
+	// 10:10:10:2 UNORM relative to the mesh bounds, 4 bytes.
+	UNORM10
+};
+
+// Layout of the vertices uploaded to the GPU. vertex_t stays the full-precision form used while loading.
+// Every layout ends with the material as a 16-bit integer, MATERIAL in the input layout.
+struct vertex_format_t {
+	position_encoding_t position_encoding = position_encoding_t::UNORM16;
+	// Texture coordinates as 16-bit instead of 32-bit floats.
+	bool half_tex_coord = true;
+	// Per-vertex RGBA8 color. Without it the COLOR input is read from a constant white vertex in
+	// CONSTANT_COLOR_SLOT, so that the same vertex shader works with both layouts.
+	bool color = false;
+};
+
+constexpr UINT CONSTANT_COLOR_SLOT = 1;
+constexpr UINT CONSTANT_COLOR = 0xffffffff;
+
+// Maps decoded positions back to scene space: position = decoded * scale + offset.
+struct position_dequantization_t {
+	FLOAT scale[3];
+	FLOAT offset[3];
+};
+
+UINT GetVertexStride(const vertex_format_t& format);
+std::vector<D3D12_INPUT_ELEMENT_DESC> GetInputElementDescs(const vertex_format_t& format);
+
+// Uses the bounding box of the vertices for quantized encodings, and the identity for FLOAT3.
+position_dequantization_t ComputePositionDequantization(std::span<const vertex_t> vertices,
+	position_encoding_t encoding);
+
+// destination must hold vertices.size() * GetVertexStride(format) bytes.
+void PackVertices(std::span<const vertex_t> vertices, const vertex_format_t& format,
+	const position_dequantization_t& dequantization, BYTE* destination);
+// Inverse of PackVertices, up to quantization error. Missing colors are decoded as white.
+void UnpackVertices(std::span<const BYTE> packed, const vertex_format_t& format,
+	const position_dequantization_t& dequantization, vertex_t* destination);
@@ -7,12 +7,14 @@ struct vs_output_t {
 	float4 position : SV_POSITION;
 	float4 color : COLOR;
 	float2 tex : TEXCOORD;
+	nointerpolation uint material : MATERIAL;
 };
 
-vs_output_t main(float3 pos : POSITION, float4 col : COLOR, float2 tex : TEXCOORD) {
+vs_output_t main(float3 pos : POSITION, float4 col : COLOR, float2 tex : TEXCOORD, uint material : MATERIAL) {
 	vs_output_t result;
 	result.position = mul(float4(pos, 1.0f), matWorldViewProj);
 	result.color = col;
 	result.tex = tex;
+	result.material = material;
 	return result;
 }
@@ -0,0 +1,308 @@
+#include "pch.h"
+#include "VirtualTexture.h"
+
+namespace {
+	struct texel_block_t {
+		// Width and height in texels, and size in bytes.
+		UINT size;
+		UINT bytes;
+	};
+
+	texel_block_t GetTexelBlock(DXGI_FORMAT format) {
+		switch (format) {
+		case DXGI_FORMAT_R8G8B8A8_UNORM:
+		case DXGI_FORMAT_R8G8B8A8_UNORM_SRGB:
+			return { .size = 1, .bytes = 4 };
+		case DXGI_FORMAT_BC1_UNORM:
+			return { .size = 4, .bytes = 8 };
+		case DXGI_FORMAT_BC3_UNORM:
+		case DXGI_FORMAT_BC7_UNORM:
+			return { .size = 4, .bytes = 16 };
+		default:
+			throw std::runtime_error("VirtualTexture: unsupported format");
+		}
+	}
+}
+
+VirtualTexture::VirtualTexture(std::span<const texture_level_t> levels, UINT slice_count, DXGI_FORMAT format,
+	const virtual_texture_options_t& options)
+	: levels(levels.begin(), levels.end()), slice_count(slice_count), tile_size(options.tile_size),
+	max_uploads_per_update(options.max_uploads_per_update) {
+	texel_block_t block = GetTexelBlock(format);
+	block_size = block.size;
+	block_bytes = block.bytes;
+	if (levels.empty() || slice_count == 0) {
+		throw std::runtime_error("VirtualTexture: empty texture");
+	}
+	if (!std::has_single_bit(tile_size) || tile_size < block_size) {
+		throw std::runtime_error("VirtualTexture: tile size must be a power of two of at least one block");
+	}
+
+	tiles_per_slice = 0;
+	for (const texture_level_t& level : levels) {
+		tile_grid_t grid = {
+			.columns = (level.width + tile_size - 1) / tile_size,
+			.rows = (level.height + tile_size - 1) / tile_size,
+			.first_tile = tiles_per_slice
+		};
+		grids.push_back(grid);
+		tiles_per_slice += grid.columns * grid.rows;
+		if (grid.columns == 1 && grid.rows == 1) {
+			break;
+		}
+	}
+
+	std::size_t slot_count = options.cache_budget / (std::size_t(GetTileRowPitch()) * GetTileRowCount());
+	if (slot_count <= slice_count) {
+		throw std::runtime_error("VirtualTexture: cache budget too small");
+	}
+	slots.resize(std::min<std::size_t>(slot_count, NO_SLOT));
+
+	UINT tiled_level_count = GetTiledLevelCount();
+	page_table.assign(std::size_t(slice_count) * tiles_per_slice, { .cache_slot = NO_SLOT,
+		.level = tiled_level_count });
+	tile_slots.assign(page_table.size(), NO_SLOT);
+
+	// The first slots hold the coarsest tiles, so that every page entry has a resident tile to fall back to.
+	for (UINT slice = 0; slice < slice_count; slice++) {
+		tile_id_t tile = { .slice = slice, .level = tiled_level_count - 1, .x = 0, .y = 0 };
+		UINT tile_index = GetTileIndex(tile);
+		slots[slice] = { .tile = tile_index, .state = slot_state_t::LOADING };
+		tile_slots[tile_index] = slice;
+		pinned_uploads.push_back({ .tile = tile, .cache_slot = slice });
+	}
+	for (UINT slot = static_cast<UINT>(slots.size()); slot-- > slice_count;) {
+		free_slots.push_back(slot);
+	}
+}
+
+std::vector<tile_upload_t> VirtualTexture::Update(std::span<const tile_id_t> feedback) {
+	frame++;
+	request_counts.clear();
+	UINT tiled_level_count = GetTiledLevelCount();
+	for (tile_id_t tile : feedback) {
+		if (tile.level >= tiled_level_count) {
+			tile = { .slice = tile.slice, .level = tiled_level_count - 1, .x = 0, .y = 0 };
+		}
+		if (tile.slice >= slice_count || tile.x >= grids[tile.level].columns || tile.y >= grids[tile.level].rows) {
+			throw std::runtime_error("VirtualTexture: tile request out of range");
+		}
+
+		stats.requests++;
+		UINT tile_index = GetTileIndex(tile);
+		UINT slot = tile_slots[tile_index];
+		if (slot == NO_SLOT) {
+			request_counts[tile_index]++;
+			continue;
+		}
+		if (slots[slot].state == slot_state_t::LOADING) {
+			continue;
+		}
+		stats.hits++;
+		slots[slot].last_used_frame = frame;
+		if (slots[slot].state == slot_state_t::RESIDENT && slot != most_recent) {
+			Unlink(slot);
+			LinkMostRecent(slot);
+		}
+	}
+
+	pending.clear();
+	for (auto [tile_index, request_count] : request_counts) {
+		pending.push_back({
+			.tile = tile_index,
+			.request_count = request_count,
+			.level_gap = page_table[tile_index].level - GetTileId(tile_index).level
+		});
+	}
+	std::sort(pending.begin(), pending.end(), [](const pending_tile_t& a, const pending_tile_t& b) {
+		if (a.level_gap != b.level_gap) {
+			return a.level_gap > b.level_gap;
+		}
+		if (a.request_count != b.request_count) {
+			return a.request_count > b.request_count;
+		}
+		return a.tile < b.tile;
+	});
+
+	// Taken only once the feedback is known to be valid, so that a throw does not lose them.
+	std::vector<tile_upload_t> uploads = std::move(pinned_uploads);
+	pinned_uploads.clear();
+	std::size_t upload_count = std::min<std::size_t>(pending.size(), max_uploads_per_update);
+	for (std::size_t i = 0; i < upload_count; i++) {
+		UINT slot = AllocateSlot();
+		if (slot == NO_SLOT) {
+			// Every resident tile was requested in this frame; evicting one would only bring it back.
+			break;
+		}
+		UINT tile_index = pending[i].tile;
+		slots[slot] = { .tile = tile_index, .state = slot_state_t::LOADING };
+		tile_slots[tile_index] = slot;
+		uploads.push_back({ .tile = GetTileId(tile_index), .cache_slot = slot });
+	}
+	return uploads;
+}
+
+void VirtualTexture::CompleteUpload(const tile_upload_t& upload) {
+	UINT tile_index = GetTileIndex(upload.tile);
+	cache_slot_t& slot = slots.at(upload.cache_slot);
+	if (slot.tile != tile_index || slot.state != slot_state_t::LOADING) {
+		throw std::runtime_error("VirtualTexture: upload was not scheduled");
+	}
+
+	slot.last_used_frame = frame;
+	if (upload.tile.level == GetTiledLevelCount() - 1) {
+		slot.state = slot_state_t::PINNED;
+	}
+	else {
+		slot.state = slot_state_t::RESIDENT;
+		LinkMostRecent(upload.cache_slot);
+	}
+	MapTile(tile_index, { .cache_slot = upload.cache_slot, .level = upload.tile.level }, upload.tile.level + 1);
+	stats.uploads++;
+	stats.upload_bytes += std::size_t(GetTileRowPitch()) * GetTileRowCount();
+}
+
+void VirtualTexture::CopyTile(const tile_id_t& tile, std::span<const BYTE> slice_data, BYTE* destination) const {
+	const texture_level_t& level = levels.at(tile.level);
+	UINT row_pitch = GetTileRowPitch();
+	UINT row_count = GetTileRowCount();
+	std::size_t level_row_size = std::size_t((level.width + block_size - 1) / block_size) * block_bytes;
+	std::size_t first_row = std::size_t(tile.y) * row_count;
+	std::size_t column_offset = std::size_t(tile.x) * row_pitch;
+	std::size_t copy_rows = first_row < level.row_count ?
+		std::min<std::size_t>(row_count, level.row_count - first_row) : 0;
+	std::size_t copy_size = column_offset < level_row_size ?
+		std::min<std::size_t>(row_pitch, level_row_size - column_offset) : 0;
+	if (copy_rows == 0 || level.offset + (first_row + copy_rows - 1) * level.row_pitch + column_offset + copy_size >
+		slice_data.size()) {
+		throw std::runtime_error("VirtualTexture: tile outside the texture data");
+	}
+
+	if (copy_rows < row_count || copy_size < row_pitch) {
+		memset(destination, 0, std::size_t(row_pitch) * row_count);
+	}
+	const BYTE* source = slice_data.data() + level.offset + first_row * level.row_pitch + column_offset;
+	for (std::size_t row = 0; row < copy_rows; row++) {
+		memcpy(destination + row * row_pitch, source + row * level.row_pitch, copy_size);
+	}
+}
+
+UINT VirtualTexture::GetCacheSlotCount() const {
+	return static_cast<UINT>(slots.size());
+}
+
+UINT VirtualTexture::GetTileRowPitch() const {
+	return tile_size / block_size * block_bytes;
+}
+
+UINT VirtualTexture::GetTileRowCount() const {
+	return tile_size / block_size;
+}
+
+UINT VirtualTexture::GetTiledLevelCount() const {
+	return static_cast<UINT>(grids.size());
+}
+
+UINT VirtualTexture::GetTileColumns(UINT level) const {
+	return grids.at(level).columns;
+}
+
+UINT VirtualTexture::GetTileRows(UINT level) const {
+	return grids.at(level).rows;
+}
+
+std::span<const page_entry_t> VirtualTexture::GetPageTable(UINT slice, UINT level) const {
+	const tile_grid_t& grid = grids.at(level);
+	return std::span(page_table).subspan(std::size_t(slice) * tiles_per_slice + grid.first_tile,
+		std::size_t(grid.columns) * grid.rows);
+}
+
+const virtual_texture_stats_t& VirtualTexture::GetStats() const {
+	return stats;
+}
+
+UINT VirtualTexture::GetTileIndex(const tile_id_t& tile) const {
+	const tile_grid_t& grid = grids[tile.level];
+	return tile.slice * tiles_per_slice + grid.first_tile + tile.y * grid.columns + tile.x;
+}
+
+tile_id_t VirtualTexture::GetTileId(UINT tile) const {
+	UINT slice = tile / tiles_per_slice;
+	UINT slice_tile = tile % tiles_per_slice;
+	UINT level = 0;
+	while (level + 1 < grids.size() && grids[level + 1].first_tile <= slice_tile) {
+		level++;
+	}
+	UINT level_tile = slice_tile - grids[level].first_tile;
+	return {
+		.slice = slice,
+		.level = level,
+		.x = level_tile % grids[level].columns,
+		.y = level_tile / grids[level].columns
+	};
+}
+
+void VirtualTexture::Unlink(UINT slot) {
+	cache_slot_t& entry = slots[slot];
+	(entry.previous != NO_SLOT ? slots[entry.previous].next : most_recent) = entry.next;
+	(entry.next != NO_SLOT ? slots[entry.next].previous : least_recent) = entry.previous;
+	entry.previous = NO_SLOT;
+	entry.next = NO_SLOT;
+}
+
+void VirtualTexture::LinkMostRecent(UINT slot) {
+	slots[slot].next = most_recent;
+	(most_recent != NO_SLOT ? slots[most_recent].previous : least_recent) = slot;
+	most_recent = slot;
+}
+
+UINT VirtualTexture::AllocateSlot() {
+	if (!free_slots.empty()) {
+		UINT slot = free_slots.back();
+		free_slots.pop_back();
+		return slot;
+	}
+
+	UINT slot = least_recent;
+	if (slot == NO_SLOT || slots[slot].last_used_frame == frame) {
+		return NO_SLOT;
+	}
+	Unlink(slot);
+	UINT tile_index = slots[slot].tile;
+	tile_slots[tile_index] = NO_SLOT;
+
+	// Pages that showed the evicted tile fall back to whatever its parent's page shows.
+	tile_id_t tile = GetTileId(tile_index);
+	const tile_grid_t& parent_grid = grids[tile.level + 1];
+	page_entry_t parent_entry = page_table[std::size_t(tile.slice) * tiles_per_slice + parent_grid.first_tile +
+		std::min(tile.y / 2, parent_grid.rows - 1) * parent_grid.columns +
+		std::min(tile.x / 2, parent_grid.columns - 1)];
+	MapTile(tile_index, parent_entry, tile.level);
+	stats.evictions++;
+	return slot;
+}
+
+// Points the page of a tile, and the pages of the finer tiles it covers, at entry wherever they show a
+// tile of replaced_level or coarser. The last column and row of a level also cover the extra tiles that
+// rounding leaves in the finer levels.
+void VirtualTexture::MapTile(UINT tile_index, const page_entry_t& entry, UINT replaced_level) {
+	tile_id_t tile = GetTileId(tile_index);
+	const tile_grid_t& tile_grid = grids[tile.level];
+	for (UINT level = tile.level + 1; level-- > 0;) {
+		UINT shift = tile.level - level;
+		const tile_grid_t& grid = grids[level];
+		UINT x_begin = tile.x << shift;
+		UINT y_begin = tile.y << shift;
+		UINT x_end = tile.x + 1 == tile_grid.columns ? grid.columns : std::min((tile.x + 1) << shift, grid.columns);
+		UINT y_end = tile.y + 1 == tile_grid.rows ? grid.rows : std::min((tile.y + 1) << shift, grid.rows);
+		page_entry_t* pages = page_table.data() + std::size_t(tile.slice) * tiles_per_slice + grid.first_tile;
+		for (UINT y = y_begin; y < y_end; y++) {
+			for (UINT x = x_begin; x < x_end; x++) {
+				page_entry_t& page = pages[y * grid.columns + x];
+				if (page.level >= replaced_level) {
+					page = entry;
+				}
+			}
+		}
+	}
+}
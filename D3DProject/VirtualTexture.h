@@ -0,0 +1,143 @@
+#pragma once
+
+#include "TextureData.h"
+
+struct virtual_texture_options_t {
+	// Width and height of a tile in texels; a power of two and a whole number of blocks. Tiles have no border
+	// texels, so filtering across tile edges needs the neighboring tiles of the same level to be resident.
+	UINT tile_size = 128;
+	// Memory of the physical tile cache. The coarsest tile of every slice stays resident; the others are
+	// evicted least recently used first.
+	std::size_t cache_budget = 64 << 20;
+	// Limits the uploads started by each Update, so that a camera cut spreads its cost over several frames.
+	UINT max_uploads_per_update = 16;
+};
+
+struct tile_id_t {
+	UINT slice;
+	UINT level;
+	UINT x;
+	UINT y;
+};
+
+struct tile_upload_t {
+	tile_id_t tile;
+	// Slot of the physical cache that the tile is written to.
+	UINT cache_slot;
+};
+
+// Tile that the shader samples in place of a virtual tile: the tile itself once resident, otherwise the
+// nearest coarser resident tile covering it.
+struct page_entry_t {
+	UINT cache_slot;
+	UINT level;
+};
+
+struct virtual_texture_stats_t {
+	// Tile requests from the feedback, and those whose tile was resident.
+	UINT64 requests = 0;
+	UINT64 hits = 0;
+	UINT64 uploads = 0;
+	UINT64 upload_bytes = 0;
+	UINT64 evictions = 0;
+};
+
+// Residency of the tiles of a texture array that is too large to keep in memory. Levels are split into
+// tiles of a fixed size down to the first level that fits in a single tile, past which the shader does not
+// sample. Nothing here touches the GPU: the renderer feeds the tiles sampled in each frame to Update,
+// copies the returned tiles into the physical cache and uploads the page table.
+class VirtualTexture {
+public:
+	// Takes the layout shared by the slices of a TextureArray. Throws if the cache budget cannot hold the
+	// coarsest tile of every slice and at least one more tile.
+	VirtualTexture(std::span<const texture_level_t> levels, UINT slice_count, DXGI_FORMAT format,
+		const virtual_texture_options_t& options = {});
+
+	// Counts the requests of a frame, repeated once per sample, and returns the tiles to load in order of
+	// priority. Missing tiles whose page entry is furthest from the requested level come first, then those
+	// requested most often. Every returned tile has a cache slot, taken from a tile that was not requested
+	// in this frame; when no such slot is left the remaining tiles wait for a later frame. The first call
+	// also returns the coarsest tile of every slice. Requests for levels past the tiled levels are clamped.
+	std::vector<tile_upload_t> Update(std::span<const tile_id_t> feedback);
+	// Maps a tile returned by Update in the page table once its data is in the cache slot.
+	void CompleteUpload(const tile_upload_t& upload);
+
+	// Writes a tile in rows of GetTileRowPitch bytes from the levels of one slice, as laid out by
+	// TextureAsset. The part of edge tiles past the level is zeroed.
+	void CopyTile(const tile_id_t& tile, std::span<const BYTE> slice_data, BYTE* destination) const;
+
+	UINT GetCacheSlotCount() const;
+	UINT GetTileRowPitch() const;
+	UINT GetTileRowCount() const;
+	// Levels 0 to GetTiledLevelCount() - 1 have a page table; the last one is a single tile.
+	UINT GetTiledLevelCount() const;
+	UINT GetTileColumns(UINT level) const;
+	UINT GetTileRows(UINT level) const;
+	// Entries of a level in rows of GetTileColumns(level).
+	std::span<const page_entry_t> GetPageTable(UINT slice, UINT level) const;
+	// Hit rate and upload bandwidth are for the caller to report, as this neither logs nor keeps time.
+	const virtual_texture_stats_t& GetStats() const;
+private:
+	static constexpr UINT NO_SLOT = UINT_MAX;
+	static constexpr UINT NO_TILE = UINT_MAX;
+
+	enum class slot_state_t : UINT {
+		FREE,
+		LOADING,
+		RESIDENT,
+		// Holds the coarsest tile of a slice, which is never evicted.
+		PINNED
+	};
+
+	struct tile_grid_t {
+		UINT columns;
+		UINT rows;
+		// Index of the first tile of the level among the tiles of a slice.
+		UINT first_tile;
+	};
+
+	// Slots form a list from the most to the least recently used resident tile.
+	struct cache_slot_t {
+		UINT tile = NO_TILE;
+		slot_state_t state = slot_state_t::FREE;
+		UINT64 last_used_frame = 0;
+		UINT previous = NO_SLOT;
+		UINT next = NO_SLOT;
+	};
+
+	struct pending_tile_t {
+		UINT tile;
+		UINT request_count;
+		UINT level_gap;
+	};
+
+	std::vector<texture_level_t> levels;
+	UINT slice_count;
+	UINT tile_size;
+	UINT block_size;
+	UINT block_bytes;
+	UINT max_uploads_per_update;
+	std::vector<tile_grid_t> grids;
+	UINT tiles_per_slice;
+	// Indexed by the tile index, slice after slice.
+	std::vector<page_entry_t> page_table;
+	std::vector<UINT> tile_slots;
+	std::vector<cache_slot_t> slots;
+	std::vector<UINT> free_slots;
+	UINT most_recent = NO_SLOT;
+	UINT least_recent = NO_SLOT;
+	UINT64 frame = 0;
+	// Requests of the current frame, by tile.
+	std::unordered_map<UINT, UINT> request_counts;
+	std::vector<pending_tile_t> pending;
+	// Coarsest tiles, returned by the first Update.
+	std::vector<tile_upload_t> pinned_uploads;
+	virtual_texture_stats_t stats;
+
+	UINT GetTileIndex(const tile_id_t& tile) const;
+	tile_id_t GetTileId(UINT tile) const;
+	void Unlink(UINT slot);
+	void LinkMostRecent(UINT slot);
+	UINT AllocateSlot();
+	void MapTile(UINT tile, const page_entry_t& entry, UINT replaced_level);
+};
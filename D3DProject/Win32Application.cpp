@@ -35,10 +35,11 @@ int Win32Application::Run(D3DHandler* d3d_handler, HINSTANCE instance, int cmd_s
 	);
 	winrt::check_pointer(hwnd);
 
-	d3d_handler->OnInit();
-
+	// The window is shown first; the scene appears in it once loaded.
 	ShowWindow(hwnd, cmd_show);
 
+	d3d_handler->OnInit();
+
 	MSG msg = {};
 	while (GetMessage(&msg, nullptr, 0, 0))
 	{
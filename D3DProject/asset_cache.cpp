@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "asset_cache.h"
+
+source_stamp_t GetSourceStamp(const std::string& path) {
+	WIN32_FILE_ATTRIBUTE_DATA attributes;
+	winrt::check_bool(GetFileAttributesExA(path.c_str(), GetFileExInfoStandard, &attributes));
+	return {
+		.size = (static_cast<UINT64>(attributes.nFileSizeHigh) << 32) | attributes.nFileSizeLow,
+		.write_time = (static_cast<UINT64>(attributes.ftLastWriteTime.dwHighDateTime) << 32) |
+			attributes.ftLastWriteTime.dwLowDateTime
+	};
+}
+
+UINT64 HashBytes(std::span<const char> data) {
+	constexpr UINT64 PRIME_1 = 0x9e3779b185ebca87ull;
+	constexpr UINT64 PRIME_2 = 0xc2b2ae3d27d4eb4full;
+	auto round = [](UINT64 lane, UINT64 word) {
+		return std::rotl(lane + word * PRIME_2, 31) * PRIME_1;
+	};
+
+	// Four independent lanes keep several multiplications in flight.
+	UINT64 lanes[4] = { PRIME_1, PRIME_2, 0, ~PRIME_1 };
+	const char* current = data.data();
+	const char* end = current + data.size();
+	for (; end - current >= 32; current += 32) {
+		for (std::size_t lane = 0; lane < 4; lane++) {
+			UINT64 word;
+			memcpy(&word, current + lane * 8, sizeof(word));
+			lanes[lane] = round(lanes[lane], word);
+		}
+	}
+
+	UINT64 hash = std::rotl(lanes[0], 1) + std::rotl(lanes[1], 7) + std::rotl(lanes[2], 12) +
+		std::rotl(lanes[3], 18) + data.size();
+	for (; end - current >= 8; current += 8) {
+		UINT64 word;
+		memcpy(&word, current, sizeof(word));
+		hash = round(hash, word);
+	}
+	for (; current != end; current++) {
+		hash = round(hash, static_cast<unsigned char>(*current));
+	}
+
+	hash ^= hash >> 33;
+	hash *= PRIME_2;
+	hash ^= hash >> 29;
+	return hash;
+}
+
+bool WriteCacheFile(const std::string& path, std::initializer_list<std::span<const char>> parts) {
+	const std::string temporary_path = path + ".tmp";
+	{
+		std::ofstream cache_stream(temporary_path, std::ios::binary | std::ios::trunc);
+		for (auto part : parts) {
+			cache_stream.write(part.data(), part.size());
+		}
+		cache_stream.close();
+		if (!cache_stream) {
+			DeleteFileA(temporary_path.c_str());
+			return false;
+		}
+	}
+	return MoveFileExA(temporary_path.c_str(), path.c_str(), MOVEFILE_REPLACE_EXISTING) != FALSE;
+}
+
+bool UpdateCacheHeader(const std::string& path, std::span<const char> header) {
+	std::fstream cache_stream(path, std::ios::binary | std::ios::in | std::ios::out);
+	cache_stream.write(header.data(), header.size());
+	cache_stream.close();
+	return !cache_stream.fail();
+}
@@ -0,0 +1,22 @@
+#pragma once
+
+// Helpers shared by the binary caches written next to source assets.
+
+// Identity of a source file, cheap enough to check on every start.
+struct source_stamp_t {
+	UINT64 size;
+	UINT64 write_time;
+};
+
+source_stamp_t GetSourceStamp(const std::string& path);
+
+// Fast non-cryptographic 64-bit hash, used to detect modified sources and corrupt caches.
+UINT64 HashBytes(std::span<const char> data);
+
+// Writes the parts to a temporary file and then moves it over path, so that readers never observe a
+// partially written cache. Returns false if the cache could not be written.
+bool WriteCacheFile(const std::string& path, std::initializer_list<std::span<const char>> parts);
+
+// Overwrites the start of the cache at path with header, in place, for changes that leave the payload valid.
+// The cache must not be mapped. Returns false if the header could not be written.
+bool UpdateCacheHeader(const std::string& path, std::span<const char> header);
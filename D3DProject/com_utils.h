@@ -0,0 +1,22 @@
+#pragma once
+
+// Initializes COM on the calling thread for the lifetime of the object, and uninitializes it only if the
+// initialization succeeded, so that every exit path is balanced.
+class ComInitializer {
+public:
+	explicit ComInitializer(DWORD concurrency_model) : result(CoInitializeEx(nullptr, concurrency_model)) {}
+	ComInitializer(const ComInitializer&) = delete;
+	ComInitializer& operator=(const ComInitializer&) = delete;
+	~ComInitializer() {
+		if (SUCCEEDED(result)) {
+			CoUninitialize();
+		}
+	}
+
+	// Fails on a thread that is already in an apartment of another concurrency model.
+	HRESULT GetResult() const {
+		return result;
+	}
+private:
+	HRESULT result;
+};
@@ -7,6 +7,19 @@ int WINAPI WinMain(HINSTANCE hInstance, HINSTANCE, LPSTR, int nCmdShow) {
 	RECT desktop;
 	GetClientRect(GetDesktopWindow(), &desktop);
 
-	D3DHandler sample(desktop.right - desktop.left, desktop.bottom - desktop.top);
-	return Win32Application::Run(&sample, hInstance, nCmdShow);
+	int result;
+	{
+		D3DHandler sample(desktop.right - desktop.left, desktop.bottom - desktop.top);
+		result = Win32Application::Run(&sample, hInstance, nCmdShow);
+	}
+
+#if defined(_DEBUG)
+	// The handler owns every D3D12 and DXGI object, so any object still alive after it is destroyed leaked.
+	winrt::com_ptr<IDXGIDebug1> dxgi_debug;
+	if (SUCCEEDED(DXGIGetDebugInterface1(0, IID_PPV_ARGS(dxgi_debug.put())))) {
+		dxgi_debug->ReportLiveObjects(DXGI_DEBUG_ALL,
+			static_cast<DXGI_DEBUG_RLO_FLAGS>(DXGI_DEBUG_RLO_DETAIL | DXGI_DEBUG_RLO_IGNORE_INTERNAL));
+	}
+#endif
+	return result;
 }
@@ -0,0 +1,34 @@
+#pragma once
+
+// Runs function(0) ... function(count - 1) on separate threads, using the calling thread for index 0.
+// The first exception thrown by any of the invocations is rethrown after all threads have finished.
+template <typename Function>
+void ParallelFor(std::size_t count, Function&& function) {
+	if (count == 0) {
+		return;
+	}
+
+	std::vector<std::exception_ptr> errors(count);
+	auto run = [&](std::size_t index) {
+		try {
+			function(index);
+		}
+		catch (...) {
+			errors[index] = std::current_exception();
+		}
+	};
+	{
+		std::vector<std::jthread> workers;
+		workers.reserve(count - 1);
+		for (std::size_t i = 1; i < count; i++) {
+			workers.emplace_back(run, i);
+		}
+		run(0);
+	}
+
+	for (auto& error : errors) {
+		if (error) {
+			std::rethrow_exception(error);
+		}
+	}
+}
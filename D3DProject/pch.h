@@ -1,20 +1,54 @@
 #pragma once
 
+#ifdef _WIN32
 #include "targetver.h"
 #define WIN32_LEAN_AND_MEAN             // Exclude rarely-used stuff from Windows headers
 
 // Windows Header Files
 #include <windows.h>
 #include <wincodec.h>
+#include <psapi.h>
 
 #include <d3d12.h>
 #include <dxgi1_6.h>
+#include <dxgidebug.h>
 #include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <emmintrin.h>
 #include "d3d12_utils.h"
 
 #include <winrt/base.h>
+#else
+// Builds without the Windows SDK, such as the tests on Linux, only compile the modules that talk to neither the
+// OS nor the GPU, and take the subset of the SDK that those use from Tests/headless.
+#include <headless_platform.h>
+#endif
 
 // C RunTime Header Files
 #include <string>
+#include <string_view>
 #include <vector>
+#include <deque>
+#include <span>
 #include <fstream>
+#include <charconv>
+#include <cstring>
+#include <stdexcept>
+#include <exception>
+#include <thread>
+#include <algorithm>
+#include <bit>
+#include <optional>
+#include <unordered_map>
+#if __has_include(<format>)
+#include <format>
+#endif
+#include <numeric>
+#include <cmath>
+#include <cfloat>
+#include <future>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <memory>
+#include <chrono>
@@ -4,4 +4,6 @@ struct vertex_t {
 	FLOAT position[3];
 	FLOAT color[4];
 	FLOAT tex_coord[2];
+	// Index of the material, which selects the slice of the scene's texture array.
+	UINT material;
 };
@@ -0,0 +1,232 @@
+#include "pch.h"
+#include "BlockCompressor.h"
+#include "test_utils.h"
+
+namespace {
+	constexpr UINT IMAGE_SIZE = 256;
+
+	texture_data_t MakeTexture(DXGI_FORMAT format, UINT width, UINT height, UINT row_pitch, UINT row_count) {
+		return {
+			.format = format,
+			.levels = { { .width = width, .height = height, .offset = 0, .row_pitch = row_pitch,
+				.row_count = row_count } },
+			.data = std::vector<BYTE>(std::size_t(row_pitch) * row_count)
+		};
+	}
+
+	// A fixed RGBA8 image with smooth gradients, hard edges, fine noise and a varying alpha channel, in
+	// quarters that each stress the encoders differently.
+	texture_data_t MakeImage(UINT size) {
+		texture_data_t image = MakeTexture(DXGI_FORMAT_R8G8B8A8_UNORM, size, size, size * 4, size);
+		UINT32 state = 12345;
+		for (UINT y = 0; y < size; y++) {
+			for (UINT x = 0; x < size; x++) {
+				state = state * 1664525u + 1013904223u;
+				BYTE noise = static_cast<BYTE>(state >> 24);
+				BYTE* pixel = &image.data[(std::size_t(y) * size + x) * 4];
+				bool right = x >= size / 2, bottom = y >= size / 2;
+				if (!right && !bottom) {
+					pixel[0] = static_cast<BYTE>(x * 255 / size);
+					pixel[1] = static_cast<BYTE>(y * 255 / size);
+					pixel[2] = static_cast<BYTE>(128 + (x + y) % 64);
+				}
+				else if (right && !bottom) {
+					bool checker = (x / 8 + y / 8) % 2 != 0;
+					pixel[0] = checker ? 230 : 20;
+					pixel[1] = checker ? 40 : 200;
+					pixel[2] = checker ? 90 : 160;
+				}
+				else if (!right) {
+					pixel[0] = static_cast<BYTE>(100 + noise / 8);
+					pixel[1] = static_cast<BYTE>(80 + noise / 16);
+					pixel[2] = static_cast<BYTE>(60 + noise / 8);
+				}
+				else {
+					BYTE ring = static_cast<BYTE>(((size - x) * (size - x) + (size - y) * (size - y)) / 64);
+					pixel[0] = ring;
+					pixel[1] = static_cast<BYTE>(255 - ring);
+					pixel[2] = static_cast<BYTE>(ring / 2 + 64);
+				}
+				pixel[3] = static_cast<BYTE>(right ? 255 - y * 255 / size : (x / 4 % 2) * 191 + 64);
+			}
+		}
+		return image;
+	}
+
+	const char* FormatName(DXGI_FORMAT format) {
+		switch (format) {
+		case DXGI_FORMAT_BC1_UNORM: return "BC1";
+		case DXGI_FORMAT_BC3_UNORM: return "BC3";
+		default: return "BC7";
+		}
+	}
+
+	const char* QualityName(compression_quality_t quality) {
+		switch (quality) {
+		case compression_quality_t::FAST: return "FAST";
+		case compression_quality_t::HIGH: return "HIGH";
+		default: return "NORMAL";
+		}
+	}
+
+	struct quality_case_t {
+		DXGI_FORMAT format;
+		compression_quality_t quality;
+		// Lowest PSNR in dB on the fixed image, a little below what the encoder reached when it was written.
+		double min_psnr;
+	};
+
+	// Each format and quality reaches its PSNR on the fixed image, a higher quality never does worse, and
+	// encoding on several threads gives the same blocks. BC1 has no alpha, so it is compared with an opaque
+	// copy of the image.
+	void TestQuality() {
+		texture_data_t image = MakeImage(IMAGE_SIZE);
+		texture_data_t opaque = image;
+		for (std::size_t i = 3; i < opaque.data.size(); i += 4) {
+			opaque.data[i] = 255;
+		}
+		const quality_case_t cases[] = {
+			{ DXGI_FORMAT_BC1_UNORM, compression_quality_t::FAST, 42.0 },
+			{ DXGI_FORMAT_BC1_UNORM, compression_quality_t::NORMAL, 42.5 },
+			{ DXGI_FORMAT_BC1_UNORM, compression_quality_t::HIGH, 42.5 },
+			{ DXGI_FORMAT_BC3_UNORM, compression_quality_t::FAST, 42.0 },
+			{ DXGI_FORMAT_BC3_UNORM, compression_quality_t::NORMAL, 42.5 },
+			{ DXGI_FORMAT_BC3_UNORM, compression_quality_t::HIGH, 42.5 },
+			{ DXGI_FORMAT_BC7_UNORM, compression_quality_t::FAST, 51.2 },
+			{ DXGI_FORMAT_BC7_UNORM, compression_quality_t::NORMAL, 52.3 },
+			{ DXGI_FORMAT_BC7_UNORM, compression_quality_t::HIGH, 52.6 }
+		};
+		double previous_psnr = 0.0;
+		for (const quality_case_t& test_case : cases) {
+			const texture_data_t& source = test_case.format == DXGI_FORMAT_BC1_UNORM ? opaque : image;
+			texture_data_t compressed;
+			double time = test::MeasureMilliseconds([&] {
+				compressed = CompressTexture(source, { .format = test_case.format, .quality = test_case.quality });
+			});
+			double psnr = ComputePsnr(source, DecompressTexture(compressed, 1));
+			std::printf("%s %-6s %6.2f dB %8.2f MP/s\n", FormatName(test_case.format), QualityName(test_case.quality),
+				psnr, IMAGE_SIZE * IMAGE_SIZE / (time * 1e3));
+			CHECK(psnr >= test_case.min_psnr);
+			if (test_case.quality != compression_quality_t::FAST) {
+				CHECK(psnr >= previous_psnr);
+			}
+			previous_psnr = psnr;
+
+			texture_data_t threaded = CompressTexture(source, { .format = test_case.format,
+				.quality = test_case.quality, .thread_count = 4 });
+			CHECK(threaded.data == compressed.data);
+		}
+	}
+
+	// Writes fields into a block from the least significant bit of its first byte on, as BC7 stores them.
+	class BitWriter {
+	public:
+		explicit BitWriter(BYTE* destination) : destination(destination) {
+		}
+
+		void Write(UINT value, UINT bits) {
+			for (UINT bit = 0; bit < bits; bit++, position++) {
+				destination[position / 8] |= static_cast<BYTE>(((value >> bit) & 1) << (position % 8));
+			}
+		}
+	private:
+		BYTE* destination;
+		UINT position = 0;
+	};
+
+	UINT Interpolate(UINT first, UINT second, UINT weight) {
+		return ((64 - weight) * first + weight * second + 32) >> 6;
+	}
+
+	std::array<BYTE, 64> DecodeBlock(const BYTE (&block)[16]) {
+		texture_data_t texture = MakeTexture(DXGI_FORMAT_BC7_UNORM, 4, 4, 16, 1);
+		memcpy(texture.data.data(), block, sizeof(block));
+		texture_data_t decoded = DecompressTexture(texture, 1);
+		std::array<BYTE, 64> pixels;
+		std::copy(decoded.data.begin(), decoded.data.end(), pixels.begin());
+		return pixels;
+	}
+
+	// A mode 6 block: 7-bit RGBA endpoints with a shared low bit each, and 4-bit indices.
+	void TestBc7Mode6Block() {
+		constexpr UINT ENDPOINTS[2][4] = { { 20, 127, 64, 127 }, { 100, 0, 64, 10 } };
+		constexpr UINT P_BITS[2] = { 1, 0 };
+		constexpr UINT WEIGHTS[] = { 0, 4, 9, 13, 17, 21, 26, 30, 34, 38, 43, 47, 51, 55, 60, 64 };
+		BYTE block[16] = {};
+		BitWriter writer(block);
+		writer.Write(1 << 6, 7);
+		for (UINT channel = 0; channel < 4; channel++) {
+			writer.Write(ENDPOINTS[0][channel], 7);
+			writer.Write(ENDPOINTS[1][channel], 7);
+		}
+		writer.Write(P_BITS[0], 1);
+		writer.Write(P_BITS[1], 1);
+		// The index of the first pixel drops its high bit, which is always zero.
+		for (UINT i = 0; i < 16; i++) {
+			writer.Write(i * 7 % 16, i == 0 ? 3 : 4);
+		}
+
+		std::array<BYTE, 64> pixels = DecodeBlock(block);
+		bool exact = true;
+		for (UINT i = 0; i < 16; i++) {
+			for (UINT channel = 0; channel < 4; channel++) {
+				UINT expected = Interpolate(ENDPOINTS[0][channel] * 2 + P_BITS[0],
+					ENDPOINTS[1][channel] * 2 + P_BITS[1], WEIGHTS[i * 7 % 16]);
+				exact = exact && pixels[i * 4 + channel] == expected;
+			}
+		}
+		CHECK(exact);
+		// The first pixel is the first endpoint, and the one with index 15 the second.
+		CHECK(pixels[0] == 41 && pixels[1] == 255 && pixels[2] == 129 && pixels[3] == 255);
+		CHECK(pixels[9 * 4] == 200 && pixels[9 * 4 + 1] == 0 && pixels[9 * 4 + 2] == 128 && pixels[9 * 4 + 3] == 20);
+	}
+
+	// A mode 5 block: 7-bit color and 8-bit alpha endpoints, with separate 2-bit color and alpha indices, and
+	// the red and alpha channels swapped by the rotation.
+	void TestBc7Mode5Block() {
+		constexpr UINT COLOR_ENDPOINTS[2][3] = { { 0, 127, 33 }, { 127, 64, 90 } };
+		constexpr UINT ALPHA_ENDPOINTS[2] = { 250, 16 };
+		constexpr UINT WEIGHTS[] = { 0, 21, 43, 64 };
+		BYTE block[16] = {};
+		BitWriter writer(block);
+		writer.Write(1 << 5, 6);
+		writer.Write(1, 2);
+		for (UINT channel = 0; channel < 3; channel++) {
+			writer.Write(COLOR_ENDPOINTS[0][channel], 7);
+			writer.Write(COLOR_ENDPOINTS[1][channel], 7);
+		}
+		writer.Write(ALPHA_ENDPOINTS[0], 8);
+		writer.Write(ALPHA_ENDPOINTS[1], 8);
+		for (UINT i = 0; i < 16; i++) {
+			writer.Write(i % 4 % (i == 0 ? 2 : 4), i == 0 ? 1 : 2);
+		}
+		for (UINT i = 0; i < 16; i++) {
+			writer.Write((i / 4 + i) % 4 % (i == 0 ? 2 : 4), i == 0 ? 1 : 2);
+		}
+
+		std::array<BYTE, 64> pixels = DecodeBlock(block);
+		bool exact = true;
+		for (UINT i = 0; i < 16; i++) {
+			UINT expected[4];
+			for (UINT channel = 0; channel < 3; channel++) {
+				UINT first = COLOR_ENDPOINTS[0][channel], second = COLOR_ENDPOINTS[1][channel];
+				expected[channel] = Interpolate(first << 1 | first >> 6, second << 1 | second >> 6, WEIGHTS[i % 4]);
+			}
+			expected[3] = Interpolate(ALPHA_ENDPOINTS[0], ALPHA_ENDPOINTS[1], WEIGHTS[(i / 4 + i) % 4]);
+			std::swap(expected[0], expected[3]);
+			for (UINT channel = 0; channel < 4; channel++) {
+				exact = exact && pixels[i * 4 + channel] == expected[channel];
+			}
+		}
+		CHECK(exact);
+		// The first pixel has both first endpoints, with alpha in red and red in alpha.
+		CHECK(pixels[0] == 250 && pixels[1] == 255 && pixels[2] == 66 && pixels[3] == 0);
+	}
+}
+
+int main() {
+	TestQuality();
+	TestBc7Mode6Block();
+	TestBc7Mode5Block();
+	return test::Result();
+}
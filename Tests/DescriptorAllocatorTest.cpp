@@ -0,0 +1,182 @@
+#include "pch.h"
+#include "DescriptorAllocator.h"
+#include "test_utils.h"
+#include <random>
+#include <set>
+
+namespace {
+	void TestPersistent() {
+		DescriptorAllocator allocator(3, 0, 0);
+		CHECK(allocator.GetCount() == 3);
+		CHECK(allocator.AllocatePersistent() == 0);
+		CHECK(allocator.AllocatePersistent() == 1);
+		CHECK(allocator.AllocatePersistent() == 2);
+		CHECK(!allocator.AllocatePersistent());
+
+		allocator.FreePersistent(1);
+		CHECK(allocator.GetPersistentUsedCount() == 2);
+		CHECK(allocator.AllocatePersistent() == 1);
+
+		// Descriptors freed after a fence value stay in use until a Reclaim has seen it complete.
+		allocator.FreePersistentAfter(0, 5);
+		allocator.FreePersistentAfter(2, 6);
+		CHECK(allocator.GetPendingFreeCount() == 2);
+		CHECK(!allocator.AllocatePersistent());
+		allocator.Reclaim(4);
+		CHECK(!allocator.AllocatePersistent());
+		allocator.Reclaim(5);
+		CHECK(allocator.GetPendingFreeCount() == 1);
+		CHECK(allocator.AllocatePersistent() == 0);
+		allocator.Reclaim(6);
+		CHECK(allocator.GetPendingFreeCount() == 0);
+		CHECK(allocator.GetPersistentUsedCount() == 2);
+	}
+
+	void TestTransient() {
+		DescriptorAllocator allocator(4, 2, 8);
+		CHECK(allocator.GetCount() == 20);
+		// The regions follow the persistent descriptors, one per frame context.
+		CHECK(allocator.AllocateTransient(2) == 4);
+		CHECK(allocator.AllocateTransient(6) == 6);
+		CHECK(allocator.GetTransientUsedCount() == 8);
+		CHECK(!allocator.AllocateTransient(1));
+		allocator.BeginFrame(1);
+		CHECK(allocator.AllocateTransient(8) == 12);
+		allocator.BeginFrame(0);
+		CHECK(allocator.GetTransientUsedCount() == 0);
+		CHECK(allocator.AllocateTransient(3) == 4);
+	}
+
+	void TestErrors() {
+		CHECK_THROWS(DescriptorAllocator(1, 2, UINT_MAX / 2 + 1));
+		DescriptorAllocator allocator(2, 1, 4);
+		CHECK_THROWS(allocator.FreePersistent(0));
+		CHECK_THROWS(allocator.FreePersistent(7));
+		UINT index = *allocator.AllocatePersistent();
+		allocator.FreePersistent(index);
+		CHECK_THROWS(allocator.FreePersistent(index));
+		index = *allocator.AllocatePersistent();
+		allocator.FreePersistentAfter(index, 3);
+		CHECK_THROWS(allocator.FreePersistentAfter(index, 3));
+		CHECK_THROWS(allocator.FreePersistentAfter(*allocator.AllocatePersistent(), 2));
+		CHECK_THROWS(allocator.BeginFrame(1));
+		CHECK_THROWS(allocator.AllocateTransient(0));
+		CHECK_THROWS(DescriptorAllocator(2, 0, 0).AllocateTransient(1));
+	}
+
+	// Random persistent allocations and frees, transient allocations and frames, with a GPU that completes
+	// zero to two frames per frame. A descriptor that is live or waiting for its fence value must never be
+	// handed out, and transient ranges must stay inside the region of their frame and apart.
+	void TestRandomOperations() {
+		constexpr UINT SEEDS = 200;
+		constexpr UINT OPERATIONS = 5000;
+		UINT64 frames = 0;
+		for (UINT seed = 0; seed < SEEDS; seed++) {
+			std::mt19937 random(seed);
+			UINT persistent_count = 1 + random() % 300;
+			UINT frame_count = 1 + random() % 3;
+			UINT transient_count = 1 + random() % 64;
+			DescriptorAllocator allocator(persistent_count, frame_count, transient_count);
+			std::set<UINT> live, pending;
+			std::deque<std::pair<UINT64, UINT>> pending_frees;
+			std::vector<std::pair<UINT, UINT>> transient_ranges;
+			UINT64 fence_value = 1, completed = 0;
+			UINT frame = 0;
+			for (UINT i = 0; i < OPERATIONS; i++) {
+				UINT action = random() % 100;
+				if (action < 40) {
+					std::optional<UINT> index = allocator.AllocatePersistent();
+					if (!index) {
+						CHECK(live.size() + pending.size() == persistent_count);
+						continue;
+					}
+					CHECK(*index < persistent_count);
+					CHECK(!live.contains(*index) && !pending.contains(*index));
+					live.insert(*index);
+				}
+				else if (action < 75 && !live.empty()) {
+					auto freed = std::next(live.begin(), random() % live.size());
+					UINT index = *freed;
+					live.erase(freed);
+					if (action < 55) {
+						allocator.FreePersistent(index);
+					}
+					else {
+						allocator.FreePersistentAfter(index, fence_value);
+						pending_frees.push_back({ fence_value, index });
+						pending.insert(index);
+					}
+				}
+				else if (action < 90) {
+					UINT count = 1 + random() % 8;
+					UINT used = allocator.GetTransientUsedCount();
+					std::optional<UINT> index = allocator.AllocateTransient(count);
+					if (!index) {
+						CHECK(used + count > transient_count);
+						continue;
+					}
+					UINT region = persistent_count + frame * transient_count;
+					CHECK(*index >= region && *index + count <= region + transient_count);
+					for (auto [first, other_count] : transient_ranges) {
+						CHECK(*index >= first + other_count || *index + count <= first);
+					}
+					transient_ranges.push_back({ *index, count });
+				}
+				else {
+					fence_value++;
+					completed = std::min(fence_value - 1, completed + random() % 3);
+					allocator.Reclaim(completed);
+					while (!pending_frees.empty() && pending_frees.front().first <= completed) {
+						pending.erase(pending_frees.front().second);
+						pending_frees.pop_front();
+					}
+					CHECK(allocator.GetPendingFreeCount() == pending_frees.size());
+					frame = (frame + 1) % frame_count;
+					allocator.BeginFrame(frame);
+					transient_ranges.clear();
+					frames++;
+				}
+				CHECK(allocator.GetPersistentUsedCount() == live.size() + pending.size());
+			}
+		}
+		std::printf("%u operations over %u seeds, %llu frames\n", SEEDS * OPERATIONS, SEEDS,
+			static_cast<unsigned long long>(frames));
+	}
+
+	// Per frame: 256 persistent allocations freed after the frame, and 256 two-descriptor tables.
+	void BenchmarkOperations() {
+		constexpr UINT FRAMES = 2000;
+		constexpr UINT FRAME_ALLOCATIONS = 256;
+		DescriptorAllocator allocator(1 << 16, 2, 1024);
+		UINT64 checksum = 0;
+		double time = test::MeasureMilliseconds([&] {
+			for (UINT frame = 1; frame <= FRAMES; frame++) {
+				UINT indices[FRAME_ALLOCATIONS];
+				for (UINT& index : indices) {
+					index = allocator.AllocatePersistent().value_or(0);
+				}
+				for (UINT index : indices) {
+					allocator.FreePersistentAfter(index, frame);
+				}
+				allocator.Reclaim(frame);
+				allocator.BeginFrame(frame % 2);
+				for (UINT i = 0; i < FRAME_ALLOCATIONS; i++) {
+					checksum += allocator.AllocateTransient(2).value_or(0);
+				}
+			}
+		});
+		CHECK(checksum != 0);
+		CHECK(allocator.GetPersistentUsedCount() == 0);
+		UINT operations = FRAMES * FRAME_ALLOCATIONS * 3;
+		std::printf("%u allocations and frees: %.1f ns each\n", operations, time * 1e6 / operations);
+	}
+}
+
+int main() {
+	TestPersistent();
+	TestTransient();
+	TestErrors();
+	TestRandomOperations();
+	BenchmarkOperations();
+	return test::Result();
+}
@@ -0,0 +1,193 @@
+#include "pch.h"
+#include "FrameRing.h"
+#include "test_utils.h"
+
+namespace {
+	// Simulated GPU: a thread that executes the submitted frames in order, each taking gpu_time, and then
+	// signals their fence values. Also counts, per frame context, the frames that are queued or executing,
+	// which must be zero whenever FrameRing hands the context out.
+	class MockFrameFence : public FrameFence {
+	public:
+		MockFrameFence(std::chrono::milliseconds gpu_time, UINT frame_count)
+			: gpu_time(gpu_time), frames_in_flight(frame_count) {
+			gpu = std::thread([this] { Execute(); });
+		}
+
+		~MockFrameFence() override {
+			{
+				std::lock_guard lock(mutex);
+				stopping = true;
+			}
+			condition.notify_all();
+			gpu.join();
+		}
+
+		// Tags the work submitted until the next Signal with the context that it was recorded into.
+		void Submit(UINT frame) {
+			submitted_frame = frame;
+		}
+
+		void Signal(UINT64 value) override {
+			std::lock_guard lock(mutex);
+			if (value <= (queue.empty() ? completed_value : queue.back().fence_value)) {
+				throw std::runtime_error("MockFrameFence: fence values must increase");
+			}
+			queue.push_back({ .fence_value = value, .frame = submitted_frame });
+			if (submitted_frame) {
+				frames_in_flight[*submitted_frame]++;
+			}
+			submitted_frame.reset();
+			condition.notify_all();
+		}
+
+		UINT64 GetCompletedValue() override {
+			std::lock_guard lock(mutex);
+			return completed_value;
+		}
+
+		void WaitForValue(UINT64 value) override {
+			std::unique_lock lock(mutex);
+			condition.wait(lock, [&] { return completed_value >= value; });
+		}
+
+		bool IsInFlight(UINT frame) {
+			std::lock_guard lock(mutex);
+			return frames_in_flight[frame] != 0;
+		}
+	private:
+		struct submission_t {
+			UINT64 fence_value;
+			std::optional<UINT> frame;
+		};
+
+		std::chrono::milliseconds gpu_time;
+		std::mutex mutex;
+		std::condition_variable condition;
+		std::deque<submission_t> queue;
+		UINT64 completed_value = 0;
+		std::vector<UINT> frames_in_flight;
+		std::optional<UINT> submitted_frame;
+		bool stopping = false;
+		std::thread gpu;
+
+		void Execute() {
+			std::unique_lock lock(mutex);
+			for (;;) {
+				condition.wait(lock, [&] { return stopping || !queue.empty(); });
+				if (queue.empty()) {
+					return;
+				}
+				lock.unlock();
+				std::this_thread::sleep_for(gpu_time);
+				lock.lock();
+				submission_t submission = queue.front();
+				queue.pop_front();
+				if (submission.frame) {
+					frames_in_flight[*submission.frame]--;
+				}
+				completed_value = submission.fence_value;
+				condition.notify_all();
+			}
+		}
+	};
+
+	// Fence that the test completes by hand; WaitForValue completes the fence up to the value it waits for.
+	class ManualFrameFence : public FrameFence {
+	public:
+		UINT64 signalled_value = 0;
+		UINT64 completed_value = 0;
+		std::vector<UINT64> waits;
+
+		void Signal(UINT64 value) override {
+			signalled_value = value;
+		}
+
+		UINT64 GetCompletedValue() override {
+			return completed_value;
+		}
+
+		void WaitForValue(UINT64 value) override {
+			CHECK(value <= signalled_value);
+			waits.push_back(value);
+			completed_value = std::max(completed_value, value);
+		}
+	};
+
+	// Hands out every context once without waiting, then waits for the frame that last used the next one.
+	void TestWaits() {
+		ManualFrameFence fence;
+		FrameRing ring(fence, 3);
+		CHECK(ring.GetFrameIndex() == 0);
+		CHECK(ring.GetFrameFenceValue() == 1);
+
+		ring.NextFrame();
+		ring.NextFrame();
+		CHECK(fence.waits.empty());
+		CHECK(ring.GetFrameIndex() == 2);
+		CHECK(ring.GetFrameFenceValue() == 3);
+
+		// The first context was last used by the frame that signals 1.
+		ring.NextFrame();
+		CHECK(ring.GetFrameIndex() == 0);
+		CHECK((fence.waits == std::vector<UINT64>{ 1 }));
+
+		// Once the GPU has caught up, the next context is handed out without waiting.
+		fence.completed_value = 4;
+		ring.NextFrame();
+		CHECK(fence.waits.size() == 1);
+		CHECK(ring.GetStats().frames == 4);
+		CHECK(ring.GetStats().stalls == 1);
+
+		ring.WaitForIdle();
+		CHECK(fence.signalled_value == 5);
+		CHECK(fence.completed_value == 5);
+		// WaitForIdle uses a fence value of its own.
+		CHECK(ring.GetFrameFenceValue() == 6);
+
+		CHECK_THROWS(FrameRing(fence, 0));
+	}
+
+	// Runs frames that take as long to record as to execute against the simulated GPU. With a single context
+	// the CPU waits for every frame; with more, recording overlaps with execution and halves the frame time.
+	double MeasureFrameTime(UINT frame_count) {
+		constexpr std::chrono::milliseconds FRAME_TIME(8);
+		constexpr int FRAMES = 30;
+		MockFrameFence fence(FRAME_TIME, frame_count);
+		FrameRing ring(fence, frame_count);
+		bool reused_early = false;
+		double total_time = test::MeasureMilliseconds([&] {
+			for (int i = 0; i < FRAMES; i++) {
+				UINT frame = ring.GetFrameIndex();
+				reused_early |= fence.IsInFlight(frame);
+				std::this_thread::sleep_for(FRAME_TIME);
+				fence.Submit(frame);
+				ring.NextFrame();
+			}
+			ring.WaitForIdle();
+		});
+		CHECK(!reused_early);
+		for (UINT frame = 0; frame < frame_count; frame++) {
+			CHECK(!fence.IsInFlight(frame));
+		}
+
+		const frame_ring_stats_t& stats = ring.GetStats();
+		double frame_time = total_time / FRAMES;
+		std::printf("%u contexts: %.1f ms per frame, %llu of %llu frames waited for the GPU\n", frame_count,
+			frame_time, static_cast<unsigned long long>(stats.stalls), static_cast<unsigned long long>(stats.frames));
+		return frame_time;
+	}
+
+	void TestOverlap() {
+		double serial_time = MeasureFrameTime(1);
+		double overlapped_time = MeasureFrameTime(2);
+		MeasureFrameTime(3);
+		CHECK(serial_time > 15.0);
+		CHECK(overlapped_time < serial_time * 0.75);
+	}
+}
+
+int main() {
+	TestWaits();
+	TestOverlap();
+	return test::Result();
+}
@@ -0,0 +1,256 @@
+#include "pch.h"
+#include "MeshSimplifier.h"
+#include "test_utils.h"
+
+namespace {
+	// A gently curved grid of size by size quads over x and z, with one texture stretched over it.
+	void MakeGrid(UINT size, std::vector<vertex_t>& vertices, std::vector<UINT>& indices) {
+		for (UINT z = 0; z <= size; z++) {
+			for (UINT x = 0; x <= size; x++) {
+				vertices.push_back({
+					.position = { FLOAT(x), 2.0f * std::sin(x * 0.1f) * std::cos(z * 0.1f), FLOAT(z) },
+					.color = { 1.0f, 1.0f, 1.0f, 1.0f },
+					.tex_coord = { x / FLOAT(size), z / FLOAT(size) }
+				});
+			}
+		}
+		for (UINT z = 0; z < size; z++) {
+			for (UINT x = 0; x < size; x++) {
+				UINT corner = z * (size + 1) + x;
+				indices.insert(indices.end(), { corner, corner + size + 2, corner + 1 });
+				indices.insert(indices.end(), { corner, corner + size + 1, corner + size + 2 });
+			}
+		}
+	}
+
+	void TestGenerateLodChain() {
+		std::vector<vertex_t> vertices;
+		std::vector<UINT> indices;
+		MakeGrid(64, vertices, indices);
+		std::vector<UINT> full_detail = indices;
+		std::vector<lod_level_t> chunk_levels;
+		std::vector<lod_level_t> levels = GenerateLodChain(indices, vertices, {}, 4, chunk_levels);
+		CHECK(levels.size() == 4);
+		CHECK(levels[0].first_index == 0 && levels[0].index_count == full_detail.size() && levels[0].error == 0.0f);
+		for (std::size_t level = 1; level < levels.size(); level++) {
+			// Each level follows the previous one, has fewer triangles and at least its error.
+			CHECK(levels[level].first_index == levels[level - 1].first_index + levels[level - 1].index_count);
+			CHECK(levels[level].index_count % 3 == 0);
+			CHECK(levels[level].index_count < levels[level - 1].index_count);
+			CHECK(levels[level].error >= levels[level - 1].error);
+		}
+		CHECK(levels.back().first_index + levels.back().index_count == indices.size());
+		for (UINT index : indices) {
+			CHECK(index < vertices.size());
+		}
+
+		// Level 0 holds the same triangles, regrouped by chunk.
+		auto triangles = [](std::span<const UINT> source) {
+			std::vector<std::array<UINT, 3>> result;
+			for (std::size_t i = 0; i < source.size(); i += 3) {
+				result.push_back({ source[i], source[i + 1], source[i + 2] });
+			}
+			std::sort(result.begin(), result.end());
+			return result;
+		};
+		CHECK(triangles(std::span(indices).first(full_detail.size())) == triangles(full_detail));
+
+		// The chunks split every level into consecutive ranges in the same order, with at most its error.
+		CHECK(chunk_levels.size() > levels.size() && chunk_levels.size() % levels.size() == 0);
+		std::size_t chunk_count = chunk_levels.size() / levels.size();
+		for (std::size_t level = 0; level < levels.size(); level++) {
+			UINT next_index = levels[level].first_index;
+			FLOAT error = 0.0f;
+			for (std::size_t chunk = 0; chunk < chunk_count; chunk++) {
+				const lod_level_t& lod = chunk_levels[chunk * levels.size() + level];
+				CHECK(lod.first_index == next_index && lod.index_count % 3 == 0);
+				next_index += lod.index_count;
+				error = std::max(error, lod.error);
+			}
+			CHECK(next_index == levels[level].first_index + levels[level].index_count);
+			CHECK(error == levels[level].error);
+		}
+	}
+
+	// Distance from p to the nearest point of the triangle abc: to the plane of the triangle when p projects
+	// inside it, otherwise to the nearest edge.
+	double PointTriangleDistance(const FLOAT (&p)[3], const FLOAT (&a)[3], const FLOAT (&b)[3], const FLOAT (&c)[3]) {
+		using vector_t = std::array<double, 3>;
+		auto sub = [](const auto& u, const auto& v) { return vector_t{ u[0] - v[0], u[1] - v[1], u[2] - v[2] }; };
+		auto dot = [](const vector_t& u, const vector_t& v) { return u[0] * v[0] + u[1] * v[1] + u[2] * v[2]; };
+		auto cross = [](const vector_t& u, const vector_t& v) {
+			return vector_t{ u[1] * v[2] - u[2] * v[1], u[2] * v[0] - u[0] * v[2], u[0] * v[1] - u[1] * v[0] };
+		};
+		auto segment_distance = [&](const FLOAT (&from)[3], const FLOAT (&to)[3]) {
+			vector_t edge = sub(to, from), offset = sub(p, from);
+			double length_sq = dot(edge, edge);
+			double t = length_sq > 0.0 ? std::clamp(dot(offset, edge) / length_sq, 0.0, 1.0) : 0.0;
+			vector_t nearest = { from[0] + t * edge[0], from[1] + t * edge[1], from[2] + t * edge[2] };
+			vector_t difference = sub(p, nearest);
+			return std::sqrt(dot(difference, difference));
+		};
+
+		vector_t normal = cross(sub(b, a), sub(c, a));
+		double normal_length = std::sqrt(dot(normal, normal));
+		if (normal_length > 0.0) {
+			vector_t offset = sub(p, a);
+			bool inside = dot(cross(sub(b, a), sub(p, a)), normal) >= 0.0 &&
+				dot(cross(sub(c, b), sub(p, b)), normal) >= 0.0 && dot(cross(sub(a, c), sub(p, c)), normal) >= 0.0;
+			if (inside) {
+				return std::abs(dot(offset, normal)) / normal_length;
+			}
+		}
+		return std::min({ segment_distance(a, b), segment_distance(b, c), segment_distance(c, a) });
+	}
+
+	// Every vertex of the full-detail mesh is within the reported error of the nearest triangle of each level.
+	void TestLevelErrors() {
+		std::vector<vertex_t> vertices;
+		std::vector<UINT> indices;
+		MakeGrid(48, vertices, indices);
+		std::vector<lod_level_t> chunk_levels;
+		std::vector<lod_level_t> levels = GenerateLodChain(indices, vertices, {}, 4, chunk_levels);
+		CHECK(levels.size() == 4);
+		for (std::size_t level = 1; level < levels.size(); level++) {
+			const lod_level_t& lod = levels[level];
+			double largest_distance = 0.0;
+			for (const vertex_t& vertex : vertices) {
+				double distance = DBL_MAX;
+				for (UINT i = lod.first_index; i < lod.first_index + lod.index_count; i += 3) {
+					distance = std::min(distance, PointTriangleDistance(vertex.position, vertices[indices[i]].position,
+						vertices[indices[i + 1]].position, vertices[indices[i + 2]].position));
+				}
+				largest_distance = std::max(largest_distance, distance);
+			}
+			std::printf("LOD %zu: %u triangles, error %.4f, largest distance %.4f\n", level, lod.index_count / 3,
+				lod.error, largest_distance);
+			CHECK(largest_distance > 0.0);
+			CHECK(largest_distance <= lod.error * 1.0001 + 1e-5);
+			// The error is the measured distance, not a bound far above it.
+			CHECK(largest_distance >= lod.error * 0.9999 - 1e-5);
+		}
+	}
+
+	// A flat grid whose left and right halves use different parts of the texture, so that the vertices of
+	// the middle column are split into a wedge per half. The border and the middle column zigzag, so that
+	// removing any vertex of either would change the outline or move the seam. side receives 0 for the
+	// vertices of the left half and 1 for those of the right one.
+	void MakeSeamedGrid(UINT size, std::vector<vertex_t>& vertices, std::vector<UINT>& indices,
+		std::vector<UINT>& side) {
+		const UINT seam = size / 2;
+		std::vector<UINT> left_vertices((size + 1) * (size + 1)), right_vertices((size + 1) * (size + 1));
+		for (UINT z = 0; z <= size; z++) {
+			for (UINT x = 0; x <= size; x++) {
+				FLOAT position_x = FLOAT(x), position_z = FLOAT(z);
+				if (x == 0 || x == size) {
+					position_x += (x == 0 ? -0.5f : 0.5f) * (z % 2);
+				}
+				else if (x == seam) {
+					position_x += 0.5f * (z % 2);
+				}
+				if (z == 0 || z == size) {
+					position_z += (z == 0 ? -0.5f : 0.5f) * (x % 2);
+				}
+				UINT grid_index = z * (size + 1) + x;
+				for (UINT half = 0; half < 2; half++) {
+					if ((half == 0 && x > seam) || (half == 1 && x < seam)) {
+						continue;
+					}
+					(half == 0 ? left_vertices : right_vertices)[grid_index] = static_cast<UINT>(vertices.size());
+					side.push_back(half);
+					vertices.push_back({
+						.position = { position_x, 0.0f, position_z },
+						.color = { 1.0f, 1.0f, 1.0f, 1.0f },
+						.tex_coord = { 0.5f * half + 0.5f * x / size, FLOAT(z) / size }
+					});
+				}
+			}
+		}
+		for (UINT z = 0; z < size; z++) {
+			for (UINT x = 0; x < size; x++) {
+				const std::vector<UINT>& half = x < seam ? left_vertices : right_vertices;
+				UINT corner = z * (size + 1) + x;
+				UINT corners[4] = { half[corner], half[corner + 1], half[corner + size + 2], half[corner + size + 1] };
+				indices.insert(indices.end(), { corners[0], corners[2], corners[1] });
+				indices.insert(indices.end(), { corners[0], corners[3], corners[2] });
+			}
+		}
+	}
+
+	// The flat inside of the grid is simplified, while every border and seam vertex survives, and no triangle
+	// uses wedges of both halves of the seam.
+	void TestBordersAndSeams() {
+		constexpr UINT SIZE = 24;
+		std::vector<vertex_t> vertices;
+		std::vector<UINT> indices;
+		std::vector<UINT> side;
+		MakeSeamedGrid(SIZE, vertices, indices, side);
+		std::vector<lod_level_t> chunk_levels;
+		std::vector<lod_level_t> levels = GenerateLodChain(indices, vertices,
+			{ .level_count = 3, .target_error = 0.001f }, 1, chunk_levels);
+		CHECK(levels.size() > 1);
+
+		for (std::size_t level = 1; level < levels.size(); level++) {
+			const lod_level_t& lod = levels[level];
+			CHECK(lod.index_count < levels[0].index_count);
+			// Only vertices inside the halves, on the plane of the grid, are removed.
+			CHECK(lod.error < 1e-4f);
+
+			std::vector<BYTE> used(vertices.size(), 0);
+			bool halves_kept = true;
+			for (UINT i = lod.first_index; i < lod.first_index + lod.index_count; i += 3) {
+				used[indices[i]] = used[indices[i + 1]] = used[indices[i + 2]] = 1;
+				halves_kept = halves_kept && side[indices[i]] == side[indices[i + 1]] &&
+					side[indices[i + 1]] == side[indices[i + 2]];
+			}
+			CHECK(halves_kept);
+
+			bool borders_kept = true, seams_kept = true;
+			for (std::size_t vertex = 0; vertex < vertices.size(); vertex++) {
+				const FLOAT* position = vertices[vertex].position;
+				bool border = position[0] <= 0.0f || position[0] >= SIZE || position[2] <= 0.0f || position[2] >= SIZE;
+				borders_kept = borders_kept && (!border || used[vertex]);
+				// The wedges of a seam position are created one after the other.
+				if (side[vertex] == 0 && vertex + 1 < vertices.size() && side[vertex + 1] == 1) {
+					seams_kept = seams_kept && used[vertex] && used[vertex + 1];
+				}
+			}
+			CHECK(borders_kept);
+			CHECK(seams_kept);
+		}
+	}
+
+	void TestSelectLodLevel() {
+		std::vector<lod_level_t> levels = {
+			{ .first_index = 0, .index_count = 3000, .error = 0.0f },
+			{ .first_index = 3000, .index_count = 1500, .error = 0.01f },
+			{ .first_index = 4500, .index_count = 750, .error = 0.04f },
+			{ .first_index = 5250, .index_count = 375, .error = 0.16f }
+		};
+		constexpr FLOAT PIXELS_PER_UNIT = 1000.0f;
+		CHECK(SelectLodLevel(levels, 0.0f, PIXELS_PER_UNIT, 1.0f) == 0);
+		CHECK(SelectLodLevel(levels, 5.0f, PIXELS_PER_UNIT, 1.0f) == 0);
+		// An error of 0.01 covers one pixel at a distance of 10.
+		CHECK(SelectLodLevel(levels, 10.0f, PIXELS_PER_UNIT, 1.0f) == 1);
+		CHECK(SelectLodLevel(levels, 40.0f, PIXELS_PER_UNIT, 1.0f) == 2);
+		CHECK(SelectLodLevel(levels, 1000.0f, PIXELS_PER_UNIT, 1.0f) == 3);
+		// A larger allowed error reaches the same levels closer.
+		CHECK(SelectLodLevel(levels, 10.0f, PIXELS_PER_UNIT, 4.0f) == 2);
+		CHECK(SelectLodLevel(std::span<const lod_level_t>(levels).first(1), 1000.0f, PIXELS_PER_UNIT, 1.0f) == 0);
+
+		UINT previous = 0;
+		for (FLOAT distance = 0.0f; distance < 500.0f; distance += 0.5f) {
+			UINT level = SelectLodLevel(levels, distance, PIXELS_PER_UNIT, 1.0f);
+			CHECK(level >= previous);
+			previous = level;
+		}
+	}
+}
+
+int main() {
+	TestGenerateLodChain();
+	TestLevelErrors();
+	TestBordersAndSeams();
+	TestSelectLodLevel();
+	return test::Result();
+}
@@ -0,0 +1,164 @@
+#include "pch.h"
+#include "MeshletBuilder.h"
+#include "test_utils.h"
+
+using namespace DirectX;
+
+namespace {
+	struct mesh_t {
+		std::vector<XMFLOAT3> positions;
+		std::vector<UINT> indices;
+	};
+
+	// Spheres of radius 1, spaced 4 units apart on a count by count grid over x and z, with their triangles
+	// facing outwards.
+	mesh_t MakeSpheres(UINT count) {
+		constexpr UINT RINGS = 32, SEGMENTS = 64;
+		mesh_t mesh;
+		for (UINT sphere = 0; sphere < count * count; sphere++) {
+			XMFLOAT3 center = { 4.0f * (sphere % count), 1.0f, 4.0f * (sphere / count) };
+			UINT first_vertex = static_cast<UINT>(mesh.positions.size());
+			for (UINT ring = 0; ring <= RINGS; ring++) {
+				FLOAT polar = XM_PI * ring / RINGS;
+				for (UINT segment = 0; segment <= SEGMENTS; segment++) {
+					FLOAT azimuth = 2.0f * XM_PI * segment / SEGMENTS;
+					mesh.positions.push_back({ center.x + std::sin(polar) * std::cos(azimuth),
+						center.y + std::cos(polar), center.z + std::sin(polar) * std::sin(azimuth) });
+				}
+			}
+			// In tiles of 4 rings by 8 segments, as a vertex cache optimizer would order them, so that meshlets
+			// cover patches of the surface.
+			for (UINT tile = 0; tile < RINGS * SEGMENTS / 32; tile++) {
+				for (UINT quad = 0; quad < 32; quad++) {
+					UINT ring = tile / (SEGMENTS / 8) * 4 + quad / 8;
+					UINT segment = tile % (SEGMENTS / 8) * 8 + quad % 8;
+					UINT corner = first_vertex + ring * (SEGMENTS + 1) + segment;
+					UINT below = corner + SEGMENTS + 1;
+					// Triangles at the poles collapse to lines, which are left out.
+					if (ring != 0) {
+						mesh.indices.insert(mesh.indices.end(), { corner, corner + 1, below });
+					}
+					if (ring != RINGS - 1) {
+						mesh.indices.insert(mesh.indices.end(), { corner + 1, below + 1, below });
+					}
+				}
+			}
+		}
+		return mesh;
+	}
+
+	// Whether the triangle is front-facing as seen from camera_position and has a corner inside the frustum,
+	// or straddles it; these are the triangles that CullMeshlets must not reject.
+	bool MayBeVisible(const mesh_t& mesh, std::size_t first_index, FXMMATRIX view_projection,
+		FXMVECTOR camera_position) {
+		XMVECTOR p[3];
+		XMFLOAT4 clip[3];
+		for (std::size_t corner = 0; corner < 3; corner++) {
+			p[corner] = XMLoadFloat3(&mesh.positions[mesh.indices[first_index + corner]]);
+			XMStoreFloat4(&clip[corner], XMVector4Transform(XMVectorSelect(p[corner], g_XMOne, g_XMSelect0001),
+				view_projection));
+		}
+		XMVECTOR normal = XMVector3Cross(XMVectorSubtract(p[1], p[0]), XMVectorSubtract(p[2], p[0]));
+		if (XMVectorGetX(XMVector3Dot(XMVectorSubtract(p[0], camera_position), normal)) >= 0.0f) {
+			return false;
+		}
+		auto all = [&](auto outside) {
+			return outside(clip[0]) && outside(clip[1]) && outside(clip[2]);
+		};
+		return !(all([](XMFLOAT4 c) { return c.x < -c.w; }) || all([](XMFLOAT4 c) { return c.x > c.w; }) ||
+			all([](XMFLOAT4 c) { return c.y < -c.w; }) || all([](XMFLOAT4 c) { return c.y > c.w; }) ||
+			all([](XMFLOAT4 c) { return c.z < 0.0f; }) || all([](XMFLOAT4 c) { return c.z > c.w; }));
+	}
+
+	void TestBuildMeshlets(const mesh_t& mesh, const meshlet_data_t& data) {
+		UINT next_index = 0;
+		for (const meshlet_t& meshlet : data.meshlets) {
+			// The meshlets cover the index list in order and stay within the limits.
+			CHECK(meshlet.first_index == next_index);
+			CHECK(meshlet.triangle_count > 0 && meshlet.triangle_count <= MESHLET_MAX_TRIANGLES);
+			CHECK(meshlet.vertex_count <= MESHLET_MAX_VERTICES);
+			CHECK(meshlet.cone_cutoff <= 1.0f);
+			next_index += meshlet.triangle_count * 3;
+			for (UINT i = 0; i < meshlet.triangle_count * 3; i++) {
+				BYTE local = data.triangles[meshlet.triangle_offset + i];
+				CHECK(local < meshlet.vertex_count);
+				CHECK(data.vertices[meshlet.vertex_offset + local] == mesh.indices[meshlet.first_index + i]);
+				XMVECTOR position = XMLoadFloat3(&mesh.positions[mesh.indices[meshlet.first_index + i]]);
+				CHECK(XMVectorGetX(XMVector3Length(XMVectorSubtract(position, XMLoadFloat3(&meshlet.center)))) <=
+					meshlet.radius * 1.0001f + 1e-5f);
+			}
+		}
+		CHECK(next_index == mesh.indices.size());
+	}
+
+	// A camera at eye height walks twice around the middle of the grid of spheres, turning as it goes, and
+	// culls the meshlets at each step, both against the frustum and the normal cones and against the frustum
+	// alone. Reports how many triangles each rejects and how long a call takes.
+	void TestCameraWalk(const mesh_t& mesh, const meshlet_data_t& data) {
+		constexpr UINT STEPS = 360;
+		constexpr FLOAT WALK_RADIUS = 7.0f;
+		XMFLOAT3 middle = { 10.0f, 1.0f, 10.0f };
+		// Without their normal cones, the meshlets are culled against the frustum only.
+		std::vector<meshlet_t> frustum_only = data.meshlets;
+		for (meshlet_t& meshlet : frustum_only) {
+			meshlet.cone_cutoff = 1.0f;
+		}
+
+		std::size_t total = 0, visible = 0, frustum_visible = 0, wrongly_culled = 0;
+		double milliseconds = 0.0, frustum_milliseconds = 0.0;
+		std::vector<UINT> culled, frustum_culled;
+		std::vector<bool> kept(data.meshlets.size());
+		for (UINT step = 0; step < STEPS; step++) {
+			FLOAT angle = 4.0f * XM_PI * step / STEPS;
+			XMVECTOR camera_position = XMVectorSet(middle.x + WALK_RADIUS * std::cos(angle), middle.y,
+				middle.z + WALK_RADIUS * std::sin(angle), 1.0f);
+			// Looks ahead along the walk, turned a little towards the middle.
+			FLOAT yaw = -angle + 0.3f;
+			XMMATRIX view_projection = XMMatrixMultiply(XMMatrixMultiply(
+				XMMatrixTranslation(-XMVectorGetX(camera_position), -middle.y, -XMVectorGetZ(camera_position)),
+				XMMatrixRotationY(yaw)), XMMatrixPerspectiveFovLH(XM_PI / 4.0f, 16.0f / 9.0f, 0.1f, 100.0f));
+
+			culled.clear();
+			frustum_culled.clear();
+			milliseconds += test::MeasureMilliseconds([&] {
+				visible += CullMeshlets(data.meshlets, view_projection, camera_position, culled);
+			});
+			frustum_milliseconds += test::MeasureMilliseconds([&] {
+				frustum_visible += CullMeshlets(frustum_only, view_projection, camera_position, frustum_culled);
+			});
+			total += mesh.indices.size() / 3;
+
+			// Checking every triangle that was culled is slow, so only some of the steps are checked.
+			if (step % 6 != 0) {
+				continue;
+			}
+			std::fill(kept.begin(), kept.end(), false);
+			for (UINT i : culled) {
+				kept[i] = true;
+			}
+			for (std::size_t i = 0; i < data.meshlets.size(); i++) {
+				const meshlet_t& meshlet = data.meshlets[i];
+				for (UINT triangle = 0; triangle < meshlet.triangle_count && !kept[i]; triangle++) {
+					wrongly_culled += MayBeVisible(mesh, meshlet.first_index + triangle * 3, view_projection,
+						camera_position);
+				}
+			}
+		}
+
+		std::printf("camera walk over %zu meshlets: frustum rejects %.1f%% of triangles, %.3f ms per call\n",
+			data.meshlets.size(), 100.0 - 100.0 * frustum_visible / total, frustum_milliseconds / STEPS);
+		std::printf("camera walk over %zu meshlets: frustum and cones reject %.1f%% of triangles, %.3f ms per call\n",
+			data.meshlets.size(), 100.0 - 100.0 * visible / total, milliseconds / STEPS);
+		CHECK(wrongly_culled == 0);
+		CHECK(visible < frustum_visible);
+		CHECK(frustum_visible < total);
+	}
+}
+
+int main() {
+	mesh_t mesh = MakeSpheres(6);
+	meshlet_data_t data = BuildMeshlets(mesh.indices, mesh.positions);
+	TestBuildMeshlets(mesh, data);
+	TestCameraWalk(mesh, data);
+	return test::Result();
+}
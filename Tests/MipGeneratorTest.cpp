@@ -0,0 +1,106 @@
+#include "pch.h"
+#include "MipGenerator.h"
+#include "PngDecoder.h"
+#include "test_png.h"
+#include "test_utils.h"
+#include <thread>
+
+namespace {
+	// Every level halves the previous one, rounding down to at least one pixel, with rows and levels placed
+	// at the alignments that the copies into a texture need.
+	void TestLevelSizes() {
+		CHECK(GetMipLevelCount(1, 1) == 1);
+		CHECK(GetMipLevelCount(256, 1) == 9);
+		CHECK(GetMipLevelCount(37, 300) == 9);
+
+		texture_data_t texture = AllocateMipChain(37, 300, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT,
+			D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+		CHECK(texture.format == DXGI_FORMAT_R8G8B8A8_UNORM);
+		CHECK(texture.levels.size() == 9);
+		std::size_t end = 0;
+		for (UINT level = 0; level < texture.levels.size(); level++) {
+			const texture_level_t& mip = texture.levels[level];
+			CHECK(mip.width == std::max(37u >> level, 1u) && mip.height == std::max(300u >> level, 1u));
+			CHECK(mip.row_count == mip.height);
+			CHECK(mip.row_pitch >= mip.width * 4 && mip.row_pitch % D3D12_TEXTURE_DATA_PITCH_ALIGNMENT == 0);
+			CHECK(mip.offset >= end && mip.offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT == 0);
+			end = mip.offset + std::size_t(mip.row_pitch) * mip.row_count;
+		}
+		CHECK(texture.levels.back().width == 1 && texture.levels.back().height == 1);
+		CHECK(texture.data.size() == end);
+		CHECK_THROWS(AllocateMipChain(0, 4));
+	}
+
+	void Fill(texture_data_t& texture, const BYTE (&color)[4]) {
+		const texture_level_t& top = texture.levels[0];
+		for (UINT y = 0; y < top.height; y++) {
+			for (UINT x = 0; x < top.width; x++) {
+				memcpy(&texture.data[top.offset + std::size_t(y) * top.row_pitch + x * 4], color, 4);
+			}
+		}
+	}
+
+	// Largest difference of a channel of any pixel of any level from the color.
+	int MaxDifference(const texture_data_t& texture, const BYTE (&color)[4]) {
+		int difference = 0;
+		for (const texture_level_t& level : texture.levels) {
+			for (UINT y = 0; y < level.height; y++) {
+				const BYTE* row = &texture.data[level.offset + std::size_t(y) * level.row_pitch];
+				for (UINT x = 0; x < level.width * 4; x++) {
+					difference = std::max(difference, std::abs(row[x] - color[x % 4]));
+				}
+			}
+		}
+		return difference;
+	}
+
+	// The filter weights of every destination pixel add up to one, at the edges as well, so a constant image
+	// stays constant down to the last level, up to the rounding of the sRGB conversion.
+	void TestConstantImage() {
+		const BYTE color[4] = { 200, 90, 17, 128 };
+		for (mip_filter_t filter : { mip_filter_t::BOX, mip_filter_t::KAISER }) {
+			for (bool wrap : { false, true }) {
+				for (bool srgb : { false, true }) {
+					texture_data_t texture = AllocateMipChain(37, 23);
+					Fill(texture, color);
+					GenerateMipLevels(texture, { .filter = filter, .srgb = srgb, .wrap = wrap, .thread_count = 3 });
+					CHECK(MaxDifference(texture, color) <= 1);
+				}
+			}
+		}
+	}
+
+	// Decoding a PNG straight into the first level and generating the levels below it, as TextureAsset does
+	// for a texture without a cache, at several image sizes.
+	void BenchmarkDecodeAndMips() {
+		UINT thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+		std::printf("%6s %10s %12s %12s\n", "size", "decode ms", "mips 1t ms", "mips Nt ms");
+		for (UINT size : { 256u, 512u, 1024u, 2048u }) {
+			std::vector<BYTE> rgba(std::size_t(size) * size * 4);
+			for (std::size_t i = 0; i < rgba.size(); i++) {
+				rgba[i] = static_cast<BYTE>((i / 4 % size) ^ (i / 4 / size) ^ (i % 4 * 85));
+			}
+			std::vector<BYTE> png = test::EncodePng(size, size, rgba);
+
+			texture_data_t texture = AllocateMipChain(size, size, D3D12_TEXTURE_DATA_PITCH_ALIGNMENT,
+				D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT);
+			double decode_time = test::MeasureMilliseconds([&] {
+				DecodePng(png, texture.data.data() + texture.levels[0].offset, texture.levels[0].row_pitch);
+			});
+			double single_time = test::MeasureMilliseconds([&] {
+				GenerateMipLevels(texture, { .thread_count = 1 });
+			});
+			double threaded_time = test::MeasureMilliseconds([&] {
+				GenerateMipLevels(texture, { .thread_count = thread_count });
+			});
+			std::printf("%6u %10.2f %12.2f %12.2f\n", size, decode_time, single_time, threaded_time);
+		}
+	}
+}
+
+int main() {
+	TestLevelSizes();
+	TestConstantImage();
+	BenchmarkDecodeAndMips();
+	return test::Result();
+}
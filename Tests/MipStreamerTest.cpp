@@ -0,0 +1,179 @@
+#include "pch.h"
+#include "MipStreamer.h"
+#include "test_utils.h"
+
+using namespace DirectX;
+
+namespace {
+	// Vertical field of view of 45 degrees on a 1920x1080 viewport.
+	constexpr FLOAT TAN_HALF_HEIGHT = 0.41421356f;
+	constexpr FLOAT TAN_HALF_WIDTH = TAN_HALF_HEIGHT * 16.0f / 9.0f;
+	constexpr FLOAT PIXELS_PER_UNIT = 540.0f / TAN_HALF_HEIGHT;
+
+	// Levels of a square RGBA8 texture, laid out one after the other.
+	std::vector<texture_level_t> SquareLevels(UINT size) {
+		std::vector<texture_level_t> levels;
+		std::size_t offset = 0;
+		for (UINT width = size; width > 0; width /= 2) {
+			levels.push_back({ .width = width, .height = width, .offset = offset, .row_pitch = width * 4,
+				.row_count = width });
+			offset += std::size_t(width) * width * 4;
+		}
+		return levels;
+	}
+
+	stream_view_t View(XMFLOAT3 position, FLOAT yaw) {
+		return {
+			.position = position,
+			.direction = { -std::sin(yaw), 0.0f, std::cos(yaw) },
+			.half_angle = std::atan(std::sqrt(TAN_HALF_WIDTH * TAN_HALF_WIDTH + TAN_HALF_HEIGHT * TAN_HALF_HEIGHT)),
+			.pixels_per_unit = PIXELS_PER_UNIT
+		};
+	}
+
+	// A vertical square wall of side 4, facing the origin from distance units away in the direction of yaw,
+	// with one texture across it.
+	texture_usage_t Wall(FLOAT yaw, FLOAT distance) {
+		XMFLOAT3 center = { -std::sin(yaw) * distance, 0.0f, std::cos(yaw) * distance };
+		FLOAT half_x = std::abs(std::cos(yaw)) * 2.0f, half_z = std::abs(std::sin(yaw)) * 2.0f;
+		return {
+			.aabb_min = { center.x - half_x, -2.0f, center.z - half_z },
+			.aabb_max = { center.x + half_x, 2.0f, center.z + half_z },
+			.uv_per_unit = 0.25f
+		};
+	}
+
+	void TestComputeTextureUsage() {
+		// A 2x2 square with material 0 stretched over it, and a triangle using material 2.
+		std::vector<vertex_t> vertices = {
+			{ .position = { 0.0f, 0.0f, 0.0f }, .tex_coord = { 0.0f, 0.0f }, .material = 0 },
+			{ .position = { 2.0f, 0.0f, 0.0f }, .tex_coord = { 1.0f, 0.0f }, .material = 0 },
+			{ .position = { 2.0f, 2.0f, 0.0f }, .tex_coord = { 1.0f, 1.0f }, .material = 0 },
+			{ .position = { 0.0f, 2.0f, 0.0f }, .tex_coord = { 0.0f, 1.0f }, .material = 0 },
+			{ .position = { 5.0f, 0.0f, 1.0f }, .tex_coord = { 0.0f, 0.0f }, .material = 2 }
+		};
+		std::vector<UINT> indices = { 0, 1, 2, 0, 2, 3, 4, 1, 2 };
+		std::vector<UINT> material_textures = { 0, 1, 2 };
+		std::vector<texture_usage_t> usage = ComputeTextureUsage(vertices, indices, material_textures);
+		CHECK(usage.size() == 3);
+		CHECK(std::abs(usage[0].uv_per_unit - 0.5f) < 1e-6f);
+		CHECK(usage[0].aabb_min.x == 0.0f && usage[0].aabb_max.x == 2.0f && usage[0].aabb_max.y == 2.0f);
+		// Unused textures have empty bounds.
+		CHECK(usage[1].uv_per_unit == 0.0f && usage[1].aabb_min.x > usage[1].aabb_max.x);
+		CHECK(usage[2].aabb_min.x == 2.0f && usage[2].aabb_max.x == 5.0f && usage[2].aabb_max.z == 1.0f);
+
+		// Materials sharing a texture add up to one usage.
+		material_textures = { 1, 0, 1 };
+		std::vector<texture_usage_t> shared = ComputeTextureUsage(vertices, indices, material_textures);
+		CHECK(shared.size() == 2);
+		CHECK(shared[0].uv_per_unit == 0.0f && shared[0].aabb_min.x > shared[0].aabb_max.x);
+		CHECK(shared[1].aabb_min.x == 0.0f && shared[1].aabb_max.x == 5.0f && shared[1].aabb_max.z == 1.0f);
+		CHECK(shared[1].uv_per_unit > 0.0f && shared[1].uv_per_unit < usage[0].uv_per_unit);
+
+		indices.push_back(0);
+		indices.push_back(1);
+		indices.push_back(2);
+		vertices[0].material = 3;
+		CHECK_THROWS(ComputeTextureUsage(vertices, indices, material_textures));
+	}
+
+	void TestTargets() {
+		std::vector<texture_level_t> levels = SquareLevels(1024);
+		// In front of the camera, behind it, and around it.
+		std::vector<texture_usage_t> usage = { Wall(0.0f, 10.0f), Wall(XM_PI, 10.0f), Wall(0.0f, 0.0f) };
+		usage[2].aabb_min.z = -2.0f;
+		usage[2].aabb_max.z = 2.0f;
+		MipStreamer streamer(levels, usage);
+		CHECK(streamer.GetBootLevel() == 4);
+
+		// 256 texels per unit over 130 pixels per unit.
+		streamer.UpdateTargets(View({ 0.0f, 0.0f, 0.0f }, 0.0f));
+		CHECK(streamer.GetTargetLevel(0) == 0);
+		CHECK(streamer.GetTargetLevel(1) == 2);
+		CHECK(streamer.GetTargetLevel(2) == 0);
+		streamer.UpdateTargets(View({ 0.0f, 0.0f, 0.0f }, XM_PI));
+		CHECK(streamer.GetTargetLevel(0) == 2);
+		CHECK(streamer.GetTargetLevel(1) == 0);
+		// Just outside the edge of the view, and just inside.
+		streamer.UpdateTargets(View({ 0.0f, 0.0f, 0.0f }, 1.0f));
+		CHECK(streamer.GetTargetLevel(0) == 2);
+		streamer.UpdateTargets(View({ 0.0f, 0.0f, 0.0f }, 0.8f));
+		CHECK(streamer.GetTargetLevel(0) == 0);
+
+		MipStreamer unweighted(levels, usage, { .outside_view_scale = 1.0f });
+		unweighted.UpdateTargets(View({ 0.0f, 0.0f, 0.0f }, 0.0f));
+		CHECK(unweighted.GetTargetLevel(1) == 0);
+	}
+
+	struct camera_path_result_t {
+		// Frames times textures in view, and how many of those were resident down to the level that they
+		// need in view.
+		UINT visible = 0;
+		UINT visible_at_target = 0;
+		UINT64 upload_bytes = 0;
+		UINT64 evictions = 0;
+	};
+
+	// A camera standing in the middle of a ring of walls turns around twice, one turn every 10 seconds at 60
+	// frames per second. Uploads complete one frame after they are scheduled, as on the GPU.
+	camera_path_result_t SimulateCameraPath(FLOAT outside_view_scale) {
+		constexpr UINT WALL_COUNT = 16;
+		constexpr UINT FRAMES = 1200;
+		constexpr FLOAT TURN_FRAMES = 600.0f;
+		std::vector<texture_level_t> levels = SquareLevels(1024);
+		std::vector<texture_usage_t> usage;
+		for (UINT i = 0; i < WALL_COUNT; i++) {
+			usage.push_back(Wall(2.0f * XM_PI * i / WALL_COUNT, 10.0f));
+		}
+		// Room for six of the sixteen textures at full resolution; four are in view at a time.
+		MipStreamer streamer(levels, usage, {
+			.budget = std::size_t(32) << 20,
+			.upload_size = std::size_t(4) << 20,
+			.outside_view_scale = outside_view_scale
+		});
+
+		camera_path_result_t result;
+		std::vector<mip_upload_t> in_flight;
+		for (UINT frame = 0; frame < FRAMES; frame++) {
+			for (const mip_upload_t& upload : in_flight) {
+				streamer.CompleteUpload(upload);
+			}
+			FLOAT yaw = 2.0f * XM_PI * frame / TURN_FRAMES;
+			streamer.UpdateTargets(View({ 0.0f, 0.0f, 0.0f }, yaw));
+			in_flight = streamer.ScheduleUploads();
+
+			for (UINT i = 0; i < WALL_COUNT; i++) {
+				// Whether the center of the wall is within the horizontal field of view.
+				FLOAT offset = std::remainder(2.0f * XM_PI * i / WALL_COUNT - yaw, 2.0f * XM_PI);
+				if (std::abs(offset) < std::atan(TAN_HALF_WIDTH)) {
+					result.visible++;
+					result.visible_at_target += streamer.GetResidentLevel(i) == 0;
+				}
+			}
+			CHECK(streamer.GetResidentSize() <= std::size_t(32) << 20);
+		}
+		result.upload_bytes = streamer.GetStats().upload_bytes;
+		result.evictions = streamer.GetStats().evictions;
+		return result;
+	}
+
+	void TestCameraPath() {
+		camera_path_result_t weighted = SimulateCameraPath(0.25f);
+		camera_path_result_t unweighted = SimulateCameraPath(1.0f);
+		auto report = [](const char* name, const camera_path_result_t& result) {
+			std::printf("%s: visible textures at full resolution in %.1f%% of frames, %.1f MiB streamed, %llu "
+				"levels evicted\n", name, 100.0 * result.visible_at_target / result.visible,
+				result.upload_bytes / (1024.0 * 1024.0), static_cast<unsigned long long>(result.evictions));
+		};
+		report("camera turning, weighted by view direction", weighted);
+		report("camera turning, distance only", unweighted);
+		CHECK(weighted.visible_at_target > unweighted.visible_at_target);
+	}
+}
+
+int main() {
+	TestComputeTextureUsage();
+	TestTargets();
+	TestCameraPath();
+	return test::Result();
+}
@@ -0,0 +1,211 @@
+#include "pch.h"
+#include "MortonImage.h"
+#include "test_utils.h"
+#include <random>
+
+namespace {
+	struct linear_image_t {
+		UINT width;
+		UINT height;
+		std::size_t row_pitch;
+		std::vector<BYTE> pixels;
+
+		UINT32 GetTexel(UINT x, UINT y) const {
+			UINT32 texel;
+			memcpy(&texel, &pixels[y * row_pitch + x * 4], sizeof(texel));
+			return texel;
+		}
+	};
+
+	// Sums the channels of up to 256 texels, two at a time in 16-bit lanes.
+	struct box_sum_t {
+		UINT32 even = 0;
+		UINT32 odd = 0;
+
+		void Add(UINT32 texel) {
+			even += texel & 0x00ff00ff;
+			odd += (texel >> 8) & 0x00ff00ff;
+		}
+
+		// The count must be a power of two.
+		UINT32 Average(UINT count) const {
+			int shift = std::countr_zero(count);
+			return ((even >> shift) & 0x00ff00ff) | (((odd >> shift) & 0x00ff00ff) << 8);
+		}
+	};
+
+	// Random texels, with rows padded past the width so that the pitch is honoured.
+	linear_image_t RandomImage(UINT width, UINT height, std::size_t padding, std::mt19937& random) {
+		linear_image_t image = { .width = width, .height = height, .row_pitch = width * 4 + padding };
+		image.pixels.resize(image.row_pitch * height);
+		for (BYTE& pixel : image.pixels) {
+			pixel = static_cast<BYTE>(random());
+		}
+		return image;
+	}
+
+	void TestMorton() {
+		for (UINT x : { 0u, 1u, 5u, 1234u, 65535u }) {
+			for (UINT y : { 0u, 2u, 7u, 4321u, 65535u }) {
+				UINT decoded_x, decoded_y;
+				DecodeMorton(EncodeMorton(x, y), &decoded_x, &decoded_y);
+				CHECK(decoded_x == x && decoded_y == y);
+			}
+		}
+		CHECK(EncodeMorton(1, 0) == 1 && EncodeMorton(0, 1) == 2 && EncodeMorton(3, 3) == 15);
+		CHECK_THROWS(MortonImage(0, 4));
+	}
+
+	// Every accessor agrees with the linear image, with texels past the edges clamped to it.
+	void TestAccessors() {
+		std::mt19937 random(3);
+		std::vector<std::pair<UINT, UINT>> sizes = { { 1, 1 }, { 17, 5 }, { 64, 64 }, { 100, 37 } };
+		for (auto [width, height] : sizes) {
+			linear_image_t linear = RandomImage(width, height, 12, random);
+			MortonImage image(width, height);
+			image.CopyFromLinear(linear.pixels.data(), linear.row_pitch);
+			std::vector<BYTE> copy(linear.pixels.size());
+			image.CopyToLinear(copy.data(), linear.row_pitch);
+			auto clamped = [&](UINT x, UINT y) {
+				return linear.GetTexel(std::min(x, width - 1), std::min(y, height - 1));
+			};
+
+			for (UINT y = 0; y < height; y++) {
+				CHECK(memcmp(&copy[y * linear.row_pitch], &linear.pixels[y * linear.row_pitch], width * 4) == 0);
+				for (UINT x = 0; x < width; x++) {
+					CHECK(image.GetTexel(x, y) == linear.GetTexel(x, y));
+				}
+			}
+
+			std::size_t quad_count = 0;
+			image.ForEachQuad([&](UINT quad_x, UINT quad_y, std::span<const UINT32, 4> texels) {
+				quad_count++;
+				CHECK(texels.data() == image.GetQuad(quad_x, quad_y).data());
+				CHECK(texels[0] == clamped(quad_x * 2, quad_y * 2));
+				CHECK(texels[1] == clamped(quad_x * 2 + 1, quad_y * 2));
+				CHECK(texels[2] == clamped(quad_x * 2, quad_y * 2 + 1));
+				CHECK(texels[3] == clamped(quad_x * 2 + 1, quad_y * 2 + 1));
+			});
+			CHECK(quad_count == std::size_t((width + 1) / 2) * ((height + 1) / 2));
+
+			std::size_t block_count = 0;
+			image.ForEachBlock([&](UINT block_x, UINT block_y, std::span<const UINT32, 16> texels) {
+				block_count++;
+				CHECK(texels.data() == image.GetBlock(block_x, block_y).data());
+				for (UINT i = 0; i < 16; i++) {
+					UINT x, y;
+					DecodeMorton(i, &x, &y);
+					CHECK(texels[i] == clamped(block_x * 4 + x, block_y * 4 + y));
+				}
+			});
+			CHECK(block_count == std::size_t((width + 3) / 4) * ((height + 3) / 4));
+
+			image.SetTexel(width - 1, height - 1, 0x12345678);
+			CHECK(image.GetTexel(width - 1, height - 1) == 0x12345678);
+			CHECK(image.GetBlock((width - 1) / 4, (height - 1) / 4)[EncodeMorton((width - 1) % 4, (height - 1) % 4)] ==
+				0x12345678);
+		}
+	}
+
+	// Box filters a 4096x4096 image over 2x2 and 4x4 footprints, as mip generation and block compression read it,
+	// both sweeping the whole image and at random positions, from the linear image and from the Morton one.
+	void BenchmarkFootprints() {
+		constexpr UINT SIZE = 4096;
+		constexpr std::size_t SAMPLES = 1 << 20;
+		std::mt19937 random(5);
+		linear_image_t linear = RandomImage(SIZE, SIZE, 0, random);
+		MortonImage image(SIZE, SIZE);
+		double to_morton = test::MeasureMilliseconds([&] {
+			image.CopyFromLinear(linear.pixels.data(), linear.row_pitch);
+		});
+		std::vector<BYTE> copy(linear.pixels.size());
+		double to_linear = test::MeasureMilliseconds([&] {
+			image.CopyToLinear(copy.data(), linear.row_pitch);
+		});
+		CHECK(copy == linear.pixels);
+		const MortonImage& morton = image;
+		std::printf("%ux%u conversion: %.1f ms to Morton, %.1f ms back\n", SIZE, SIZE, to_morton, to_linear);
+
+		// Top left corners of the footprints, aligned to 4 texels.
+		std::vector<std::pair<UINT, UINT>> samples(SAMPLES);
+		for (auto& [x, y] : samples) {
+			x = random() % (SIZE / 4) * 4;
+			y = random() % (SIZE / 4) * 4;
+		}
+		auto linear_average = [&](UINT x, UINT y, UINT size) {
+			box_sum_t sum;
+			for (UINT row = 0; row < size; row++) {
+				for (UINT column = 0; column < size; column++) {
+					sum.Add(linear.GetTexel(x + column, y + row));
+				}
+			}
+			return sum.Average(size * size);
+		};
+		auto span_average = [](auto texels) {
+			box_sum_t sum;
+			for (UINT32 texel : texels) {
+				sum.Add(texel);
+			}
+			return sum.Average(static_cast<UINT>(texels.size()));
+		};
+
+		// Each pass writes one texel per footprint, and runs three times, of which the fastest counts.
+		std::vector<UINT32> linear_result(SIZE * SIZE / 4), morton_result(SIZE * SIZE / 4);
+		auto benchmark = [&](const char* name, auto linear_pass, auto morton_pass) {
+			double linear_milliseconds = DBL_MAX, morton_milliseconds = DBL_MAX;
+			for (UINT run = 0; run < 3; run++) {
+				linear_milliseconds = std::min(linear_milliseconds, test::MeasureMilliseconds(linear_pass));
+				morton_milliseconds = std::min(morton_milliseconds, test::MeasureMilliseconds(morton_pass));
+			}
+			CHECK(linear_result == morton_result);
+			std::printf("%s: %.1f ms linear, %.1f ms Morton\n", name, linear_milliseconds, morton_milliseconds);
+		};
+		benchmark("2x2 sweep", [&] {
+			for (UINT y = 0; y < SIZE; y += 2) {
+				for (UINT x = 0; x < SIZE; x += 2) {
+					linear_result[y / 2 * (SIZE / 2) + x / 2] = linear_average(x, y, 2);
+				}
+			}
+		}, [&] {
+			morton.ForEachQuad([&](UINT x, UINT y, std::span<const UINT32, 4> texels) {
+				morton_result[y * (SIZE / 2) + x] = span_average(texels);
+			});
+		});
+		benchmark("4x4 sweep", [&] {
+			for (UINT y = 0; y < SIZE; y += 4) {
+				for (UINT x = 0; x < SIZE; x += 4) {
+					linear_result[y / 4 * (SIZE / 4) + x / 4] = linear_average(x, y, 4);
+				}
+			}
+		}, [&] {
+			morton.ForEachBlock([&](UINT x, UINT y, std::span<const UINT32, 16> texels) {
+				morton_result[y * (SIZE / 4) + x] = span_average(texels);
+			});
+		});
+		benchmark("2x2 at random positions", [&] {
+			for (std::size_t i = 0; i < SAMPLES; i++) {
+				linear_result[i] = linear_average(samples[i].first, samples[i].second, 2);
+			}
+		}, [&] {
+			for (std::size_t i = 0; i < SAMPLES; i++) {
+				morton_result[i] = span_average(morton.GetQuad(samples[i].first / 2, samples[i].second / 2));
+			}
+		});
+		benchmark("4x4 at random positions", [&] {
+			for (std::size_t i = 0; i < SAMPLES; i++) {
+				linear_result[i] = linear_average(samples[i].first, samples[i].second, 4);
+			}
+		}, [&] {
+			for (std::size_t i = 0; i < SAMPLES; i++) {
+				morton_result[i] = span_average(morton.GetBlock(samples[i].first / 4, samples[i].second / 4));
+			}
+		});
+	}
+}
+
+int main() {
+	TestMorton();
+	TestAccessors();
+	BenchmarkFootprints();
+	return test::Result();
+}
@@ -0,0 +1,157 @@
+#include "pch.h"
+#include "PngDecoder.h"
+#include "png_fixtures.h"
+#include "test_png.h"
+#include "test_utils.h"
+
+namespace {
+	// Rewrites the size in the header of an encoded image, leaving its image data as it was.
+	std::vector<BYTE> WithSize(std::vector<BYTE> png, UINT width, UINT height) {
+		std::vector<BYTE> size;
+		test::AppendBigEndian(size, width);
+		test::AppendBigEndian(size, height);
+		std::copy(size.begin(), size.end(), png.begin() + 16);
+		std::vector<BYTE> crc;
+		test::AppendBigEndian(crc, test::Crc32(png.data() + 12, 17));
+		std::copy(crc.begin(), crc.end(), png.begin() + 29);
+		return png;
+	}
+
+	void TestDecode() {
+		std::vector<BYTE> rgba(5 * 3 * 4);
+		for (std::size_t i = 0; i < rgba.size(); i++) {
+			rgba[i] = static_cast<BYTE>(i * 7);
+		}
+		std::vector<BYTE> png = test::EncodePng(5, 3, rgba);
+		png_header_t header = ReadPngHeader(png);
+		CHECK(header.width == 5 && header.height == 3 && header.bit_depth == 8 && header.color_type == 6);
+
+		// Rows padded past the width.
+		constexpr std::size_t ROW_PITCH = 24;
+		std::vector<BYTE> decoded(ROW_PITCH * 3);
+		DecodePng(png, decoded.data(), ROW_PITCH);
+		for (std::size_t y = 0; y < 3; y++) {
+			CHECK(memcmp(&decoded[y * ROW_PITCH], &rgba[y * 5 * 4], 5 * 4) == 0);
+		}
+	}
+
+	// Sizes from the header are checked before anything of that size is allocated.
+	void TestOversizedHeaders() {
+		std::vector<BYTE> png = test::EncodePng(1, 1, { 1, 2, 3, 4 });
+		CHECK_THROWS(ReadPngHeader(WithSize(png, PNG_MAX_DIMENSION + 1, 1)));
+		CHECK_THROWS(ReadPngHeader(WithSize(png, 1, PNG_MAX_DIMENSION + 1)));
+		CHECK_THROWS(ReadPngHeader(WithSize(png, 0x7fffffff, 0x7fffffff)));
+		CHECK_THROWS(ReadPngHeader(WithSize(png, 0, 1)));
+
+		// The largest size passes the header, but a few bytes of image data cannot fill it.
+		std::vector<BYTE> largest = WithSize(png, PNG_MAX_DIMENSION, PNG_MAX_DIMENSION);
+		png_header_t header = ReadPngHeader(largest);
+		CHECK(header.width == PNG_MAX_DIMENSION && header.height == PNG_MAX_DIMENSION);
+		BYTE destination[16];
+		CHECK_THROWS(DecodePng(largest, destination, 8));
+
+		// Data that is merely inconsistent with a plausible size still fails while inflating.
+		CHECK_THROWS(DecodePng(WithSize(png, 2, 2), destination, 8));
+	}
+
+	// Sample of the pixel at x, y in the fixtures, as make_png_fixtures.py writes it.
+	BYTE FixtureSample(UINT x, UINT y, UINT channel) {
+		UINT32 noise = ((x * 73856093u) ^ (y * 19349663u) ^ (channel * 83492791u)) >> 7;
+		return static_cast<BYTE>(x * 2 + y * 3 + channel * 60 + noise % 7);
+	}
+
+	// Image data of the first IDAT chunk and the number of IDAT chunks.
+	std::span<const BYTE> FindImageData(std::span<const BYTE> png, UINT& idat_count) {
+		std::span<const BYTE> first;
+		idat_count = 0;
+		for (std::size_t offset = 8; offset + 12 <= png.size();) {
+			UINT32 size = (png[offset] << 24) | (png[offset + 1] << 16) | (png[offset + 2] << 8) | png[offset + 3];
+			if (memcmp(&png[offset + 4], "IDAT", 4) == 0 && idat_count++ == 0) {
+				first = png.subspan(offset + 8, size);
+			}
+			offset += 12 + size;
+		}
+		return first;
+	}
+
+	// zlib-compressed images of every 8-bit color type, with all five filter types in every image, so that
+	// the SSE2 unfilters of three and four bytes per pixel and the scalar ones of fewer bytes all run. They
+	// are compressed with fixed and dynamic Huffman codes, some interlaced with Adam7, and one with its image
+	// data split over many IDAT chunks, one of them empty.
+	void TestFixtures() {
+		for (const test::png_fixture_t& fixture : test::PNG_FIXTURES) {
+			png_header_t header = ReadPngHeader(fixture.png);
+			CHECK(header.width == fixture.width && header.height == fixture.height && header.bit_depth == 8);
+			CHECK(header.color_type == fixture.color_type && header.interlace_method == (fixture.interlaced ? 1 : 0));
+			UINT idat_count;
+			std::span<const BYTE> image_data = FindImageData(fixture.png, idat_count);
+			CHECK(idat_count == fixture.idat_count);
+			// BTYPE follows the BFINAL bit of the first block, after the two bytes of the zlib header.
+			CHECK(image_data.size() > 2 && ((image_data[2] >> 1) & 3) == fixture.block_type);
+
+			std::size_t row_pitch = std::size_t(fixture.width) * 4 + 12;
+			std::vector<BYTE> decoded(row_pitch * fixture.height);
+			DecodePng(fixture.png, decoded.data(), row_pitch);
+			bool exact = true;
+			for (UINT y = 0; y < fixture.height; y++) {
+				for (UINT x = 0; x < fixture.width; x++) {
+					BYTE expected[4];
+					switch (fixture.color_type) {
+					case 0:
+					case 4:
+						expected[0] = expected[1] = expected[2] = FixtureSample(x, y, 0);
+						expected[3] = fixture.color_type == 4 ? FixtureSample(x, y, 1) : 255;
+						break;
+					default:
+						for (UINT channel = 0; channel < 4; channel++) {
+							expected[channel] = channel == 3 && fixture.color_type == 2 ? 255 :
+								FixtureSample(x, y, channel);
+						}
+						break;
+					}
+					exact = exact && memcmp(&decoded[y * row_pitch + x * 4], expected, 4) == 0;
+				}
+			}
+			if (!exact) {
+				std::printf("fixture %s decoded wrong\n", fixture.name);
+			}
+			CHECK(exact);
+		}
+	}
+
+	// Decode throughput of RGBA images compressed with the fixed Huffman codes, every row with the next filter
+	// type, from a smooth gradient with a little noise like a photograph.
+	void BenchmarkDecode() {
+		std::printf("%6s %12s %10s %10s %10s\n", "size", "compressed", "ms", "MP/s", "MB/s");
+		for (UINT size : { 128u, 256u, 512u, 1024u, 2048u }) {
+			std::vector<BYTE> rgba(std::size_t(size) * size * 4);
+			for (UINT y = 0; y < size; y++) {
+				for (UINT x = 0; x < size; x++) {
+					for (UINT channel = 0; channel < 4; channel++) {
+						rgba[(std::size_t(y) * size + x) * 4 + channel] = FixtureSample(x / 4, y / 4, channel);
+					}
+				}
+			}
+			std::vector<BYTE> png = test::EncodePng(size, size, rgba, true);
+
+			std::vector<BYTE> decoded(rgba.size());
+			UINT repeats = std::max(1u, (1024u * 1024u) / (size * size));
+			double time = test::MeasureMilliseconds([&] {
+				for (UINT repeat = 0; repeat < repeats; repeat++) {
+					DecodePng(png, decoded.data(), std::size_t(size) * 4);
+				}
+			}) / repeats;
+			CHECK(decoded == rgba);
+			std::printf("%6u %10.1f KB %10.2f %10.1f %10.1f\n", size, png.size() / 1e3, time,
+				double(size) * size / (time * 1e3), rgba.size() / (time * 1e3));
+		}
+	}
+}
+
+int main() {
+	TestDecode();
+	TestOversizedHeaders();
+	TestFixtures();
+	BenchmarkDecode();
+	return test::Result();
+}
@@ -0,0 +1,132 @@
+#include "pch.h"
+#include "RingAllocator.h"
+#include "test_utils.h"
+#include <map>
+#include <random>
+
+namespace {
+	void TestAllocate() {
+		RingAllocator ring(1024);
+		CHECK(ring.GetSize() == 1024);
+		CHECK(ring.Allocate(100, 256) == 0);
+		CHECK(ring.Allocate(300, 256) == 256);
+		// The padding before the aligned offset counts as used.
+		CHECK(ring.GetUsedSize() == 556);
+		CHECK(ring.Allocate(256, 256) == 768);
+		CHECK(ring.GetUsedSize() == 1024);
+		CHECK(!ring.Allocate(1, 1));
+		CHECK(!ring.GetPendingFenceValue());
+	}
+
+	void TestReclaim() {
+		RingAllocator ring(1024);
+		CHECK(ring.Allocate(512, 1) == 0);
+		ring.EndFrame(1);
+		CHECK(ring.Allocate(256, 1) == 512);
+		ring.EndFrame(2);
+		CHECK(ring.GetPendingFenceValue() == 1);
+		CHECK(!ring.Allocate(512, 1));
+
+		ring.Reclaim(0);
+		CHECK(ring.GetUsedSize() == 768);
+		ring.Reclaim(1);
+		CHECK(ring.GetUsedSize() == 256);
+		CHECK(ring.GetPendingFenceValue() == 2);
+		// The rest of the buffer is too small, so the range starts over at the beginning, freed by frame 1.
+		CHECK(ring.Allocate(512, 1) == 0);
+		CHECK(ring.GetUsedSize() == 1024);
+		ring.EndFrame(3);
+
+		// Reclaims every frame up to the completed value at once.
+		ring.Reclaim(3);
+		CHECK(ring.GetUsedSize() == 0);
+		CHECK(!ring.GetPendingFenceValue());
+		// Nothing is in use, so even the largest range fits.
+		CHECK(ring.Allocate(1024, 1024) == 0);
+	}
+
+	void TestErrors() {
+		CHECK_THROWS(RingAllocator(0));
+		RingAllocator ring(1024);
+		CHECK_THROWS(ring.Allocate(0, 1));
+		CHECK_THROWS(ring.Allocate(1025, 1));
+		CHECK_THROWS(ring.Allocate(16, 48));
+		CHECK_THROWS(ring.Allocate(16, 2048));
+		ring.EndFrame(2);
+		CHECK_THROWS(ring.EndFrame(2));
+		CHECK_THROWS(ring.EndFrame(1));
+	}
+
+	// Frames of random allocations, completed by a GPU that lags zero to three frames behind. No range may
+	// overlap a range of a frame that has not completed, or break its alignment.
+	void TestRandomFrames() {
+		constexpr UINT64 SIZE = 1 << 16;
+		constexpr UINT FRAMES = 20000;
+		std::mt19937 random(5);
+		RingAllocator ring(SIZE);
+		// The ranges of the frames in flight, by fence value.
+		std::map<UINT64, std::vector<std::pair<UINT64, UINT64>>> live_ranges;
+		UINT64 completed = 0;
+		std::size_t allocations = 0, full = 0;
+		for (UINT64 fence_value = 1; fence_value <= FRAMES; fence_value++) {
+			UINT count = random() % 40;
+			for (UINT i = 0; i < count; i++) {
+				UINT64 size = 1 + random() % 2000;
+				UINT64 alignment = UINT64(1) << (random() % 9);
+				std::optional<UINT64> offset = ring.Allocate(size, alignment);
+				if (!offset) {
+					full++;
+					continue;
+				}
+				allocations++;
+				CHECK(*offset % alignment == 0);
+				CHECK(*offset + size <= SIZE);
+				for (const auto& [frame, ranges] : live_ranges) {
+					for (auto [begin, end] : ranges) {
+						CHECK(*offset >= end || *offset + size <= begin);
+					}
+				}
+				live_ranges[fence_value].push_back({ *offset, *offset + size });
+			}
+			ring.EndFrame(fence_value);
+
+			UINT64 lag = random() % 4;
+			completed = std::max(completed, fence_value - std::min(lag, fence_value));
+			ring.Reclaim(completed);
+			live_ranges.erase(live_ranges.begin(), live_ranges.upper_bound(completed));
+			CHECK(ring.GetUsedSize() <= SIZE);
+		}
+		std::printf("%u frames: %zu allocations, %zu found the ring full\n", FRAMES, allocations, full);
+	}
+
+	// Allocations of frame constants, reclaimed with one frame of lag every 1024 allocations.
+	void BenchmarkAllocate() {
+		constexpr UINT ALLOCATIONS = 20000000;
+		constexpr UINT FRAME_ALLOCATIONS = 1024;
+		RingAllocator ring(UINT64(1) << 24);
+		UINT64 fence_value = 1, checksum = 0;
+		double time = test::MeasureMilliseconds([&] {
+			for (UINT i = 1; i <= ALLOCATIONS; i++) {
+				checksum += ring.Allocate(256, 256).value_or(1);
+				if (i % FRAME_ALLOCATIONS == 0) {
+					ring.EndFrame(fence_value);
+					ring.Reclaim(fence_value - 1);
+					fence_value++;
+				}
+			}
+		});
+		// The ring never fills, so every offset is a multiple of 256.
+		CHECK(checksum % 256 == 0);
+		std::printf("%u allocations of 256 bytes, with a frame ended and reclaimed every %u: %.1f ns each\n",
+			ALLOCATIONS, FRAME_ALLOCATIONS, time * 1e6 / ALLOCATIONS);
+	}
+}
+
+int main() {
+	TestAllocate();
+	TestReclaim();
+	TestErrors();
+	TestRandomFrames();
+	BenchmarkAllocate();
+	return test::Result();
+}
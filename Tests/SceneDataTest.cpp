@@ -0,0 +1,459 @@
+#include "pch.h"
+#include "SceneData.h"
+#include "asset_cache.h"
+#include "test_utils.h"
+
+namespace {
+	// Stands in for a mapped upload heap, which the CPU writes but must not read back. Scribble zeroes the
+	// geometry once SceneData has filled it, as the GPU-side copy is all that the heap is for, so that reading
+	// it back gives wrong results rather than indices out of range.
+	class UploadHeapSink : public SceneSink {
+	public:
+		std::span<BYTE> AllocateVertexData(std::size_t size) override {
+			vertex_data.resize(size);
+			return vertex_data;
+		}
+
+		std::span<BYTE> AllocateIndexData(std::size_t size) override {
+			index_data.resize(size);
+			return index_data;
+		}
+
+		void Scribble() {
+			std::fill(vertex_data.begin(), vertex_data.end(), BYTE(0));
+			std::fill(index_data.begin(), index_data.end(), BYTE(0));
+		}
+
+		std::vector<BYTE> vertex_data;
+		std::vector<BYTE> index_data;
+	};
+
+	// What SceneData derives from its geometry after loading.
+	struct derived_data_t {
+		std::vector<vertex_t> triangles;
+		std::vector<lod_level_t> chunk_levels;
+		std::vector<meshlet_data_t> meshlets;
+		std::vector<texture_usage_t> usage;
+	};
+
+	derived_data_t Derive(SceneData& scene) {
+		// Every material with a texture of its own.
+		std::vector<UINT> material_textures(scene.GetMaterials().size());
+		std::iota(material_textures.begin(), material_textures.end(), 0);
+		derived_data_t derived = {
+			.triangles = scene.GetTriangleData(),
+			.chunk_levels = { scene.GetLodChunkLevels().begin(), scene.GetLodChunkLevels().end() },
+			.usage = scene.ComputeTextureUsage(material_textures)
+		};
+		for (UINT level = 0; level < scene.GetLodLevels().size(); level++) {
+			derived.meshlets.push_back(scene.BuildMeshlets(level));
+		}
+		return derived;
+	}
+
+	template <typename T>
+	bool SameBytes(std::span<const T> a, std::span<const T> b) {
+		return a.size() == b.size() && memcmp(a.data(), b.data(), a.size_bytes()) == 0;
+	}
+
+	bool Same(const derived_data_t& a, const derived_data_t& b) {
+		if (!SameBytes<lod_level_t>(a.chunk_levels, b.chunk_levels) || a.meshlets.size() != b.meshlets.size()) {
+			return false;
+		}
+		for (std::size_t level = 0; level < a.meshlets.size(); level++) {
+			if (!SameBytes<meshlet_t>(a.meshlets[level].meshlets, b.meshlets[level].meshlets) ||
+				a.meshlets[level].vertices != b.meshlets[level].vertices ||
+				a.meshlets[level].triangles != b.meshlets[level].triangles) {
+				return false;
+			}
+		}
+		return SameBytes<vertex_t>(a.triangles, b.triangles) && SameBytes<texture_usage_t>(a.usage, b.usage);
+	}
+
+	// A bumpy grid of size by size quads over x and z, the half with x below the middle in one material and
+	// the rest in another.
+	void WriteGrid(const std::string& path, UINT size) {
+		std::ofstream obj(path);
+		for (UINT z = 0; z <= size; z++) {
+			for (UINT x = 0; x <= size; x++) {
+				obj << "v " << x << ' ' << std::sin(x * 0.7f) * std::cos(z * 0.3f) << ' ' << z << '\n';
+				obj << "vt " << x / static_cast<float>(size) << ' ' << z / static_cast<float>(size) << '\n';
+			}
+		}
+		for (UINT half = 0; half < 2; half++) {
+			obj << (half == 0 ? "usemtl stone\n" : "usemtl wood\n");
+			for (UINT z = 0; z < size; z++) {
+				for (UINT x = half * size / 2; x < (half + 1) * size / 2; x++) {
+					UINT corner = z * (size + 1) + x + 1;
+					UINT corners[4] = { corner, corner + 1, corner + size + 2, corner + size + 1 };
+					obj << "f " << corners[0] << '/' << corners[0] << ' ' << corners[2] << '/' << corners[2] << ' ' <<
+						corners[1] << '/' << corners[1] << '\n';
+					obj << "f " << corners[0] << '/' << corners[0] << ' ' << corners[3] << '/' << corners[3] << ' ' <<
+						corners[2] << '/' << corners[2] << '\n';
+				}
+			}
+		}
+	}
+
+	// Full-precision vertices, so that the triangle data can be compared exactly, and a single level.
+	scene_options_t ExactOptions(UINT thread_count) {
+		return {
+			.thread_count = thread_count,
+			.vertex_format = { .position_encoding = position_encoding_t::FLOAT3, .half_tex_coord = false },
+			.lod = { .level_count = 0 }
+		};
+	}
+
+	// A grid whose faces switch between three materials every stripe faces, so that material runs start and
+	// end inside the chunks the source is split into, and names come back after other materials.
+	void WriteStripedGrid(const std::string& path, UINT size, UINT stripe) {
+		static constexpr const char* MATERIAL_NAMES[] = { "stone", "wood", "moss" };
+		std::ofstream obj(path);
+		for (UINT z = 0; z <= size; z++) {
+			for (UINT x = 0; x <= size; x++) {
+				obj << "v " << x << ' ' << std::sin(x * 0.7f) * std::cos(z * 0.3f) << ' ' << z << '\n';
+				obj << "vt " << x / static_cast<float>(size) << ' ' << z / static_cast<float>(size) << '\n';
+			}
+		}
+		UINT face = 0;
+		for (UINT z = 0; z < size; z++) {
+			for (UINT x = 0; x < size; x++) {
+				UINT corner = z * (size + 1) + x + 1;
+				UINT corners[4] = { corner, corner + 1, corner + size + 2, corner + size + 1 };
+				for (UINT triangle = 0; triangle < 2; triangle++, face++) {
+					if (face % stripe == 0) {
+						obj << "usemtl " << MATERIAL_NAMES[face / stripe % 3] << '\n';
+					}
+					UINT second = triangle == 0 ? corners[2] : corners[3];
+					UINT third = triangle == 0 ? corners[1] : corners[2];
+					obj << "f " << corners[0] << '/' << corners[0] << ' ' << second << '/' << second << ' ' <<
+						third << '/' << third << '\n';
+				}
+			}
+		}
+	}
+
+	struct scene_output_t {
+		std::vector<BYTE> vertex_data;
+		std::vector<BYTE> index_data;
+		std::vector<lod_level_t> lod_levels;
+		std::vector<lod_level_t> lod_chunk_levels;
+		std::vector<std::string> materials;
+		std::vector<vertex_t> triangles;
+	};
+
+	scene_output_t LoadUncached(const std::string& path, UINT thread_count) {
+		std::filesystem::remove(path + ".cache");
+		SceneData scene(path, { .thread_count = thread_count });
+		scene_output_t output = {
+			.vertex_data = { scene.GetVertexData().begin(), scene.GetVertexData().end() },
+			.index_data = { scene.GetIndexData().begin(), scene.GetIndexData().end() },
+			.lod_levels = { scene.GetLodLevels().begin(), scene.GetLodLevels().end() },
+			.lod_chunk_levels = { scene.GetLodChunkLevels().begin(), scene.GetLodChunkLevels().end() },
+			.triangles = scene.GetTriangleData()
+		};
+		for (const scene_material_t& material : scene.GetMaterials()) {
+			output.materials.push_back(material.name);
+		}
+		return output;
+	}
+
+	// Parsing the chunks in parallel gives the same output as parsing the whole source on one thread.
+	void TestThreadCounts(const std::string& path) {
+		CHECK(std::filesystem::file_size(path) > 8 * 256 * 1024);
+		scene_output_t expected = LoadUncached(path, 1);
+		CHECK(expected.materials == std::vector<std::string>({ "stone", "wood", "moss" }));
+		CHECK(expected.lod_levels.size() > 1);
+		for (UINT thread_count : { 2u, 3u, 4u, 7u, 16u }) {
+			scene_output_t output = LoadUncached(path, thread_count);
+			CHECK(output.vertex_data == expected.vertex_data);
+			CHECK(output.index_data == expected.index_data);
+			CHECK(SameBytes<lod_level_t>(output.lod_levels, expected.lod_levels));
+			CHECK(SameBytes<lod_level_t>(output.lod_chunk_levels, expected.lod_chunk_levels));
+			CHECK(output.materials == expected.materials);
+			CHECK(SameBytes<vertex_t>(output.triangles, expected.triangles));
+		}
+	}
+
+	// Reports how much indexing shrinks a large scene: the bytes of the non-indexed triangles, of the indexed
+	// mesh before packing, and of the packed vertex and index data, with the time BuildIndexedMesh took.
+	void BenchmarkIndexing(const std::string& path) {
+		std::filesystem::remove(path + ".cache");
+		SceneData scene(path, { .lod = { .level_count = 0 } });
+		std::size_t triangle_bytes = scene.GetTriangleData().size() * sizeof(vertex_t);
+		std::size_t indexed_bytes = scene.GetVertexCount() * sizeof(vertex_t) + scene.GetIndexCount() * sizeof(UINT);
+		std::size_t packed_bytes = scene.GetVertexData().size() + scene.GetIndexData().size();
+		std::printf("%u corners to %u vertices in %.1f ms: %.1f MB non-indexed, %.1f MB indexed, %.1f MB packed "
+			"(%.1fx smaller)\n", scene.GetIndexCount(), scene.GetVertexCount(), scene.GetLoadStats().index_time,
+			triangle_bytes / 1e6, indexed_bytes / 1e6, packed_bytes / 1e6,
+			static_cast<double>(triangle_bytes) / packed_bytes);
+	}
+
+	// Startup with and without the cache: the first load parses the source and writes the cache, the second
+	// maps the cache and copies the geometry out of it.
+	void BenchmarkCache(const std::string& path) {
+		UINT thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+		std::filesystem::remove(path + ".cache");
+		double cold_time = test::MeasureMilliseconds([&] {
+			SceneData scene(path, { .thread_count = thread_count });
+		});
+		bool cached = false;
+		double warm_time = test::MeasureMilliseconds([&] {
+			SceneData scene(path, { .thread_count = thread_count });
+			cached = scene.GetLoadStats().cached;
+		});
+		CHECK(cached);
+		std::printf("%.1f MB source: %.1f ms without the cache, %.1f ms from the cache (%.1fx faster)\n",
+			std::filesystem::file_size(path) / 1e6, cold_time, warm_time, cold_time / warm_time);
+	}
+
+	// Parses the same source without a cache on 1 to N threads, with at least 4 so that the chunking is
+	// measured on small machines too.
+	void BenchmarkThreadCounts(const std::string& path) {
+		UINT max_thread_count = std::max(std::thread::hardware_concurrency(), 4u);
+		double single_parse_time = 0.0;
+		for (UINT thread_count = 1; thread_count <= max_thread_count; thread_count *= 2) {
+			std::filesystem::remove(path + ".cache");
+			std::unique_ptr<SceneData> scene;
+			double load_time = test::MeasureMilliseconds([&] {
+				scene = std::make_unique<SceneData>(path, ExactOptions(thread_count));
+			});
+			double parse_time = scene->GetLoadStats().parse_time;
+			if (thread_count == 1) {
+				single_parse_time = parse_time;
+			}
+			std::printf("%u threads: parsed in %.1f ms (%.2fx), loaded in %.1f ms\n", thread_count, parse_time,
+				single_parse_time / parse_time, load_time);
+		}
+	}
+
+	// Meshlets, texture usage and triangle data come from a copy of the geometry in CPU memory, both when the
+	// source is parsed straight into the sink and when the cache is copied into it.
+	void TestDerivedFromCpuCopy(const std::string& path) {
+		std::filesystem::remove(path + ".cache");
+		SceneData reference(path);
+		derived_data_t expected = Derive(reference);
+		std::vector<BYTE> vertex_data(reference.GetVertexData().begin(), reference.GetVertexData().end());
+		CHECK(expected.meshlets.size() == 4);
+		CHECK(!expected.meshlets[0].meshlets.empty());
+		CHECK(expected.usage.size() == 2);
+		// The two halves meet at x = 16, up to the quantization of the positions.
+		CHECK(std::abs(expected.usage[0].aabb_max.x - 16.0f) < 1e-3f);
+		CHECK(std::abs(expected.usage[1].aabb_min.x - 16.0f) < 1e-3f);
+
+		for (bool cached : { false, true }) {
+			if (!cached) {
+				std::filesystem::remove(path + ".cache");
+			}
+			UploadHeapSink sink;
+			SceneData scene(path, sink);
+			CHECK(SameBytes<BYTE>(sink.vertex_data, vertex_data));
+			sink.Scribble();
+			CHECK(Same(Derive(scene), expected));
+		}
+
+		// And without a sink, from the mapped cache.
+		SceneData cached(path);
+		CHECK(Same(Derive(cached), expected));
+	}
+	// The stored timestamp at byte 16 of the cache header.
+	UINT64 ReadCachedWriteTime(const std::string& cache_path) {
+		std::ifstream cache(cache_path, std::ios::binary);
+		UINT64 write_time = 0;
+		cache.seekg(16);
+		cache.read(reinterpret_cast<char*>(&write_time), sizeof(write_time));
+		return write_time;
+	}
+
+	// A source with a new timestamp but the same contents keeps its cache, which then records the timestamp.
+	void TestTouchedSource(const std::string& path) {
+		std::string cache_path = path + ".cache";
+		std::filesystem::remove(cache_path);
+		SceneData parsed(path);
+		derived_data_t expected = Derive(parsed);
+		std::vector<char> payload(std::filesystem::file_size(cache_path));
+		std::ifstream(cache_path, std::ios::binary).read(payload.data(), payload.size());
+		CHECK(ReadCachedWriteTime(cache_path) == GetSourceStamp(path).write_time);
+
+		std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+		CHECK(ReadCachedWriteTime(cache_path) != GetSourceStamp(path).write_time);
+		SceneData touched(path);
+		CHECK(Same(Derive(touched), expected));
+		CHECK(ReadCachedWriteTime(cache_path) == GetSourceStamp(path).write_time);
+
+		// Only the timestamp in the header changed.
+		std::vector<char> refreshed(payload.size());
+		std::ifstream(cache_path, std::ios::binary).read(refreshed.data(), refreshed.size());
+		CHECK(std::filesystem::file_size(cache_path) == payload.size());
+		memcpy(&payload[16], &refreshed[16], sizeof(UINT64));
+		CHECK(refreshed == payload);
+		SceneData cached(path);
+		CHECK(Same(Derive(cached), expected));
+	}
+
+	// The parser that SceneData replaced, which reads the source token by token from a stream, as the
+	// reference for the triangle data.
+	std::vector<vertex_t> ParseWithStream(const std::string& path) {
+		std::ifstream scene_stream(path);
+		std::vector<std::array<FLOAT, 3>> positions;
+		std::vector<std::array<FLOAT, 2>> texture_positions;
+		std::vector<vertex_t> triangles;
+		std::string type;
+		while (scene_stream >> type) {
+			if (type == "v") {
+				FLOAT x, y, z;
+				scene_stream >> x >> y >> z;
+				positions.push_back({ x, y, z });
+			}
+			else if (type == "vt") {
+				FLOAT u, v;
+				scene_stream >> u >> v;
+				texture_positions.push_back({ u, v });
+			}
+			else if (type == "f") {
+				for (std::size_t i = 0; i < 3; i++) {
+					std::size_t vertex_index, texture_index;
+					scene_stream >> vertex_index;
+					scene_stream.ignore(1);
+					scene_stream >> texture_index;
+					const std::array<FLOAT, 3>& position = positions[vertex_index - 1];
+					const std::array<FLOAT, 2>& texture_position = texture_positions[texture_index - 1];
+					triangles.push_back({ { position[0], position[1], position[2] }, { 1.0f, 1.0f, 1.0f, 1.0f },
+						{ texture_position[0], texture_position[1] } });
+				}
+			}
+		}
+		return triangles;
+	}
+
+	// The position and texture coordinates of the corners of every triangle, each starting at its smallest
+	// corner so that the winding is kept, in sorted order: the optimizers reorder the triangles and may
+	// rotate their corners.
+	std::vector<std::array<FLOAT, 15>> SortedTriangles(std::span<const vertex_t> triangle_data) {
+		std::vector<std::array<FLOAT, 15>> triangles;
+		for (std::size_t i = 0; i + 2 < triangle_data.size(); i += 3) {
+			std::array<std::array<FLOAT, 5>, 3> corners;
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				const vertex_t& vertex = triangle_data[i + corner];
+				corners[corner] = { vertex.position[0], vertex.position[1], vertex.position[2], vertex.tex_coord[0],
+					vertex.tex_coord[1] };
+			}
+			std::rotate(corners.begin(), std::min_element(corners.begin(), corners.end()), corners.end());
+			std::array<FLOAT, 15>& triangle = triangles.emplace_back();
+			for (std::size_t corner = 0; corner < 3; corner++) {
+				std::copy(corners[corner].begin(), corners[corner].end(), triangle.begin() + corner * 5);
+			}
+		}
+		std::sort(triangles.begin(), triangles.end());
+		return triangles;
+	}
+
+	void TestMatchesStreamParser(const std::string& path) {
+		std::filesystem::remove(path + ".cache");
+		SceneData scene(path, ExactOptions(1));
+		CHECK(!scene.GetLoadStats().cached);
+		std::vector<std::array<FLOAT, 15>> expected = SortedTriangles(ParseWithStream(path));
+		CHECK(!expected.empty());
+		CHECK(SortedTriangles(scene.GetTriangleData()) == expected);
+		SceneData cached(path, ExactOptions(1));
+		CHECK(cached.GetLoadStats().cached);
+		CHECK(SortedTriangles(cached.GetTriangleData()) == expected);
+	}
+
+	// Writes copies of the source one after another, each moved along x past the previous one, with the
+	// indices of its faces offset to its own positions and texture coordinates.
+	void WriteCopies(const std::string& source_path, const std::string& path, UINT copy_count) {
+		std::ifstream source(source_path);
+		std::vector<std::string> lines;
+		std::size_t position_count = 0, texture_position_count = 0;
+		for (std::string line; std::getline(source, line);) {
+			position_count += line.starts_with("v ");
+			texture_position_count += line.starts_with("vt ");
+			lines.push_back(std::move(line));
+		}
+
+		std::ofstream obj(path);
+		obj << std::fixed << std::setprecision(6);
+		for (UINT copy = 0; copy < copy_count; copy++) {
+			for (const std::string& line : lines) {
+				std::istringstream record(line);
+				std::string type;
+				record >> type;
+				if (type == "v") {
+					FLOAT x, y, z;
+					record >> x >> y >> z;
+					obj << "v " << x + 25.0f * copy << ' ' << y << ' ' << z << '\n';
+				}
+				else if (type == "f") {
+					obj << 'f';
+					std::size_t vertex_index, texture_index;
+					char separator;
+					while (record >> vertex_index >> separator >> texture_index) {
+						obj << ' ' << vertex_index + position_count * copy << '/' <<
+							texture_index + texture_position_count * copy;
+					}
+					obj << '\n';
+				}
+				else {
+					obj << line << '\n';
+				}
+			}
+		}
+	}
+
+	// Loads the shipped scene and a copy of it 100 times as large, without a cache, on every hardware
+	// thread, and reports the parsing throughput, then the whole load, in megabytes and triangles per
+	// second. The stream parser reads the shipped scene for comparison.
+	void BenchmarkParse(const std::string& asset_path, const std::string& large_path) {
+		UINT thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+		for (const std::string& path : { asset_path, large_path }) {
+			double megabytes = std::filesystem::file_size(path) / 1e6;
+			std::filesystem::remove(path + ".cache");
+			std::unique_ptr<SceneData> scene;
+			double load_time = test::MeasureMilliseconds([&] {
+				scene = std::make_unique<SceneData>(path, ExactOptions(thread_count));
+			});
+			double parse_time = scene->GetLoadStats().parse_time;
+			double triangles = scene->GetIndexCount() / 3.0;
+			std::printf("%.1f MB, %.0f triangles on %u threads: parsed in %.1f ms (%.0f MB/s, %.2f M triangles/s), "
+				"loaded in %.1f ms (%.0f MB/s, %.2f M triangles/s)\n", megabytes, triangles, thread_count,
+				parse_time, megabytes * 1000.0 / parse_time, triangles / 1000.0 / parse_time, load_time,
+				megabytes * 1000.0 / load_time, triangles / 1000.0 / load_time);
+		}
+
+		std::size_t corner_count = 0;
+		double stream_time = test::MeasureMilliseconds([&] {
+			corner_count = ParseWithStream(asset_path).size();
+		});
+		double megabytes = std::filesystem::file_size(asset_path) / 1e6;
+		std::printf("%.1f MB with the stream parser: %.1f ms (%.0f MB/s, %.2f M triangles/s)\n", megabytes,
+			stream_time, megabytes * 1000.0 / stream_time, corner_count / 3.0 / 1000.0 / stream_time);
+	}
+}
+
+int main() {
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "SceneDataTest";
+	std::filesystem::create_directories(directory);
+	std::string path = (directory / "grid.obj").string();
+	WriteGrid(path, 32);
+	TestDerivedFromCpuCopy(path);
+	TestTouchedSource(path);
+
+	// Copied, so that the caches are not written next to the shipped scene.
+	std::string asset_path = (directory / "SceneData.obj").string();
+	std::filesystem::copy_file(D3DPROJECT_ASSETS_DIR "/SceneData.obj", asset_path);
+	TestMatchesStreamParser(asset_path);
+	std::string large_path = (directory / "large.obj").string();
+	WriteCopies(asset_path, large_path, 100);
+	BenchmarkParse(asset_path, large_path);
+	BenchmarkIndexing(large_path);
+	BenchmarkCache(asset_path);
+	BenchmarkCache(large_path);
+
+	std::string striped_path = (directory / "striped.obj").string();
+	WriteStripedGrid(striped_path, 256, 1000);
+	TestThreadCounts(striped_path);
+	BenchmarkThreadCounts(striped_path);
+	std::filesystem::remove_all(directory);
+	return test::Result();
+}
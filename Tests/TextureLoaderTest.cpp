@@ -0,0 +1,140 @@
+#include "pch.h"
+#include "TextureLoader.h"
+#include "test_png.h"
+#include "test_utils.h"
+
+namespace {
+	texture_options_t Options(UINT thread_count) {
+		return {
+			.thread_count = thread_count,
+			.format = DXGI_FORMAT_BC7_UNORM,
+			.quality = compression_quality_t::FAST,
+			.decoder = bitmap_decoder_t::PORTABLE
+		};
+	}
+
+	// A smooth gradient with a pattern that depends on seed, so that every texture compresses differently.
+	void WriteTexture(const std::string& path, UINT size, UINT seed) {
+		std::vector<BYTE> rgba(std::size_t(size) * size * 4);
+		for (UINT y = 0; y < size; y++) {
+			for (UINT x = 0; x < size; x++) {
+				BYTE* texel = &rgba[(std::size_t(y) * size + x) * 4];
+				texel[0] = static_cast<BYTE>(x * 255 / size);
+				texel[1] = static_cast<BYTE>(y * 255 / size);
+				texel[2] = static_cast<BYTE>((x ^ y) * seed);
+				texel[3] = 255;
+			}
+		}
+		test::WriteFile(path, test::EncodePng(size, size, rgba));
+	}
+
+	void TestCachedSize(const std::string& directory) {
+		std::string path = directory + "/cached.png";
+		WriteTexture(path, 64, 1);
+		std::filesystem::remove(path + ".cache");
+		texture_options_t options = Options(1);
+		CHECK(!TextureAsset::GetCachedSize(path, options));
+		CHECK(!TextureAsset(path, options).IsCached());
+
+		// The estimate of the loader charges what a cached texture maps.
+		std::optional<std::size_t> cached_size = TextureAsset::GetCachedSize(path, options);
+		CHECK(cached_size && *cached_size == std::filesystem::file_size(path + ".cache"));
+		CHECK(TextureAsset(path, options).IsCached());
+		texture_options_t uncompressed = options;
+		uncompressed.format = DXGI_FORMAT_R8G8B8A8_UNORM;
+		CHECK(!TextureAsset::GetCachedSize(path, uncompressed));
+
+		// A new timestamp alone is not reported until loading has compared the contents and recorded it.
+		std::filesystem::last_write_time(path, std::filesystem::last_write_time(path) + std::chrono::hours(1));
+		CHECK(!TextureAsset::GetCachedSize(path, options));
+		CHECK(TextureAsset(path, options).IsCached());
+		cached_size = TextureAsset::GetCachedSize(path, options);
+		CHECK(cached_size && *cached_size == std::filesystem::file_size(path + ".cache"));
+		CHECK(TextureAsset(path, options).IsCached());
+		CHECK(!TextureAsset::GetCachedSize(path + ".missing", options));
+	}
+
+	void TestLoadTextures(const std::string& directory) {
+		std::vector<std::string> paths;
+		for (UINT i = 0; i < 6; i++) {
+			paths.push_back(directory + "/load" + std::to_string(i) + ".png");
+			WriteTexture(paths.back(), 16u << (i % 3), i);
+		}
+
+		// A budget smaller than any texture still loads them, one at a time.
+		for (std::size_t budget : { std::size_t(1) << 30, std::size_t(1) }) {
+			for (const std::string& path : paths) {
+				std::filesystem::remove(path + ".cache");
+			}
+			std::vector<std::unique_ptr<TextureAsset>> textures(paths.size());
+			LoadTextures(paths, Options(2), { .worker_count = 3, .memory_budget = budget },
+				[&](UINT index, std::unique_ptr<TextureAsset> texture) {
+					CHECK(index < textures.size() && !textures[index]);
+					textures[index] = std::move(texture);
+				});
+			for (std::size_t i = 0; i < paths.size(); i++) {
+				CHECK(textures[i] && textures[i]->GetLevels()[0].width == 16u << (i % 3));
+			}
+		}
+
+		// Opening a missing file throws winrt::hresult_error, which is not a std::exception.
+		std::vector<std::string> missing = paths;
+		missing[3] = directory + "/missing.png";
+		std::size_t loaded = 0;
+		bool thrown = false;
+		try {
+			LoadTextures(missing, Options(1), { .worker_count = 2 },
+				[&](UINT, std::unique_ptr<TextureAsset>) { loaded++; });
+		}
+		catch (const winrt::hresult_error&) {
+			thrown = true;
+		}
+		CHECK(thrown && loaded < paths.size());
+		CHECK_THROWS(LoadTextures(paths, Options(1), { .worker_count = 2 },
+			[](UINT index, std::unique_ptr<TextureAsset>) {
+				if (index == 1) {
+					throw std::runtime_error("TextureLoaderTest: callback failed");
+				}
+			}));
+	}
+
+	// Loads a batch of textures with 1 to 8 workers, sharing the threads of the machine between them, first
+	// processing the sources and then from the caches that the first load wrote.
+	void BenchmarkWorkerCounts(const std::string& directory) {
+		constexpr UINT TEXTURE_COUNT = 16;
+		std::vector<std::string> paths;
+		for (UINT i = 0; i < TEXTURE_COUNT; i++) {
+			paths.push_back(directory + "/batch" + std::to_string(i) + ".png");
+			WriteTexture(paths.back(), i % 4 == 0 ? 256 : 128, i);
+		}
+		UINT thread_count = std::max(std::thread::hardware_concurrency(), 1u);
+		std::printf("%u textures on %u hardware threads:\n", TEXTURE_COUNT, thread_count);
+
+		for (UINT worker_count : { 1u, 2u, 4u, 8u }) {
+			for (const std::string& path : paths) {
+				std::filesystem::remove(path + ".cache");
+			}
+			double times[2];
+			for (bool cached : { false, true }) {
+				UINT cached_count = 0;
+				times[cached] = test::MeasureMilliseconds([&] {
+					LoadTextures(paths, Options(thread_count), { .worker_count = worker_count },
+						[&](UINT, std::unique_ptr<TextureAsset> texture) { cached_count += texture->IsCached(); });
+				});
+				CHECK(cached_count == (cached ? TEXTURE_COUNT : 0));
+			}
+			std::printf("%u workers: %.1f ms from the sources, %.1f ms from the caches\n", worker_count, times[0],
+				times[1]);
+		}
+	}
+}
+
+int main() {
+	std::filesystem::path directory = std::filesystem::temp_directory_path() / "TextureLoaderTest";
+	std::filesystem::create_directories(directory);
+	TestCachedSize(directory.string());
+	TestLoadTextures(directory.string());
+	BenchmarkWorkerCounts(directory.string());
+	std::filesystem::remove_all(directory);
+	return test::Result();
+}
@@ -0,0 +1,170 @@
+#include "pch.h"
+#include "TlsfAllocator.h"
+#include "test_utils.h"
+#include <map>
+#include <random>
+
+namespace {
+	void TestAllocate() {
+		TlsfAllocator allocator(1024, 64);
+		std::optional<tlsf_allocation_t> a = allocator.Allocate(100, 64);
+		std::optional<tlsf_allocation_t> b = allocator.Allocate(64, 256);
+		CHECK(a && a->offset == 0);
+		// Aligned past the rounded up first allocation, leaving the padding in front free.
+		CHECK(b && b->offset == 256);
+		CHECK(allocator.GetUsedSize() == 192);
+		CHECK(allocator.GetAllocationCount() == 2);
+		CHECK(allocator.GetFreeBlockCount() == 2);
+		CHECK(!allocator.Allocate(1024, 64));
+
+		allocator.Free(a->block);
+		allocator.Free(b->block);
+		CHECK(allocator.GetUsedSize() == 0);
+		CHECK(allocator.GetFreeBlockCount() == 1);
+		CHECK(allocator.GetLargestFreeBlock() == 1024);
+		CHECK(allocator.GetFragmentation() == 0.0);
+	}
+
+	// Allocations that fill the range exactly are found in the size class of the size itself.
+	void TestExactFit() {
+		std::mt19937_64 random(3);
+		UINT failures = 0;
+		for (UINT i = 0; i < 100000; i++) {
+			UINT64 granularity = UINT64(1) << (random() % 17);
+			UINT64 granules = 1 + random() % 5000;
+			TlsfAllocator allocator(granules * granularity, granularity);
+			if (!allocator.Allocate(granules * granularity - random() % granularity, granularity)) {
+				failures++;
+			}
+		}
+		CHECK(failures == 0);
+	}
+
+	void TestFragmentation() {
+		TlsfAllocator allocator(UINT64(64) << 20, 64 << 10);
+		std::vector<UINT32> blocks;
+		for (UINT i = 0; i < 512; i++) {
+			blocks.push_back(allocator.Allocate(128 << 10, 64 << 10)->block);
+		}
+		for (UINT i = 0; i < 512; i += 2) {
+			allocator.Free(blocks[i]);
+		}
+		CHECK(allocator.GetFreeBlockCount() == 256);
+		CHECK(allocator.GetLargestFreeBlock() == 128 << 10);
+		CHECK(allocator.GetFragmentation() > 0.99);
+	}
+
+	void TestErrors() {
+		CHECK_THROWS(TlsfAllocator(0, 64));
+		CHECK_THROWS(TlsfAllocator(1000, 48));
+		CHECK_THROWS(TlsfAllocator(1000, 64));
+		TlsfAllocator allocator(1024, 64);
+		CHECK_THROWS(allocator.Allocate(0, 64));
+		CHECK_THROWS(allocator.Allocate(64, 48));
+		CHECK(!allocator.Allocate(2048, 64));
+		tlsf_allocation_t allocation = *allocator.Allocate(64, 64);
+		allocator.Free(allocation.block);
+		CHECK_THROWS(allocator.Free(allocation.block));
+		CHECK_THROWS(allocator.Free(1000));
+	}
+
+	// Random allocations and frees over random ranges and granularities. Allocations must be aligned, inside
+	// the range and apart from each other, the counters must match, and freeing everything must merge the
+	// range back into one block.
+	void TestRandomOperations() {
+		constexpr UINT SEEDS = 200;
+		constexpr UINT OPERATIONS = 3000;
+		UINT64 failed = 0;
+		for (UINT seed = 0; seed < SEEDS; seed++) {
+			std::mt19937_64 random(seed);
+			UINT64 granularity = UINT64(1) << (random() % 17);
+			UINT64 size = granularity * (1 + random() % 5000);
+			TlsfAllocator allocator(size, granularity);
+			// The live allocations by offset, with their size and block.
+			std::map<UINT64, std::pair<UINT64, UINT32>> live;
+			UINT64 used_size = 0;
+			for (UINT i = 0; i < OPERATIONS; i++) {
+				if (live.empty() || random() % 100 < 55) {
+					UINT64 largest = std::max<UINT64>(size / (1 + random() % 64), 1);
+					UINT64 allocation_size = 1 + random() % largest;
+					UINT64 alignment = UINT64(1) << (random() % 24);
+					std::optional<tlsf_allocation_t> allocation = allocator.Allocate(allocation_size, alignment);
+					if (!allocation) {
+						// Any block of twice the aligned size is in a larger size class than the request.
+						UINT64 needed = ((allocation_size + granularity - 1) & ~(granularity - 1)) +
+							std::max(alignment, granularity) - granularity;
+						CHECK(allocator.GetLargestFreeBlock() < 2 * needed);
+						failed++;
+						continue;
+					}
+					UINT64 offset = allocation->offset;
+					CHECK(offset % alignment == 0);
+					CHECK(offset + allocation_size <= size);
+					auto next = live.lower_bound(offset);
+					CHECK(next == live.end() || offset + allocation_size <= next->first);
+					CHECK(next == live.begin() || std::prev(next)->first + std::prev(next)->second.first <= offset);
+					live[offset] = { allocation_size, allocation->block };
+					used_size += (allocation_size + granularity - 1) & ~(granularity - 1);
+				}
+				else {
+					auto freed = std::next(live.begin(), random() % live.size());
+					allocator.Free(freed->second.second);
+					used_size -= (freed->second.first + granularity - 1) & ~(granularity - 1);
+					live.erase(freed);
+				}
+				CHECK(allocator.GetUsedSize() == used_size);
+				CHECK(allocator.GetAllocationCount() == live.size());
+				// Free neighbours are merged, so no two free blocks are next to each other.
+				CHECK(allocator.GetFreeBlockCount() <= live.size() + 1);
+			}
+			for (auto& [offset, allocation] : live) {
+				allocator.Free(allocation.second);
+			}
+			CHECK(allocator.GetUsedSize() == 0);
+			CHECK(allocator.GetFreeBlockCount() == 1);
+			CHECK(allocator.GetLargestFreeBlock() == size);
+		}
+		std::printf("%u operations over %u seeds, %llu allocations found no block\n", SEEDS * OPERATIONS, SEEDS,
+			static_cast<unsigned long long>(failed));
+	}
+
+	// Resource-sized allocations at 64 KiB granularity, with between half and all of live_count of them live.
+	// The time per operation does not depend on live_count.
+	void BenchmarkOperations(std::size_t live_count) {
+		constexpr UINT OPERATIONS = 2000000;
+		std::mt19937 random(1);
+		TlsfAllocator allocator(UINT64(1) << 38, 64 << 10);
+		std::vector<UINT32> live;
+		live.reserve(live_count);
+		double time = test::MeasureMilliseconds([&] {
+			for (UINT i = 0; i < OPERATIONS; i++) {
+				if (live.size() < live_count / 2 || (random() % 2 != 0 && live.size() < live_count)) {
+					UINT64 allocation_size = (1 + random() % 64) << 16;
+					std::optional<tlsf_allocation_t> allocation = allocator.Allocate(allocation_size, 64 << 10);
+					CHECK(allocation.has_value());
+					live.push_back(allocation->block);
+				}
+				else {
+					std::size_t freed = random() % live.size();
+					allocator.Free(live[freed]);
+					live[freed] = live.back();
+					live.pop_back();
+				}
+			}
+		});
+		CHECK(allocator.GetAllocationCount() == live.size());
+		std::printf("%u allocations and frees with up to %zu live: %.1f ns each, %u free blocks at the end\n",
+			OPERATIONS, live_count, time * 1e6 / OPERATIONS, allocator.GetFreeBlockCount());
+	}
+}
+
+int main() {
+	TestAllocate();
+	TestExactFit();
+	TestFragmentation();
+	TestErrors();
+	TestRandomOperations();
+	BenchmarkOperations(1024);
+	BenchmarkOperations(65536);
+	return test::Result();
+}
@@ -0,0 +1,350 @@
+#include "pch.h"
+#include "UploadScheduler.h"
+#include "test_utils.h"
+#include <map>
+#include <random>
+
+namespace {
+	// Stands in for a resource; only compared, never dereferenced.
+	ID3D12Resource* FakeResource(std::size_t id) {
+		return reinterpret_cast<ID3D12Resource*>((id + 1) * alignof(std::max_align_t));
+	}
+
+	// Simulated copy queue that runs the copies of a batch only once the batch completes, reading the staging
+	// buffer at that point, as a GPU lagging behind would: staging memory reused too early shows up as wrong
+	// contents. Batches complete when waited for and, unless disabled, at random when the fence is polled.
+	// Only RGBA8 textures are copied.
+	class FakeCopyQueue : public CopyQueue {
+	public:
+		// Contents of the destinations, by resource and subresource; buffers use subresource 0.
+		std::map<std::pair<ID3D12Resource*, UINT>, std::vector<BYTE>> contents;
+		// Staging offsets of the copies recorded so far, in order.
+		std::vector<UINT64> staging_offsets;
+		bool complete_when_polled = true;
+
+		FakeCopyQueue(UINT64 staging_size, UINT seed) : staging(staging_size), random(seed) {}
+
+		std::span<BYTE> GetStagingData() override {
+			return staging;
+		}
+
+		void RecordBufferCopy(ID3D12Resource* destination, UINT64 destination_offset, UINT64 staging_offset,
+			UINT64 size) override {
+			CHECK(staging_offset + size <= staging.size());
+			recording.push_back({ .destination = destination, .destination_offset = destination_offset,
+				.staging_offset = staging_offset, .size = size });
+			staging_offsets.push_back(staging_offset);
+		}
+
+		void RecordTextureCopy(ID3D12Resource* destination, UINT subresource,
+			const D3D12_PLACED_SUBRESOURCE_FOOTPRINT& footprint) override {
+			CHECK(footprint.Offset % D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT == 0);
+			CHECK(footprint.Offset + UINT64(footprint.Footprint.RowPitch) * footprint.Footprint.Height <=
+				staging.size());
+			recording.push_back({ .destination = destination, .staging_offset = footprint.Offset, .texture = true,
+				.subresource = subresource, .footprint = footprint });
+			staging_offsets.push_back(footprint.Offset);
+		}
+
+		void Submit(UINT64 fence_value) override {
+			CHECK(fence_value > signalled_value);
+			signalled_value = fence_value;
+			batches.push_back({ .fence_value = fence_value, .copies = std::move(recording) });
+			recording.clear();
+		}
+
+		UINT64 GetCompletedValue() override {
+			if (complete_when_polled) {
+				for (UINT count = random() % 3; count > 0 && !batches.empty(); count--) {
+					CompleteBatch();
+				}
+			}
+			return completed_value;
+		}
+
+		void WaitForValue(UINT64 value) override {
+			CHECK(value <= signalled_value);
+			while (completed_value < value && !batches.empty()) {
+				CompleteBatch();
+			}
+		}
+
+		bool IsIdle() const {
+			return batches.empty() && recording.empty();
+		}
+
+		std::size_t GetSubmittedCount() const {
+			return batches.size();
+		}
+
+		// Staging offsets that went back towards the beginning of the buffer.
+		UINT64 CountWraps() const {
+			UINT64 wraps = 0;
+			for (std::size_t i = 1; i < staging_offsets.size(); i++) {
+				wraps += staging_offsets[i] < staging_offsets[i - 1];
+			}
+			return wraps;
+		}
+	private:
+		struct copy_t {
+			ID3D12Resource* destination;
+			UINT64 destination_offset = 0;
+			UINT64 staging_offset;
+			UINT64 size = 0;
+			bool texture = false;
+			UINT subresource = 0;
+			D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = {};
+		};
+
+		struct batch_t {
+			UINT64 fence_value;
+			std::vector<copy_t> copies;
+		};
+
+		std::vector<BYTE> staging;
+		std::mt19937 random;
+		std::vector<copy_t> recording;
+		std::deque<batch_t> batches;
+		UINT64 signalled_value = 0;
+		UINT64 completed_value = 0;
+
+		void CompleteBatch() {
+			for (const copy_t& copy : batches.front().copies) {
+				if (!copy.texture) {
+					std::vector<BYTE>& buffer = contents[{ copy.destination, 0 }];
+					buffer.resize(std::max<std::size_t>(buffer.size(), copy.destination_offset + copy.size));
+					memcpy(buffer.data() + copy.destination_offset, staging.data() + copy.staging_offset, copy.size);
+					continue;
+				}
+				const D3D12_SUBRESOURCE_FOOTPRINT& footprint = copy.footprint.Footprint;
+				std::size_t row_size = std::size_t(footprint.Width) * 4;
+				std::vector<BYTE>& texture = contents[{ copy.destination, copy.subresource }];
+				texture.resize(row_size * footprint.Height);
+				for (UINT y = 0; y < footprint.Height; y++) {
+					memcpy(texture.data() + row_size * y,
+						staging.data() + copy.staging_offset + std::size_t(footprint.RowPitch) * y, row_size);
+				}
+			}
+			completed_value = batches.front().fence_value;
+			batches.pop_front();
+		}
+	};
+
+	std::vector<BYTE> RandomBytes(std::mt19937& random, std::size_t size) {
+		std::vector<BYTE> bytes(size);
+		for (BYTE& byte : bytes) {
+			byte = static_cast<BYTE>(random());
+		}
+		return bytes;
+	}
+
+	// Texture rows of width RGBA8 texels, source_row_pitch apart, as GetCopyableFootprints lays them out.
+	D3D12_PLACED_SUBRESOURCE_FOOTPRINT TextureFootprint(UINT width, UINT height) {
+		UINT row_pitch = (width * 4 + D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1) &
+			~(D3D12_TEXTURE_DATA_PITCH_ALIGNMENT - 1);
+		return { .Offset = 0, .Footprint = { .Format = DXGI_FORMAT_R8G8B8A8_UNORM, .Width = width, .Height = height,
+			.Depth = 1, .RowPitch = row_pitch } };
+	}
+
+	void TestBatches() {
+		FakeCopyQueue queue(4096, 0);
+		queue.complete_when_polled = false;
+		UploadScheduler scheduler(queue, { .batch_size = 1024 });
+		std::mt19937 random(0);
+
+		// Copies gather in a batch until it holds batch_size bytes.
+		std::vector<BYTE> first = RandomBytes(random, 600);
+		CHECK(scheduler.UploadBuffer(FakeResource(0), 0, first) == 1);
+		CHECK(queue.GetSubmittedCount() == 0);
+		std::vector<BYTE> second = RandomBytes(random, 600);
+		CHECK(scheduler.UploadBuffer(FakeResource(0), 600, second) == 1);
+		CHECK(queue.GetSubmittedCount() == 1);
+		CHECK(!scheduler.IsComplete(1));
+
+		std::vector<BYTE> third = RandomBytes(random, 100);
+		CHECK(scheduler.UploadBuffer(FakeResource(1), 0, third) == 2);
+		scheduler.Flush();
+		scheduler.Flush();
+		CHECK(scheduler.GetStats().batches == 2);
+
+		scheduler.Wait(1);
+		CHECK(scheduler.IsComplete(1));
+		CHECK(!scheduler.IsComplete(2));
+
+		// Waiting for the batch being recorded submits it first.
+		std::vector<BYTE> fourth = RandomBytes(random, 10);
+		upload_ticket_t ticket = scheduler.UploadBuffer(FakeResource(2), 0, fourth);
+		CHECK(ticket == 3);
+		scheduler.Wait(ticket);
+		CHECK(scheduler.IsComplete(ticket));
+
+		// Larger buffers are split into batches of batch_size.
+		std::vector<BYTE> large = RandomBytes(random, 2500);
+		UINT64 copies = scheduler.GetStats().copies;
+		CHECK(scheduler.UploadBuffer(FakeResource(3), 0, large) == 6);
+		CHECK(scheduler.GetStats().copies == copies + 3);
+		scheduler.WaitForIdle();
+		CHECK(queue.IsIdle());
+
+		first.insert(first.end(), second.begin(), second.end());
+		CHECK((queue.contents[{ FakeResource(0), 0 }] == first));
+		CHECK((queue.contents[{ FakeResource(1), 0 }] == third));
+		CHECK((queue.contents[{ FakeResource(2), 0 }] == fourth));
+		CHECK((queue.contents[{ FakeResource(3), 0 }] == large));
+		CHECK(scheduler.GetStats().bytes == 600 + 600 + 100 + 10 + 2500);
+		CHECK(scheduler.GetStats().stalls == 0);
+	}
+
+	void TestWraparound() {
+		FakeCopyQueue queue(4096, 0);
+		queue.complete_when_polled = false;
+		UploadScheduler scheduler(queue, { .batch_size = 4096 });
+		std::mt19937 random(1);
+
+		std::vector<std::vector<BYTE>> data;
+		for (std::size_t i = 0; i < 3; i++) {
+			data.push_back(RandomBytes(random, 1500));
+			scheduler.UploadBuffer(FakeResource(i), 0, data.back());
+			scheduler.Flush();
+		}
+		// The third upload does not fit before the end of the buffer, nor at its beginning while the first
+		// batch is in flight, so it waits for that batch and then wraps around.
+		CHECK((queue.staging_offsets == std::vector<UINT64>{ 0, 1504, 0 }));
+		CHECK(scheduler.GetStats().stalls == 1);
+		CHECK(scheduler.IsComplete(1));
+		CHECK(!scheduler.IsComplete(2));
+
+		// Textures are staged at the placement alignment, with the row pitch of their footprint. This one only
+		// fits once the second batch has finished as well.
+		D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = TextureFootprint(3, 2);
+		std::vector<BYTE> texels = RandomBytes(random, 3 * 4 * 2);
+		scheduler.UploadTexture(FakeResource(3), 5, footprint, 2, 3 * 4, texels.data(), 3 * 4);
+		CHECK(queue.staging_offsets.back() == 1536);
+		CHECK(scheduler.GetStats().stalls == 2);
+
+		scheduler.WaitForIdle();
+		for (std::size_t i = 0; i < data.size(); i++) {
+			CHECK((queue.contents[{ FakeResource(i), 0 }] == data[i]));
+		}
+		CHECK((queue.contents[{ FakeResource(3), 5 }] == texels));
+
+		// Once every batch has finished, staging starts over at the beginning of the buffer.
+		scheduler.UploadBuffer(FakeResource(4), 0, data[0]);
+		CHECK(queue.staging_offsets.back() == 0);
+		scheduler.WaitForIdle();
+	}
+
+	void TestErrors() {
+		FakeCopyQueue queue(4096, 0);
+		CHECK_THROWS(UploadScheduler(queue, { .batch_size = 0 }));
+		CHECK_THROWS(UploadScheduler(queue, { .batch_size = 8192 }));
+		FakeCopyQueue unaligned_queue(1000, 0);
+		CHECK_THROWS(UploadScheduler(unaligned_queue, { .batch_size = 512 }));
+
+		UploadScheduler scheduler(queue, { .batch_size = 4096 });
+		CHECK_THROWS(scheduler.UploadBuffer(FakeResource(0), 0, {}));
+		std::vector<BYTE> texels(64 * 4 * 32);
+		CHECK_THROWS(scheduler.UploadTexture(FakeResource(0), 0, TextureFootprint(64, 32), 32, 64 * 4, texels.data(),
+			64 * 4));
+		CHECK_THROWS(scheduler.UploadTexture(FakeResource(0), 0, TextureFootprint(1, 1), 0, 4, texels.data(), 4));
+	}
+
+	// Random buffer and texture uploads, waits and flushes, against staging buffers and batches of random
+	// sizes, with a queue that completes batches in random steps.
+	void TestRandomUploads() {
+		constexpr UINT SEEDS = 300;
+		constexpr UINT UPLOADS = 200;
+		UINT64 batches = 0, wraps = 0, stalls = 0;
+		for (UINT seed = 0; seed < SEEDS; seed++) {
+			std::mt19937 random(seed);
+			UINT64 staging_size = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT * (8 + random() % 256);
+			FakeCopyQueue queue(staging_size, seed * 7 + 1);
+			UINT64 batch_size = D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT *
+				(1 + random() % (staging_size / 2 / D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT));
+			UploadScheduler scheduler(queue, { .batch_size = batch_size });
+
+			std::map<std::pair<ID3D12Resource*, UINT>, std::vector<BYTE>> expected;
+			upload_ticket_t last_ticket = 0;
+			for (UINT i = 0; i < UPLOADS; i++) {
+				upload_ticket_t ticket;
+				if (random() % 3 != 0) {
+					// Every tenth buffer is larger than the staging buffer.
+					bool large = random() % 10 == 0;
+					std::size_t size = 1 + random() % (large ? staging_size * 3 : 4000);
+					std::vector<BYTE> data = RandomBytes(random, size);
+					ticket = scheduler.UploadBuffer(FakeResource(i), 0, data);
+					expected[{ FakeResource(i), 0 }] = std::move(data);
+				}
+				else {
+					UINT width = 1 + random() % 64;
+					UINT height = 1 + random() % 32;
+					D3D12_PLACED_SUBRESOURCE_FOOTPRINT footprint = TextureFootprint(width, height);
+					if (UINT64(footprint.Footprint.RowPitch) * height > staging_size) {
+						height = 1;
+						footprint.Footprint.Height = 1;
+					}
+					// Source rows are either packed or padded.
+					std::size_t row_size = std::size_t(width) * 4;
+					std::size_t source_row_pitch = row_size + (random() % 2) * 12;
+					std::vector<BYTE> source = RandomBytes(random, source_row_pitch * height);
+					std::vector<BYTE> texels(row_size * height);
+					for (UINT y = 0; y < height; y++) {
+						memcpy(texels.data() + row_size * y, source.data() + source_row_pitch * y, row_size);
+					}
+					UINT subresource = random() % 4;
+					ticket = scheduler.UploadTexture(FakeResource(i), subresource, footprint, height, row_size,
+						source.data(), source_row_pitch);
+					expected[{ FakeResource(i), subresource }] = std::move(texels);
+				}
+				CHECK(ticket >= last_ticket);
+				last_ticket = ticket;
+
+				UINT action = random() % 10;
+				if (action == 0) {
+					scheduler.Wait(ticket);
+					CHECK(scheduler.IsComplete(ticket));
+				}
+				else if (action == 1) {
+					scheduler.Flush();
+				}
+			}
+			scheduler.WaitForIdle();
+			CHECK(scheduler.IsComplete(last_ticket));
+			CHECK(queue.IsIdle());
+			CHECK(queue.contents == expected);
+
+			batches += scheduler.GetStats().batches;
+			stalls += scheduler.GetStats().stalls;
+			wraps += queue.CountWraps();
+		}
+		std::printf("%u uploads over %u seeds: %llu batches, %llu staging wraps, %llu waits for staging room\n",
+			SEEDS * UPLOADS, SEEDS, static_cast<unsigned long long>(batches), static_cast<unsigned long long>(wraps),
+			static_cast<unsigned long long>(stalls));
+	}
+
+	// Stages 256 MiB through a 64 MiB buffer, with a queue that copies each batch as soon as it is polled.
+	void BenchmarkStaging() {
+		constexpr UINT64 STAGING_SIZE = UINT64(64) << 20;
+		FakeCopyQueue queue(STAGING_SIZE, 0);
+		UploadScheduler scheduler(queue);
+		std::vector<BYTE> data(std::size_t(STAGING_SIZE * 4), 1);
+		queue.contents[{ FakeResource(0), 0 }].resize(data.size());
+		double time = test::MeasureMilliseconds([&] {
+			scheduler.UploadBuffer(FakeResource(0), 0, data);
+			scheduler.WaitForIdle();
+		});
+		CHECK((queue.contents[{ FakeResource(0), 0 }] == data));
+		std::printf("staged 256 MiB through a 64 MiB buffer in %llu batches, %.1f ms (%.2f GB/s, fake copies "
+			"included)\n", static_cast<unsigned long long>(scheduler.GetStats().batches), time,
+			data.size() / (time * 1e6));
+	}
+}
+
+int main() {
+	TestBatches();
+	TestWraparound();
+	TestErrors();
+	TestRandomUploads();
+	BenchmarkStaging();
+	return test::Result();
+}
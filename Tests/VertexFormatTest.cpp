@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "VertexFormat.h"
+#include "test_utils.h"
+#include <random>
+
+namespace {
+	// Positions spread over a box that does not contain the origin, texture coordinates that repeat outside
+	// [0, 1], random colors and materials.
+	std::vector<vertex_t> MakeVertices(std::size_t count) {
+		std::mt19937 random(7);
+		std::uniform_real_distribution<FLOAT> x(-40.0f, 130.0f), y(2.0f, 9.5f), z(-1000.0f, -250.0f);
+		std::uniform_real_distribution<FLOAT> tex_coord(-3.0f, 4.0f), channel(0.0f, 1.0f);
+		std::uniform_int_distribution<UINT> material(0, UINT16_MAX);
+		std::vector<vertex_t> vertices(count);
+		for (vertex_t& vertex : vertices) {
+			vertex = {
+				.position = { x(random), y(random), z(random) },
+				.color = { channel(random), channel(random), channel(random), channel(random) },
+				.tex_coord = { tex_coord(random), tex_coord(random) },
+				.material = material(random)
+			};
+		}
+		return vertices;
+	}
+
+	// Largest difference of a decoded value from the original: half a quantization step of the extent of the
+	// axis for UNORM16 and UNORM10, plus the rounding of the float arithmetic that maps it back to scene space.
+	FLOAT PositionTolerance(position_encoding_t encoding, const position_dequantization_t& dequantization,
+		UINT axis) {
+		FLOAT magnitude = std::max(std::abs(dequantization.offset[axis]),
+			std::abs(dequantization.offset[axis] + dequantization.scale[axis]));
+		FLOAT rounding = 4.0f * std::numeric_limits<FLOAT>::epsilon() * magnitude;
+		switch (encoding) {
+		case position_encoding_t::UNORM16: return 0.5f * dequantization.scale[axis] / 65535.0f + rounding;
+		case position_encoding_t::UNORM10: return 0.5f * dequantization.scale[axis] / 1023.0f + rounding;
+		default: return 0.0f;
+		}
+	}
+
+	void TestRoundTrip(const std::vector<vertex_t>& vertices, const vertex_format_t& format) {
+		position_dequantization_t dequantization = ComputePositionDequantization(vertices, format.position_encoding);
+		std::vector<BYTE> packed(vertices.size() * GetVertexStride(format));
+		PackVertices(vertices, format, dequantization, packed.data());
+		std::vector<vertex_t> unpacked(vertices.size());
+		UnpackVertices(packed, format, dequantization, unpacked.data());
+
+		FLOAT position_error[3] = {}, tex_coord_error = 0.0f, color_error = 0.0f;
+		bool same_materials = true;
+		for (std::size_t i = 0; i < vertices.size(); i++) {
+			const vertex_t& original = vertices[i];
+			const vertex_t& decoded = unpacked[i];
+			for (UINT axis = 0; axis < 3; axis++) {
+				position_error[axis] = std::max(position_error[axis],
+					std::abs(decoded.position[axis] - original.position[axis]));
+			}
+			for (UINT component = 0; component < 2; component++) {
+				FLOAT error = std::abs(decoded.tex_coord[component] - original.tex_coord[component]);
+				// Half floats round to 11 significant bits, so the error is relative to the coordinate, down to
+				// the smallest normal half.
+				if (format.half_tex_coord) {
+					error /= std::max(std::abs(original.tex_coord[component]), 1.0f / 16384.0f);
+				}
+				tex_coord_error = std::max(tex_coord_error, error);
+			}
+			for (UINT channel = 0; channel < 4; channel++) {
+				FLOAT expected = format.color ? original.color[channel] : 1.0f;
+				color_error = std::max(color_error, std::abs(decoded.color[channel] - expected));
+			}
+			same_materials = same_materials && decoded.material == original.material;
+		}
+
+		for (UINT axis = 0; axis < 3; axis++) {
+			CHECK(position_error[axis] <= PositionTolerance(format.position_encoding, dequantization, axis));
+		}
+		CHECK(tex_coord_error <= (format.half_tex_coord ? 1.0f / 2048.0f : 0.0f));
+		CHECK(color_error <= (format.color ? 0.5f / 255.0f + 1e-6f : 0.0f));
+		CHECK(same_materials);
+	}
+
+	void TestRoundTrips() {
+		std::vector<vertex_t> vertices = MakeVertices(10000);
+		for (position_encoding_t encoding :
+			{ position_encoding_t::FLOAT3, position_encoding_t::UNORM16, position_encoding_t::UNORM10 }) {
+			for (bool half_tex_coord : { false, true }) {
+				for (bool color : { false, true }) {
+					TestRoundTrip(vertices, { .position_encoding = encoding, .half_tex_coord = half_tex_coord,
+						.color = color });
+				}
+			}
+		}
+	}
+
+	// An axis on which all vertices lie at the same coordinate has a zero extent, and decodes exactly.
+	void TestFlatAxis() {
+		std::vector<vertex_t> vertices = MakeVertices(100);
+		for (vertex_t& vertex : vertices) {
+			vertex.position[1] = 3.25f;
+		}
+		for (position_encoding_t encoding : { position_encoding_t::UNORM16, position_encoding_t::UNORM10 }) {
+			vertex_format_t format = { .position_encoding = encoding };
+			position_dequantization_t dequantization = ComputePositionDequantization(vertices, encoding);
+			CHECK(dequantization.scale[1] == 0.0f);
+			std::vector<BYTE> packed(vertices.size() * GetVertexStride(format));
+			PackVertices(vertices, format, dequantization, packed.data());
+			std::vector<vertex_t> unpacked(vertices.size());
+			UnpackVertices(packed, format, dequantization, unpacked.data());
+			CHECK(std::all_of(unpacked.begin(), unpacked.end(), [](const vertex_t& vertex) {
+				return vertex.position[1] == 3.25f;
+			}));
+		}
+	}
+
+	void TestMaterialOutOfRange() {
+		std::vector<vertex_t> vertices = MakeVertices(1);
+		vertices[0].material = UINT16_MAX + 1;
+		vertex_format_t format;
+		std::vector<BYTE> packed(GetVertexStride(format));
+		CHECK_THROWS(PackVertices(vertices, format, ComputePositionDequantization(vertices,
+			format.position_encoding), packed.data()));
+	}
+}
+
+int main() {
+	TestRoundTrips();
+	TestFlatAxis();
+	TestMaterialOutOfRange();
+	return test::Result();
+}
@@ -0,0 +1,249 @@
+#include "pch.h"
+#include "VirtualTexture.h"
+#include "test_utils.h"
+#include <map>
+#include <random>
+
+namespace {
+	// Levels of an RGBA8 texture with tightly packed rows, laid out one after the other.
+	std::vector<texture_level_t> Levels(UINT width, UINT height) {
+		std::vector<texture_level_t> levels;
+		std::size_t offset = 0;
+		while (true) {
+			levels.push_back({ .width = width, .height = height, .offset = offset, .row_pitch = width * 4,
+				.row_count = height });
+			offset += std::size_t(width) * height * 4;
+			if (width == 1 && height == 1) {
+				return levels;
+			}
+			width = std::max(width / 2, 1u);
+			height = std::max(height / 2, 1u);
+		}
+	}
+
+	std::size_t TileBytes(UINT tile_size) {
+		return std::size_t(tile_size) * tile_size * 4;
+	}
+
+	// 512x512 in tiles of 128: 4x4 tiles, then 2x2, then a single tile.
+	void TestPageTable() {
+		std::vector<texture_level_t> levels = Levels(512, 512);
+		VirtualTexture texture(levels, 1, DXGI_FORMAT_R8G8B8A8_UNORM, { .cache_budget = 6 * TileBytes(128) });
+		CHECK(texture.GetCacheSlotCount() == 6);
+		CHECK(texture.GetTiledLevelCount() == 3);
+		CHECK(texture.GetTileColumns(0) == 4 && texture.GetTileRows(1) == 2 && texture.GetTileColumns(2) == 1);
+		CHECK(texture.GetTileRowPitch() == 512 && texture.GetTileRowCount() == 128);
+
+		std::vector<tile_upload_t> uploads = texture.Update({});
+		CHECK(uploads.size() == 1);
+		CHECK(uploads[0].tile.level == 2 && uploads[0].cache_slot == 0);
+		// Nothing is mapped before the coarsest tile is in the cache.
+		CHECK(texture.GetPageTable(0, 0)[5].level == 3);
+		texture.CompleteUpload(uploads[0]);
+		for (page_entry_t page : texture.GetPageTable(0, 0)) {
+			CHECK(page.cache_slot == 0 && page.level == 2);
+		}
+
+		// The tile furthest from its requested level comes first.
+		std::vector<tile_id_t> feedback = {
+			{ .slice = 0, .level = 1, .x = 1, .y = 1 },
+			{ .slice = 0, .level = 1, .x = 1, .y = 1 },
+			{ .slice = 0, .level = 0, .x = 0, .y = 0 }
+		};
+		uploads = texture.Update(feedback);
+		CHECK(uploads.size() == 2);
+		CHECK(uploads[0].tile.level == 0 && uploads[1].tile.level == 1);
+		// Requests for tiles that are still loading are neither uploaded again nor counted as hits.
+		CHECK(texture.Update(feedback).empty());
+		CHECK(texture.GetStats().hits == 0);
+		for (const tile_upload_t& upload : uploads) {
+			texture.CompleteUpload(upload);
+		}
+		std::span<const page_entry_t> pages = texture.GetPageTable(0, 0);
+		CHECK(pages[0].cache_slot == uploads[0].cache_slot && pages[0].level == 0);
+		CHECK(pages[1].level == 2);
+		CHECK(pages[2 * 4 + 3].cache_slot == uploads[1].cache_slot && pages[2 * 4 + 3].level == 1);
+		CHECK(texture.GetPageTable(0, 1)[3].level == 1);
+
+		// Levels past the tiled ones sample the coarsest tile.
+		CHECK(texture.Update(std::vector<tile_id_t>{ { .slice = 0, .level = 9, .x = 0, .y = 0 } }).empty());
+		const virtual_texture_stats_t& stats = texture.GetStats();
+		CHECK(stats.requests == 7 && stats.hits == 1);
+		CHECK(stats.uploads == 3 && stats.upload_bytes == 3 * TileBytes(128));
+	}
+
+	void TestEviction() {
+		std::vector<texture_level_t> levels = Levels(512, 512);
+		VirtualTexture texture(levels, 1, DXGI_FORMAT_R8G8B8A8_UNORM, { .cache_budget = 3 * TileBytes(128) });
+		tile_id_t a = { .slice = 0, .level = 0, .x = 0, .y = 0 };
+		tile_id_t b = { .slice = 0, .level = 0, .x = 3, .y = 0 };
+		tile_id_t c = { .slice = 0, .level = 0, .x = 0, .y = 3 };
+		auto update = [&](std::vector<tile_id_t> feedback) {
+			std::vector<tile_upload_t> uploads = texture.Update(feedback);
+			for (const tile_upload_t& upload : uploads) {
+				texture.CompleteUpload(upload);
+			}
+			return uploads;
+		};
+		update({});
+		CHECK(update({ a, b }).size() == 2);
+		// b is the least recently used, since a was requested again.
+		std::vector<tile_upload_t> uploads = update({ a, c });
+		CHECK(uploads.size() == 1);
+		CHECK(texture.GetStats().evictions == 1);
+		CHECK(texture.GetPageTable(0, 0)[3].level == 2);
+		CHECK(texture.GetPageTable(0, 0)[12].cache_slot == uploads[0].cache_slot);
+		// Every slot holds a tile requested in this frame, so b waits.
+		CHECK(update({ a, b, c }).empty());
+		CHECK(texture.GetStats().evictions == 1);
+		CHECK(update({ b }).size() == 1);
+		CHECK(texture.GetPageTable(0, 0)[3].level == 0);
+	}
+
+	void TestUploadLimit() {
+		std::vector<texture_level_t> levels = Levels(1024, 1024);
+		VirtualTexture texture(levels, 2, DXGI_FORMAT_R8G8B8A8_UNORM, { .max_uploads_per_update = 4 });
+		std::vector<tile_id_t> feedback;
+		for (UINT i = 0; i < 8; i++) {
+			// Tile i is requested i + 1 times.
+			for (UINT j = 0; j <= i; j++) {
+				feedback.push_back({ .slice = 1, .level = 0, .x = i, .y = 0 });
+			}
+		}
+		// The coarsest tiles of both slices come on top of the limit.
+		std::vector<tile_upload_t> uploads = texture.Update(feedback);
+		CHECK(uploads.size() == 6);
+		CHECK(uploads[2].tile.x == 7 && uploads[5].tile.x == 4);
+		for (const tile_upload_t& upload : uploads) {
+			texture.CompleteUpload(upload);
+		}
+		uploads = texture.Update(feedback);
+		CHECK(uploads.size() == 4 && uploads[0].tile.x == 3);
+	}
+
+	void TestCopyTile() {
+		// The tile at 2, 1 covers texels 256 to 299 and 128 to 199 of level 0.
+		std::vector<texture_level_t> levels = Levels(300, 200);
+		std::vector<BYTE> data(levels.back().offset + 4);
+		for (std::size_t i = 0; i < data.size(); i++) {
+			data[i] = static_cast<BYTE>(i * 7 + i / 251);
+		}
+		VirtualTexture texture(levels, 1, DXGI_FORMAT_R8G8B8A8_UNORM);
+		std::vector<BYTE> tile(TileBytes(128), 0xff);
+		texture.CopyTile({ .slice = 0, .level = 0, .x = 2, .y = 1 }, data, tile.data());
+		bool match = true;
+		for (UINT y = 0; y < 128; y++) {
+			for (UINT x = 0; x < 128 * 4; x++) {
+				UINT texel_x = 256 + x / 4, texel_y = 128 + y;
+				BYTE expected = texel_x < 300 && texel_y < 200 ? data[texel_y * levels[0].row_pitch + 256 * 4 + x] : 0;
+				match &= tile[y * 512 + x] == expected;
+			}
+		}
+		CHECK(match);
+
+		CHECK_THROWS(texture.CopyTile({ .slice = 0, .level = 0, .x = 2, .y = 1 },
+			std::span(data).first(levels[1].offset - 1), tile.data()));
+		VirtualTexture compressed(levels, 1, DXGI_FORMAT_BC1_UNORM);
+		CHECK(compressed.GetTileRowPitch() == 256 && compressed.GetTileRowCount() == 32);
+	}
+
+	void TestErrors() {
+		std::vector<texture_level_t> levels = Levels(512, 512);
+		CHECK_THROWS(VirtualTexture(levels, 1, DXGI_FORMAT_UNKNOWN));
+		CHECK_THROWS(VirtualTexture(levels, 0, DXGI_FORMAT_R8G8B8A8_UNORM));
+		CHECK_THROWS(VirtualTexture(levels, 1, DXGI_FORMAT_R8G8B8A8_UNORM, { .tile_size = 96 }));
+		CHECK_THROWS(VirtualTexture(levels, 1, DXGI_FORMAT_BC7_UNORM, { .tile_size = 2 }));
+		CHECK_THROWS(VirtualTexture(levels, 2, DXGI_FORMAT_R8G8B8A8_UNORM, { .cache_budget = 2 * TileBytes(128) }));
+		VirtualTexture texture(levels, 1, DXGI_FORMAT_R8G8B8A8_UNORM);
+		CHECK_THROWS(texture.Update(std::vector<tile_id_t>{ { .slice = 1, .level = 0, .x = 0, .y = 0 } }));
+		CHECK_THROWS(texture.Update(std::vector<tile_id_t>{ { .slice = 0, .level = 1, .x = 2, .y = 0 } }));
+		CHECK_THROWS(texture.CompleteUpload({ .tile = { .slice = 0, .level = 0, .x = 0, .y = 0 }, .cache_slot = 1 }));
+		tile_upload_t upload = texture.Update({})[0];
+		texture.CompleteUpload(upload);
+		CHECK_THROWS(texture.CompleteUpload(upload));
+	}
+
+	// A view that drifts over three slices of a 1000x600 texture, sampling 300 tiles a frame around its
+	// center at random levels, some past the tiled ones. Every page must show the tile that the cache slot
+	// it points to holds: the requested tile itself or the coarser tile covering it at the level of the entry.
+	void TestSyntheticFeedback() {
+		constexpr UINT SLICES = 3;
+		constexpr UINT FRAMES = 2000;
+		constexpr UINT SAMPLES = 300;
+		constexpr UINT TILE_SIZE = 64;
+		std::vector<texture_level_t> levels = Levels(1000, 600);
+		VirtualTexture texture(levels, SLICES, DXGI_FORMAT_R8G8B8A8_UNORM, {
+			.tile_size = TILE_SIZE,
+			.cache_budget = 40 * TileBytes(TILE_SIZE),
+			.max_uploads_per_update = 8
+		});
+		CHECK(texture.GetTiledLevelCount() == 5);
+
+		std::mt19937 random(5);
+		std::uniform_real_distribution<double> step(-0.01, 0.01), spread(-0.1, 0.1);
+		std::map<UINT, tile_id_t> slot_tiles;
+		double center_x = 0.5, center_y = 0.5;
+		UINT mismatches = 0;
+		for (UINT frame = 0; frame < FRAMES; frame++) {
+			center_x = std::clamp(center_x + step(random), 0.0, 1.0);
+			center_y = std::clamp(center_y + step(random), 0.0, 1.0);
+			std::vector<tile_id_t> feedback;
+			for (UINT i = 0; i < SAMPLES; i++) {
+				UINT level = random() % 8;
+				UINT tiled_level = std::min(level, texture.GetTiledLevelCount() - 1);
+				double u = std::clamp(center_x + spread(random), 0.0, 0.999);
+				double v = std::clamp(center_y + spread(random), 0.0, 0.999);
+				feedback.push_back({
+					.slice = static_cast<UINT>(random() % SLICES),
+					.level = level,
+					.x = static_cast<UINT>(u * texture.GetTileColumns(tiled_level)),
+					.y = static_cast<UINT>(v * texture.GetTileRows(tiled_level))
+				});
+			}
+			for (const tile_upload_t& upload : texture.Update(feedback)) {
+				slot_tiles[upload.cache_slot] = upload.tile;
+				texture.CompleteUpload(upload);
+			}
+
+			for (UINT slice = 0; slice < SLICES; slice++) {
+				for (UINT level = 0; level < texture.GetTiledLevelCount(); level++) {
+					std::span<const page_entry_t> pages = texture.GetPageTable(slice, level);
+					UINT columns = texture.GetTileColumns(level);
+					for (UINT y = 0; y < texture.GetTileRows(level); y++) {
+						for (UINT x = 0; x < columns; x++) {
+							page_entry_t page = pages[y * columns + x];
+							UINT covering_x = x, covering_y = y;
+							for (UINT covering_level = level + 1; covering_level <= page.level; covering_level++) {
+								covering_x = std::min(covering_x / 2, texture.GetTileColumns(covering_level) - 1);
+								covering_y = std::min(covering_y / 2, texture.GetTileRows(covering_level) - 1);
+							}
+							auto slot_tile = slot_tiles.find(page.cache_slot);
+							mismatches += slot_tile == slot_tiles.end() || slot_tile->second.slice != slice ||
+								slot_tile->second.level != page.level || slot_tile->second.x != covering_x ||
+								slot_tile->second.y != covering_y;
+						}
+					}
+				}
+			}
+		}
+		CHECK(mismatches == 0);
+
+		const virtual_texture_stats_t& stats = texture.GetStats();
+		CHECK(stats.requests == UINT64(FRAMES) * SAMPLES);
+		CHECK(stats.evictions > 0);
+		std::printf("%u frames of %u tile requests: %.1f%% hit, %llu uploads, %.1f MiB/s at 60 frames per second, "
+			"%llu evictions\n", FRAMES, SAMPLES, 100.0 * stats.hits / stats.requests,
+			static_cast<unsigned long long>(stats.uploads), stats.upload_bytes / (1024.0 * 1024.0) * 60.0 / FRAMES,
+			static_cast<unsigned long long>(stats.evictions));
+	}
+}
+
+int main() {
+	TestPageTable();
+	TestEviction();
+	TestUploadLimit();
+	TestCopyTile();
+	TestErrors();
+	TestSyntheticFeedback();
+	return test::Result();
+}
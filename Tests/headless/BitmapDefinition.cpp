@@ -0,0 +1,25 @@
+#include "pch.h"
+#include "BitmapDefinition.h"
+
+// Builds BitmapDefinition with the portable decoder only, in place of D3DProject/BitmapDefinition.cpp, as
+// WIC is not available headless.
+
+BitmapDefinition::BitmapDefinition(PCWSTR uri, bitmap_decoder_t decoder) : uri(uri), decoder(decoder), png_header() {}
+
+void BitmapDefinition::CreateDeviceIndependentResources(IWICImagingFactory*) {
+	if (decoder != bitmap_decoder_t::PORTABLE) {
+		throw std::runtime_error("BitmapDefinition: WIC is not available in headless builds");
+	}
+	file.emplace(winrt::to_string(uri));
+	file_data = { reinterpret_cast<const BYTE*>(file->GetData().data()), file->GetData().size() };
+	png_header = ReadPngHeader(file_data);
+}
+
+void BitmapDefinition::GetSize(UINT* width, UINT* height) {
+	*width = png_header.width;
+	*height = png_header.height;
+}
+
+void BitmapDefinition::CopyPixels(BYTE* destination, UINT row_pitch) {
+	DecodePng(file_data, destination, row_pitch);
+}
@@ -0,0 +1,432 @@
+#pragma once
+
+// Scalar stand-in for the part of DirectXMath that the headless modules use, with the semantics of the
+// library: vectors of four floats, row vectors multiplied on the left of matrices, and comparison results as
+// all-ones or all-zero masks.
+
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <iterator>
+
+namespace DirectX {
+	constexpr float XM_PI = 3.141592654f;
+
+	struct XMVECTOR {
+		float f[4];
+	};
+
+	typedef const XMVECTOR FXMVECTOR;
+	typedef const XMVECTOR GXMVECTOR;
+	typedef const XMVECTOR HXMVECTOR;
+	typedef const XMVECTOR& CXMVECTOR;
+
+	struct XMMATRIX {
+		XMVECTOR r[4];
+
+		XMMATRIX() = default;
+		XMMATRIX(FXMVECTOR r0, FXMVECTOR r1, FXMVECTOR r2, CXMVECTOR r3) : r{ r0, r1, r2, r3 } {}
+	};
+
+	typedef const XMMATRIX& FXMMATRIX;
+	typedef const XMMATRIX& CXMMATRIX;
+
+	struct XMVECTORF32 {
+		union {
+			float f[4];
+			XMVECTOR v;
+		};
+
+		operator XMVECTOR() const {
+			return v;
+		}
+	};
+
+	struct XMVECTORU32 {
+		union {
+			std::uint32_t u[4];
+			XMVECTOR v;
+		};
+
+		operator XMVECTOR() const {
+			return v;
+		}
+	};
+
+	inline const XMVECTORF32 g_XMOne = { { { 1.0f, 1.0f, 1.0f, 1.0f } } };
+	inline const XMVECTORU32 g_XMSelect0001 = { { { 0, 0, 0, 0xFFFFFFFFu } } };
+
+	struct XMFLOAT2 {
+		float x;
+		float y;
+
+		XMFLOAT2() = default;
+		constexpr XMFLOAT2(float x, float y) : x(x), y(y) {}
+	};
+
+	struct XMFLOAT3 {
+		float x;
+		float y;
+		float z;
+
+		XMFLOAT3() = default;
+		constexpr XMFLOAT3(float x, float y, float z) : x(x), y(y), z(z) {}
+	};
+
+	struct XMFLOAT4 {
+		float x;
+		float y;
+		float z;
+		float w;
+
+		XMFLOAT4() = default;
+		constexpr XMFLOAT4(float x, float y, float z, float w) : x(x), y(y), z(z), w(w) {}
+	};
+
+	struct alignas(16) XMFLOAT4A : public XMFLOAT4 {
+		using XMFLOAT4::XMFLOAT4;
+	};
+
+	struct XMUINT4 {
+		std::uint32_t x;
+		std::uint32_t y;
+		std::uint32_t z;
+		std::uint32_t w;
+	};
+
+	struct XMFLOAT4X4 {
+		float m[4][4];
+	};
+
+	namespace headless {
+		template <typename F>
+		XMVECTOR Map(FXMVECTOR v, F f) {
+			return { { f(v.f[0]), f(v.f[1]), f(v.f[2]), f(v.f[3]) } };
+		}
+
+		template <typename F>
+		XMVECTOR Map(FXMVECTOR v1, FXMVECTOR v2, F f) {
+			return { { f(v1.f[0], v2.f[0]), f(v1.f[1], v2.f[1]), f(v1.f[2], v2.f[2]), f(v1.f[3], v2.f[3]) } };
+		}
+
+		inline float Mask(bool set) {
+			std::uint32_t bits = set ? 0xFFFFFFFFu : 0;
+			float mask;
+			std::memcpy(&mask, &bits, sizeof(mask));
+			return mask;
+		}
+
+		inline std::uint32_t Bits(float value) {
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			return bits;
+		}
+
+		inline std::uint32_t FloatToUInt(float value) {
+			if (!(value > 0.0f)) {
+				return 0;
+			}
+			return value >= 4294967295.0f ? 0xFFFFFFFFu : static_cast<std::uint32_t>(value);
+		}
+	}
+
+	inline XMVECTOR XMVectorSet(float x, float y, float z, float w) {
+		return { { x, y, z, w } };
+	}
+
+	inline XMVECTOR XMVectorReplicate(float value) {
+		return { { value, value, value, value } };
+	}
+
+	inline XMVECTOR XMVectorZero() {
+		return XMVectorReplicate(0.0f);
+	}
+
+	inline XMVECTOR XMVectorSplatOne() {
+		return XMVectorReplicate(1.0f);
+	}
+
+	inline float XMVectorGetX(FXMVECTOR v) {
+		return v.f[0];
+	}
+
+	inline float XMVectorGetY(FXMVECTOR v) {
+		return v.f[1];
+	}
+
+	inline float XMVectorGetZ(FXMVECTOR v) {
+		return v.f[2];
+	}
+
+	inline float XMVectorGetW(FXMVECTOR v) {
+		return v.f[3];
+	}
+
+	inline XMVECTOR XMVectorSplatX(FXMVECTOR v) {
+		return XMVectorReplicate(v.f[0]);
+	}
+
+	inline XMVECTOR XMVectorSplatY(FXMVECTOR v) {
+		return XMVectorReplicate(v.f[1]);
+	}
+
+	inline XMVECTOR XMVectorSplatZ(FXMVECTOR v) {
+		return XMVectorReplicate(v.f[2]);
+	}
+
+	inline XMVECTOR XMVectorSplatW(FXMVECTOR v) {
+		return XMVectorReplicate(v.f[3]);
+	}
+
+	template <std::uint32_t X, std::uint32_t Y, std::uint32_t Z, std::uint32_t W>
+	XMVECTOR XMVectorSwizzle(FXMVECTOR v) {
+		static_assert(X < 4 && Y < 4 && Z < 4 && W < 4);
+		return { { v.f[X], v.f[Y], v.f[Z], v.f[W] } };
+	}
+
+	inline XMVECTOR XMLoadFloat2(const XMFLOAT2* source) {
+		return { { source->x, source->y, 0.0f, 0.0f } };
+	}
+
+	inline XMVECTOR XMLoadFloat3(const XMFLOAT3* source) {
+		return { { source->x, source->y, source->z, 0.0f } };
+	}
+
+	inline XMVECTOR XMLoadFloat4(const XMFLOAT4* source) {
+		return { { source->x, source->y, source->z, source->w } };
+	}
+
+	inline XMVECTOR XMLoadFloat4A(const XMFLOAT4A* source) {
+		return XMLoadFloat4(source);
+	}
+
+	inline void XMStoreFloat2(XMFLOAT2* destination, FXMVECTOR v) {
+		*destination = { v.f[0], v.f[1] };
+	}
+
+	inline void XMStoreFloat3(XMFLOAT3* destination, FXMVECTOR v) {
+		*destination = { v.f[0], v.f[1], v.f[2] };
+	}
+
+	inline void XMStoreFloat4(XMFLOAT4* destination, FXMVECTOR v) {
+		*destination = { v.f[0], v.f[1], v.f[2], v.f[3] };
+	}
+
+	inline void XMStoreFloat4A(XMFLOAT4A* destination, FXMVECTOR v) {
+		XMStoreFloat4(destination, v);
+	}
+
+	// Converts to unsigned integers, saturating.
+	inline void XMStoreUInt4(XMUINT4* destination, FXMVECTOR v) {
+		*destination = { headless::FloatToUInt(v.f[0]), headless::FloatToUInt(v.f[1]),
+			headless::FloatToUInt(v.f[2]), headless::FloatToUInt(v.f[3]) };
+	}
+
+	inline XMVECTOR XMVectorAdd(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return a + b; });
+	}
+
+	inline XMVECTOR XMVectorSubtract(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return a - b; });
+	}
+
+	inline XMVECTOR XMVectorMultiply(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return a * b; });
+	}
+
+	inline XMVECTOR XMVectorDivide(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return a / b; });
+	}
+
+	inline XMVECTOR XMVectorMultiplyAdd(FXMVECTOR v1, FXMVECTOR v2, FXMVECTOR v3) {
+		return XMVectorAdd(XMVectorMultiply(v1, v2), v3);
+	}
+
+	inline XMVECTOR XMVectorScale(FXMVECTOR v, float scale) {
+		return headless::Map(v, [scale](float a) { return a * scale; });
+	}
+
+	inline XMVECTOR XMVectorNegate(FXMVECTOR v) {
+		return headless::Map(v, [](float a) { return -a; });
+	}
+
+	inline XMVECTOR XMVectorReciprocal(FXMVECTOR v) {
+		return headless::Map(v, [](float a) { return 1.0f / a; });
+	}
+
+	inline XMVECTOR XMVectorMin(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return a < b ? a : b; });
+	}
+
+	inline XMVECTOR XMVectorMax(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return a > b ? a : b; });
+	}
+
+	inline XMVECTOR XMVectorClamp(FXMVECTOR v, FXMVECTOR min, FXMVECTOR max) {
+		return XMVectorMin(XMVectorMax(v, min), max);
+	}
+
+	inline XMVECTOR XMVectorSaturate(FXMVECTOR v) {
+		return XMVectorClamp(v, XMVectorZero(), XMVectorSplatOne());
+	}
+
+	// Rounds halfway cases to even.
+	inline XMVECTOR XMVectorRound(FXMVECTOR v) {
+		return headless::Map(v, [](float a) { return std::nearbyint(a); });
+	}
+
+	inline XMVECTOR XMVectorFloor(FXMVECTOR v) {
+		return headless::Map(v, [](float a) { return std::floor(a); });
+	}
+
+	inline XMVECTOR XMVectorEqual(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return headless::Mask(a == b); });
+	}
+
+	inline XMVECTOR XMVectorNotEqual(FXMVECTOR v1, FXMVECTOR v2) {
+		return headless::Map(v1, v2, [](float a, float b) { return headless::Mask(a != b); });
+	}
+
+	// Takes each component from v2 where the control has its bits set, and from v1 elsewhere.
+	inline XMVECTOR XMVectorSelect(FXMVECTOR v1, FXMVECTOR v2, FXMVECTOR control) {
+		XMVECTOR result;
+		for (int i = 0; i < 4; i++) {
+			std::uint32_t mask = headless::Bits(control.f[i]);
+			std::uint32_t bits = (headless::Bits(v1.f[i]) & ~mask) | (headless::Bits(v2.f[i]) & mask);
+			std::memcpy(&result.f[i], &bits, sizeof(bits));
+		}
+		return result;
+	}
+
+	inline XMVECTOR XMVector3Dot(FXMVECTOR v1, FXMVECTOR v2) {
+		return XMVectorReplicate(v1.f[0] * v2.f[0] + v1.f[1] * v2.f[1] + v1.f[2] * v2.f[2]);
+	}
+
+	inline XMVECTOR XMVector3Cross(FXMVECTOR v1, FXMVECTOR v2) {
+		return { { v1.f[1] * v2.f[2] - v1.f[2] * v2.f[1], v1.f[2] * v2.f[0] - v1.f[0] * v2.f[2],
+			v1.f[0] * v2.f[1] - v1.f[1] * v2.f[0], 0.0f } };
+	}
+
+	inline XMVECTOR XMVector3LengthSq(FXMVECTOR v) {
+		return XMVector3Dot(v, v);
+	}
+
+	inline XMVECTOR XMVector3Length(FXMVECTOR v) {
+		return XMVectorReplicate(std::sqrt(v.f[0] * v.f[0] + v.f[1] * v.f[1] + v.f[2] * v.f[2]));
+	}
+
+	inline XMVECTOR XMVector3Normalize(FXMVECTOR v) {
+		float length = XMVectorGetX(XMVector3Length(v));
+		return length > 0.0f ? XMVectorScale(v, 1.0f / length) : XMVectorZero();
+	}
+
+	inline XMVECTOR XMVector4Dot(FXMVECTOR v1, FXMVECTOR v2) {
+		return XMVectorReplicate(v1.f[0] * v2.f[0] + v1.f[1] * v2.f[1] + v1.f[2] * v2.f[2] + v1.f[3] * v2.f[3]);
+	}
+
+	inline XMVECTOR XMVector4LengthSq(FXMVECTOR v) {
+		return XMVector4Dot(v, v);
+	}
+
+	inline XMVECTOR XMVector4Normalize(FXMVECTOR v) {
+		float length = std::sqrt(XMVectorGetX(XMVector4LengthSq(v)));
+		return length > 0.0f ? XMVectorScale(v, 1.0f / length) : XMVectorZero();
+	}
+
+	inline XMVECTOR XMVector3Transform(FXMVECTOR v, FXMMATRIX m) {
+		XMVECTOR result = m.r[3];
+		for (int i = 0; i < 3; i++) {
+			result = XMVectorMultiplyAdd(XMVectorReplicate(v.f[i]), m.r[i], result);
+		}
+		return result;
+	}
+
+	inline XMVECTOR XMVector4Transform(FXMVECTOR v, FXMMATRIX m) {
+		XMVECTOR result = XMVectorZero();
+		for (int i = 0; i < 4; i++) {
+			result = XMVectorMultiplyAdd(XMVectorReplicate(v.f[i]), m.r[i], result);
+		}
+		return result;
+	}
+
+	// Scales the plane so that its normal has unit length.
+	inline XMVECTOR XMPlaneNormalize(FXMVECTOR plane) {
+		float length = XMVectorGetX(XMVector3Length(plane));
+		return length > 0.0f ? XMVectorScale(plane, 1.0f / length) : XMVectorZero();
+	}
+
+	inline XMVECTOR XMPlaneDotCoord(FXMVECTOR plane, FXMVECTOR v) {
+		return XMVectorReplicate(plane.f[0] * v.f[0] + plane.f[1] * v.f[1] + plane.f[2] * v.f[2] + plane.f[3]);
+	}
+
+	inline XMMATRIX XMMatrixSet(float m00, float m01, float m02, float m03, float m10, float m11, float m12,
+		float m13, float m20, float m21, float m22, float m23, float m30, float m31, float m32, float m33) {
+		return XMMATRIX(XMVectorSet(m00, m01, m02, m03), XMVectorSet(m10, m11, m12, m13),
+			XMVectorSet(m20, m21, m22, m23), XMVectorSet(m30, m31, m32, m33));
+	}
+
+	inline XMMATRIX XMMatrixIdentity() {
+		return XMMatrixSet(1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XMMatrixMultiply(FXMMATRIX m1, CXMMATRIX m2) {
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) {
+			result.r[i] = XMVector4Transform(m1.r[i], m2);
+		}
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranspose(FXMMATRIX m) {
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) {
+			for (int j = 0; j < 4; j++) {
+				result.r[i].f[j] = m.r[j].f[i];
+			}
+		}
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixTranslation(float x, float y, float z) {
+		XMMATRIX result = XMMatrixIdentity();
+		result.r[3] = XMVectorSet(x, y, z, 1.0f);
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixScaling(float x, float y, float z) {
+		XMMATRIX result = XMMatrixIdentity();
+		result.r[0].f[0] = x;
+		result.r[1].f[1] = y;
+		result.r[2].f[2] = z;
+		return result;
+	}
+
+	inline XMMATRIX XMMatrixRotationY(float angle) {
+		float sine = std::sin(angle), cosine = std::cos(angle);
+		return XMMatrixSet(cosine, 0.0f, -sine, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f, sine, 0.0f, cosine, 0.0f,
+			0.0f, 0.0f, 0.0f, 1.0f);
+	}
+
+	inline XMMATRIX XMMatrixPerspectiveFovLH(float fov_angle_y, float aspect_ratio, float near_z, float far_z) {
+		float height = 1.0f / std::tan(0.5f * fov_angle_y);
+		float range = far_z / (far_z - near_z);
+		return XMMatrixSet(height / aspect_ratio, 0.0f, 0.0f, 0.0f, 0.0f, height, 0.0f, 0.0f, 0.0f, 0.0f, range,
+			1.0f, 0.0f, 0.0f, -range * near_z, 0.0f);
+	}
+
+	inline XMMATRIX XMLoadFloat4x4(const XMFLOAT4X4* source) {
+		XMMATRIX result;
+		for (int i = 0; i < 4; i++) {
+			result.r[i] = XMVectorSet(source->m[i][0], source->m[i][1], source->m[i][2], source->m[i][3]);
+		}
+		return result;
+	}
+
+	inline void XMStoreFloat4x4(XMFLOAT4X4* destination, FXMMATRIX m) {
+		for (int i = 0; i < 4; i++) {
+			std::copy(std::begin(m.r[i].f), std::end(m.r[i].f), destination->m[i]);
+		}
+	}
+}
@@ -0,0 +1,164 @@
+#pragma once
+
+// Scalar stand-in for the packed vector types of DirectXMath that the vertex formats use, with the rounding
+// of the library: normalized values are saturated, scaled and rounded to nearest, and halves are rounded to
+// nearest even.
+
+#include <DirectXMath.h>
+
+namespace DirectX {
+	namespace PackedVector {
+		typedef std::uint16_t HALF;
+
+		struct XMHALF2 {
+			HALF x;
+			HALF y;
+		};
+
+		struct XMUSHORTN4 {
+			std::uint16_t x;
+			std::uint16_t y;
+			std::uint16_t z;
+			std::uint16_t w;
+		};
+
+		// 10 bits each for x, y and z, and 2 bits for w, from the least significant bit up.
+		struct XMUDECN4 {
+			std::uint32_t v;
+		};
+
+		struct XMUBYTEN4 {
+			std::uint8_t x;
+			std::uint8_t y;
+			std::uint8_t z;
+			std::uint8_t w;
+		};
+
+		namespace headless {
+			inline std::uint32_t Normalize(float value, float scale) {
+				return static_cast<std::uint32_t>(std::nearbyint(std::clamp(value, 0.0f, 1.0f) * scale));
+			}
+		}
+
+		inline HALF XMConvertFloatToHalf(float value) {
+			std::uint32_t bits;
+			std::memcpy(&bits, &value, sizeof(bits));
+			std::uint32_t sign = (bits >> 16) & 0x8000u;
+			std::uint32_t magnitude = bits & 0x7fffffffu;
+			if (magnitude >= 0x7f800000u) {
+				// Infinity stays infinity, and NaN stays a quiet NaN.
+				return static_cast<HALF>(sign | 0x7c00u | (magnitude > 0x7f800000u ? 0x0200u : 0u));
+			}
+			if (magnitude >= 0x477ff000u) {
+				// Rounds to past the largest half.
+				return static_cast<HALF>(sign | 0x7c00u);
+			}
+
+			std::uint32_t exponent = magnitude >> 23;
+			std::uint32_t mantissa = (magnitude & 0x7fffffu) | (exponent != 0 ? 0x800000u : 0u);
+			// The number of mantissa bits that the half drops: 13 for normal halves, more for subnormal ones.
+			std::uint32_t shift = exponent < 113 ? std::min<std::uint32_t>(126 - exponent, 25) : 13;
+			std::uint32_t half = exponent < 113 ? 0 : (exponent - 112) << 10;
+			std::uint32_t kept = mantissa >> shift;
+			std::uint32_t dropped = mantissa & ((1u << shift) - 1);
+			std::uint32_t halfway = 1u << (shift - 1);
+			// Normal halves leave the implicit bit out of the stored mantissa, and a mantissa that rounds up to
+			// the next power of two carries into the exponent.
+			half |= kept & 0x3ffu;
+			if (dropped > halfway || (dropped == halfway && (kept & 1) != 0)) {
+				half++;
+			}
+			return static_cast<HALF>(sign | half);
+		}
+
+		inline float XMConvertHalfToFloat(HALF value) {
+			std::uint32_t sign = static_cast<std::uint32_t>(value & 0x8000u) << 16;
+			std::uint32_t exponent = (value >> 10) & 0x1fu;
+			std::uint32_t mantissa = value & 0x3ffu;
+			float magnitude;
+			if (exponent == 0x1f) {
+				magnitude = mantissa != 0 ? NAN : INFINITY;
+			}
+			else if (exponent == 0) {
+				magnitude = std::ldexp(static_cast<float>(mantissa), -24);
+			}
+			else {
+				magnitude = std::ldexp(static_cast<float>(mantissa | 0x400u), static_cast<int>(exponent) - 25);
+			}
+			std::uint32_t bits;
+			std::memcpy(&bits, &magnitude, sizeof(bits));
+			bits |= sign;
+			std::memcpy(&magnitude, &bits, sizeof(bits));
+			return magnitude;
+		}
+
+		inline XMVECTOR XMLoadHalf2(const XMHALF2* source) {
+			return { { XMConvertHalfToFloat(source->x), XMConvertHalfToFloat(source->y), 0.0f, 0.0f } };
+		}
+
+		inline void XMStoreHalf2(XMHALF2* destination, FXMVECTOR v) {
+			*destination = { XMConvertFloatToHalf(v.f[0]), XMConvertFloatToHalf(v.f[1]) };
+		}
+
+		inline XMVECTOR XMLoadUShortN4(const XMUSHORTN4* source) {
+			return { { source->x / 65535.0f, source->y / 65535.0f, source->z / 65535.0f, source->w / 65535.0f } };
+		}
+
+		inline void XMStoreUShortN4(XMUSHORTN4* destination, FXMVECTOR v) {
+			*destination = {
+				static_cast<std::uint16_t>(headless::Normalize(v.f[0], 65535.0f)),
+				static_cast<std::uint16_t>(headless::Normalize(v.f[1], 65535.0f)),
+				static_cast<std::uint16_t>(headless::Normalize(v.f[2], 65535.0f)),
+				static_cast<std::uint16_t>(headless::Normalize(v.f[3], 65535.0f))
+			};
+		}
+
+		inline XMVECTOR XMLoadUDecN4(const XMUDECN4* source) {
+			return { {
+				(source->v & 0x3ffu) / 1023.0f,
+				((source->v >> 10) & 0x3ffu) / 1023.0f,
+				((source->v >> 20) & 0x3ffu) / 1023.0f,
+				(source->v >> 30) / 3.0f
+			} };
+		}
+
+		inline void XMStoreUDecN4(XMUDECN4* destination, FXMVECTOR v) {
+			destination->v = headless::Normalize(v.f[0], 1023.0f) | (headless::Normalize(v.f[1], 1023.0f) << 10) |
+				(headless::Normalize(v.f[2], 1023.0f) << 20) | (headless::Normalize(v.f[3], 3.0f) << 30);
+		}
+
+		struct XMUBYTE4 {
+			std::uint8_t x;
+			std::uint8_t y;
+			std::uint8_t z;
+			std::uint8_t w;
+		};
+
+		inline XMVECTOR XMLoadUByte4(const XMUBYTE4* source) {
+			return { { float(source->x), float(source->y), float(source->z), float(source->w) } };
+		}
+
+		// Saturated to 0 to 255 and rounded to nearest.
+		inline void XMStoreUByte4(XMUBYTE4* destination, FXMVECTOR v) {
+			*destination = {
+				static_cast<std::uint8_t>(std::nearbyint(std::clamp(v.f[0], 0.0f, 255.0f))),
+				static_cast<std::uint8_t>(std::nearbyint(std::clamp(v.f[1], 0.0f, 255.0f))),
+				static_cast<std::uint8_t>(std::nearbyint(std::clamp(v.f[2], 0.0f, 255.0f))),
+				static_cast<std::uint8_t>(std::nearbyint(std::clamp(v.f[3], 0.0f, 255.0f)))
+			};
+		}
+
+		inline XMVECTOR XMLoadUByteN4(const XMUBYTEN4* source) {
+			return { { source->x / 255.0f, source->y / 255.0f, source->z / 255.0f, source->w / 255.0f } };
+		}
+
+		inline void XMStoreUByteN4(XMUBYTEN4* destination, FXMVECTOR v) {
+			*destination = {
+				static_cast<std::uint8_t>(headless::Normalize(v.f[0], 255.0f)),
+				static_cast<std::uint8_t>(headless::Normalize(v.f[1], 255.0f)),
+				static_cast<std::uint8_t>(headless::Normalize(v.f[2], 255.0f)),
+				static_cast<std::uint8_t>(headless::Normalize(v.f[3], 255.0f))
+			};
+		}
+	}
+}
@@ -0,0 +1,44 @@
+#include "pch.h"
+#include "MappedFile.h"
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+// Builds MappedFile from the POSIX calls in place of D3DProject/MappedFile.cpp. The mapping outlives the file
+// descriptor, so the winrt handles stay empty.
+
+MappedFile::MappedFile(const std::string& path) {
+	int descriptor = open(path.c_str(), O_RDONLY);
+	if (descriptor < 0) {
+		winrt::throw_last_error();
+	}
+
+	struct stat status;
+	if (fstat(descriptor, &status) != 0) {
+		close(descriptor);
+		winrt::throw_last_error();
+	}
+	size = static_cast<std::size_t>(status.st_size);
+	if (size == 0) {
+		close(descriptor);
+		return; // Empty files cannot be mapped.
+	}
+
+	void* mapped_view = mmap(nullptr, size, PROT_READ, MAP_PRIVATE, descriptor, 0);
+	close(descriptor);
+	if (mapped_view == MAP_FAILED) {
+		winrt::throw_last_error();
+	}
+	view = static_cast<const char*>(mapped_view);
+}
+
+MappedFile::~MappedFile() {
+	if (view != nullptr) {
+		munmap(const_cast<char*>(view), size);
+	}
+}
+
+std::span<const char> MappedFile::GetData() const {
+	return { view, size };
+}
@@ -0,0 +1,292 @@
+#pragma once
+
+// Stands in for the Windows SDK headers that pch.h includes, in builds without them. Only the modules that
+// do not talk to the GPU are built that way, so this declares just the types and macros that they use,
+// defined as in the SDK, and implements the few file functions that they call with the standard library.
+
+#include <cstddef>
+#include <cstdint>
+#include <cstdio>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+#include <DirectXMath.h>
+#include <DirectXPackedVector.h>
+#include <emmintrin.h>
+
+typedef int BOOL;
+typedef int INT;
+typedef unsigned int UINT;
+typedef std::uint8_t BYTE;
+typedef std::uint8_t UINT8;
+typedef std::uint16_t UINT16;
+typedef std::uint32_t UINT32;
+typedef std::uint32_t DWORD;
+typedef std::uint64_t UINT64;
+typedef std::size_t SIZE_T;
+typedef float FLOAT;
+
+#define FALSE 0
+#define TRUE 1
+
+enum DXGI_FORMAT {
+	DXGI_FORMAT_UNKNOWN = 0,
+	DXGI_FORMAT_R32G32B32_FLOAT = 6,
+	DXGI_FORMAT_R16G16B16A16_UNORM = 11,
+	DXGI_FORMAT_R32G32_FLOAT = 16,
+	DXGI_FORMAT_R10G10B10A2_UNORM = 24,
+	DXGI_FORMAT_R8G8B8A8_UNORM = 28,
+	DXGI_FORMAT_R8G8B8A8_UNORM_SRGB = 29,
+	DXGI_FORMAT_R16G16_FLOAT = 34,
+	DXGI_FORMAT_R32_UINT = 42,
+	DXGI_FORMAT_R16_UINT = 57,
+	DXGI_FORMAT_BC1_UNORM = 71,
+	DXGI_FORMAT_BC3_UNORM = 77,
+	DXGI_FORMAT_BC7_UNORM = 98,
+};
+
+// Only passed around by pointer.
+struct ID3D12Resource;
+
+struct D3D12_SUBRESOURCE_FOOTPRINT {
+	DXGI_FORMAT Format;
+	UINT Width;
+	UINT Height;
+	UINT Depth;
+	UINT RowPitch;
+};
+
+struct D3D12_PLACED_SUBRESOURCE_FOOTPRINT {
+	UINT64 Offset;
+	D3D12_SUBRESOURCE_FOOTPRINT Footprint;
+};
+
+enum D3D12_INPUT_CLASSIFICATION {
+	D3D12_INPUT_CLASSIFICATION_PER_VERTEX_DATA = 0,
+	D3D12_INPUT_CLASSIFICATION_PER_INSTANCE_DATA = 1
+};
+
+struct D3D12_INPUT_ELEMENT_DESC {
+	const char* SemanticName;
+	UINT SemanticIndex;
+	DXGI_FORMAT Format;
+	UINT InputSlot;
+	UINT AlignedByteOffset;
+	D3D12_INPUT_CLASSIFICATION InputSlotClass;
+	UINT InstanceDataStepRate;
+};
+
+#define D3D12_APPEND_ALIGNED_ELEMENT 0xffffffff
+#define D3D12_TEXTURE_DATA_PITCH_ALIGNMENT 256
+#define D3D12_TEXTURE_DATA_PLACEMENT_ALIGNMENT 512
+#define D3D12_REQ_MIP_LEVELS 15
+
+// The debugger output of Windows; the closest headless equivalent is the standard error stream.
+inline void OutputDebugStringA(const char* output_string) {
+	std::fputs(output_string, stderr);
+}
+
+typedef std::int32_t HRESULT;
+typedef const wchar_t* PCWSTR;
+
+#define S_OK (static_cast<HRESULT>(0))
+#define E_NOTIMPL (static_cast<HRESULT>(0x80004001))
+#define SUCCEEDED(hr) ((hr) >= 0)
+#define FAILED(hr) ((hr) < 0)
+
+// COM and WIC have no headless equivalent. Initializing COM succeeds, but creating the imaging factory
+// fails, so that textures load with the portable decoder only, which Tests/headless builds
+// BitmapDefinition with.
+enum COINIT {
+	COINIT_MULTITHREADED = 0
+};
+
+#define CLSCTX_INPROC_SERVER 0x1
+#define IID_PPV_ARGS(pointer) 0, reinterpret_cast<void**>(pointer)
+
+struct IWICImagingFactory {};
+struct IWICImagingFactory2 : IWICImagingFactory {};
+struct IWICFormatConverter {};
+
+inline constexpr int CLSID_WICImagingFactory2 = 0;
+
+inline HRESULT CoInitializeEx(void*, DWORD) {
+	return S_OK;
+}
+
+inline void CoUninitialize() {}
+
+inline HRESULT CoCreateInstance(int, void*, DWORD, int, void**) {
+	return E_NOTIMPL;
+}
+
+// What the modules use of C++/WinRT: the error that failed calls throw, the handles that MappedFile keeps,
+// which its headless build in Tests/headless leaves unused, COM pointers, which stay empty, and the string
+// conversions of file names.
+namespace winrt {
+	struct hresult_error {};
+
+	struct handle {};
+	struct file_handle {};
+
+	template <typename T>
+	struct com_ptr {
+		T* pointer = nullptr;
+
+		T* get() const {
+			return pointer;
+		}
+
+		T** put() {
+			return &pointer;
+		}
+	};
+
+	[[noreturn]] inline void throw_last_error() {
+		throw hresult_error();
+	}
+
+	inline void check_bool(BOOL result) {
+		if (!result) {
+			throw_last_error();
+		}
+	}
+
+	inline void check_hresult(HRESULT result) {
+		if (FAILED(result)) {
+			throw hresult_error();
+		}
+	}
+
+	inline std::wstring to_hstring(std::string_view value) {
+		return std::filesystem::path(value).wstring();
+	}
+
+	inline std::string to_string(std::wstring_view value) {
+		return std::filesystem::path(value).string();
+	}
+}
+
+#define INVALID_FILE_ATTRIBUTES (static_cast<DWORD>(-1))
+#define FILE_ATTRIBUTE_NORMAL 0x80
+#define MOVEFILE_REPLACE_EXISTING 0x1
+
+struct FILETIME {
+	DWORD dwLowDateTime;
+	DWORD dwHighDateTime;
+};
+
+struct WIN32_FILE_ATTRIBUTE_DATA {
+	DWORD dwFileAttributes;
+	FILETIME ftCreationTime;
+	FILETIME ftLastAccessTime;
+	FILETIME ftLastWriteTime;
+	DWORD nFileSizeHigh;
+	DWORD nFileSizeLow;
+};
+
+enum GET_FILEEX_INFO_LEVELS {
+	GetFileExInfoStandard
+};
+
+// Every existing file is reported as a normal file, which is all that the modules check for.
+inline DWORD GetFileAttributesA(const char* file_name) {
+	std::error_code error;
+	return std::filesystem::exists(file_name, error) ? FILE_ATTRIBUTE_NORMAL : INVALID_FILE_ATTRIBUTES;
+}
+
+// Fills in the size and the last write time, in the units of the file clock rather than of a FILETIME.
+inline BOOL GetFileAttributesExA(const char* file_name, GET_FILEEX_INFO_LEVELS, void* file_information) {
+	std::error_code error;
+	UINT64 size = std::filesystem::file_size(file_name, error);
+	if (error) {
+		return FALSE;
+	}
+	UINT64 write_time = std::filesystem::last_write_time(file_name, error).time_since_epoch().count();
+	if (error) {
+		return FALSE;
+	}
+	*static_cast<WIN32_FILE_ATTRIBUTE_DATA*>(file_information) = {
+		.dwFileAttributes = FILE_ATTRIBUTE_NORMAL,
+		.ftLastWriteTime = { static_cast<DWORD>(write_time), static_cast<DWORD>(write_time >> 32) },
+		.nFileSizeHigh = static_cast<DWORD>(size >> 32),
+		.nFileSizeLow = static_cast<DWORD>(size)
+	};
+	return TRUE;
+}
+
+inline BOOL DeleteFileA(const char* file_name) {
+	std::error_code error;
+	return std::filesystem::remove(file_name, error) ? TRUE : FALSE;
+}
+
+// Always replaces an existing file, as with MOVEFILE_REPLACE_EXISTING.
+inline BOOL MoveFileExA(const char* existing_file_name, const char* new_file_name, DWORD) {
+	std::error_code error;
+	std::filesystem::rename(existing_file_name, new_file_name, error);
+	return error ? FALSE : TRUE;
+}
+
+#if !__has_include(<format>)
+#include <sstream>
+#include <type_traits>
+
+// Standard libraries without <format> (libstdc++ before 13) get a fallback that covers what the modules
+// format: "{}" for strings and numbers, and "{:.Nf}" for floating-point values.
+namespace std {
+	template <typename... Args>
+	string format(string_view format_string, const Args&... args) {
+		ostringstream out;
+		auto write_argument = [&](std::size_t index, string_view spec) {
+			std::size_t current = 0;
+			auto write = [&](const auto& argument) {
+				if (current++ != index) {
+					return;
+				}
+				using argument_t = decay_t<decltype(argument)>;
+				if constexpr (is_floating_point_v<argument_t>) {
+					ostringstream number;
+					if (spec.size() > 2 && spec[0] == '.' && spec.back() == 'f') {
+						number.setf(ios::fixed);
+						number.precision(stoi(string(spec.substr(1, spec.size() - 2))));
+					}
+					number << argument;
+					out << number.str();
+				}
+				else if constexpr (is_same_v<argument_t, signed char> || is_same_v<argument_t, unsigned char>) {
+					// Formatted as numbers, not as characters.
+					out << static_cast<int>(argument);
+				}
+				else {
+					out << argument;
+				}
+			};
+			(write(args), ...);
+		};
+
+		std::size_t argument_index = 0;
+		for (std::size_t i = 0; i < format_string.size(); i++) {
+			char c = format_string[i];
+			if ((c == '{' || c == '}') && i + 1 < format_string.size() && format_string[i + 1] == c) {
+				out << c;
+				i++;
+			}
+			else if (c == '{') {
+				std::size_t end = format_string.find('}', i);
+				string_view spec = format_string.substr(i + 1, end - i - 1);
+				if (!spec.empty() && spec[0] == ':') {
+					spec.remove_prefix(1);
+				}
+				write_argument(argument_index++, spec);
+				i = end;
+			}
+			else {
+				out << c;
+			}
+		}
+		return out.str();
+	}
+}
+#endif
@@ -0,0 +1,126 @@
+# Writes png_fixtures.h, the small deflate-compressed PNG images that PngDecoderTest decodes. The images are
+# compressed with zlib, which the tests do not link, so they are kept as generated source:
+#
+#     python3 make_png_fixtures.py > png_fixtures.h
+
+import struct
+import zlib
+
+ADAM7_PASSES = [(0, 0, 8, 8), (4, 0, 8, 8), (0, 4, 4, 8), (2, 0, 4, 4), (0, 2, 2, 4), (1, 0, 2, 2), (0, 1, 1, 2)]
+CHANNELS = {0: 1, 2: 3, 4: 2, 6: 4}
+
+
+# A gradient with a little noise, whose filtered rows have skewed byte frequencies that zlib codes with
+# dynamic Huffman codes even for small images. Must match FixtureSample in PngDecoderTest.cpp.
+def sample(x, y, channel):
+    noise = (((x * 73856093) ^ (y * 19349663) ^ (channel * 83492791)) & 0xFFFFFFFF) >> 7
+    return (x * 2 + y * 3 + channel * 60 + noise % 7) & 0xFF
+
+
+def paeth(a, b, c):
+    p = a + b - c
+    pa, pb, pc = abs(p - a), abs(p - b), abs(p - c)
+    return a if pa <= pb and pa <= pc else b if pb <= pc else c
+
+
+def filter_row(filter_type, row, previous, bpp):
+    out = bytearray([filter_type])
+    for i, value in enumerate(row):
+        left = row[i - bpp] if i >= bpp else 0
+        up = previous[i]
+        up_left = previous[i - bpp] if i >= bpp else 0
+        predictor = [0, left, up, (left + up) >> 1, paeth(left, up, up_left)][filter_type]
+        out.append((value - predictor) & 0xFF)
+    return out
+
+
+# Rows of the pixels at the given positions, each filtered with the next of the five filter types in turn,
+# so that every image uses all of them.
+def filter_image(xs, ys, color_type, filter_start):
+    bpp = CHANNELS[color_type]
+    raw = bytearray()
+    previous = bytes(len(xs) * bpp)
+    for row_index, y in enumerate(ys):
+        row = bytes(sample(x, y, c) for x in xs for c in range(bpp))
+        raw += filter_row((filter_start + row_index) % 5, row, previous, bpp)
+        previous = row
+    return raw
+
+
+def chunk(chunk_type, data):
+    body = chunk_type + data
+    return struct.pack(">I", len(data)) + body + struct.pack(">I", zlib.crc32(body) & 0xFFFFFFFF)
+
+
+def encode(width, height, color_type, interlaced, fixed_huffman, idat_size):
+    raw = bytearray()
+    if interlaced:
+        for pass_index, (x0, y0, dx, dy) in enumerate(ADAM7_PASSES):
+            xs, ys = list(range(x0, width, dx)), list(range(y0, height, dy))
+            if xs and ys:
+                raw += filter_image(xs, ys, color_type, pass_index)
+    else:
+        raw = filter_image(list(range(width)), list(range(height)), color_type, 0)
+
+    compressor = zlib.compressobj(9, zlib.DEFLATED, 15, 9, zlib.Z_FIXED if fixed_huffman else zlib.Z_DEFAULT_STRATEGY)
+    stream = compressor.compress(bytes(raw)) + compressor.flush()
+    block_type = (stream[2] >> 1) & 3
+    assert block_type == (1 if fixed_huffman else 2)
+
+    png = b"\x89PNG\r\n\x1a\n" + chunk(b"IHDR", struct.pack(">IIBBBBB", width, height, 8, color_type, 0, 0,
+        1 if interlaced else 0))
+    if idat_size:
+        # An empty IDAT chunk in the middle is allowed, and must not end the image data.
+        pieces = [stream[i:i + idat_size] for i in range(0, len(stream), idat_size)]
+        pieces.insert(len(pieces) // 2, b"")
+    else:
+        pieces = [stream]
+    for piece in pieces:
+        png += chunk(b"IDAT", piece)
+    return png + chunk(b"IEND", b""), block_type, len(pieces)
+
+
+FIXTURES = [
+    # name, width, height, color type, interlaced, fixed Huffman codes, IDAT size
+    ("GRAY", 19, 11, 0, False, False, 0),
+    ("GRAY_ALPHA", 19, 11, 4, False, False, 0),
+    ("RGB", 17, 10, 2, False, False, 0),
+    ("RGBA", 17, 10, 6, False, False, 0),
+    ("RGBA_FIXED", 17, 10, 6, False, True, 0),
+    ("GRAY_ADAM7", 19, 11, 0, True, False, 0),
+    ("RGB_ADAM7", 17, 10, 2, True, False, 0),
+    ("RGBA_ADAM7", 17, 10, 6, True, False, 0),
+    ("RGBA_SPLIT", 17, 10, 6, False, False, 37),
+]
+
+print("#pragma once")
+print()
+print("// Generated by make_png_fixtures.py; do not edit.")
+print("namespace test {")
+entries = []
+for name, width, height, color_type, interlaced, fixed_huffman, idat_size in FIXTURES:
+    png, block_type, idat_count = encode(width, height, color_type, interlaced, fixed_huffman, idat_size)
+    print(f"\tinline constexpr BYTE PNG_{name}[] = {{")
+    for i in range(0, len(png), 16):
+        print("\t\t" + ", ".join(f"0x{b:02x}" for b in png[i:i + 16]) + ",")
+    print("\t};")
+    entries.append(f"\t\t{{ \"{name.lower()}\", PNG_{name}, {width}, {height}, {color_type}, "
+        f"{'true' if interlaced else 'false'}, {block_type}, {idat_count} }},")
+print()
+print("\tstruct png_fixture_t {")
+print("\t\tconst char* name;")
+print("\t\tstd::span<const BYTE> png;")
+print("\t\tUINT width;")
+print("\t\tUINT height;")
+print("\t\tBYTE color_type;")
+print("\t\tbool interlaced;")
+print("\t\t// BTYPE of the first deflate block: 1 for the fixed Huffman codes, 2 for dynamic ones.")
+print("\t\tBYTE block_type;")
+print("\t\tUINT idat_count;")
+print("\t};")
+print()
+print("\tinline constexpr png_fixture_t PNG_FIXTURES[] = {")
+for entry in entries:
+    print(entry)
+print("\t};")
+print("}")
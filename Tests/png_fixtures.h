@@ -0,0 +1,335 @@
+#pragma once
+
+// Generated by make_png_fixtures.py; do not edit.
+namespace test {
+	inline constexpr BYTE PNG_GRAY[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x0b, 0x08, 0x00, 0x00, 0x00, 0x00, 0xb8, 0xbe, 0xe9,
+		0xe6, 0x00, 0x00, 0x00, 0xb3, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x0d, 0x8d, 0xc1, 0x4a, 0xc3,
+		0x50, 0x10, 0x45, 0xe7, 0xce, 0x9d, 0x99, 0x26, 0x18, 0x10, 0x23, 0x95, 0x08, 0xb5, 0x45, 0x24,
+		0x96, 0x58, 0x5d, 0xd8, 0x14, 0x54, 0x10, 0x0a, 0xe2, 0xc2, 0xff, 0xff, 0x9e, 0xf4, 0x8d, 0x6f,
+		0x71, 0x17, 0x67, 0x71, 0xcf, 0x11, 0x89, 0x88, 0xae, 0xeb, 0x6e, 0xfb, 0xfe, 0x7e, 0x18, 0x76,
+		0xbb, 0xed, 0x38, 0x8e, 0x58, 0x11, 0xaa, 0x10, 0x98, 0x83, 0xc5, 0x6d, 0x31, 0x75, 0x15, 0x25,
+		0x24, 0x68, 0xcc, 0x4c, 0xcb, 0x0b, 0x83, 0xca, 0xab, 0x42, 0x03, 0x22, 0xb2, 0x11, 0xd5, 0x86,
+		0x74, 0x2f, 0x26, 0x46, 0xb1, 0x7a, 0x8b, 0x4b, 0xbb, 0x58, 0x52, 0x34, 0x43, 0xae, 0x6f, 0x86,
+		0xf5, 0xe6, 0xa1, 0xba, 0xf7, 0xe3, 0xb4, 0x9f, 0x0e, 0xf3, 0x3c, 0x9f, 0x70, 0x87, 0x64, 0x48,
+		0xaa, 0x3a, 0x40, 0x69, 0xb2, 0x92, 0x0a, 0x56, 0x6e, 0xd1, 0x36, 0x66, 0x1e, 0x35, 0x67, 0x61,
+		0xc2, 0x5e, 0x95, 0x64, 0xa9, 0x50, 0x67, 0xd4, 0xf0, 0x34, 0x78, 0x71, 0x28, 0x02, 0xd9, 0x4a,
+		0x41, 0x2c, 0x52, 0xb3, 0xdb, 0xc7, 0xa7, 0xe7, 0xe9, 0xf5, 0xe5, 0xed, 0xf8, 0x7e, 0xfa, 0xfc,
+		0xf8, 0xfa, 0x3e, 0xff, 0xfe, 0xfc, 0xfd, 0x03, 0xa1, 0xe2, 0x24, 0x8c, 0xa8, 0x14, 0xab, 0xe1,
+		0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_GRAY_ALPHA[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x0b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x37, 0xdc, 0x7e,
+		0xb1, 0x00, 0x00, 0x01, 0x57, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x1d, 0x90, 0xd1, 0x4b, 0x94,
+		0x51, 0x10, 0xc5, 0x67, 0xe6, 0xcc, 0xcc, 0xbd, 0x1f, 0x2d, 0x44, 0x1b, 0xc9, 0x0a, 0xb5, 0x4b,
+		0xc4, 0xd7, 0xb2, 0x56, 0x0f, 0xa9, 0xa0, 0x42, 0x54, 0x88, 0x48, 0x90, 0x94, 0x4a, 0x08, 0xc5,
+		0xb6, 0x2c, 0x19, 0x6c, 0x3e, 0x54, 0x88, 0xa0, 0x0f, 0x82, 0xf8, 0x87, 0xef, 0x77, 0xa7, 0x9b,
+		0xcc, 0xdb, 0x9c, 0xc3, 0xcc, 0xef, 0x1c, 0xa2, 0x5d, 0x7f, 0xeb, 0xfb, 0xbe, 0xd7, 0xdb, 0xef,
+		0x7d, 0xec, 0x1d, 0x3c, 0x3c, 0xec, 0x7f, 0xea, 0x1f, 0xaf, 0x1e, 0x0e, 0x4e, 0x06, 0x27, 0xa3,
+		0xe9, 0x68, 0x3a, 0x9c, 0xb6, 0xb3, 0xf6, 0xb4, 0xfd, 0xc9, 0xe9, 0x3d, 0xc0, 0x2c, 0x2c, 0x89,
+		0x83, 0x84, 0xa1, 0x62, 0xc1, 0x09, 0x52, 0x60, 0xa1, 0xba, 0x2c, 0x2a, 0x02, 0x13, 0xa1, 0x24,
+		0x06, 0xe5, 0x4c, 0xe2, 0x8a, 0xa4, 0x0e, 0x09, 0x0f, 0x0e, 0x56, 0x04, 0xba, 0x82, 0xf4, 0x7f,
+		0x2b, 0xc0, 0xbd, 0x71, 0x51, 0x90, 0x7a, 0x55, 0x92, 0x77, 0x6e, 0x11, 0x59, 0x88, 0x45, 0xc4,
+		0x72, 0x20, 0xa3, 0xb3, 0x6c, 0xd5, 0xad, 0x04, 0x0d, 0x24, 0x2a, 0x9a, 0xb9, 0x83, 0x16, 0x71,
+		0xea, 0xac, 0xd1, 0xa5, 0x68, 0x09, 0x07, 0x48, 0xa4, 0x44, 0xf6, 0x42, 0xf7, 0x0f, 0x1e, 0x1c,
+		0x0d, 0x8e, 0x1f, 0x1d, 0x3d, 0xfe, 0xf2, 0xe4, 0xdb, 0xe8, 0xeb, 0x70, 0xd6, 0xce, 0xc6, 0xf3,
+		0xf6, 0xc7, 0xe4, 0x74, 0xbc, 0x98, 0x9c, 0xbd, 0x58, 0x6c, 0xfc, 0xa9, 0x73, 0xb1, 0x79, 0xce,
+		0x2b, 0x9f, 0x39, 0xc5, 0x12, 0xe2, 0x99, 0x38, 0x50, 0x9f, 0x71, 0x8d, 0x20, 0x15, 0x0d, 0x14,
+		0x99, 0x02, 0x21, 0x55, 0x83, 0x90, 0x71, 0x97, 0x60, 0xa6, 0xec, 0x68, 0x4a, 0x0e, 0x2d, 0x6a,
+		0x66, 0x5e, 0x55, 0x24, 0x6e, 0xd4, 0x1c, 0x15, 0x3d, 0xa1, 0xbf, 0x76, 0x67, 0xaf, 0x4d, 0x54,
+		0xb2, 0x7a, 0x47, 0xb3, 0x47, 0x11, 0x4e, 0x7a, 0x87, 0x2d, 0x70, 0x37, 0x8d, 0x4e, 0xb9, 0xb1,
+		0x52, 0xd8, 0xbc, 0x86, 0x2b, 0xdc, 0x78, 0x61, 0x04, 0x37, 0x4c, 0xa8, 0x56, 0xf1, 0x58, 0x12,
+		0x51, 0x11, 0x65, 0x1a, 0x7e, 0x7f, 0x3a, 0x7d, 0x36, 0x7f, 0x3e, 0x9f, 0x2c, 0x5e, 0x2e, 0xd6,
+		0x7e, 0xbd, 0x3a, 0x5b, 0xff, 0xfb, 0xfa, 0xf7, 0xe6, 0xc5, 0xf6, 0xe5, 0xd6, 0xd5, 0xce, 0xd5,
+		0x9b, 0xeb, 0x77, 0x37, 0x7b, 0xd7, 0xbb, 0xb7, 0x1f, 0x6e, 0xff, 0x01, 0x6c, 0xc9, 0x5c, 0x4d,
+		0xe3, 0x30, 0x36, 0x0c, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_RGB[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x0a, 0x08, 0x02, 0x00, 0x00, 0x00, 0xdd, 0x1e, 0x22,
+		0xf5, 0x00, 0x00, 0x01, 0x85, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x1d, 0x51, 0x4d, 0x6b, 0x54,
+		0x41, 0x10, 0xec, 0xef, 0x99, 0x87, 0x0b, 0xe2, 0x8a, 0xb2, 0x82, 0x66, 0x4f, 0x61, 0x89, 0x1e,
+		0x73, 0x17, 0x91, 0xb0, 0x17, 0x17, 0x4d, 0x82, 0x04, 0x94, 0x25, 0x88, 0x1e, 0x82, 0x97, 0xfc,
+		0x83, 0xa0, 0x1e, 0x84, 0x28, 0xba, 0x98, 0x80, 0x90, 0x45, 0xe2, 0x49, 0x48, 0x7e, 0xe4, 0x7b,
+		0xdd, 0xf6, 0x04, 0x86, 0x99, 0xa6, 0xbb, 0xba, 0xbb, 0xaa, 0x06, 0xe0, 0xf9, 0x89, 0x3d, 0xfd,
+		0x6c, 0xf3, 0x13, 0xdb, 0xf9, 0x32, 0x9a, 0x7f, 0x1d, 0xbd, 0x38, 0x1d, 0x2d, 0x4e, 0xef, 0xee,
+		0x7e, 0x1b, 0xbf, 0xfc, 0x39, 0xde, 0x5f, 0x3d, 0xd8, 0xfd, 0x35, 0x39, 0x58, 0x4d, 0x0e, 0xce,
+		0xa6, 0xcb, 0xdf, 0xd3, 0xe5, 0x7a, 0x63, 0xb9, 0xde, 0x3c, 0xbc, 0xc4, 0xf2, 0xec, 0x13, 0xb3,
+		0x20, 0x06, 0xe5, 0x29, 0x8c, 0xa1, 0x40, 0x82, 0xdc, 0x0b, 0x89, 0x06, 0x60, 0x11, 0x26, 0x74,
+		0xce, 0x98, 0x44, 0xa4, 0xcf, 0x88, 0x90, 0xa0, 0x20, 0x69, 0x64, 0x12, 0x6b, 0x49, 0xb4, 0x09,
+		0x71, 0x19, 0xf2, 0xe1, 0xcc, 0x5a, 0x0d, 0xb4, 0x40, 0x12, 0x96, 0x60, 0x1a, 0x5c, 0xb2, 0x64,
+		0xe2, 0x7c, 0x6b, 0x36, 0x77, 0x51, 0x86, 0x86, 0xc3, 0x36, 0x58, 0x6d, 0x20, 0xd3, 0x1a, 0x01,
+		0x95, 0x18, 0x72, 0x39, 0x65, 0x7b, 0x76, 0x33, 0x57, 0xe4, 0x81, 0xb5, 0x56, 0x01, 0xc6, 0x1c,
+		0xc2, 0x05, 0xc1, 0x41, 0x6a, 0xc1, 0xa1, 0x11, 0x71, 0x62, 0x03, 0x1c, 0x94, 0x3b, 0xf1, 0x9e,
+		0x54, 0x9c, 0xc2, 0x20, 0x25, 0x40, 0xf6, 0x3b, 0xc2, 0xed, 0xc5, 0xf7, 0x3b, 0x7b, 0xab, 0xc9,
+		0xfe, 0x8f, 0x7b, 0x7b, 0xe7, 0x0f, 0x5f, 0x9f, 0x3d, 0x7a, 0x7b, 0x3e, 0x7d, 0x73, 0xb1, 0x71,
+		0x98, 0x5a, 0xff, 0xcc, 0xde, 0xad, 0x37, 0xdf, 0x5f, 0x6e, 0x7d, 0xf8, 0x3b, 0x3b, 0xfa, 0xb7,
+		0xf5, 0xf1, 0xea, 0xc9, 0xd1, 0xf5, 0xf6, 0xf1, 0xd5, 0xf6, 0xf1, 0x35, 0xde, 0x7f, 0xb5, 0xc2,
+		0x02, 0xd1, 0x6b, 0x6a, 0xb5, 0x8a, 0x80, 0x29, 0x8e, 0x88, 0x9c, 0x9a, 0xcc, 0x76, 0x61, 0x52,
+		0x61, 0x80, 0x90, 0x0a, 0x1c, 0x0c, 0x41, 0x40, 0xa0, 0x8c, 0x03, 0x97, 0x24, 0xa4, 0x91, 0x7e,
+		0x19, 0x47, 0xe7, 0x54, 0x43, 0xc4, 0x4b, 0xfa, 0xa2, 0xca, 0x16, 0x9a, 0x8c, 0x92, 0x3c, 0x76,
+		0x09, 0x2a, 0xc6, 0xcc, 0xe3, 0xc7, 0x0b, 0x62, 0x25, 0x43, 0x46, 0x65, 0x49, 0xce, 0xe4, 0x6d,
+		0x7c, 0x6a, 0xd3, 0x44, 0x3b, 0x35, 0xbb, 0x5b, 0xba, 0xc9, 0x49, 0x3b, 0xc2, 0x2c, 0x7f, 0xa6,
+		0x53, 0x75, 0x77, 0x44, 0x35, 0xc4, 0x04, 0xbb, 0x61, 0xe7, 0xe6, 0x8a, 0x4c, 0x81, 0xd1, 0xdd,
+		0x30, 0x73, 0xba, 0x29, 0x44, 0xe9, 0x21, 0x00, 0xe8, 0x3f, 0x56, 0x0e, 0x70, 0xfe, 0x8a, 0x92,
+		0xbf, 0xe4, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_RGBA[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x0a, 0x08, 0x06, 0x00, 0x00, 0x00, 0x52, 0x7c, 0xb5,
+		0xa2, 0x00, 0x00, 0x02, 0x08, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x1d, 0x91, 0x4d, 0x4b, 0xd5,
+		0x41, 0x14, 0xc6, 0xcf, 0xeb, 0xcc, 0x5c, 0xba, 0x10, 0x19, 0x85, 0x41, 0xe9, 0x4a, 0x2e, 0xd6,
+		0xd2, 0x7d, 0x44, 0x84, 0x9b, 0xa4, 0x54, 0x22, 0x28, 0x44, 0xa4, 0x16, 0xe2, 0xc6, 0x6f, 0x20,
+		0xd5, 0x22, 0xb0, 0xa8, 0x4b, 0x0a, 0x41, 0x97, 0xb0, 0x55, 0xa0, 0x1f, 0xa1, 0x08, 0xa1, 0x17,
+		0x08, 0x33, 0x90, 0xde, 0xa0, 0x8c, 0x5a, 0x54, 0xf4, 0x2d, 0xee, 0x7f, 0x4e, 0xcf, 0x6d, 0x31,
+		0x30, 0x33, 0xe7, 0xcc, 0x99, 0xdf, 0xf3, 0x3c, 0x44, 0x67, 0x57, 0x9e, 0xa7, 0xd3, 0x37, 0x5f,
+		0xa4, 0xc9, 0x95, 0xed, 0x74, 0xee, 0xd6, 0x76, 0x7b, 0xf2, 0xf6, 0xab, 0xf6, 0xf9, 0xd5, 0xd7,
+		0xed, 0xa9, 0xd5, 0x97, 0x87, 0xa7, 0xef, 0xbc, 0x19, 0xba, 0x70, 0x7f, 0x67, 0x68, 0xb6, 0xbb,
+		0x7b, 0x6c, 0xfa, 0xc1, 0xde, 0xf0, 0xe5, 0x2e, 0xd6, 0xda, 0xc7, 0xd1, 0xb9, 0x87, 0x58, 0xbd,
+		0x4f, 0x23, 0x73, 0xbd, 0x6f, 0x63, 0xf3, 0x1b, 0x5f, 0x38, 0x9f, 0xb9, 0xf1, 0x4c, 0xd5, 0x8c,
+		0x39, 0x5c, 0x38, 0x48, 0xb2, 0x12, 0xb6, 0x4e, 0x62, 0xca, 0xda, 0xaf, 0x26, 0x66, 0x1e, 0xc4,
+		0x9c, 0x4d, 0x54, 0x58, 0xab, 0x1a, 0x7b, 0x08, 0x5e, 0x98, 0xf4, 0x71, 0x30, 0x61, 0x16, 0xca,
+		0xac, 0xe2, 0xc1, 0x6a, 0xde, 0x70, 0xc9, 0x86, 0xc7, 0x9e, 0x50, 0xd1, 0xdc, 0x90, 0x25, 0xd3,
+		0x41, 0x31, 0x52, 0x49, 0xc1, 0x89, 0x83, 0x85, 0x4d, 0x2d, 0x85, 0x8a, 0x36, 0xd5, 0xfe, 0xf7,
+		0x24, 0xab, 0xac, 0x07, 0x3a, 0x93, 0x0b, 0xd5, 0xdc, 0x94, 0x1a, 0x94, 0x41, 0x14, 0xe4, 0x9c,
+		0x3d, 0x52, 0x23, 0x96, 0xbc, 0x48, 0x04, 0x95, 0x22, 0x0a, 0x16, 0x8c, 0x00, 0x80, 0x78, 0xd2,
+		0x32, 0x98, 0x52, 0x98, 0xb4, 0x51, 0xf7, 0x52, 0xd8, 0x08, 0xd0, 0x16, 0x9a, 0x34, 0xe3, 0x79,
+		0x25, 0xb7, 0x92, 0x89, 0x9b, 0xea, 0x20, 0x8b, 0x0a, 0x01, 0x89, 0x58, 0x1b, 0xd7, 0x68, 0x59,
+		0xb5, 0xbe, 0xe0, 0xba, 0x02, 0x2d, 0x51, 0xc0, 0x02, 0x68, 0x57, 0x11, 0x80, 0xd0, 0xc1, 0xa9,
+		0xbb, 0xef, 0x0e, 0xcd, 0x74, 0x77, 0x86, 0x67, 0xef, 0xed, 0x1e, 0x99, 0x59, 0x7f, 0x7f, 0xfc,
+		0xd2, 0xda, 0xde, 0x89, 0xab, 0xeb, 0x1f, 0x46, 0xaf, 0x3c, 0xfa, 0x3c, 0x32, 0xdf, 0xfb, 0x3a,
+		0x36, 0xff, 0x78, 0xbf, 0xb3, 0xd0, 0xdb, 0x1f, 0xbb, 0xb6, 0xf1, 0x7d, 0xfc, 0xfa, 0x93, 0x1f,
+		0x9d, 0xc5, 0xa7, 0xbf, 0xc6, 0x97, 0x36, 0x7f, 0x9e, 0x5a, 0xdc, 0xfa, 0x33, 0xb1, 0xbc, 0xf9,
+		0x7b, 0x62, 0x79, 0xeb, 0x2f, 0x1f, 0xbd, 0xd8, 0x7d, 0xcb, 0x99, 0x52, 0xf4, 0x9d, 0x60, 0x1c,
+		0xa7, 0x82, 0xc9, 0xec, 0x80, 0x13, 0xc3, 0x37, 0x8d, 0xc0, 0x07, 0x18, 0x59, 0x58, 0x9c, 0xc0,
+		0x5d, 0x55, 0x49, 0x29, 0x4c, 0x0b, 0xa9, 0x07, 0x76, 0x21, 0x94, 0x84, 0x1c, 0xea, 0x1a, 0xa5,
+		0x0c, 0x7e, 0x47, 0x37, 0xec, 0x82, 0xb6, 0x88, 0x56, 0x95, 0x28, 0x68, 0xb6, 0x9a, 0xb3, 0x39,
+		0x43, 0xbc, 0xe2, 0x27, 0x4f, 0x50, 0xe0, 0x90, 0xce, 0xdc, 0x52, 0x32, 0xcf, 0x96, 0x54, 0x43,
+		0x87, 0x4e, 0x4e, 0x2d, 0x89, 0x3a, 0xc4, 0xc3, 0x78, 0x46, 0xb7, 0xe1, 0x60, 0x92, 0x6b, 0x08,
+		0x20, 0x06, 0x1e, 0xc1, 0x02, 0x44, 0x5e, 0x85, 0x0c, 0x31, 0x23, 0x01, 0xb8, 0x01, 0xe6, 0x81,
+		0xc5, 0xf0, 0x3b, 0x12, 0xdc, 0x34, 0x6e, 0xb9, 0x7a, 0xad, 0x08, 0x8a, 0xc9, 0x13, 0x13, 0xe8,
+		0x43, 0x6a, 0x52, 0x6e, 0xd5, 0x7e, 0xaa, 0x0e, 0x30, 0xb4, 0xc2, 0xf3, 0x16, 0x1b, 0xe2, 0x40,
+		0xb2, 0x32, 0x18, 0x5e, 0x91, 0x79, 0x6e, 0xfa, 0xd0, 0x45, 0x24, 0xf5, 0x1f, 0xdc, 0x58, 0xa6,
+		0xf6, 0xb0, 0x97, 0xcf, 0xa1, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60,
+		0x82,
+	};
+	inline constexpr BYTE PNG_RGBA_FIXED[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x0a, 0x08, 0x06, 0x00, 0x00, 0x00, 0x52, 0x7c, 0xb5,
+		0xa2, 0x00, 0x00, 0x02, 0x8a, 0x49, 0x44, 0x41, 0x54, 0x78, 0x01, 0x63, 0x60, 0x70, 0xaa, 0xdd,
+		0xc9, 0x66, 0xd7, 0xb0, 0x9b, 0xcd, 0xad, 0x76, 0x2f, 0x9b, 0x4b, 0xe3, 0x5e, 0x1e, 0xb7, 0xd6,
+		0x83, 0x3c, 0xde, 0x1d, 0x87, 0x78, 0x7c, 0x3a, 0x0e, 0x08, 0x07, 0x74, 0x1e, 0x16, 0xf2, 0xeb,
+		0x3d, 0x21, 0x14, 0xd4, 0x77, 0x4a, 0x32, 0x60, 0xc2, 0x39, 0x89, 0xb0, 0x3e, 0x20, 0x9e, 0x78,
+		0x51, 0x3e, 0x66, 0x2a, 0x10, 0xcf, 0xbc, 0x24, 0x17, 0x33, 0xf3, 0x86, 0x6a, 0xdc, 0xdc, 0x2b,
+		0x8c, 0xec, 0x0e, 0xf5, 0x3b, 0x98, 0x99, 0x59, 0x58, 0x18, 0x19, 0xff, 0xb3, 0x32, 0x31, 0xfe,
+		0x67, 0x60, 0x62, 0x67, 0x66, 0x00, 0x32, 0x59, 0x19, 0x98, 0x58, 0x98, 0x19, 0x99, 0xff, 0xfc,
+		0x63, 0x61, 0x62, 0x61, 0x61, 0xfd, 0xcf, 0xc0, 0xc8, 0xc8, 0xce, 0xc2, 0xc4, 0xcc, 0xc4, 0xc8,
+		0xfc, 0x8f, 0x99, 0x85, 0x91, 0xf5, 0x3f, 0x13, 0x50, 0x07, 0x0b, 0xd3, 0x1f, 0x20, 0x87, 0x85,
+		0x89, 0x91, 0x91, 0x89, 0x81, 0x9d, 0x91, 0x99, 0x89, 0xf5, 0x3f, 0x23, 0x33, 0x0b, 0xeb, 0x5f,
+		0x46, 0x0e, 0x76, 0x16, 0xa0, 0x66, 0x56, 0x36, 0xa0, 0x0c, 0x33, 0xfb, 0x5f, 0x06, 0x16, 0x36,
+		0x16, 0x66, 0x90, 0xe4, 0x7f, 0x36, 0x0e, 0xb6, 0xff, 0x8c, 0x6c, 0x8c, 0xff, 0x19, 0x99, 0x18,
+		0x59, 0x98, 0x59, 0xd8, 0xfe, 0x33, 0x33, 0x31, 0xff, 0xfd, 0xc7, 0x02, 0x56, 0xc3, 0xc6, 0xf2,
+		0x8f, 0x91, 0x99, 0x5b, 0xdd, 0x2d, 0xe1, 0x1f, 0x0b, 0x2b, 0x0b, 0x33, 0xc3, 0x5f, 0xa0, 0x34,
+		0xd0, 0x45, 0xff, 0x19, 0x58, 0x19, 0xd9, 0x59, 0xff, 0xb3, 0xfd, 0x65, 0x62, 0x61, 0x63, 0xe5,
+		0x60, 0xfa, 0xff, 0x9f, 0x81, 0x83, 0x83, 0x89, 0x19, 0xe8, 0x16, 0xa0, 0x11, 0x40, 0x07, 0x30,
+		0xb1, 0xb2, 0x31, 0x73, 0x80, 0x4c, 0xe1, 0x60, 0x64, 0x60, 0xfe, 0xcb, 0xcc, 0xca, 0xca, 0xc1,
+		0xc1, 0xc8, 0xc2, 0x00, 0x74, 0x34, 0xcb, 0x7f, 0x66, 0x36, 0x66, 0x76, 0xa0, 0xf6, 0x7f, 0x0c,
+		0xac, 0x2c, 0x1c, 0xec, 0x0c, 0x8c, 0x7f, 0xff, 0xb1, 0x02, 0x5d, 0xf6, 0xff, 0x1f, 0xd0, 0x03,
+		0x6c, 0x0c, 0x8c, 0xcc, 0x7f, 0x59, 0x99, 0xff, 0x73, 0xb2, 0xfc, 0x63, 0xf9, 0xc3, 0x04, 0x14,
+		0xfe, 0x07, 0x74, 0x1a, 0x1b, 0xc3, 0x7f, 0x60, 0x10, 0x00, 0xfd, 0xce, 0xcc, 0xc4, 0x04, 0x74,
+		0x08, 0x03, 0xbf, 0x4f, 0xd7, 0x49, 0xc1, 0xc0, 0xbe, 0x13, 0x12, 0x41, 0x3d, 0xa7, 0x44, 0x03,
+		0x27, 0x9d, 0x96, 0x09, 0x99, 0x78, 0x4e, 0x36, 0x6a, 0xd2, 0x05, 0xf9, 0xc8, 0x19, 0x97, 0xe5,
+		0xe2, 0x66, 0x5e, 0x57, 0x8d, 0x9b, 0x7d, 0x53, 0x3d, 0x61, 0xe6, 0x4d, 0xd5, 0xa4, 0xb9, 0xb7,
+		0x34, 0x93, 0xe7, 0xdd, 0x51, 0x4f, 0x5f, 0xf2, 0x50, 0x33, 0x73, 0xf9, 0x5d, 0xed, 0xf4, 0x15,
+		0x8f, 0x8d, 0xf3, 0x96, 0x3f, 0x32, 0xce, 0x5b, 0xf1, 0x94, 0x51, 0xcc, 0xbf, 0xef, 0x18, 0x23,
+		0x3b, 0x03, 0xdb, 0xff, 0x3f, 0xac, 0x0c, 0xc0, 0x80, 0x63, 0x64, 0xe3, 0x00, 0x9a, 0xcc, 0xc8,
+		0x0a, 0x74, 0x1c, 0x13, 0x0b, 0xd0, 0x9a, 0xbf, 0x4c, 0xc0, 0x70, 0x00, 0x06, 0x24, 0x07, 0x23,
+		0x13, 0x2b, 0x03, 0xd0, 0xdd, 0xff, 0x98, 0x99, 0x19, 0x98, 0x19, 0xfe, 0xb3, 0x30, 0x73, 0x30,
+		0x30, 0xb3, 0xfe, 0x07, 0xb2, 0xfe, 0x33, 0x31, 0xb0, 0x31, 0x31, 0xb0, 0x02, 0x7d, 0xf7, 0x97,
+		0x99, 0x81, 0x1d, 0xe8, 0x7e, 0x56, 0xa0, 0x6a, 0x60, 0x70, 0x01, 0xfd, 0xf6, 0xff, 0x3f, 0xe7,
+		0x3f, 0xa6, 0xff, 0x1c, 0x40, 0xc5, 0x2c, 0xff, 0xd8, 0xd9, 0x59, 0x58, 0x19, 0x81, 0x9e, 0x67,
+		0x06, 0xda, 0xc4, 0xca, 0x06, 0xf4, 0x01, 0x2b, 0xd0, 0xeb, 0x8c, 0x8c, 0x9c, 0xcc, 0x0c, 0x2c,
+		0xac, 0xec, 0x2c, 0x6c, 0xcc, 0xcc, 0xff, 0x99, 0x85, 0xb4, 0x7c, 0x32, 0x99, 0x98, 0x59, 0x81,
+		0x9e, 0x07, 0x06, 0x3c, 0x23, 0x50, 0x35, 0x0b, 0x90, 0xc3, 0xc2, 0xc4, 0xfe, 0xef, 0x3f, 0x13,
+		0xd0, 0x11, 0xa0, 0x30, 0x02, 0x06, 0x01, 0x30, 0xca, 0xff, 0x31, 0x31, 0xb0, 0x00, 0xa3, 0x19,
+		0x18, 0x03, 0xc0, 0xd0, 0x00, 0xba, 0x19, 0x14, 0xc4, 0xc0, 0xf0, 0xfe, 0xcf, 0x06, 0x0c, 0x4d,
+		0x16, 0x46, 0x4e, 0x56, 0x66, 0xd6, 0x7f, 0xff, 0x80, 0x11, 0xc5, 0xc8, 0xc0, 0xca, 0xc6, 0xc8,
+		0x00, 0x74, 0xfd, 0x7f, 0xa6, 0x7f, 0x6c, 0xcc, 0x8c, 0x9c, 0xff, 0xfe, 0xb0, 0xfd, 0x63, 0x05,
+		0x3a, 0x0c, 0xa8, 0x14, 0x18, 0xe6, 0x9c, 0x8c, 0x2c, 0xc0, 0xe8, 0x00, 0xc6, 0x2c, 0x13, 0xc8,
+		0xf0, 0x7f, 0xc0, 0x38, 0x67, 0xff, 0xfb, 0x07, 0xe8, 0x2f, 0x06, 0x06, 0xa6, 0x7f, 0x00, 0xdc,
+		0x58, 0xa6, 0xf6, 0x53, 0x29, 0x7b, 0x06, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae,
+		0x42, 0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_GRAY_ADAM7[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x13, 0x00, 0x00, 0x00, 0x0b, 0x08, 0x00, 0x00, 0x00, 0x01, 0xcf, 0xb9, 0xd9,
+		0x70, 0x00, 0x00, 0x00, 0xbf, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x1d, 0x8d, 0xed, 0x4a, 0xc3,
+		0x40, 0x10, 0x45, 0x77, 0x66, 0xee, 0xcc, 0x7e, 0xb0, 0x8a, 0x34, 0x1a, 0x54, 0x70, 0xa3, 0x85,
+		0xa4, 0x2a, 0x91, 0x5a, 0x35, 0x68, 0x51, 0xab, 0xf8, 0xfe, 0x8f, 0x24, 0x89, 0x8b, 0x3f, 0xcf,
+		0x3d, 0x5c, 0x8e, 0x73, 0xab, 0x9e, 0xae, 0x8e, 0x4e, 0x29, 0x67, 0xbe, 0xb8, 0xe4, 0xe3, 0xb3,
+		0x6e, 0xd8, 0x89, 0xc5, 0xa6, 0x69, 0x91, 0x53, 0x42, 0x74, 0xa5, 0x1f, 0x5f, 0x3f, 0xe0, 0x3d,
+		0x41, 0xd9, 0x38, 0x8a, 0x6b, 0xdb, 0xae, 0xac, 0x6f, 0xc7, 0x97, 0xa7, 0x77, 0x2a, 0x6a, 0x14,
+		0x58, 0x34, 0xc0, 0x99, 0xe5, 0x66, 0x75, 0xde, 0x95, 0x9e, 0x32, 0x87, 0x05, 0x10, 0x18, 0x4b,
+		0x9d, 0x55, 0xbd, 0x99, 0x9c, 0x68, 0x90, 0xa0, 0x08, 0x40, 0xe5, 0x25, 0xce, 0xa6, 0xde, 0xdd,
+		0x0c, 0xe3, 0xc3, 0xee, 0x6d, 0xff, 0xf5, 0x43, 0x5e, 0x88, 0x99, 0x5c, 0x2d, 0x90, 0xcc, 0x8a,
+		0x5f, 0xb0, 0xf2, 0x7f, 0x0f, 0x31, 0xc3, 0x33, 0xa9, 0x97, 0x90, 0x12, 0x49, 0x40, 0x70, 0x51,
+		0xe1, 0x12, 0xc4, 0x33, 0x4b, 0x64, 0x42, 0xd5, 0x6a, 0x5a, 0xdf, 0x33, 0x98, 0x17, 0x32, 0x26,
+		0x62, 0x57, 0xd6, 0xd7, 0xc3, 0xe6, 0xfe, 0x6e, 0xfb, 0xb8, 0x9d, 0xa6, 0xe7, 0xe9, 0x73, 0x7f,
+		0x38, 0x7c, 0xff, 0x01, 0xe6, 0xce, 0x13, 0xad, 0xe8, 0xd4, 0xef, 0xe3, 0x00, 0x00, 0x00, 0x00,
+		0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_RGB_ADAM7[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x0a, 0x08, 0x02, 0x00, 0x00, 0x01, 0xaa, 0x19, 0x12,
+		0x63, 0x00, 0x00, 0x01, 0xc6, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x15, 0x90, 0xdd, 0x4b, 0x94,
+		0x51, 0x10, 0xc6, 0xcf, 0x7c, 0x9f, 0xf3, 0xee, 0x6b, 0xa8, 0x9b, 0x56, 0x1b, 0xad, 0x21, 0xa8,
+		0x29, 0x82, 0x56, 0x2e, 0xd1, 0x45, 0x12, 0x11, 0x2a, 0x7d, 0x27, 0x21, 0x81, 0x5b, 0x98, 0x09,
+		0xe1, 0x1a, 0x04, 0x51, 0x7b, 0x11, 0x48, 0x16, 0x44, 0x75, 0xd1, 0x12, 0xf4, 0xb9, 0xa4, 0x84,
+		0x2c, 0x58, 0xed, 0xc5, 0xd2, 0x45, 0xf5, 0xd7, 0x6d, 0xef, 0xdb, 0x09, 0x66, 0x60, 0x86, 0x99,
+		0x79, 0x9e, 0x1f, 0xe3, 0xdc, 0xb9, 0xcd, 0xfe, 0x2b, 0x6f, 0x46, 0x6e, 0xef, 0xc0, 0x91, 0x1b,
+		0xef, 0x7b, 0x06, 0xfa, 0xf6, 0xf7, 0x15, 0x20, 0x9d, 0x7b, 0x91, 0xf6, 0xa6, 0x78, 0xa8, 0x74,
+		0xa0, 0x74, 0xb8, 0x84, 0xfb, 0x2e, 0xbf, 0x1c, 0x58, 0x7a, 0x3b, 0x74, 0xf3, 0xe3, 0xe8, 0x9d,
+		0xdd, 0xe3, 0xeb, 0x3f, 0x48, 0xe7, 0x36, 0xc3, 0xf8, 0x85, 0xe2, 0xc4, 0xa5, 0xe2, 0xcc, 0x75,
+		0x4e, 0x0b, 0x3d, 0x09, 0x87, 0x24, 0x15, 0x0e, 0xa9, 0x2b, 0x2f, 0x7f, 0x1e, 0x59, 0xf9, 0x3a,
+		0x59, 0xdb, 0x3b, 0x55, 0xef, 0xb0, 0xcd, 0x6f, 0x19, 0x18, 0x28, 0xb0, 0xa2, 0x38, 0x8f, 0x22,
+		0x6a, 0x84, 0x99, 0x06, 0xcd, 0xdc, 0xe0, 0xd5, 0xc6, 0xe0, 0xe2, 0xbb, 0xa1, 0xea, 0x87, 0xf2,
+		0xca, 0xf6, 0xf0, 0xdd, 0xed, 0x63, 0x6b, 0xad, 0xc9, 0x8d, 0xd6, 0x4c, 0xad, 0x7d, 0xe2, 0x41,
+		0xdb, 0xe9, 0xec, 0x96, 0x9e, 0x7f, 0x96, 0x5e, 0x7c, 0x55, 0xbc, 0xf6, 0xba, 0x7f, 0xb1, 0x71,
+		0x70, 0xa9, 0xf1, 0x7f, 0xaf, 0xda, 0x84, 0x74, 0xe1, 0x39, 0x8a, 0x7a, 0xa4, 0xdc, 0x90, 0xc1,
+		0x33, 0xe7, 0xc4, 0x1a, 0xc5, 0x91, 0x38, 0x61, 0x44, 0xc7, 0xa4, 0x5c, 0x10, 0x15, 0xf1, 0xc1,
+		0xcc, 0x94, 0x53, 0xea, 0x9d, 0x5e, 0x10, 0xf4, 0x3e, 0x09, 0x64, 0xe0, 0x89, 0x45, 0x95, 0x49,
+		0x3c, 0xc7, 0xca, 0x05, 0x31, 0x32, 0xc3, 0x3c, 0xc3, 0x20, 0x21, 0xb3, 0x28, 0x03, 0x12, 0xd3,
+		0xce, 0x3e, 0x25, 0x62, 0x80, 0x1c, 0x63, 0x18, 0x41, 0x2e, 0x2e, 0x7a, 0x51, 0x97, 0x91, 0x25,
+		0x77, 0x60, 0x4c, 0x08, 0x59, 0xbc, 0xcf, 0x91, 0x99, 0xbb, 0xb1, 0x42, 0x40, 0x4b, 0x0c, 0x92,
+		0x08, 0x42, 0x92, 0x06, 0x44, 0xe1, 0x44, 0x03, 0x43, 0xea, 0xd3, 0xc8, 0x63, 0x96, 0x44, 0x5d,
+		0x40, 0x15, 0x0d, 0xc6, 0xd1, 0x91, 0xbd, 0x60, 0x52, 0x30, 0xf2, 0x63, 0xf3, 0x1c, 0x41, 0x85,
+		0x9c, 0xb3, 0x20, 0x91, 0x2c, 0xea, 0x79, 0xa7, 0x94, 0x48, 0x6c, 0x1c, 0xa9, 0x1a, 0x47, 0x4b,
+		0x45, 0x55, 0xca, 0x25, 0x04, 0x42, 0x04, 0x36, 0x1f, 0x79, 0x9d, 0x60, 0x50, 0xee, 0x4a, 0x9c,
+		0x11, 0x60, 0x26, 0x40, 0x2e, 0x73, 0xb1, 0xeb, 0x22, 0x1a, 0x66, 0x98, 0xdb, 0x5f, 0x20, 0x88,
+		0x0f, 0xc7, 0x9c, 0xc1, 0x75, 0x5d, 0xf9, 0x56, 0x73, 0x78, 0xf9, 0xd3, 0xd1, 0x6a, 0x73, 0x74,
+		0xf5, 0xcb, 0xd8, 0xda, 0xce, 0xc4, 0x6a, 0x6b, 0x7c, 0x7d, 0x77, 0xea, 0xde, 0xde, 0xf4, 0xfd,
+		0xef, 0x53, 0xb5, 0x6f, 0x95, 0x8d, 0x76, 0xe5, 0x61, 0xe7, 0xe4, 0xa3, 0x9f, 0x95, 0x7a, 0xe7,
+		0xcc, 0xe3, 0xdf, 0xa7, 0xeb, 0xbf, 0x66, 0x9f, 0xfc, 0xf9, 0x07, 0x78, 0xa9, 0x5d, 0x01, 0xca,
+		0x71, 0x7b, 0x8e, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_RGBA_ADAM7[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x0a, 0x08, 0x06, 0x00, 0x00, 0x01, 0x25, 0x7b, 0x85,
+		0x34, 0x00, 0x00, 0x02, 0x59, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x1d, 0x50, 0x5b, 0x4b, 0x56,
+		0x51, 0x10, 0xdd, 0x33, 0x7b, 0x66, 0x5f, 0xce, 0x77, 0x0c, 0x2f, 0x79, 0xc9, 0xe8, 0x33, 0x04,
+		0x35, 0x45, 0xd0, 0x4a, 0x89, 0x1e, 0x92, 0x88, 0x50, 0xe9, 0x9e, 0x84, 0x04, 0x5a, 0x98, 0x09,
+		0xa1, 0x5f, 0x14, 0x44, 0xf9, 0x10, 0x48, 0x16, 0x44, 0xf5, 0x90, 0x04, 0x5d, 0x25, 0x25, 0x44,
+		0xb0, 0xf2, 0x41, 0x7a, 0xa8, 0x28, 0x44, 0xe8, 0x02, 0x11, 0x21, 0x61, 0x94, 0x1a, 0x08, 0x0a,
+		0xa1, 0xf9, 0x22, 0xf9, 0x07, 0xbe, 0xce, 0x69, 0x6c, 0x3f, 0xcc, 0x5e, 0x7b, 0xd8, 0xb3, 0x66,
+		0xad, 0xa5, 0xd4, 0x9e, 0x9e, 0xb7, 0xd9, 0x87, 0x6e, 0x7f, 0x2e, 0x39, 0x39, 0xf8, 0x03, 0x36,
+		0x1d, 0xbb, 0x37, 0x95, 0x91, 0x9b, 0x15, 0xae, 0xcf, 0x4a, 0xe4, 0x42, 0x58, 0x7f, 0xfd, 0x7d,
+		0x98, 0x19, 0x66, 0xe2, 0x86, 0xc2, 0xfc, 0xfc, 0xc2, 0x8d, 0x85, 0x05, 0xb8, 0xee, 0xe0, 0x8d,
+		0x77, 0xb9, 0xcd, 0x77, 0x26, 0x8b, 0x8e, 0x3f, 0x98, 0x29, 0x3d, 0x35, 0x34, 0xbf, 0xb5, 0xf3,
+		0xf9, 0xa2, 0x36, 0xf5, 0x3d, 0x13, 0xbe, 0x7c, 0x5f, 0x7b, 0x4e, 0xc5, 0x81, 0x73, 0x39, 0x35,
+		0x47, 0x53, 0x14, 0x26, 0x32, 0x7c, 0x40, 0xde, 0x04, 0x21, 0x3b, 0xf2, 0xa1, 0x51, 0xc9, 0x96,
+		0x47, 0xd3, 0x25, 0x6d, 0x4f, 0xe6, 0x2a, 0xbb, 0x46, 0x16, 0x77, 0x74, 0x8f, 0xad, 0x90, 0x6d,
+		0xe8, 0x1d, 0xb7, 0x60, 0x35, 0x18, 0x70, 0x64, 0x50, 0xb3, 0x72, 0x80, 0xcc, 0x6c, 0xac, 0xf6,
+		0x18, 0x19, 0xe5, 0x4d, 0xc4, 0x2a, 0xef, 0x70, 0xdf, 0xa7, 0xbc, 0xa6, 0xbb, 0x93, 0x45, 0xad,
+		0xf7, 0xa7, 0x92, 0x6d, 0x03, 0x3f, 0x8b, 0x4f, 0x0f, 0xcc, 0x6c, 0xe9, 0x18, 0x9e, 0xaf, 0x4c,
+		0x0d, 0x2f, 0xd4, 0x74, 0x8d, 0x2e, 0x6f, 0x3b, 0x3f, 0xba, 0xa2, 0x4c, 0x5d, 0xef, 0xb8, 0xd9,
+		0x7b, 0x75, 0x22, 0xdc, 0x7f, 0xf3, 0x43, 0xce, 0x91, 0x5b, 0x1f, 0xb3, 0x9b, 0xfa, 0xbe, 0x14,
+		0x34, 0xf7, 0x7d, 0x95, 0xa1, 0x6f, 0xc9, 0xd6, 0xfe, 0x9f, 0x10, 0x36, 0x5e, 0x9b, 0x40, 0x36,
+		0xce, 0xa1, 0xc6, 0xd8, 0xa2, 0x26, 0x70, 0x8e, 0x28, 0x56, 0x9a, 0x8c, 0x59, 0x5b, 0x2d, 0x9d,
+		0x20, 0x20, 0x44, 0xab, 0x48, 0x4b, 0x27, 0x21, 0x22, 0x58, 0xb1, 0xf3, 0x56, 0x0e, 0x1b, 0x0a,
+		0x8d, 0xce, 0xac, 0x6e, 0xec, 0x64, 0x74, 0xe0, 0x02, 0x6f, 0xb5, 0x05, 0x72, 0x5a, 0x7e, 0x19,
+		0x03, 0xa4, 0x85, 0x56, 0x0a, 0xb1, 0xf2, 0xcc, 0x56, 0xa3, 0xb5, 0xe8, 0xe2, 0x08, 0xd1, 0xb3,
+		0xe7, 0xc8, 0x12, 0x1b, 0x04, 0x25, 0x05, 0xc1, 0xee, 0xbe, 0xf2, 0x46, 0x6b, 0x22, 0x80, 0x98,
+		0x11, 0x62, 0x85, 0x56, 0x2b, 0x81, 0xac, 0x90, 0x34, 0xe8, 0x74, 0x44, 0x48, 0xc4, 0xb1, 0x02,
+		0xb0, 0x24, 0x82, 0x40, 0x47, 0xa2, 0x92, 0x63, 0x51, 0x46, 0x84, 0x69, 0x79, 0x10, 0x02, 0xa0,
+		0x0d, 0x2c, 0x43, 0x60, 0x98, 0x8c, 0x06, 0x0e, 0xbd, 0xf0, 0x72, 0x40, 0x81, 0x41, 0x4f, 0xa0,
+		0x43, 0x17, 0x1a, 0x91, 0xef, 0xac, 0x0d, 0x64, 0x01, 0x6b, 0x40, 0x23, 0xeb, 0xc5, 0x03, 0x59,
+		0xd6, 0x42, 0xea, 0x18, 0x29, 0x48, 0x58, 0xad, 0x5d, 0x59, 0x43, 0x8a, 0x98, 0xb5, 0x63, 0xc9,
+		0x5c, 0x49, 0xda, 0xbc, 0xe6, 0x02, 0x99, 0xc8, 0xb1, 0x32, 0x5a, 0xc6, 0x05, 0xf2, 0xff, 0x28,
+		0xd8, 0x0a, 0x42, 0x32, 0x16, 0x8d, 0x51, 0x3a, 0x96, 0x48, 0xbc, 0xf0, 0x0a, 0x3b, 0x59, 0x67,
+		0x19, 0x63, 0x15, 0xb1, 0x38, 0x35, 0x94, 0x8e, 0x44, 0x92, 0xe8, 0x06, 0x85, 0x82, 0x40, 0x9c,
+		0x45, 0x4a, 0x48, 0x4c, 0x7a, 0x2d, 0xd4, 0xbf, 0x18, 0x21, 0xc5, 0x72, 0xc1, 0x9a, 0x26, 0xd9,
+		0x83, 0xb1, 0x58, 0x56, 0x69, 0x50, 0xc9, 0x13, 0xfd, 0xdf, 0x8b, 0x5b, 0x1e, 0xce, 0x6e, 0x6e,
+		0xed, 0x9f, 0x2d, 0x6d, 0x7f, 0x3c, 0x5d, 0xd6, 0x31, 0x38, 0x5b, 0xd1, 0x3e, 0xbc, 0x50, 0xde,
+		0x39, 0x34, 0x57, 0x75, 0x66, 0xe4, 0x57, 0xf5, 0xd9, 0x67, 0x4b, 0x55, 0x5d, 0x4f, 0x97, 0x6a,
+		0x53, 0xa3, 0xbf, 0x6b, 0x2f, 0x8c, 0x2d, 0x6d, 0xbf, 0xf8, 0x62, 0xb9, 0xb6, 0x7b, 0x6c, 0x75,
+		0xd7, 0xa5, 0x57, 0x2b, 0x3b, 0xbb, 0x5f, 0xfe, 0xa9, 0xbb, 0xfc, 0x7a, 0xf5, 0x1f, 0xf7, 0xc9,
+		0x90, 0x6a, 0x4b, 0x46, 0x73, 0x2f, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e, 0x44, 0xae, 0x42,
+		0x60, 0x82,
+	};
+	inline constexpr BYTE PNG_RGBA_SPLIT[] = {
+		0x89, 0x50, 0x4e, 0x47, 0x0d, 0x0a, 0x1a, 0x0a, 0x00, 0x00, 0x00, 0x0d, 0x49, 0x48, 0x44, 0x52,
+		0x00, 0x00, 0x00, 0x11, 0x00, 0x00, 0x00, 0x0a, 0x08, 0x06, 0x00, 0x00, 0x00, 0x52, 0x7c, 0xb5,
+		0xa2, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0x78, 0xda, 0x1d, 0x91, 0x4d, 0x4b, 0xd5,
+		0x41, 0x14, 0xc6, 0xcf, 0xeb, 0xcc, 0x5c, 0xba, 0x10, 0x19, 0x85, 0x41, 0xe9, 0x4a, 0x2e, 0xd6,
+		0xd2, 0x7d, 0x44, 0x84, 0x9b, 0xa4, 0x54, 0x22, 0x28, 0x44, 0xa4, 0x16, 0xe2, 0xc6, 0xcb, 0x6f,
+		0x67, 0x1a, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0x6f, 0x20, 0xd5, 0x22, 0xb0, 0xa8,
+		0x4b, 0x0a, 0x41, 0x97, 0xb0, 0x55, 0xa0, 0x1f, 0xa1, 0x08, 0xa1, 0x17, 0x08, 0x33, 0x90, 0xde,
+		0xa0, 0x8c, 0x5a, 0x54, 0xf4, 0x2d, 0xee, 0x7f, 0x4e, 0xcf, 0x6d, 0x31, 0x30, 0x33, 0xe7, 0x73,
+		0x70, 0x0c, 0x1d, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0xcc, 0x99, 0xdf, 0xf3, 0x3c,
+		0x44, 0x67, 0x57, 0x9e, 0xa7, 0xd3, 0x37, 0x5f, 0xa4, 0xc9, 0x95, 0xed, 0x74, 0xee, 0xd6, 0x76,
+		0x7b, 0xf2, 0xf6, 0xab, 0xf6, 0xf9, 0xd5, 0xd7, 0xed, 0xa9, 0xd5, 0x97, 0x87, 0xa7, 0xef, 0xbc,
+		0xe7, 0x44, 0x85, 0xd6, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0x19, 0xba, 0x70, 0x7f,
+		0x67, 0x68, 0xb6, 0xbb, 0x7b, 0x6c, 0xfa, 0xc1, 0xde, 0xf0, 0xe5, 0x2e, 0xd6, 0xda, 0xc7, 0xd1,
+		0xb9, 0x87, 0x58, 0xbd, 0x4f, 0x23, 0x73, 0xbd, 0x6f, 0x63, 0xf3, 0x1b, 0x5f, 0x38, 0x9f, 0xb9,
+		0xf1, 0x3c, 0x90, 0x6d, 0xec, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0x4c, 0xd5, 0x8c,
+		0x39, 0x5c, 0x38, 0x48, 0xb2, 0x12, 0xb6, 0x4e, 0x62, 0xca, 0xda, 0xaf, 0x26, 0x66, 0x1e, 0xc4,
+		0x9c, 0x4d, 0x54, 0x58, 0xab, 0x1a, 0x7b, 0x08, 0x5e, 0x98, 0xf4, 0x71, 0x30, 0x61, 0x16, 0xca,
+		0xac, 0xe2, 0xe2, 0x55, 0x12, 0x9d, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0xc1, 0x6a,
+		0xde, 0x70, 0xc9, 0x86, 0xc7, 0x9e, 0x50, 0xd1, 0xdc, 0x90, 0x25, 0xd3, 0x41, 0x31, 0x52, 0x49,
+		0xc1, 0x89, 0x83, 0x85, 0x4d, 0x2d, 0x85, 0x8a, 0x36, 0xd5, 0xfe, 0xf7, 0x24, 0xab, 0xac, 0x07,
+		0x3a, 0x93, 0x0b, 0x36, 0x08, 0x98, 0xb9, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0xd5,
+		0xdc, 0x94, 0x1a, 0x94, 0x41, 0x14, 0xe4, 0x9c, 0x3d, 0x52, 0x23, 0x96, 0xbc, 0x48, 0x04, 0x95,
+		0x22, 0x0a, 0x16, 0x8c, 0x00, 0x80, 0x78, 0xd2, 0x32, 0x98, 0x52, 0x98, 0xb4, 0x51, 0xf7, 0x52,
+		0xd8, 0x08, 0xd0, 0x16, 0xa9, 0x05, 0x91, 0x06, 0x00, 0x00, 0x00, 0x00, 0x49, 0x44, 0x41, 0x54,
+		0x35, 0xaf, 0x06, 0x1e, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0x9a, 0x34, 0xe3, 0x79,
+		0x25, 0xb7, 0x92, 0x89, 0x9b, 0xea, 0x20, 0x8b, 0x0a, 0x01, 0x89, 0x58, 0x1b, 0xd7, 0x68, 0x59,
+		0xb5, 0xbe, 0xe0, 0xba, 0x02, 0x2d, 0x51, 0xc0, 0x02, 0x68, 0x57, 0x11, 0x80, 0xd0, 0xc1, 0xa9,
+		0xbb, 0x08, 0xea, 0x7c, 0xfa, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0xef, 0x0e, 0xcd,
+		0x74, 0x77, 0x86, 0x67, 0xef, 0xed, 0x1e, 0x99, 0x59, 0x7f, 0x7f, 0xfc, 0xd2, 0xda, 0xde, 0x89,
+		0xab, 0xeb, 0x1f, 0x46, 0xaf, 0x3c, 0xfa, 0x3c, 0x32, 0xdf, 0xfb, 0x3a, 0x36, 0xff, 0x78, 0xbf,
+		0xb3, 0xd0, 0xcf, 0xa4, 0x66, 0x03, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0xdb, 0x1f,
+		0xbb, 0xb6, 0xf1, 0x7d, 0xfc, 0xfa, 0x93, 0x1f, 0x9d, 0xc5, 0xa7, 0xbf, 0xc6, 0x97, 0x36, 0x7f,
+		0x9e, 0x5a, 0xdc, 0xfa, 0x33, 0xb1, 0xbc, 0xf9, 0x7b, 0x62, 0x79, 0xeb, 0x2f, 0x1f, 0xbd, 0xd8,
+		0x7d, 0xcb, 0x99, 0x08, 0x18, 0x2f, 0x05, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54, 0x52,
+		0xf4, 0x9d, 0x60, 0x1c, 0xa7, 0x82, 0xc9, 0xec, 0x80, 0x13, 0xc3, 0x37, 0x8d, 0xc0, 0x07, 0x18,
+		0x59, 0x58, 0x9c, 0xc0, 0x5d, 0x55, 0x49, 0x29, 0x4c, 0x0b, 0xa9, 0x07, 0x76, 0x21, 0x94, 0x84,
+		0x1c, 0xea, 0x1a, 0xa5, 0x7a, 0xa3, 0xca, 0x1b, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41, 0x54,
+		0x0c, 0x7e, 0x47, 0x37, 0xec, 0x82, 0xb6, 0x88, 0x56, 0x95, 0x28, 0x68, 0xb6, 0x9a, 0xb3, 0x39,
+		0x43, 0xbc, 0xe2, 0x27, 0x4f, 0x50, 0xe0, 0x90, 0xce, 0xdc, 0x52, 0x32, 0xcf, 0x96, 0x54, 0x43,
+		0x87, 0x4e, 0x4e, 0x2d, 0x89, 0x4a, 0x7d, 0x1f, 0xd6, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44, 0x41,
+		0x54, 0x3a, 0xc4, 0xc3, 0x78, 0x46, 0xb7, 0xe1, 0x60, 0x92, 0x6b, 0x08, 0x20, 0x06, 0x1e, 0xc1,
+		0x02, 0x44, 0x5e, 0x85, 0x0c, 0x31, 0x23, 0x01, 0xb8, 0x01, 0xe6, 0x81, 0xc5, 0xf0, 0x3b, 0x12,
+		0xdc, 0x34, 0x6e, 0xb9, 0x7a, 0xad, 0x46, 0x22, 0x83, 0x60, 0x00, 0x00, 0x00, 0x25, 0x49, 0x44,
+		0x41, 0x54, 0x08, 0x8a, 0xc9, 0x13, 0x13, 0xe8, 0x43, 0x6a, 0x52, 0x6e, 0xd5, 0x7e, 0xaa, 0x0e,
+		0x30, 0xb4, 0xc2, 0xf3, 0x16, 0x1b, 0xe2, 0x40, 0xb2, 0x32, 0x18, 0x5e, 0x91, 0x79, 0x6e, 0xfa,
+		0xd0, 0x45, 0x24, 0xf5, 0x1f, 0xdc, 0x58, 0x30, 0xf3, 0x58, 0xdb, 0x00, 0x00, 0x00, 0x02, 0x49,
+		0x44, 0x41, 0x54, 0xa6, 0xf6, 0xd0, 0x78, 0xf1, 0xfc, 0x00, 0x00, 0x00, 0x00, 0x49, 0x45, 0x4e,
+		0x44, 0xae, 0x42, 0x60, 0x82,
+	};
+
+	struct png_fixture_t {
+		const char* name;
+		std::span<const BYTE> png;
+		UINT width;
+		UINT height;
+		BYTE color_type;
+		bool interlaced;
+		// BTYPE of the first deflate block: 1 for the fixed Huffman codes, 2 for dynamic ones.
+		BYTE block_type;
+		UINT idat_count;
+	};
+
+	inline constexpr png_fixture_t PNG_FIXTURES[] = {
+		{ "gray", PNG_GRAY, 19, 11, 0, false, 2, 1 },
+		{ "gray_alpha", PNG_GRAY_ALPHA, 19, 11, 4, false, 2, 1 },
+		{ "rgb", PNG_RGB, 17, 10, 2, false, 2, 1 },
+		{ "rgba", PNG_RGBA, 17, 10, 6, false, 2, 1 },
+		{ "rgba_fixed", PNG_RGBA_FIXED, 17, 10, 6, false, 1, 1 },
+		{ "gray_adam7", PNG_GRAY_ADAM7, 19, 11, 0, true, 2, 1 },
+		{ "rgb_adam7", PNG_RGB_ADAM7, 17, 10, 2, true, 2, 1 },
+		{ "rgba_adam7", PNG_RGBA_ADAM7, 17, 10, 6, true, 2, 1 },
+		{ "rgba_split", PNG_RGBA_SPLIT, 17, 10, 6, false, 2, 16 },
+	};
+}
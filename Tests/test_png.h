@@ -0,0 +1,189 @@
+#pragma once
+
+#include <algorithm>
+#include <cstdio>
+#include <string>
+#include <vector>
+
+// Writes PNG files for the tests that decode them, without a compression library: the image data is stored
+// in uncompressed deflate blocks, which every decoder has to accept, or compressed with the fixed Huffman
+// codes, which need no code tables.
+namespace test {
+	inline UINT32 Crc32(const BYTE* data, std::size_t size, UINT32 crc = 0) {
+		crc = ~crc;
+		for (std::size_t i = 0; i < size; i++) {
+			crc ^= data[i];
+			for (int bit = 0; bit < 8; bit++) {
+				crc = (crc >> 1) ^ (0xedb88320u & (0u - (crc & 1)));
+			}
+		}
+		return ~crc;
+	}
+
+	inline void AppendBigEndian(std::vector<BYTE>& out, UINT32 value) {
+		for (int shift = 24; shift >= 0; shift -= 8) {
+			out.push_back(static_cast<BYTE>(value >> shift));
+		}
+	}
+
+	inline void AppendChunk(std::vector<BYTE>& out, const char (&type)[5], const std::vector<BYTE>& data) {
+		AppendBigEndian(out, static_cast<UINT32>(data.size()));
+		std::size_t type_offset = out.size();
+		out.insert(out.end(), type, type + 4);
+		out.insert(out.end(), data.begin(), data.end());
+		AppendBigEndian(out, Crc32(out.data() + type_offset, out.size() - type_offset));
+	}
+
+	inline UINT32 Adler32(const std::vector<BYTE>& data) {
+		UINT32 a = 1, b = 0;
+		for (BYTE value : data) {
+			a = (a + value) % 65521;
+			b = (b + a) % 65521;
+		}
+		return (b << 16) | a;
+	}
+
+	// A zlib stream of stored blocks, each holding at most 65535 bytes, followed by the Adler-32 checksum.
+	inline std::vector<BYTE> StoreZlib(const std::vector<BYTE>& raw) {
+		std::vector<BYTE> zlib = { 0x78, 0x01 };
+		std::size_t offset = 0;
+		do {
+			std::size_t size = std::min<std::size_t>(raw.size() - offset, 65535);
+			zlib.push_back(offset + size == raw.size() ? 1 : 0);
+			zlib.push_back(static_cast<BYTE>(size));
+			zlib.push_back(static_cast<BYTE>(size >> 8));
+			zlib.push_back(static_cast<BYTE>(~size));
+			zlib.push_back(static_cast<BYTE>(~size >> 8));
+			zlib.insert(zlib.end(), raw.begin() + offset, raw.begin() + offset + size);
+			offset += size;
+		} while (offset < raw.size());
+		AppendBigEndian(zlib, Adler32(raw));
+		return zlib;
+	}
+
+	// A zlib stream of a single block with the fixed Huffman codes, with the longest match at the last
+	// position of the same three bytes, at most 32 KiB back.
+	inline std::vector<BYTE> CompressZlib(const std::vector<BYTE>& raw) {
+		constexpr UINT LENGTH_BASES[] = { 3, 4, 5, 6, 7, 8, 9, 10, 11, 13, 15, 17, 19, 23, 27, 31, 35, 43, 51, 59, 67,
+			83, 99, 115, 131, 163, 195, 227, 258 };
+		constexpr UINT DISTANCE_BASES[] = { 1, 2, 3, 4, 5, 7, 9, 13, 17, 25, 33, 49, 65, 97, 129, 193, 257, 385, 513,
+			769, 1025, 1537, 2049, 3073, 4097, 6145, 8193, 12289, 16385, 24577 };
+		constexpr std::size_t WINDOW = 32768, MAX_LENGTH = 258;
+
+		std::vector<BYTE> zlib = { 0x78, 0x01 };
+		UINT64 bit_buffer = 0;
+		UINT bit_count = 0;
+		auto write_bits = [&](UINT value, UINT bits) {
+			bit_buffer |= UINT64(value) << bit_count;
+			for (bit_count += bits; bit_count >= 8; bit_count -= 8, bit_buffer >>= 8) {
+				zlib.push_back(static_cast<BYTE>(bit_buffer));
+			}
+		};
+		// Huffman codes are stored from their most significant bit on.
+		auto write_code = [&](UINT code, UINT bits) {
+			UINT reversed = 0;
+			for (UINT bit = 0; bit < bits; bit++) {
+				reversed |= ((code >> bit) & 1) << (bits - 1 - bit);
+			}
+			write_bits(reversed, bits);
+		};
+		auto write_symbol = [&](UINT symbol) {
+			if (symbol < 144) {
+				write_code(0x30 + symbol, 8);
+			}
+			else if (symbol < 256) {
+				write_code(0x190 + symbol - 144, 9);
+			}
+			else if (symbol < 280) {
+				write_code(symbol - 256, 7);
+			}
+			else {
+				write_code(0xc0 + symbol - 280, 8);
+			}
+		};
+		auto write_match = [&](UINT length, UINT distance) {
+			UINT code = static_cast<UINT>(std::upper_bound(std::begin(LENGTH_BASES), std::end(LENGTH_BASES), length) -
+				std::begin(LENGTH_BASES)) - 1;
+			write_symbol(257 + code);
+			UINT extra = code < 8 || code == 28 ? 0 : (code - 4) / 4;
+			write_bits(length - LENGTH_BASES[code], extra);
+			code = static_cast<UINT>(std::upper_bound(std::begin(DISTANCE_BASES), std::end(DISTANCE_BASES), distance) -
+				std::begin(DISTANCE_BASES)) - 1;
+			write_code(code, 5);
+			write_bits(distance - DISTANCE_BASES[code], code < 4 ? 0 : (code - 2) / 2);
+		};
+
+		write_bits(1, 1);
+		write_bits(1, 2);
+		std::vector<std::size_t> last(1 << 15, SIZE_MAX);
+		std::size_t i = 0;
+		while (i < raw.size()) {
+			std::size_t length = 0, distance = 0;
+			if (i + 3 <= raw.size()) {
+				UINT hash = ((raw[i] << 10) ^ (raw[i + 1] << 5) ^ raw[i + 2]) & 0x7fff;
+				std::size_t candidate = last[hash];
+				last[hash] = i;
+				if (candidate != SIZE_MAX && i - candidate <= WINDOW) {
+					std::size_t limit = std::min(MAX_LENGTH, raw.size() - i);
+					while (length < limit && raw[candidate + length] == raw[i + length]) {
+						length++;
+					}
+					distance = i - candidate;
+				}
+			}
+			if (length >= 3) {
+				write_match(static_cast<UINT>(length), static_cast<UINT>(distance));
+				i += length;
+			}
+			else {
+				write_symbol(raw[i++]);
+			}
+		}
+		write_symbol(256);
+		write_bits(0, 7);
+		AppendBigEndian(zlib, Adler32(raw));
+		return zlib;
+	}
+
+	// Encodes width by height 8-bit RGBA texels, given in rows without padding. Uncompressed images use filter
+	// type 0; compressed ones cycle through the five filter types, one per row.
+	inline std::vector<BYTE> EncodePng(UINT width, UINT height, const std::vector<BYTE>& rgba,
+		bool compressed = false) {
+		std::vector<BYTE> raw;
+		std::size_t row_size = std::size_t(width) * 4;
+		std::vector<BYTE> zero_row(row_size);
+		for (UINT y = 0; y < height; y++) {
+			BYTE filter = compressed ? static_cast<BYTE>(y % 5) : 0;
+			const BYTE* row = rgba.data() + y * row_size;
+			const BYTE* previous = y > 0 ? row - row_size : zero_row.data();
+			raw.push_back(filter);
+			for (std::size_t i = 0; i < row_size; i++) {
+				INT left = i >= 4 ? row[i - 4] : 0, up = previous[i], up_left = i >= 4 ? previous[i - 4] : 0;
+				INT p = left + up - up_left;
+				INT pa = std::abs(p - left), pb = std::abs(p - up), pc = std::abs(p - up_left);
+				INT paeth = pa <= pb && pa <= pc ? left : pb <= pc ? up : up_left;
+				INT predictors[5] = { 0, left, up, (left + up) >> 1, paeth };
+				raw.push_back(static_cast<BYTE>(row[i] - predictors[filter]));
+			}
+		}
+		std::vector<BYTE> zlib = compressed ? CompressZlib(raw) : StoreZlib(raw);
+
+		std::vector<BYTE> header;
+		AppendBigEndian(header, width);
+		AppendBigEndian(header, height);
+		// 8 bits per sample, RGBA, deflate, filtered per row, not interlaced.
+		header.insert(header.end(), { 8, 6, 0, 0, 0 });
+
+		std::vector<BYTE> png = { 0x89, 'P', 'N', 'G', '\r', '\n', 0x1a, '\n' };
+		AppendChunk(png, "IHDR", header);
+		AppendChunk(png, "IDAT", zlib);
+		AppendChunk(png, "IEND", {});
+		return png;
+	}
+
+	inline void WriteFile(const std::string& path, const std::vector<BYTE>& data) {
+		FILE* file = std::fopen(path.c_str(), "wb");
+		std::fwrite(data.data(), 1, data.size(), file);
+		std::fclose(file);
+	}
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include <chrono>
+#include <cstdio>
+#include <exception>
+
+// Checks for the headless tests, which are plain executables: a failed check prints where it failed and
+// makes Result, which main returns, nonzero.
+namespace test {
+	inline int failures = 0;
+
+	inline void Fail(const char* file, int line, const char* expression) {
+		std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+		failures++;
+	}
+
+	inline int Result() {
+		if (failures != 0) {
+			std::printf("%d checks failed\n", failures);
+			return 1;
+		}
+		std::printf("all checks passed\n");
+		return 0;
+	}
+
+	template <typename F>
+	double MeasureMilliseconds(F&& f) {
+		auto start = std::chrono::steady_clock::now();
+		f();
+		return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - start).count();
+	}
+}
+
+#define CHECK(expression) ((expression) ? void(0) : test::Fail(__FILE__, __LINE__, #expression))
+
+#define CHECK_THROWS(expression) \
+	do { \
+		bool thrown = false; \
+		try { \
+			(void)(expression); \
+		} \
+		catch (const std::exception&) { \
+			thrown = true; \
+		} \
+		if (!thrown) { \
+			test::Fail(__FILE__, __LINE__, "throws " #expression); \
+		} \
+	} while (false)